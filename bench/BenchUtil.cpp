@@ -0,0 +1,126 @@
+#include "FastFileViewerPCH.h"
+
+#include "BenchUtil.h"
+
+#include <cmath>
+
+namespace FFV
+{
+std::string BenchUtil::GetArgumentValue(const std::vector<std::string>& args, const std::string& argument)
+{
+    const auto it = std::find(args.begin(), args.end(), argument);
+    return it == args.end() || std::next(it) == args.end() ? "" : *std::next(it);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::string> BenchUtil::GetArgumentValues(const std::vector<std::string>& args, const std::string& argument)
+{
+    const auto it = std::find(args.begin(), args.end(), argument);
+    if (it == args.end())
+    {
+        return {};
+    }
+
+    const auto end = std::find_if(std::next(it), args.end(), [](const std::string& arg) { return arg.starts_with("--"); });
+    return std::vector<std::string>(std::next(it), end);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool BenchUtil::HasArgument(const std::vector<std::string>& args, const std::string& argument)
+{
+    return std::find(args.begin(), args.end(), argument) != args.end();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U64 BenchUtil::ParseCount(const std::string& text)
+{
+    char* end = nullptr;
+    const F64 value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || value <= 0.0)
+    {
+        return 0;
+    }
+
+    F64 multiplier = 1.0;
+    switch (std::toupper(static_cast<unsigned char>(*end)))
+    {
+    case 'K':
+        multiplier = 1e3;
+        break;
+    case 'M':
+        multiplier = 1e6;
+        break;
+    case 'G':
+        multiplier = 1e9;
+        break;
+    default:
+        break;
+    }
+
+    return static_cast<U64>(std::llround(value * multiplier));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string BenchUtil::FormatCount(U64 count)
+{
+    if (count >= 1'000'000'000 && count % 1'000'000'000 == 0)
+    {
+        return std::format("{0}G", count / 1'000'000'000);
+    }
+    if (count >= 1'000'000 && count % 1'000'000 == 0)
+    {
+        return std::format("{0}M", count / 1'000'000);
+    }
+    if (count >= 1'000 && count % 1'000 == 0)
+    {
+        return std::format("{0}K", count / 1'000);
+    }
+    return std::to_string(count);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BenchUtil::Percentiles BenchUtil::ComputePercentiles(std::vector<F64> samples)
+{
+    if (samples.empty())
+    {
+        return {};
+    }
+
+    std::sort(samples.begin(), samples.end());
+    const auto percentile = [&samples](F64 p)
+    {
+        const U64 rank = static_cast<U64>(std::ceil(p / 100.0 * static_cast<F64>(samples.size())));
+        return samples[std::clamp<U64>(rank, 1, samples.size()) - 1];
+    };
+
+    F64 total = 0.0;
+    for (const F64 sample : samples)
+    {
+        total += sample;
+    }
+
+    return { .P50 = percentile(50.0),
+             .P95 = percentile(95.0),
+             .P99 = percentile(99.0),
+             .Mean = total / static_cast<F64>(samples.size()),
+             .NumSamples = static_cast<U32>(samples.size()) };
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string BenchUtil::FormatPercentilesJson(const Percentiles& percentiles)
+{
+    if (percentiles.NumSamples == 0)
+    {
+        return "null";
+    }
+
+    return std::format("{{ \"p50\": {0:.4f}, \"p95\": {1:.4f}, \"p99\": {2:.4f}, \"mean\": {3:.4f}, \"samples\": {4} }}",
+                       percentiles.P50, percentiles.P95, percentiles.P99, percentiles.Mean, percentiles.NumSamples);
+}
+} // namespace FFV
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "util/Types.h"
+
+#include <string>
+#include <vector>
+
+namespace FFV
+{
+/*
+ * Command line parsing and statistics shared by the benchmark executables.
+ */
+class BenchUtil
+{
+public:
+    struct Percentiles
+    {
+        F64 P50 = 0.0;
+        F64 P95 = 0.0;
+        F64 P99 = 0.0;
+        F64 Mean = 0.0;
+        U32 NumSamples = 0;
+    };
+
+public:
+    /*
+     * @return: the argument following the given one or an empty string
+     */
+    static std::string GetArgumentValue(const std::vector<std::string>& args, const std::string& argument);
+    /*
+     * @return: all arguments following the given one up to the next option starting with --
+     */
+    static std::vector<std::string> GetArgumentValues(const std::vector<std::string>& args,
+                                                      const std::string& argument);
+    static bool HasArgument(const std::vector<std::string>& args, const std::string& argument);
+
+    /*
+     * Parses counts like 5000, 10K, 1M or 1G.
+     * @return: 0 if the text isn't a count
+     */
+    static U64 ParseCount(const std::string& text);
+    /*
+     * Inverse of ParseCount for round numbers, e.g. 1000000 becomes 1M.
+     */
+    static std::string FormatCount(U64 count);
+
+    /*
+     * Nearest rank percentiles, so every percentile is an actually measured sample.
+     */
+    static Percentiles ComputePercentiles(std::vector<F64> samples);
+    /*
+     * @return: "null" without samples, so reports stay valid JSON
+     */
+    static std::string FormatPercentilesJson(const Percentiles& percentiles);
+};
+} // namespace FFV
@@ -0,0 +1,659 @@
+#include "FastFileViewerPCH.h"
+
+#include "BenchUtil.h"
+#include "export/BatchExporter.h"
+#include "import/MeshDeduplicator.h"
+#include "import/ObjImporter.h"
+#include "scene/Bvh.h"
+#include "scene/MeshGenerator.h"
+#include "util/JobSystem.h"
+#include "util/Log.h"
+#include "util/Types.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+
+#if defined(FFV_LINUX)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/resource.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#elif defined(FFV_WINDOWS)
+    #include <psapi.h>
+#endif
+
+namespace FFV
+{
+static constexpr U64 s_PageSize = 4096;
+// Every stage adds a value depending on its work, so the compiler can't drop the work
+static volatile U64 s_Sink = 0;
+
+struct StageResult
+{
+    std::string Name;
+    U64 Bytes = 0;     // Input bytes per iteration, 0 if the stage doesn't work on file contents
+    U64 Triangles = 0; // Triangles per iteration
+    BenchUtil::Percentiles Ms;
+    U64 PeakRssBytes = 0; // Of the whole process so far, stages run from the lightest to the heaviest
+    // Stage specific values of the last iteration, e.g. the SAH cost of the BVH
+    std::vector<std::pair<std::string, F64>> Metrics;
+};
+
+/*
+ * Read only view of a whole file that the kernel pages in on access.
+ */
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path& path)
+    {
+#if defined(FFV_LINUX)
+        m_File = open(path.c_str(), O_RDONLY);
+        struct stat status = {};
+        if (m_File < 0 || fstat(m_File, &status) != 0 || status.st_size == 0)
+        {
+            return;
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, m_File, 0);
+        if (data != MAP_FAILED)
+        {
+            madvise(data, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+            m_Data = std::string_view(static_cast<const char*>(data), static_cast<size_t>(status.st_size));
+        }
+#elif defined(FFV_WINDOWS)
+        m_File = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER size = {};
+        if (m_File == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_File, &size) || size.QuadPart == 0)
+        {
+            return;
+        }
+
+        m_Mapping = CreateFileMappingW(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void* data = m_Mapping ? MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (data)
+        {
+            m_Data = std::string_view(static_cast<const char*>(data), static_cast<size_t>(size.QuadPart));
+        }
+#endif
+    }
+
+    ~MappedFile()
+    {
+#if defined(FFV_LINUX)
+        if (!m_Data.empty())
+        {
+            munmap(const_cast<char*>(m_Data.data()), m_Data.size());
+        }
+        if (m_File >= 0)
+        {
+            close(m_File);
+        }
+#elif defined(FFV_WINDOWS)
+        if (!m_Data.empty())
+        {
+            UnmapViewOfFile(m_Data.data());
+        }
+        if (m_Mapping)
+        {
+            CloseHandle(m_Mapping);
+        }
+        if (m_File != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(m_File);
+        }
+#endif
+    }
+
+    FFV_DELETE_MOVE_COPY(MappedFile);
+
+    std::string_view GetData() const { return m_Data; }
+
+private:
+    std::string_view m_Data;
+#if defined(FFV_LINUX)
+    int m_File = -1;
+#elif defined(FFV_WINDOWS)
+    HANDLE m_File = INVALID_HANDLE_VALUE;
+    HANDLE m_Mapping = nullptr;
+#endif
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static U64 GetPeakRssBytes()
+{
+#if defined(FFV_LINUX)
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<U64>(usage.ru_maxrss) * 1024; // Kilobytes on Linux
+#elif defined(FFV_WINDOWS)
+    PROCESS_MEMORY_COUNTERS counters = {};
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize;
+#else
+    return 0;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Sums one byte per page, so reads that only map the file still have to bring every page in.
+ */
+static U64 TouchPages(std::string_view data)
+{
+    U64 sum = 0;
+    for (U64 i = 0; i < data.size(); i += s_PageSize)
+    {
+        sum += static_cast<U8>(data[i]);
+    }
+    return sum;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::string ReadWithIfstream(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    std::string content(file ? static_cast<size_t>(file.tellg()) : 0, '\0');
+    file.seekg(0);
+    file.read(content.data(), static_cast<std::streamsize>(content.size()));
+    return content;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::string ReadWithStdio(const std::filesystem::path& path)
+{
+    std::FILE* file = std::fopen(path.string().c_str(), "rb");
+    if (!file)
+    {
+        return {};
+    }
+
+    std::fseek(file, 0, SEEK_END);
+    std::string content(static_cast<size_t>(std::max(std::ftell(file), 0l)), '\0');
+    std::fseek(file, 0, SEEK_SET);
+    content.resize(std::fread(content.data(), 1, content.size(), file));
+    std::fclose(file);
+    return content;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static U64 CountTriangles(const std::vector<MeshData>& meshes)
+{
+    U64 triangles = 0;
+    for (const MeshData& mesh : meshes)
+    {
+        triangles += mesh.Indices.size() / 3;
+    }
+    return triangles;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * All meshes of a file in one, without normals.
+ */
+static MeshData MergeMeshes(const std::vector<MeshData>& meshes)
+{
+    MeshData merged;
+    for (const MeshData& mesh : meshes)
+    {
+        const U32 firstVertex = static_cast<U32>(merged.Positions.size());
+        merged.Positions.insert(merged.Positions.end(), mesh.Positions.begin(), mesh.Positions.end());
+        for (const U32 index : mesh.Indices)
+        {
+            merged.Indices.push_back(firstVertex + index);
+        }
+    }
+    return merged;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * @param writeNormals: without normals the importer has to generate them
+ */
+static bool WriteObj(const std::filesystem::path& path, const std::vector<MeshData>& meshes, bool writeNormals)
+{
+    std::string text;
+    U64 firstVertex = 1;
+    for (U32 meshIndex = 0; meshIndex < meshes.size(); meshIndex++)
+    {
+        const MeshData& mesh = meshes[meshIndex];
+        text += std::format("o part_{0}\n", meshIndex);
+        for (const glm::vec3& position : mesh.Positions)
+        {
+            text += std::format("v {0:.6f} {1:.6f} {2:.6f}\n", position.x, position.y, position.z);
+        }
+        if (writeNormals)
+        {
+            for (const glm::vec3& normal : mesh.Normals)
+            {
+                text += std::format("vn {0:.6f} {1:.6f} {2:.6f}\n", normal.x, normal.y, normal.z);
+            }
+        }
+        for (U64 i = 0; i + 2 < mesh.Indices.size(); i += 3)
+        {
+            const U64 a = firstVertex + mesh.Indices[i];
+            const U64 b = firstVertex + mesh.Indices[i + 1];
+            const U64 c = firstVertex + mesh.Indices[i + 2];
+            text += writeNormals ? std::format("f {0}//{0} {1}//{1} {2}//{2}\n", a, b, c)
+                                 : std::format("f {0} {1} {2}\n", a, b, c);
+        }
+        firstVertex += mesh.Positions.size();
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(text.data(), static_cast<std::streamsize>(text.size()));
+    return static_cast<bool>(file);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * One dense mesh with normals, and an assembly of many small repeated parts without normals like a CAD export, which
+ * gives normal generation and deduplication work.
+ */
+static std::vector<std::filesystem::path> CreateSyntheticCorpus(const std::filesystem::path& directory,
+                                                                U64 numTriangles)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+    {
+        FFV_ERROR("Couldn't create the directory {0} for the synthetic corpus!", directory.string());
+        return {};
+    }
+
+    // A sphere with s segments and s / 2 rings has s * (s - 2) triangles
+    const auto createSphere = [](U64 triangles)
+    {
+        const U32 segments = std::max(static_cast<U32>(std::lround(1.0 + std::sqrt(1.0 + triangles))) & ~1u, 4u);
+        return MeshGenerator::CreateSphere(segments, segments / 2);
+    };
+
+    std::vector<std::filesystem::path> files;
+    const std::filesystem::path densePath = directory / std::format("sphere_{0}.obj", BenchUtil::FormatCount(numTriangles));
+    if (std::filesystem::exists(densePath) || WriteObj(densePath, { createSphere(numTriangles) }, true))
+    {
+        files.push_back(densePath);
+    }
+
+    constexpr U32 numParts = 200;
+    const std::filesystem::path assemblyPath =
+        directory / std::format("assembly_{0}x{1}.obj", numParts, BenchUtil::FormatCount(numTriangles / numParts));
+    if (!std::filesystem::exists(assemblyPath))
+    {
+        const MeshData part = createSphere(numTriangles / numParts);
+        std::vector<MeshData> parts;
+        parts.reserve(numParts);
+        for (U32 i = 0; i < numParts; i++)
+        {
+            glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(i % 10, i / 10 % 10, i / 100) * 1.5f);
+            transform = glm::rotate(transform, glm::radians(static_cast<F32>(i * 37 % 360)), glm::vec3(1.0f, 2.0f, 3.0f));
+            parts.push_back(MeshGenerator::Transform(part, transform));
+        }
+
+        if (!WriteObj(assemblyPath, parts, false))
+        {
+            return files;
+        }
+    }
+    files.push_back(assemblyPath);
+
+    return files;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Runs the stage the given number of times and measures every run.
+ * @param run: called with the iteration, returns a value depending on the work
+ */
+template<typename RunFn>
+static StageResult RunStage(const std::string& name, U64 bytes, U64 triangles, U32 iterations, RunFn&& run)
+{
+    std::vector<F64> samples;
+    samples.reserve(iterations);
+
+    for (U32 i = 0; i < iterations; i++)
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        s_Sink = s_Sink + run(i);
+        samples.push_back(std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+    }
+
+    StageResult result = { .Name = name,
+                           .Bytes = bytes,
+                           .Triangles = triangles,
+                           .Ms = BenchUtil::ComputePercentiles(std::move(samples)),
+                           .PeakRssBytes = GetPeakRssBytes() };
+
+    const F64 seconds = std::max(result.Ms.P50, 1e-6) * 1e-3;
+    FFV_LOG("{0:<24} {1:10.3f} ms  {2:9.1f} MB/s  {3:9.2f} Mtris/s  peak RSS {4:8.1f} MB", result.Name, result.Ms.P50,
+            bytes * 1e-6 / seconds, triangles * 1e-6 / seconds, result.PeakRssBytes / 1e6);
+    return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool WriteReport(const std::filesystem::path& path, const std::vector<std::filesystem::path>& files,
+                        U32 iterations, const std::vector<StageResult>& results)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        FFV_WARN("Couldn't open {0} for writing!", path.string());
+        return false;
+    }
+
+    std::string fileList;
+    for (U32 i = 0; i < files.size(); i++)
+    {
+        fileList += std::format("{0}\"{1}\"", i == 0 ? "" : ", ", files[i].generic_string());
+    }
+
+    file << std::format("{{\n    \"files\": [{0}],\n    \"iterations\": {1},\n    \"threads\": {2},\n    \"stages\": [",
+                        fileList, iterations, JobSystem::GetNumThreads());
+
+    for (U32 i = 0; i < results.size(); i++)
+    {
+        const StageResult& result = results[i];
+        const F64 seconds = std::max(result.Ms.P50, 1e-6) * 1e-3;
+
+        std::string metrics;
+        for (const auto& [name, value] : result.Metrics)
+        {
+            metrics += std::format(", \"{0}\": {1:.4f}", name, value);
+        }
+
+        file << std::format("{0}\n        {{ \"name\": \"{1}\", \"bytes\": {2}, \"triangles\": {3}, \"ms\": {4}, "
+                            "\"mbPerSecond\": {5:.2f}, \"trianglesPerSecond\": {6:.0f}, \"peakRssBytes\": {7}{8} }}",
+                            i == 0 ? "" : ",", result.Name, result.Bytes, result.Triangles,
+                            BenchUtil::FormatPercentilesJson(result.Ms), result.Bytes * 1e-6 / seconds,
+                            result.Triangles / seconds, result.PeakRssBytes, metrics);
+    }
+    file << "\n    ]\n}\n";
+
+    FFV_LOG("Wrote the benchmark report to {0}", path.string());
+    return static_cast<bool>(file);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Deduplicates rotated and translated copies of a random mesh far from the origin, where rounding makes the copies
+ * differ in their low bits, plus a slightly scaled copy that has to stay separate.
+ * @return: false if the copies weren't found or the scaled copy was merged
+ */
+static bool CheckDeduplication()
+{
+    constexpr U32 numVertices = 2000;
+    constexpr U32 numCopies = 200;
+    const glm::vec3 center(1000.0f, -2000.0f, 500.0f);
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<F32> distribution(-1.0f, 1.0f);
+    const auto randomVector = [&]() { return glm::vec3(distribution(random), distribution(random), distribution(random)); };
+
+    MeshData part;
+    for (U32 i = 0; i < numVertices; i++)
+    {
+        part.Positions.push_back(randomVector());
+        part.Normals.push_back(glm::normalize(randomVector() + glm::vec3(0.0f, 0.0f, 2.0f)));
+    }
+    for (U32 i = 0; i < numVertices * 2; i++)
+    {
+        part.Indices.push_back(static_cast<U32>(random() % numVertices));
+    }
+
+    std::vector<MeshData> meshes;
+    for (U32 i = 0; i < numCopies; i++)
+    {
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), center + randomVector() * 100.0f);
+        transform = glm::rotate(transform, distribution(random) * glm::pi<F32>(), glm::normalize(randomVector()));
+        meshes.push_back(MeshGenerator::Transform(part, transform));
+    }
+    meshes.push_back(MeshGenerator::Transform(part, glm::scale(glm::translate(glm::mat4(1.0f), center),
+                                                                glm::vec3(1.01f))));
+
+    const MeshDeduplicator::Result result = MeshDeduplicator::Deduplicate(meshes);
+    if (result.Meshes.size() != 2)
+    {
+        FFV_ERROR("Deduplicating {0} transformed copies and a scaled copy gave {1} unique meshes instead of 2!",
+                  numCopies, result.Meshes.size());
+        return false;
+    }
+
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Options:
+ *     --corpus <inputs...>           real models, anything BatchExporter::CollectFiles accepts
+ *     --synthetic-triangles <count>  size of the generated models, 1M by default
+ *     --no-synthetic                 only benchmarks the corpus
+ *     --work-dir <directory>         where the generated models are cached, a temporary directory by default
+ *     --iterations <count>           runs per stage, 5 by default
+ *     --out <file>                   JSON report, import_bench.json by default
+ */
+static I32 RunBenchmark(const std::vector<std::string>& args)
+{
+    const std::string iterationsArgument = BenchUtil::GetArgumentValue(args, "--iterations");
+    const std::string trianglesArgument = BenchUtil::GetArgumentValue(args, "--synthetic-triangles");
+    const std::string workDirArgument = BenchUtil::GetArgumentValue(args, "--work-dir");
+    const std::string outputArgument = BenchUtil::GetArgumentValue(args, "--out");
+    const U32 iterations =
+        std::max(static_cast<U32>(iterationsArgument.empty() ? 5 : BenchUtil::ParseCount(iterationsArgument)), 1u);
+
+    // Timing a deduplication that misses its duplicates would be meaningless
+    if (!CheckDeduplication())
+    {
+        return 1;
+    }
+
+    std::vector<std::filesystem::path> files = BatchExporter::CollectFiles(BenchUtil::GetArgumentValues(args, "--corpus"));
+    if (!BenchUtil::HasArgument(args, "--no-synthetic"))
+    {
+        const U64 numTriangles = trianglesArgument.empty() ? 1'000'000 : BenchUtil::ParseCount(trianglesArgument);
+        const std::filesystem::path workDir = workDirArgument.empty()
+                                                  ? std::filesystem::temp_directory_path() / "FastFileViewerImportBench"
+                                                  : std::filesystem::path(workDirArgument);
+        const std::vector<std::filesystem::path> syntheticFiles =
+            CreateSyntheticCorpus(workDir, std::max<U64>(numTriangles, 1'000));
+        files.insert(files.end(), syntheticFiles.begin(), syntheticFiles.end());
+    }
+
+    if (files.empty())
+    {
+        FFV_ERROR("There are no files to benchmark!");
+        return 1;
+    }
+
+    // Loaded once up front, so the parse and processing stages don't include reading
+    std::vector<std::string> contents;
+    std::vector<std::vector<MeshData>> imported;
+    U64 totalBytes = 0;
+    U64 totalTriangles = 0;
+    U64 totalMeshBytes = 0;
+    for (const std::filesystem::path& file : files)
+    {
+        contents.push_back(ReadWithIfstream(file));
+        std::vector<MeshData>& meshes = imported.emplace_back();
+        ObjImporter::Parse(contents.back(), meshes);
+
+        totalBytes += contents.back().size();
+        totalTriangles += CountTriangles(meshes);
+        for (const MeshData& mesh : meshes)
+        {
+            totalMeshBytes += mesh.GetSizeInBytes();
+        }
+    }
+
+    FFV_LOG("Import benchmark over {0} files ({1:.1f} MB, {2} triangles), {3} iterations per stage, {4} threads",
+            files.size(), totalBytes / 1e6, totalTriangles, iterations, JobSystem::GetNumThreads());
+
+    // Reads run against a warm page cache after the loading above, so they measure the read path rather than the disk
+    std::vector<StageResult> results;
+    results.push_back(RunStage("read/ifstream", totalBytes, 0, iterations,
+                               [&](U32)
+                               {
+                                   U64 sum = 0;
+                                   for (const std::filesystem::path& file : files)
+                                   {
+                                       sum += TouchPages(ReadWithIfstream(file));
+                                   }
+                                   return sum;
+                               }));
+    results.push_back(RunStage("read/stdio", totalBytes, 0, iterations,
+                               [&](U32)
+                               {
+                                   U64 sum = 0;
+                                   for (const std::filesystem::path& file : files)
+                                   {
+                                       sum += TouchPages(ReadWithStdio(file));
+                                   }
+                                   return sum;
+                               }));
+    results.push_back(RunStage("read/mmap", totalBytes, 0, iterations,
+                               [&](U32)
+                               {
+                                   U64 sum = 0;
+                                   for (const std::filesystem::path& file : files)
+                                   {
+                                       sum += TouchPages(MappedFile(file).GetData());
+                                   }
+                                   return sum;
+                               }));
+
+    results.push_back(RunStage("parse/obj", totalBytes, totalTriangles, iterations,
+                               [&](U32)
+                               {
+                                   U64 triangles = 0;
+                                   for (const std::string& content : contents)
+                                   {
+                                       std::vector<MeshData> meshes;
+                                       ObjImporter::Parse(content, meshes);
+                                       triangles += CountTriangles(meshes);
+                                   }
+                                   return triangles;
+                               }));
+    results.push_back(RunStage("import/obj", totalBytes, totalTriangles, iterations,
+                               [&](U32)
+                               {
+                                   U64 triangles = 0;
+                                   for (const std::filesystem::path& file : files)
+                                   {
+                                       std::vector<MeshData> meshes;
+                                       ObjImporter::Import(file, meshes);
+                                       triangles += CountTriangles(meshes);
+                                   }
+                                   return triangles;
+                               }));
+    results.push_back(RunStage("import/obj-mmap", totalBytes, totalTriangles, iterations,
+                               [&](U32)
+                               {
+                                   U64 triangles = 0;
+                                   for (const std::filesystem::path& file : files)
+                                   {
+                                       std::vector<MeshData> meshes;
+                                       ObjImporter::Parse(MappedFile(file).GetData(), meshes);
+                                       triangles += CountTriangles(meshes);
+                                   }
+                                   return triangles;
+                               }));
+
+    results.push_back(RunStage("process/normals", totalMeshBytes, totalTriangles, iterations,
+                               [&](U32)
+                               {
+                                   U64 numNormals = 0;
+                                   for (std::vector<MeshData>& meshes : imported)
+                                   {
+                                       for (MeshData& mesh : meshes)
+                                       {
+                                           ObjImporter::GenerateNormals(mesh);
+                                           numNormals += mesh.Normals.size();
+                                       }
+                                   }
+                                   return numNormals;
+                               }));
+    results.push_back(RunStage("process/deduplicate", totalMeshBytes, totalTriangles, iterations,
+                               [&](U32)
+                               {
+                                   U64 numUnique = 0;
+                                   for (const std::vector<MeshData>& meshes : imported)
+                                   {
+                                       if (!meshes.empty())
+                                       {
+                                           numUnique += MeshDeduplicator::Deduplicate(meshes).Meshes.size();
+                                       }
+                                   }
+                                   return numUnique;
+                               }));
+
+    // One hierarchy per file over all of its meshes, which is what picking or ray tracing the model needs
+    std::vector<MeshData> mergedFiles;
+    U64 mergedBytes = 0;
+    for (const std::vector<MeshData>& meshes : imported)
+    {
+        mergedBytes += mergedFiles.emplace_back(MergeMeshes(meshes)).GetSizeInBytes();
+    }
+
+    Bvh::Stats bvhStats;
+    F64 weightedSahCost = 0.0;
+    StageResult& bvhResult = results.emplace_back(RunStage(
+        "process/bvh", mergedBytes, totalTriangles, iterations,
+        [&](U32)
+        {
+            bvhStats = {};
+            weightedSahCost = 0.0;
+            for (const MeshData& mesh : mergedFiles)
+            {
+                const Bvh bvh(mesh.Positions, mesh.Indices);
+                const Bvh::Stats& stats = bvh.GetStats();
+                bvhStats.TriangleCount += stats.TriangleCount;
+                bvhStats.NodeCount += stats.NodeCount;
+                bvhStats.LeafCount += stats.LeafCount;
+                weightedSahCost += stats.SahCost * stats.TriangleCount;
+            }
+            return bvhStats.NodeCount;
+        }));
+
+    // The cost grows with the triangle count, so files are weighted by theirs
+    bvhStats.SahCost = bvhStats.TriangleCount > 0 ? weightedSahCost / bvhStats.TriangleCount : 0.0;
+    bvhResult.Metrics = { { "sahCost", bvhStats.SahCost },
+                          { "nodes", static_cast<F64>(bvhStats.NodeCount) },
+                          { "leaves", static_cast<F64>(bvhStats.LeafCount) } };
+    FFV_LOG("{0:<24} SAH cost {1:.2f}, {2} nodes, {3} leaves", bvhResult.Name, bvhStats.SahCost, bvhStats.NodeCount,
+            bvhStats.LeafCount);
+
+    const std::filesystem::path outputPath = outputArgument.empty() ? "import_bench.json" : outputArgument;
+    return WriteReport(outputPath, files, iterations, results) ? 0 : 1;
+}
+} // namespace FFV
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+    FFV::Log::Init();
+    FFV::JobSystem::Init();
+
+    const I32 result = FFV::RunBenchmark(std::vector<std::string>(argv + 1, argv + argc));
+
+    FFV::JobSystem::Shutdown();
+    return result;
+}
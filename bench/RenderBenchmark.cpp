@@ -0,0 +1,402 @@
+#include "FastFileViewerPCH.h"
+
+#include "BenchUtil.h"
+#include "import/ObjImporter.h"
+#include "renderer/Renderer.h"
+#include "scene/MeshGenerator.h"
+#include "util/JobSystem.h"
+#include "util/Log.h"
+#include "util/Types.h"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <optional>
+
+namespace FFV
+{
+// Larger generated scenes are split into instances of this size, so the geometry always fits into the geometry pool
+static constexpr U64 s_MaxTrianglesPerMesh = 100'000;
+static constexpr std::array<U64, 6> s_DefaultTriangleCounts = { 1'000,     10'000,     100'000,
+                                                                1'000'000, 10'000'000, 100'000'000 };
+
+struct BenchmarkSettings
+{
+    VkExtent2D Extent = { 1280, 720 };
+    U32 NumFrames = 300;
+    U32 NumWarmupFrames = 30;
+    bool DepthPrePass = false;
+    bool OcclusionCulling = true;
+    bool CpuPathTracing = false;
+    bool RayTracing = false;
+    std::filesystem::path OutputPath = "bench.json";
+};
+
+struct BenchmarkScene
+{
+    std::string Name;
+    std::vector<MeshData> Meshes;
+    std::vector<MeshDeduplicator::Instance> Instances; // Empty if the meshes still have to be deduplicated
+    U64 NumTriangles = 0;
+};
+
+struct SceneResult
+{
+    std::string Name;
+    U64 NumTriangles = 0;
+    U32 NumObjects = 0;
+    F64 LoadMs = 0.0;
+    BenchUtil::Percentiles FrameMs;
+    BenchUtil::Percentiles CpuMs;
+    BenchUtil::Percentiles GpuMs;
+    // Per frame averages of the cull stats
+    F64 DrawnTriangles = 0.0;
+    F64 FrustumCulledTriangles = 0.0;
+    F64 OccludedTriangles = 0.0;
+    // Rays of all measured frames over their trace time, 0 when rasterized
+    F64 MraysPerSecond = 0.0;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * A cubic grid of spheres that together have about the requested number of triangles. The spheres occlude each other
+ * like the parts of a dense model and only one sphere mesh gets uploaded.
+ */
+static BenchmarkScene CreateSphereGrid(U64 numTriangles)
+{
+    const U64 numInstances = std::max<U64>((numTriangles + s_MaxTrianglesPerMesh - 1) / s_MaxTrianglesPerMesh, 1);
+    const U64 trianglesPerSphere = std::max<U64>(numTriangles / numInstances, 8);
+
+    // A sphere with s segments and s / 2 rings has s * (s - 2) triangles
+    const U32 segments = std::max(static_cast<U32>(std::lround(1.0 + std::sqrt(1.0 + trianglesPerSphere))) & ~1u, 4u);
+    const MeshData sphere = MeshGenerator::CreateSphere(segments, segments / 2);
+
+    BenchmarkScene scene = { .Name = std::format("spheres_{0}", BenchUtil::FormatCount(numTriangles)) };
+    scene.Meshes.push_back(sphere);
+
+    const U32 gridSize = static_cast<U32>(std::ceil(std::cbrt(static_cast<F64>(numInstances))));
+    constexpr F32 spacing = 1.25f;
+    const glm::vec3 gridCenter = glm::vec3(static_cast<F32>(gridSize - 1) * spacing * 0.5f);
+
+    scene.Instances.reserve(numInstances);
+    for (U64 i = 0; i < numInstances; i++)
+    {
+        const glm::vec3 cell = { static_cast<F32>(i % gridSize), static_cast<F32>(i / gridSize % gridSize),
+                                 static_cast<F32>(i / gridSize / gridSize) };
+        scene.Instances.push_back(
+            { .MeshIndex = 0, .Transform = glm::translate(glm::mat4(1.0f), cell * spacing - gridCenter) });
+    }
+
+    scene.NumTriangles = numInstances * (sphere.Indices.size() / 3);
+    return scene;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * The camera path only depends on the frame, so every run renders exactly the same images: one orbit around the scene
+ * while the elevation swings between 15 and 45 degrees.
+ */
+static void SetCamera(Renderer& renderer, U32 frame, U32 numFrames)
+{
+    const F32 t = static_cast<F32>(frame) / static_cast<F32>(std::max(numFrames, 1u));
+    renderer.FitCameraToScene(360.0f * t, 30.0f + 15.0f * std::sin(glm::two_pi<F32>() * t));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::optional<SceneResult> RunScene(Renderer& renderer, const BenchmarkScene& scene,
+                                           const BenchmarkSettings& settings)
+{
+    const auto loadStartTime = std::chrono::steady_clock::now();
+    const bool loaded = scene.Instances.empty() ? renderer.LoadScene(scene.Meshes)
+                                                : renderer.LoadScene(scene.Meshes, scene.Instances);
+    if (!loaded)
+    {
+        FFV_WARN("Skipped {0}, it has no geometry or doesn't fit into the geometry pool!", scene.Name);
+        return std::nullopt;
+    }
+    const F64 loadMs = std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - loadStartTime).count();
+
+    // GPU timings of a frame are collected when its frame index gets reused, so the first samples after the warmup
+    // still belong to warmup frames and the last measured frames need as many frames after them
+    const U32 framesInFlight = renderer.GetFramesInFlight();
+    const U32 numWarmupFrames = std::max(settings.NumWarmupFrames, framesInFlight);
+
+    for (U32 frame = 0; frame < numWarmupFrames; frame++)
+    {
+        SetCamera(renderer, frame, settings.NumFrames);
+        renderer.Update();
+    }
+    renderer.FinishReadbacks();
+
+    std::vector<F64> frameMs;
+    std::vector<F64> cpuMs;
+    std::vector<F64> gpuMs;
+    frameMs.reserve(settings.NumFrames);
+    cpuMs.reserve(settings.NumFrames);
+    gpuMs.reserve(settings.NumFrames + framesInFlight);
+
+    renderer.SetGpuSampleCallback(
+        [&gpuMs](const char* name, F64 milliseconds)
+        {
+            if (std::string_view(name) == "Frame")
+            {
+                gpuMs.push_back(milliseconds);
+            }
+        });
+
+    // Like the GPU timings the cull stats arrive a few frames late, so they are summed over the same frames
+    F64 drawnTriangles = 0.0;
+    F64 frustumCulledTriangles = 0.0;
+    F64 occludedTriangles = 0.0;
+    F64 tracedRays = 0.0;
+    F64 traceMs = 0.0;
+
+    auto lastFrameTime = std::chrono::steady_clock::now();
+    for (U32 frame = 0; frame < settings.NumFrames + framesInFlight; frame++)
+    {
+        SetCamera(renderer, frame, settings.NumFrames);
+        renderer.Update();
+
+        if (frame >= framesInFlight)
+        {
+            const CullingPass::CullStats& cullStats = renderer.GetCullStats();
+            drawnTriangles += static_cast<F64>(cullStats.DrawnTriangles);
+            frustumCulledTriangles +=
+                static_cast<F64>(cullStats.Triangles - std::min(cullStats.FrustumVisibleTriangles, cullStats.Triangles));
+            occludedTriangles += static_cast<F64>(cullStats.OccludedTriangles);
+        }
+
+        if (frame < settings.NumFrames)
+        {
+            tracedRays += static_cast<F64>(renderer.GetPathTracerStats().RayCount);
+            traceMs += renderer.GetPathTracerStats().RenderMs;
+        }
+
+        const auto currentTime = std::chrono::steady_clock::now();
+        if (frame < settings.NumFrames)
+        {
+            frameMs.push_back(std::chrono::duration<F64, std::milli>(currentTime - lastFrameTime).count());
+            cpuMs.push_back(renderer.GetLastCpuMs());
+        }
+        lastFrameTime = currentTime;
+    }
+    renderer.FinishReadbacks();
+    renderer.SetGpuSampleCallback(nullptr);
+
+    gpuMs.erase(gpuMs.begin(), gpuMs.begin() + std::min<I64>(framesInFlight, static_cast<I64>(gpuMs.size())));
+    gpuMs.resize(std::min<U64>(gpuMs.size(), settings.NumFrames));
+
+    const SceneResult result = { .Name = scene.Name,
+                                 .NumTriangles = scene.NumTriangles,
+                                 .NumObjects = static_cast<U32>(scene.Instances.empty() ? scene.Meshes.size()
+                                                                                        : scene.Instances.size()),
+                                 .LoadMs = loadMs,
+                                 .FrameMs = BenchUtil::ComputePercentiles(frameMs),
+                                 .CpuMs = BenchUtil::ComputePercentiles(cpuMs),
+                                 .GpuMs = BenchUtil::ComputePercentiles(gpuMs),
+                                 .DrawnTriangles = drawnTriangles / settings.NumFrames,
+                                 .FrustumCulledTriangles = frustumCulledTriangles / settings.NumFrames,
+                                 .OccludedTriangles = occludedTriangles / settings.NumFrames,
+                                 .MraysPerSecond = settings.CpuPathTracing && traceMs > 0.0
+                                                       ? tracedRays / (traceMs * 1000.0)
+                                                       : 0.0 };
+
+    FFV_LOG("{0:<16} {1:>12} triangles  frame p50/p95/p99 {2:8.3f} / {3:8.3f} / {4:8.3f} ms  cpu p50 {5:7.3f} ms  "
+            "gpu p50 {6:8.3f} ms  drawn {7:5.1f}%",
+            result.Name, result.NumTriangles, result.FrameMs.P50, result.FrameMs.P95, result.FrameMs.P99,
+            result.CpuMs.P50, result.GpuMs.P50,
+            result.NumTriangles == 0 ? 0.0 : 100.0 * result.DrawnTriangles / static_cast<F64>(result.NumTriangles));
+    if (settings.CpuPathTracing)
+    {
+        FFV_LOG("{0:<16} CPU path tracing {1:.2f} Mrays/s", result.Name, result.MraysPerSecond);
+    }
+    return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool WriteReport(const std::filesystem::path& path, const Renderer& renderer, const BenchmarkSettings& settings,
+                        const std::vector<SceneResult>& results)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        FFV_WARN("Couldn't open {0} for writing!", path.string());
+        return false;
+    }
+
+    file << std::format("{{\n    \"device\": \"{0}\",\n    \"width\": {1},\n    \"height\": {2},\n    \"frames\": {3},\n"
+                        "    \"warmupFrames\": {4},\n    \"gpuTimestamps\": {5},\n    \"depthPrePass\": {6},\n"
+                        "    \"occlusionCulling\": {7},\n    \"cpuPathTracing\": {8},\n    \"rayTracing\": {9},\n"
+                        "    \"scenes\": [",
+                        renderer.GetDeviceName(), settings.Extent.width, settings.Extent.height, settings.NumFrames,
+                        settings.NumWarmupFrames, renderer.IsGpuProfilingSupported() ? "true" : "false",
+                        settings.DepthPrePass ? "true" : "false", settings.OcclusionCulling ? "true" : "false",
+                        settings.CpuPathTracing ? "true" : "false", settings.RayTracing ? "true" : "false");
+
+    for (U32 i = 0; i < results.size(); i++)
+    {
+        const SceneResult& result = results[i];
+        file << std::format("{0}\n        {{\n            \"name\": \"{1}\",\n            \"triangles\": {2},\n"
+                            "            \"objects\": {3},\n            \"loadMs\": {4:.3f},\n",
+                            i == 0 ? "" : ",", result.Name, result.NumTriangles, result.NumObjects, result.LoadMs);
+        file << std::format("            \"drawnTriangles\": {0:.0f},\n            \"frustumCulledTriangles\": {1:.0f},\n"
+                            "            \"occludedTriangles\": {2:.0f},\n            \"mraysPerSecond\": {3:.3f},\n",
+                            result.DrawnTriangles, result.FrustumCulledTriangles, result.OccludedTriangles,
+                            result.MraysPerSecond);
+        file << std::format("            \"frameMs\": {0},\n            \"cpuMs\": {1},\n            \"gpuMs\": {2}\n"
+                            "        }}",
+                            BenchUtil::FormatPercentilesJson(result.FrameMs),
+                            BenchUtil::FormatPercentilesJson(result.CpuMs),
+                            BenchUtil::FormatPercentilesJson(result.GpuMs));
+    }
+    file << "\n    ]\n}\n";
+
+    FFV_LOG("Wrote the benchmark report to {0}", path.string());
+    return static_cast<bool>(file);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Options:
+ *     --models <files...>           benchmarks OBJ files instead of the generated scenes
+ *     --triangles <counts...>       generated scene sizes, e.g. 1K 1M, defaults to 1K up to 100M
+ *     --max-triangles <count>       skips larger generated scenes, e.g. on software rasterizers
+ *     --frames <count>              measured frames per scene, 300 by default
+ *     --warmup <count>              unmeasured frames before, 30 by default
+ *     --width <pixels> --height <pixels>
+ *     --depth-prepass               renders depth only before shading
+ *     --no-occlusion-culling        only culls against the frustum
+ *     --cpu-path-tracing            path traces on the CPU instead of rasterizing, reports the Mrays/s
+ *     --ray-tracing                 ray traces with the GPU instead of rasterizing, needs hardware ray tracing
+ *     --out <file>                  JSON report, bench.json by default
+ */
+static I32 RunBenchmark(const std::vector<std::string>& args)
+{
+    BenchmarkSettings settings;
+    const std::string widthArgument = BenchUtil::GetArgumentValue(args, "--width");
+    const std::string heightArgument = BenchUtil::GetArgumentValue(args, "--height");
+    const std::string framesArgument = BenchUtil::GetArgumentValue(args, "--frames");
+    const std::string warmupArgument = BenchUtil::GetArgumentValue(args, "--warmup");
+    const std::string outputArgument = BenchUtil::GetArgumentValue(args, "--out");
+    settings.Extent.width =
+        widthArgument.empty() ? settings.Extent.width : static_cast<U32>(BenchUtil::ParseCount(widthArgument));
+    settings.Extent.height =
+        heightArgument.empty() ? settings.Extent.height : static_cast<U32>(BenchUtil::ParseCount(heightArgument));
+    settings.NumFrames =
+        framesArgument.empty() ? settings.NumFrames : static_cast<U32>(BenchUtil::ParseCount(framesArgument));
+    settings.NumWarmupFrames =
+        warmupArgument.empty() ? settings.NumWarmupFrames : static_cast<U32>(std::max(std::atoi(warmupArgument.c_str()), 0));
+    settings.OutputPath = outputArgument.empty() ? settings.OutputPath : std::filesystem::path(outputArgument);
+    settings.DepthPrePass = BenchUtil::HasArgument(args, "--depth-prepass");
+    settings.OcclusionCulling = !BenchUtil::HasArgument(args, "--no-occlusion-culling");
+    settings.CpuPathTracing = BenchUtil::HasArgument(args, "--cpu-path-tracing");
+    settings.RayTracing = !settings.CpuPathTracing && BenchUtil::HasArgument(args, "--ray-tracing");
+    if (settings.Extent.width == 0 || settings.Extent.height == 0 || settings.NumFrames == 0)
+    {
+        FFV_ERROR("The benchmark needs a size and at least one frame!");
+        return 1;
+    }
+
+    std::vector<U64> triangleCounts(s_DefaultTriangleCounts.begin(), s_DefaultTriangleCounts.end());
+    const std::vector<std::string> trianglesArguments = BenchUtil::GetArgumentValues(args, "--triangles");
+    if (!trianglesArguments.empty())
+    {
+        triangleCounts.clear();
+        for (const std::string& argument : trianglesArguments)
+        {
+            const U64 count = BenchUtil::ParseCount(argument);
+            if (count == 0)
+            {
+                FFV_WARN("Skipped the invalid triangle count {0}!", argument);
+                continue;
+            }
+            triangleCounts.push_back(count);
+        }
+    }
+
+    const std::string maxTrianglesArgument = BenchUtil::GetArgumentValue(args, "--max-triangles");
+    if (!maxTrianglesArgument.empty())
+    {
+        const U64 maxTriangles = BenchUtil::ParseCount(maxTrianglesArgument);
+        std::erase_if(triangleCounts, [maxTriangles](U64 count) { return count > maxTriangles; });
+    }
+
+    Renderer renderer(settings.Extent);
+    renderer.SetDepthPrePass(settings.DepthPrePass);
+    renderer.SetOcclusionCulling(settings.OcclusionCulling);
+    if (settings.CpuPathTracing)
+    {
+        renderer.SetRenderMode(Renderer::RenderMode::CpuPathTraced);
+        settings.CpuPathTracing = renderer.GetRenderMode() == Renderer::RenderMode::CpuPathTraced;
+    }
+    else if (settings.RayTracing)
+    {
+        renderer.SetRenderMode(Renderer::RenderMode::RayTraced);
+        settings.RayTracing = renderer.GetRenderMode() == Renderer::RenderMode::RayTraced;
+    }
+    FFV_LOG("Rendering benchmark on {0} at {1}x{2}, {3} frames per scene", renderer.GetDeviceName(),
+            settings.Extent.width, settings.Extent.height, settings.NumFrames);
+
+    std::vector<SceneResult> results;
+    const std::vector<std::string> modelArguments = BenchUtil::GetArgumentValues(args, "--models");
+    if (!modelArguments.empty())
+    {
+        for (const std::string& model : modelArguments)
+        {
+            BenchmarkScene scene = { .Name = std::filesystem::path(model).filename().string() };
+            if (!ObjImporter::Import(model, scene.Meshes))
+            {
+                continue;
+            }
+
+            for (const MeshData& mesh : scene.Meshes)
+            {
+                scene.NumTriangles += mesh.Indices.size() / 3;
+            }
+
+            if (const std::optional<SceneResult> result = RunScene(renderer, scene, settings))
+            {
+                results.push_back(*result);
+            }
+        }
+    }
+    else
+    {
+        for (const U64 triangleCount : triangleCounts)
+        {
+            if (const std::optional<SceneResult> result = RunScene(renderer, CreateSphereGrid(triangleCount), settings))
+            {
+                results.push_back(*result);
+            }
+        }
+    }
+
+    if (results.empty())
+    {
+        FFV_ERROR("No scene could be benchmarked!");
+        return 1;
+    }
+
+    return WriteReport(settings.OutputPath, renderer, settings, results) ? 0 : 1;
+}
+} // namespace FFV
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+    FFV::Log::Init();
+    FFV::JobSystem::Init();
+
+    const I32 result = FFV::RunBenchmark(std::vector<std::string>(argv + 1, argv + argc));
+
+    FFV::JobSystem::Shutdown();
+    return result;
+}
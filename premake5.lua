@@ -1,5 +1,15 @@
 require("external/premake/premake_extensions/ecc/ecc")
 
+newoption({
+	trigger = "profiling",
+	description = "Compile the CPU profiling scopes in, traces can then be written as Chrome trace JSON",
+})
+
+newoption({
+	trigger = "ray-tracing",
+	description = "Allow the hardware ray tracing render mode, which hasn't been validated on a device yet",
+})
+
 workspace("FastFileViewer")
 architecture("x86_64")
 startproject("FastFileViewer")
@@ -14,97 +24,142 @@ VULKAN_SDK = os.getenv("VULKAN_SDK")
 
 include("external")
 
+-- Everything the viewer and the benchmarks share
+
+function FastFileViewerProject()
+	kind("ConsoleApp")
+	language("C++")
+	cppdialect("C++23")
+
+	targetdir("%{wks.location}/bin/" .. outputdir .. "/%{prj.name}")
+	objdir("%{wks.location}/bin-int/" .. outputdir .. "/%{prj.name}")
+
+	pchheader("FastFileViewerPCH.h")
+	pchsource("src/FastFileViewerPCH.cpp")
+
+	files({
+		"src/**.h",
+		"src/**.cpp",
+		"external/glm/glm/**.hpp",
+		"external/glm/glm/**.inl",
+	})
+
+	includedirs({
+		"src/",
+		"external/GLFW/include",
+		"%{VULKAN_SDK}/include",
+		"external/glm",
+		"external/spdlog/include",
+		"external/imgui",
+	})
+
+	libdirs({
+		"%{VULKAN_SDK}/lib",
+	})
+
+	links({
+		"GLFW",
+	})
+
+	defines({
+		"GLFW_INCLUDE_NONE",
+		"GLFW_INCLUDE_VULKAN",
+	})
+
+	-- Linux
+
+	filter("system:linux")
+	defines("FFV_LINUX")
+	toolset("clang")
+	buildoptions({
+		"-Wall",
+	})
+	links({
+		"vulkan",
+	})
+
+	prebuildcommands({
+		"python3 scripts/CompileShaders.py",
+	})
+
+	filter({ "system:linux", "configurations:Release" })
+	buildoptions({
+		"-Werror",
+	})
+
+	-- Windows
+
+	filter("system:windows")
+	defines("FFV_WINDOWS")
+	links({
+		"vulkan-1",
+	})
+	buildoptions({
+		"/W4",
+		"/MP",
+	})
+
+	prebuildcommands({
+		"python scripts/CompileShaders.py",
+	})
+
+	filter({ "system:windows", "configurations:Release" })
+	buildoptions({
+		"/WX",
+	})
+
+	-- Configurations
+
+	filter("configurations:Debug")
+	defines("FFV_DEBUG")
+	runtime("Debug")
+	symbols("on")
+
+	filter("configurations:Release")
+	defines("FFV_RELEASE")
+	runtime("Release")
+	optimize("on")
+
+	-- Options
+
+	filter("options:profiling")
+	defines("FFV_ENABLE_PROFILING")
+
+	filter("options:ray-tracing")
+	defines("FFV_ENABLE_RAY_TRACING")
+
+	filter({})
+end
+
 project("FastFileViewer")
-kind("ConsoleApp")
-language("C++")
-cppdialect("C++23")
+FastFileViewerProject()
 
-targetdir("%{wks.location}/bin/" .. outputdir .. "/%{prj.name}")
-objdir("%{wks.location}/bin-int/" .. outputdir .. "/%{prj.name}")
+filter({ "system:windows", "configurations:Release" })
+kind("WindowedApp")
+filter({})
 
-pchheader("FastFileViewerPCH.h")
-pchsource("src/FastFileViewerPCH.cpp")
+-- Renders generated or loaded scenes headless along a fixed camera path and writes frame time percentiles as JSON
 
+project("FastFileViewerBench")
+FastFileViewerProject()
 files({
-	"src/**.h",
-	"src/**.cpp",
-	"external/glm/glm/**.hpp",
-	"external/glm/glm/**.inl",
-})
-
-includedirs({
-	"src/",
-	"external/GLFW/include",
-	"%{VULKAN_SDK}/include",
-	"external/glm",
-	"external/spdlog/include",
-	"external/imgui",
-})
-
-libdirs({
-	"%{VULKAN_SDK}/lib",
-})
-
-links({
-	"GLFW",
-})
-
-defines({
-	"GLFW_INCLUDE_NONE",
-	"GLFW_INCLUDE_VULKAN",
-})
-
--- Linux
-
-filter("system:linux")
-defines("FFV_LINUX")
-toolset("clang")
-buildoptions({
-	"-Wall",
-})
-links({
-	"vulkan",
-})
-
-prebuildcommands({
-	"python3 scripts/CompileShaders.py",
+	"bench/BenchUtil.h",
+	"bench/BenchUtil.cpp",
+	"bench/RenderBenchmark.cpp",
 })
-
-filter({ "system:linux", "configurations:Release" })
-buildoptions({
-	"-Werror",
+removefiles({
+	"src/Main.cpp",
 })
 
--- Windows
-
-filter("system:windows")
-defines("FFV_WINDOWS")
-links({
-	"vulkan-1",
-})
-buildoptions({
-	"/W4",
-	"/MP",
-})
+-- Measures reading, importing and processing model files on the CPU, independent of rendering
 
-prebuildcommands({
-	"python scripts/CompileShaders.py",
+project("FastFileViewerImportBench")
+FastFileViewerProject()
+files({
+	"bench/BenchUtil.h",
+	"bench/BenchUtil.cpp",
+	"bench/ImportBenchmark.cpp",
 })
-
-filter({ "system:windows", "configurations:Release" })
-kind("WindowedApp")
-buildoptions({
-	"/WX",
+removefiles({
+	"src/Main.cpp",
 })
-
--- Configurations
-
-filter("configurations:Debug")
-defines("FFV_DEBUG")
-runtime("Debug")
-symbols("on")
-
-filter("configurations:Release")
-defines("FFV_RELEASE")
-runtime("Release")
-optimize("on")
@@ -2,22 +2,72 @@
 
 #include "Application.h"
 
+#include "export/BatchExporter.h"
+#include "import/ObjImporter.h"
+#include "util/JobSystem.h"
 #include "util/Log.h"
+#include "util/Profiler.h"
 #include "util/Types.h"
 #include "util/Util.h"
 
 #include <GLFW/glfw3.h>
+#include <charconv>
+#include <chrono>
 
 namespace FFV
 {
 Application* Application::s_Instance = nullptr;
 
-Application::Application()
+// Exports have no latency to care about, more frames in flight let the GPU run further ahead of the encoders
+static constexpr U32 s_ExportFramesInFlight = 4;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Parses image sizes and frame counts, atoi would silently turn typos into 0 and negative values into huge counts
+ * @return: the value, 0 if it isn't a positive integer
+ */
+static U32 ParsePositiveInteger(const std::string& value)
+{
+    U32 result = 0;
+    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+    return error == std::errc() && end == value.data() + value.size() ? result : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Application::Application(const std::vector<std::string>& args) : m_Args(args)
 {
     FFV_ASSERT(!s_Instance, "Application already exists!", return);
     s_Instance = this;
 
     Log::Init();
+    FFV_PROFILE_THREAD("Main");
+    JobSystem::Init();
+
+    m_Headless = HasArgument("--headless") || HasArgument("--batch") || HasArgument("--turntable");
+    if (m_Headless)
+    {
+        const std::string widthArgument = GetArgumentValue("--width");
+        const std::string heightArgument = GetArgumentValue("--height");
+        const VkExtent2D extent = { widthArgument.empty() ? 1920u : ParsePositiveInteger(widthArgument),
+                                    heightArgument.empty() ? 1080u : ParsePositiveInteger(heightArgument) };
+        if (extent.width == 0 || extent.height == 0)
+        {
+            FFV_ERROR("--width and --height have to be positive integers, got {0}x{1}!",
+                      widthArgument.empty() ? "1920" : widthArgument, heightArgument.empty() ? "1080" : heightArgument);
+            exit(1);
+        }
+
+        m_Renderer = MakeShared<Renderer>(extent, HasArgument("--turntable") ? s_ExportFramesInFlight
+                                                                            : Queue::DefaultFramesInFlight);
+        // Exports never switch the render mode, so their scenes don't need the CPU copy for path tracing
+        if (HasArgument("--batch") || HasArgument("--turntable"))
+        {
+            m_Renderer->SetKeepSceneMeshes(false);
+        }
+        return;
+    }
 
     FFV_ASSERT(glfwInit(), "Couldn't initilize GLFW!", exit(1));
 
@@ -25,23 +75,312 @@ Application::Application()
     glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
     m_Window = MakeShared<Window>("Fast file viewer", 800, 600);
-    m_Renderer = MakeShared<Renderer>(m_Window);
+    PresentPolicy presentPolicy = PresentPolicy::Mailbox;
+    const std::string presentArgument = GetArgumentValue("--present");
+    if (presentArgument == "vsync")
+    {
+        presentPolicy = PresentPolicy::VSync;
+    }
+    else if (presentArgument == "immediate")
+    {
+        presentPolicy = PresentPolicy::Immediate;
+    }
+    else if (presentArgument == "latency")
+    {
+        presentPolicy = PresentPolicy::LatencyOptimized;
+    }
+    else if (!presentArgument.empty() && presentArgument != "mailbox")
+    {
+        FFV_WARN("Unknown present policy {0}, expected vsync, mailbox, immediate or latency!", presentArgument);
+    }
+
+    const std::string fpsLimitArgument = GetArgumentValue("--fps-limit");
+    const F64 targetFps = fpsLimitArgument.empty() ? 0.0 : std::atof(fpsLimitArgument.c_str());
+
+    m_Renderer = MakeShared<Renderer>(m_Window, presentPolicy, targetFps);
+    m_Renderer->SetGpuProfileLogging(HasArgument("--gpu-profile"));
+    m_Renderer->SetMemoryLogging(HasArgument("--memory-stats"));
+    m_Renderer->SetDepthPrePass(HasArgument("--depth-prepass"));
+    m_Renderer->SetOcclusionCulling(!HasArgument("--no-occlusion-culling"));
+    m_Renderer->SetCullStatsLogging(HasArgument("--cull-stats"));
+    if (HasArgument("--cpu-path-tracing"))
+    {
+        m_Renderer->SetRenderMode(Renderer::RenderMode::CpuPathTraced);
+    }
+    else if (HasArgument("--ray-tracing"))
+    {
+        m_Renderer->SetRenderMode(Renderer::RenderMode::RayTraced);
+    }
+
+    // F12 captures a single frame, F11 toggles capturing every frame, F9 writes the CPU trace recorded so far, F8 toggles
+    // logging the memory budget and usage, F7 toggles the depth pre-pass, F6 toggles occlusion culling, F5 toggles
+    // logging the cull stats, F4 switches between rasterizing and CPU path tracing and F3 between rasterizing and
+    // hardware ray tracing
+    const std::string captureArgument = GetArgumentValue("--capture-dir");
+    m_FrameCapture = MakeShared<FrameCapture>(captureArgument.empty() ? "captures" : captureArgument,
+                                              m_Renderer->GetTargetFormat());
+    m_Renderer->SetReadbackCallback([this](U64 frameNumber, const U8* pixels, VkExtent2D extent)
+                                    { m_FrameCapture->OnReadback(frameNumber, pixels, extent); });
+    m_Window->SetKeyCallback(
+        [this](I32 key, I32 action)
+        {
+            if (action != GLFW_PRESS)
+            {
+                return;
+            }
+
+            if (key == GLFW_KEY_F12)
+            {
+                m_Renderer->CaptureNextFrame();
+            }
+            else if (key == GLFW_KEY_F11)
+            {
+                m_Renderer->SetContinuousCapture(!m_Renderer->IsContinuousCapture());
+                FFV_LOG("Continuous capture {0}", m_Renderer->IsContinuousCapture() ? "started" : "stopped");
+            }
+            else if (key == GLFW_KEY_F9)
+            {
+                const std::string traceArgument = GetArgumentValue("--trace");
+                Profiler::WriteChromeTrace(traceArgument.empty() ? "trace.json" : traceArgument);
+            }
+            else if (key == GLFW_KEY_F8)
+            {
+                m_Renderer->SetMemoryLogging(!m_Renderer->IsMemoryLogging());
+            }
+            else if (key == GLFW_KEY_F7)
+            {
+                m_Renderer->SetDepthPrePass(!m_Renderer->IsDepthPrePass());
+                FFV_LOG("Depth pre-pass {0}", m_Renderer->IsDepthPrePass() ? "enabled" : "disabled");
+            }
+            else if (key == GLFW_KEY_F6)
+            {
+                m_Renderer->SetOcclusionCulling(!m_Renderer->IsOcclusionCulling());
+                FFV_LOG("Occlusion culling {0}", m_Renderer->IsOcclusionCulling() ? "enabled" : "disabled");
+            }
+            else if (key == GLFW_KEY_F5)
+            {
+                m_Renderer->SetCullStatsLogging(!m_Renderer->IsCullStatsLogging());
+            }
+            else if (key == GLFW_KEY_F4)
+            {
+                const bool pathTraced = m_Renderer->GetRenderMode() == Renderer::RenderMode::CpuPathTraced;
+                m_Renderer->SetRenderMode(pathTraced ? Renderer::RenderMode::Rasterized
+                                                     : Renderer::RenderMode::CpuPathTraced);
+                FFV_LOG("CPU path tracing {0}",
+                        m_Renderer->GetRenderMode() == Renderer::RenderMode::CpuPathTraced ? "enabled" : "disabled");
+            }
+            else if (key == GLFW_KEY_F3)
+            {
+                const bool rayTraced = m_Renderer->GetRenderMode() == Renderer::RenderMode::RayTraced;
+                m_Renderer->SetRenderMode(rayTraced ? Renderer::RenderMode::Rasterized : Renderer::RenderMode::RayTraced);
+                FFV_LOG("Ray tracing {0}",
+                        m_Renderer->GetRenderMode() == Renderer::RenderMode::RayTraced ? "enabled" : "disabled");
+            }
+        });
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Application::~Application() { glfwTerminate(); }
+Application::~Application()
+{
+    // --gpu-profile only switches the per-second log on, the report file has its own option
+    const std::string gpuProfileArgument = GetArgumentValue("--gpu-profile-out");
+    if (m_Renderer && !gpuProfileArgument.empty())
+    {
+        m_Renderer->WriteGpuProfile(gpuProfileArgument);
+    }
+
+    m_Renderer.reset();
+    m_FrameCapture.reset();
+    m_Window.reset();
+
+    JobSystem::Shutdown();
+
+    // After the workers stopped, so every thread's events are complete
+    const std::string traceArgument = GetArgumentValue("--trace");
+    if (!traceArgument.empty())
+    {
+        Profiler::WriteChromeTrace(traceArgument);
+    }
+
+    if (!m_Headless)
+    {
+        glfwTerminate();
+    }
+}
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Application::Run()
 {
+    if (HasArgument("--bench-recording"))
+    {
+        m_Renderer->RunRecordingBenchmark();
+        return;
+    }
+
+    if (HasArgument("--batch"))
+    {
+        RunBatch();
+        return;
+    }
+
+    if (HasArgument("--turntable"))
+    {
+        RunTurntable();
+        return;
+    }
+
+    if (m_Headless)
+    {
+        RunHeadless();
+        return;
+    }
+
     while (!glfwWindowShouldClose(m_Window->GetNativeWindow()))
     {
+        m_Renderer->WaitForFrameStart();
         glfwPollEvents();
         m_Renderer->Update();
     }
 
-    m_Renderer->WaitIdle();
+    m_Renderer->FinishReadbacks();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Application::HasArgument(const std::string& argument) const
+{
+    return std::find(m_Args.begin(), m_Args.end(), argument) != m_Args.end();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string Application::GetArgumentValue(const std::string& argument) const
+{
+    const auto it = std::find(m_Args.begin(), m_Args.end(), argument);
+    if (it == m_Args.end() || std::next(it) == m_Args.end())
+    {
+        return "";
+    }
+
+    return *std::next(it);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::string> Application::GetArgumentValues(const std::string& argument) const
+{
+    auto it = std::find(m_Args.begin(), m_Args.end(), argument);
+    if (it == m_Args.end())
+    {
+        return {};
+    }
+
+    const auto end = std::find_if(std::next(it), m_Args.end(), [](const std::string& arg) { return arg.starts_with("--"); });
+    return std::vector<std::string>(std::next(it), end);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Application::RunHeadless()
+{
+    const std::string framesArgument = GetArgumentValue("--frames");
+    const U32 numFrames = framesArgument.empty() ? 100 : ParsePositiveInteger(framesArgument);
+    if (numFrames == 0)
+    {
+        FFV_ERROR("--frames has to be a positive integer, got {0}!", framesArgument);
+        return;
+    }
+
+    U32 numReadbacks = 0;
+    m_Renderer->SetReadbackCallback([&numReadbacks](U64, const U8*, VkExtent2D) { numReadbacks++; });
+
+    const auto startTime = std::chrono::steady_clock::now();
+    for (U32 i = 0; i < numFrames; i++)
+    {
+        m_Renderer->Update();
+    }
+    m_Renderer->FinishReadbacks();
+    const F64 totalMs = std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+    FFV_LOG("Rendered {0} headless frames in {1:.1f} ms ({2:.3f} ms per frame), {3} frames read back", numFrames,
+            totalMs, totalMs / numFrames, numReadbacks);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Application::RunBatch()
+{
+    BatchExporter::Settings settings;
+    const std::string outputArgument = GetArgumentValue("--out");
+    if (!outputArgument.empty())
+    {
+        settings.OutputDirectory = outputArgument;
+    }
+
+    const std::string azimuthArgument = GetArgumentValue("--azimuth");
+    const std::string elevationArgument = GetArgumentValue("--elevation");
+    const std::string fovArgument = GetArgumentValue("--fov");
+    settings.Azimuth = azimuthArgument.empty() ? settings.Azimuth : static_cast<F32>(std::atof(azimuthArgument.c_str()));
+    settings.Elevation =
+        elevationArgument.empty() ? settings.Elevation : static_cast<F32>(std::atof(elevationArgument.c_str()));
+    settings.FovY = fovArgument.empty() ? settings.FovY : static_cast<F32>(std::atof(fovArgument.c_str()));
+
+    const std::vector<std::filesystem::path> files = BatchExporter::CollectFiles(GetArgumentValues("--batch"));
+    FFV_LOG("Batch exporting {0} files to {1}", files.size(), settings.OutputDirectory.string());
+
+    BatchExporter exporter(m_Renderer, settings);
+    exporter.Run(files);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Application::RunTurntable()
+{
+    const std::string framesArgument = GetArgumentValue("--frames");
+    const U32 numFrames = framesArgument.empty() ? 36 : ParsePositiveInteger(framesArgument);
+    if (numFrames == 0)
+    {
+        FFV_ERROR("--frames has to be a positive integer, got {0}!", framesArgument);
+        return;
+    }
+
+    const std::filesystem::path modelPath = GetArgumentValue("--turntable");
+    std::vector<MeshData> meshes;
+    if (!ObjImporter::Import(modelPath, meshes) || !m_Renderer->LoadScene(meshes))
+    {
+        FFV_ERROR("Couldn't load {0} for the turntable!", modelPath.string());
+        return;
+    }
+
+    const std::string outputArgument = GetArgumentValue("--out");
+    const std::string elevationArgument = GetArgumentValue("--elevation");
+    const std::string fovArgument = GetArgumentValue("--fov");
+    const F32 elevation = elevationArgument.empty() ? 30.0f : static_cast<F32>(std::atof(elevationArgument.c_str()));
+    const F32 fovY = fovArgument.empty() ? 45.0f : static_cast<F32>(std::atof(fovArgument.c_str()));
+
+    // Waits instead of dropping frames, the renderer only stalls if the encoders fall behind by more than one buffer
+    // per thread
+    FrameCapture capture(outputArgument.empty() ? "turntable" : outputArgument, m_Renderer->GetTargetFormat(),
+                         FrameCapture::OverflowPolicy::Wait);
+    capture.SetFirstFrameNumber(m_Renderer->GetFrameNumber());
+    m_Renderer->SetReadbackCallback([&capture](U64 frameNumber, const U8* pixels, VkExtent2D extent)
+                                    { capture.OnReadback(frameNumber, pixels, extent); });
+
+    const auto startTime = std::chrono::steady_clock::now();
+    for (U32 i = 0; i < numFrames; i++)
+    {
+        m_Renderer->FitCameraToScene(360.0f * static_cast<F32>(i) / static_cast<F32>(numFrames), elevation, fovY);
+        m_Renderer->Update();
+    }
+    m_Renderer->FinishReadbacks();
+    capture.Flush();
+    const F64 totalSeconds = std::chrono::duration<F64>(std::chrono::steady_clock::now() - startTime).count();
+
+    m_Renderer->SetReadbackCallback(nullptr);
+
+    FFV_LOG("Exported a {0} frame turntable in {1:.2f} s ({2:.1f} frames/s)", capture.GetNumWritten(), totalSeconds,
+            numFrames / std::max(totalSeconds, 1e-6));
 }
 } // namespace FFV
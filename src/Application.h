@@ -1,16 +1,23 @@
 #pragma once
 
 #include "Window.h"
+#include "export/FrameCapture.h"
 #include "renderer/Renderer.h"
 #include "util/Types.h"
 #include "util/Util.h"
 
+#include <string>
+#include <vector>
+
 namespace FFV
 {
 class Application
 {
 public:
-    Application();
+    /*
+     * @param args: command line arguments without the executable name
+     */
+    Application(const std::vector<std::string>& args);
     ~Application();
 
     FFV_DELETE_MOVE_COPY(Application);
@@ -21,9 +28,35 @@ public:
 
     static Application& Get() { return *s_Instance; }
 
+private:
+    bool HasArgument(const std::string& argument) const;
+    /*
+     * @return: the argument following the given one or an empty string
+     */
+    std::string GetArgumentValue(const std::string& argument) const;
+    /*
+     * @return: all arguments following the given one up to the next option starting with --
+     */
+    std::vector<std::string> GetArgumentValues(const std::string& argument) const;
+    /*
+     * Renders a fixed number of frames offscreen as fast as possible and logs the throughput.
+     */
+    void RunHeadless();
+    /*
+     * Renders a preview image for every model file passed after --batch.
+     */
+    void RunBatch();
+    /*
+     * Renders the model passed after --turntable from evenly spaced angles around it into an image sequence.
+     */
+    void RunTurntable();
+
 private:
     static Application* s_Instance;
+    std::vector<std::string> m_Args;
     SharedPtr<Window> m_Window;
     SharedPtr<Renderer> m_Renderer;
+    SharedPtr<FrameCapture> m_FrameCapture;
+    bool m_Headless = false;
 };
 } // namespace FFV
@@ -5,13 +5,13 @@
 #if defined(FFV_WINDOWS) && defined(FFV_RELEASE)
 int WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 {
-    FFV::Application app{};
+    FFV::Application app{ std::vector<std::string>(__argv + 1, __argv + __argc) };
     app.Run();
 }
 #else
-int main()
+int main(int argc, char** argv)
 {
-    FFV::Application app{};
+    FFV::Application app{ std::vector<std::string>(argv + 1, argv + argc) };
     app.Run();
 }
 #endif
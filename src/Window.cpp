@@ -13,6 +13,17 @@ Window::Window(const std::string& title, U32 width, U32 height)
 
     glfwSetWindowSizeLimits(m_Window, 1, 1, GLFW_DONT_CARE, GLFW_DONT_CARE);
 
+    glfwSetWindowUserPointer(m_Window, this);
+    glfwSetKeyCallback(m_Window,
+                       [](GLFWwindow* nativeWindow, I32 key, I32, I32 action, I32)
+                       {
+                           const Window* window = static_cast<const Window*>(glfwGetWindowUserPointer(nativeWindow));
+                           if (window->m_KeyCallback)
+                           {
+                               window->m_KeyCallback(key, action);
+                           }
+                       });
+
     FFV_TRACE("Created window '{0}' ({1}x{2})", title, width, height);
 }
 
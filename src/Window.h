@@ -4,12 +4,20 @@
 #include "util/Util.h"
 
 #include <GLFW/glfw3.h>
+#include <functional>
 #include <string>
 
 namespace FFV
 {
 class Window
 {
+public:
+    /*
+     * @param key: GLFW_KEY_*
+     * @param action: GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+     */
+    using KeyCallback = std::function<void(I32 key, I32 action)>;
+
 public:
     Window(const std::string& title, U32 width, U32 height);
     ~Window();
@@ -20,7 +28,13 @@ public:
     U32 GetHeight() const;
     GLFWwindow* GetNativeWindow() const { return m_Window; }
 
+    /*
+     * Called from glfwPollEvents.
+     */
+    void SetKeyCallback(KeyCallback callback) { m_KeyCallback = std::move(callback); }
+
 private:
     GLFWwindow* m_Window = nullptr;
+    KeyCallback m_KeyCallback;
 };
 } // namespace FFV
@@ -0,0 +1,308 @@
+#include "FastFileViewerPCH.h"
+
+#include "BatchExporter.h"
+
+#include "export/PngWriter.h"
+#include "import/ObjImporter.h"
+#include "util/Log.h"
+#include "util/Profiler.h"
+
+#include <chrono>
+#include <deque>
+#include <fstream>
+
+namespace FFV
+{
+BatchExporter::BatchExporter(SharedPtr<Renderer> renderer, const Settings& settings)
+    : m_Renderer(renderer), m_Settings(settings)
+{
+    FFV_ASSERT(m_Renderer->IsHeadless(), "Batch exporting needs a headless renderer!", ;);
+
+    if (m_Settings.MaxLoadsInFlight == 0)
+    {
+        m_Settings.MaxLoadsInFlight = JobSystem::GetNumThreads() * 2;
+    }
+
+    // Called on the main thread during Update, the encoding itself moves to the job system
+    m_Renderer->SetReadbackCallback(
+        [this](U64 frameNumber, const U8* pixels, VkExtent2D extent)
+        {
+            const auto it = m_OutputPaths.find(frameNumber);
+            if (it == m_OutputPaths.end())
+            {
+                return;
+            }
+
+            // The pixels are only valid during the callback and the readback slot gets reused right after it
+            auto image = MakeShared<std::vector<U8>>(pixels, pixels + static_cast<U64>(extent.width) * extent.height * 4);
+            JobSystem::Execute(
+                [this, image, extent, path = it->second]()
+                {
+                    if (PngWriter::Write(path, image->data(), extent.width, extent.height))
+                    {
+                        m_NumWritten.fetch_add(1, std::memory_order_relaxed);
+                    }
+                },
+                &m_EncodeCounter);
+
+            m_OutputPaths.erase(it);
+        });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BatchExporter::~BatchExporter()
+{
+    // Both the callback and the encode jobs point to this exporter, so readbacks still in flight are drained before
+    // the renderer forgets the callback
+    m_Renderer->FinishReadbacks();
+    m_EncodeCounter.Wait();
+    m_Renderer->SetReadbackCallback(nullptr);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::filesystem::path> BatchExporter::CollectFiles(const std::vector<std::string>& inputs)
+{
+    std::vector<std::filesystem::path> files;
+    for (const std::string& input : inputs)
+    {
+        CollectFiles(input, files);
+    }
+
+    return files;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BatchExporter::Run(const std::vector<std::filesystem::path>& files)
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_Settings.OutputDirectory, error);
+    FFV_ASSERT(!error, std::format("Couldn't create the output directory {0}!", m_Settings.OutputDirectory.string()),
+               return);
+
+    // Mirrors the input tree, the directories are created up front so the encode jobs only write files
+    const std::filesystem::path commonDirectory = GetCommonDirectory(files);
+    std::vector<std::filesystem::path> outputPaths;
+    outputPaths.reserve(files.size());
+    for (const std::filesystem::path& file : files)
+    {
+        const std::filesystem::path absolutePath = std::filesystem::absolute(file, error).lexically_normal();
+        std::filesystem::path relativePath =
+            commonDirectory.empty() ? absolutePath.relative_path() : absolutePath.lexically_relative(commonDirectory);
+        outputPaths.push_back(m_Settings.OutputDirectory / relativePath.replace_extension(".png"));
+
+        std::filesystem::create_directories(outputPaths.back().parent_path(), error);
+        if (error)
+        {
+            FFV_WARN("Couldn't create the output directory {0}: {1}", outputPaths.back().parent_path().string(),
+                     error.message());
+            error.clear();
+        }
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    m_NumWritten = 0;
+    U32 numSkipped = 0;
+    U32 numImportFailed = 0;
+
+    std::deque<UniquePtr<PendingLoad>> loads;
+    U64 nextFile = 0;
+    const auto startLoads = [&]()
+    {
+        while (nextFile < files.size() && loads.size() < m_Settings.MaxLoadsInFlight)
+        {
+            UniquePtr<PendingLoad>& load = loads.emplace_back(MakeUnique<PendingLoad>());
+            load->Path = files[nextFile];
+            load->OutputPath = outputPaths[nextFile];
+            nextFile++;
+
+            PendingLoad* pendingLoad = load.get();
+            JobSystem::Execute([pendingLoad]()
+                               { pendingLoad->Success = ObjImporter::Import(pendingLoad->Path, pendingLoad->Meshes); },
+                               &pendingLoad->Counter);
+        }
+    };
+
+    startLoads();
+    while (!loads.empty())
+    {
+        // Helps with queued imports and encodes if the oldest file isn't imported yet
+        PendingLoad& load = *loads.front();
+        {
+            FFV_PROFILE_SCOPE("WaitForImport");
+            load.Counter.Wait();
+        }
+
+        if (!load.Success)
+        {
+            // The importer already logged why the file couldn't be read
+            FFV_WARN("Skipped {0}, it couldn't be imported!", load.Path.string());
+            numImportFailed++;
+        }
+        // Waits for the GPU to finish the previous file before replacing its geometry, the imports and encodes queued
+        // on the job system keep running meanwhile
+        else if (m_Renderer->LoadScene(load.Meshes))
+        {
+            m_Renderer->FitCameraToScene(m_Settings.Azimuth, m_Settings.Elevation, m_Settings.FovY);
+            m_OutputPaths[m_Renderer->GetFrameNumber()] = load.OutputPath;
+
+            // The readback of this frame gets collected and encoded during the Update of the next file
+            m_Renderer->Update();
+        }
+        else
+        {
+            FFV_WARN("Skipped {0}, it has no geometry or doesn't fit into the geometry pool!", load.Path.string());
+            numSkipped++;
+        }
+
+        loads.pop_front();
+        startLoads();
+    }
+
+    m_Renderer->FinishReadbacks();
+    m_EncodeCounter.Wait();
+
+    const F64 totalSeconds = std::chrono::duration<F64>(std::chrono::steady_clock::now() - startTime).count();
+    FFV_LOG("Exported {0} of {1} files in {2:.2f} s ({3:.1f} files/s), {4} failed to import, {5} skipped",
+            m_NumWritten.load(), files.size(), totalSeconds, files.size() / std::max(totalSeconds, 1e-6), numImportFailed,
+            numSkipped);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BatchExporter::CollectFiles(const std::filesystem::path& input, std::vector<std::filesystem::path>& files)
+{
+    const std::string fileName = input.filename().string();
+    std::error_code error;
+
+    if (fileName.find_first_of("*?") != std::string::npos)
+    {
+        const std::filesystem::path directory = input.has_parent_path() ? input.parent_path() : ".";
+        std::vector<std::filesystem::path> matches;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+        {
+            if (entry.is_regular_file() && MatchesPattern(entry.path().filename().string(), fileName))
+            {
+                matches.push_back(entry.path());
+            }
+        }
+
+        // Directory iteration order is unspecified, sorting keeps runs reproducible
+        std::sort(matches.begin(), matches.end());
+        files.insert(files.end(), matches.begin(), matches.end());
+    }
+    else if (std::filesystem::is_directory(input, error))
+    {
+        std::vector<std::filesystem::path> matches;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(input, error))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".obj")
+            {
+                matches.push_back(entry.path());
+            }
+        }
+
+        std::sort(matches.begin(), matches.end());
+        files.insert(files.end(), matches.begin(), matches.end());
+    }
+    else if (input.extension() == ".txt")
+    {
+        std::ifstream list(input);
+        FFV_ASSERT(list, std::format("Couldn't open the file list {0}!", input.string()), return);
+
+        std::string line;
+        while (std::getline(list, line))
+        {
+            const size_t start = line.find_first_not_of(" \t");
+            const size_t end = line.find_last_not_of(" \t\r");
+            if (start != std::string::npos)
+            {
+                CollectFiles(line.substr(start, end - start + 1), files);
+            }
+        }
+    }
+    else
+    {
+        files.push_back(input);
+    }
+
+    if (error)
+    {
+        FFV_WARN("Couldn't read {0}: {1}", input.string(), error.message());
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::filesystem::path BatchExporter::GetCommonDirectory(const std::vector<std::filesystem::path>& files)
+{
+    std::error_code error;
+    std::filesystem::path commonDirectory;
+    for (U64 i = 0; i < files.size(); i++)
+    {
+        const std::filesystem::path directory =
+            std::filesystem::absolute(files[i], error).lexically_normal().parent_path();
+        if (i == 0)
+        {
+            commonDirectory = directory;
+            continue;
+        }
+
+        // Shortens the common directory to the leading components both paths share
+        std::filesystem::path shared;
+        auto commonIt = commonDirectory.begin();
+        auto directoryIt = directory.begin();
+        for (; commonIt != commonDirectory.end() && directoryIt != directory.end() && *commonIt == *directoryIt;
+             ++commonIt, ++directoryIt)
+        {
+            shared /= *commonIt;
+        }
+        commonDirectory = shared;
+    }
+
+    return commonDirectory;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool BatchExporter::MatchesPattern(std::string_view name, std::string_view pattern)
+{
+    // Greedy matching that backtracks to the last * on a mismatch
+    size_t nameIndex = 0;
+    size_t patternIndex = 0;
+    size_t starIndex = std::string_view::npos;
+    size_t starNameIndex = 0;
+
+    while (nameIndex < name.size())
+    {
+        if (patternIndex < pattern.size() && (pattern[patternIndex] == '?' || pattern[patternIndex] == name[nameIndex]))
+        {
+            nameIndex++;
+            patternIndex++;
+        }
+        else if (patternIndex < pattern.size() && pattern[patternIndex] == '*')
+        {
+            starIndex = patternIndex++;
+            starNameIndex = nameIndex;
+        }
+        else if (starIndex != std::string_view::npos)
+        {
+            patternIndex = starIndex + 1;
+            nameIndex = ++starNameIndex;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while (patternIndex < pattern.size() && pattern[patternIndex] == '*')
+    {
+        patternIndex++;
+    }
+
+    return patternIndex == pattern.size();
+}
+} // namespace FFV
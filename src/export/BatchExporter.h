@@ -0,0 +1,83 @@
+#pragma once
+
+#include "import/MeshData.h"
+#include "renderer/Renderer.h"
+#include "util/JobSystem.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace FFV
+{
+/*
+ * Renders one preview image per model file with a headless renderer. Importing runs on the job system several files
+ * ahead and PNG encoding of finished frames runs behind, so both overlap with uploading and rendering on the main
+ * thread instead of taking turns with it. Uploading and rendering don't overlap with each other though, loading a
+ * scene waits until the GPU is done with the previous one because the renderer has a single set of scene buffers.
+ */
+class BatchExporter
+{
+public:
+    struct Settings
+    {
+        std::filesystem::path OutputDirectory = "renders";
+        F32 Azimuth = 45.0f;   // Degrees around the z axis
+        F32 Elevation = 30.0f; // Degrees above the xy plane
+        F32 FovY = 45.0f;
+        U32 MaxLoadsInFlight = 0; // Files imported ahead of the renderer, 0 uses twice the number of threads
+    };
+
+public:
+    /*
+     * @param renderer: has to be headless, its readback callback gets replaced
+     */
+    BatchExporter(SharedPtr<Renderer> renderer, const Settings& settings);
+    ~BatchExporter();
+
+    FFV_DELETE_MOVE_COPY(BatchExporter);
+
+    /*
+     * Expands the inputs into model files. An input can be a file, a directory (searched recursively for .obj
+     * files), a pattern with * and ? in its file name, or a .txt file listing one input per line.
+     */
+    static std::vector<std::filesystem::path> CollectFiles(const std::vector<std::string>& inputs);
+
+    /*
+     * Writes a .png for every file and logs the throughput, returns once all images are written. The images mirror
+     * where the files are relative to the directory they all share, so equal file names in different subdirectories
+     * don't overwrite each other.
+     */
+    void Run(const std::vector<std::filesystem::path>& files);
+
+private:
+    struct PendingLoad
+    {
+        std::filesystem::path Path;
+        std::filesystem::path OutputPath;
+        std::vector<MeshData> Meshes;
+        bool Success = false;
+        JobSystem::Counter Counter;
+    };
+
+private:
+    static void CollectFiles(const std::filesystem::path& input, std::vector<std::filesystem::path>& files);
+    static bool MatchesPattern(std::string_view name, std::string_view pattern);
+    /*
+     * @return: the deepest directory that contains every file, empty if they are on different roots
+     */
+    static std::filesystem::path GetCommonDirectory(const std::vector<std::filesystem::path>& files);
+
+private:
+    SharedPtr<Renderer> m_Renderer;
+    Settings m_Settings;
+
+    std::unordered_map<U64, std::filesystem::path> m_OutputPaths; // Frame number to the image it renders
+    JobSystem::Counter m_EncodeCounter;
+    std::atomic<U32> m_NumWritten = 0;
+};
+} // namespace FFV
@@ -0,0 +1,112 @@
+#include "FastFileViewerPCH.h"
+
+#include "FrameCapture.h"
+
+#include "export/PngWriter.h"
+#include "util/Log.h"
+#include "util/MemoryTracker.h"
+
+namespace FFV
+{
+FrameCapture::FrameCapture(const std::filesystem::path& outputDirectory, VkFormat format, OverflowPolicy overflowPolicy,
+                           U32 maxPendingEncodes)
+    : m_OutputDirectory(outputDirectory), m_OverflowPolicy(overflowPolicy), m_MaxPendingEncodes(maxPendingEncodes)
+{
+    FFV_ASSERT(format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_R8G8B8A8_UNORM ||
+                   format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_B8G8R8A8_UNORM,
+               "Captured images have to be 8 bit RGBA or BGRA!", ;);
+    m_SwapRedBlue = format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_B8G8R8A8_UNORM;
+
+    if (m_MaxPendingEncodes == 0)
+    {
+        m_MaxPendingEncodes = JobSystem::GetNumThreads();
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(m_OutputDirectory, error);
+    FFV_ASSERT(!error, std::format("Couldn't create the capture directory {0}!", m_OutputDirectory.string()), ;);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FrameCapture::~FrameCapture()
+{
+    m_EncodeCounter.Wait();
+
+    // Every buffer is back in the free list once the encodes finished
+    for (const SharedPtr<std::vector<U8>>& buffer : m_FreeBuffers)
+    {
+        MemoryTracker::AddCpuBytes(CpuMemoryCategory::Capture, -static_cast<I64>(buffer->capacity()));
+    }
+
+    if (GetNumWritten() > 0 || GetNumDropped() > 0)
+    {
+        FFV_LOG("Captured {0} frames to {1}, dropped {2} while the encoders were busy", GetNumWritten(),
+                m_OutputDirectory.string(), GetNumDropped());
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameCapture::OnReadback(U64 frameNumber, const U8* pixels, VkExtent2D extent)
+{
+    SharedPtr<std::vector<U8>> buffer;
+    {
+        std::unique_lock lock(m_BufferMutex);
+        if (m_OverflowPolicy == OverflowPolicy::Wait)
+        {
+            m_BufferFreed.wait(lock,
+                               [this]() { return !m_FreeBuffers.empty() || m_NumBuffers < m_MaxPendingEncodes; });
+        }
+
+        if (!m_FreeBuffers.empty())
+        {
+            buffer = std::move(m_FreeBuffers.back());
+            m_FreeBuffers.pop_back();
+        }
+        else if (m_NumBuffers < m_MaxPendingEncodes)
+        {
+            buffer = MakeShared<std::vector<U8>>();
+            m_NumBuffers++;
+        }
+    }
+
+    if (!buffer)
+    {
+        m_NumDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Recycled buffers keep their size, so after the first frames this copy doesn't touch new pages
+    const U64 previousCapacity = buffer->capacity();
+    buffer->assign(pixels, pixels + static_cast<U64>(extent.width) * extent.height * 4);
+    MemoryTracker::AddCpuBytes(CpuMemoryCategory::Capture,
+                               static_cast<I64>(buffer->capacity()) - static_cast<I64>(previousCapacity));
+
+    JobSystem::Execute(
+        [this, buffer, extent, frameNumber]()
+        {
+            if (m_SwapRedBlue)
+            {
+                for (U64 i = 0; i < buffer->size(); i += 4)
+                {
+                    std::swap((*buffer)[i], (*buffer)[i + 2]);
+                }
+            }
+
+            const std::filesystem::path path =
+                m_OutputDirectory / std::format("frame_{0:08}.png", frameNumber - m_FirstFrameNumber);
+            if (PngWriter::Write(path, buffer->data(), extent.width, extent.height))
+            {
+                m_NumWritten.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            {
+                std::lock_guard lock(m_BufferMutex);
+                m_FreeBuffers.push_back(buffer);
+            }
+            m_BufferFreed.notify_one();
+        },
+        &m_EncodeCounter);
+}
+} // namespace FFV
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "util/JobSystem.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * Writes captured frames as numbered PNG files. Encoding runs on the job system using a fixed number of recycled
+ * buffers, what happens when all of them are busy depends on the overflow policy.
+ */
+class FrameCapture
+{
+public:
+    enum class OverflowPolicy
+    {
+        Drop, // Never stalls the render loop, used for interactive capturing
+        Wait  // Every frame gets written, used for exports
+    };
+
+public:
+    /*
+     * @param format: of the captured images, 8 bit RGBA or BGRA
+     * @param maxPendingEncodes: 0 uses one per thread of the job system
+     */
+    FrameCapture(const std::filesystem::path& outputDirectory, VkFormat format,
+                 OverflowPolicy overflowPolicy = OverflowPolicy::Drop, U32 maxPendingEncodes = 0);
+    /*
+     * Waits for the pending encodes.
+     */
+    ~FrameCapture();
+
+    FFV_DELETE_MOVE_COPY(FrameCapture);
+
+    /*
+     * Matches ReadbackRing::ReadbackFn. Only copies the pixels, everything else happens on the job system.
+     */
+    void OnReadback(U64 frameNumber, const U8* pixels, VkExtent2D extent);
+
+    /*
+     * Files are numbered by frame number minus the first one, so a sequence starts at frame_00000000.png.
+     */
+    void SetFirstFrameNumber(U64 firstFrameNumber) { m_FirstFrameNumber = firstFrameNumber; }
+    /*
+     * Blocks until every encode started so far is written.
+     */
+    void Flush() { m_EncodeCounter.Wait(); }
+
+    U32 GetNumWritten() const { return m_NumWritten.load(std::memory_order_relaxed); }
+    U32 GetNumDropped() const { return m_NumDropped.load(std::memory_order_relaxed); }
+
+private:
+    std::filesystem::path m_OutputDirectory;
+    bool m_SwapRedBlue = false;
+    OverflowPolicy m_OverflowPolicy = OverflowPolicy::Drop;
+    U32 m_MaxPendingEncodes = 0;
+    U64 m_FirstFrameNumber = 0;
+
+    std::mutex m_BufferMutex;
+    std::condition_variable m_BufferFreed;
+    std::vector<SharedPtr<std::vector<U8>>> m_FreeBuffers;
+    U32 m_NumBuffers = 0;
+
+    JobSystem::Counter m_EncodeCounter;
+    std::atomic<U32> m_NumWritten = 0;
+    std::atomic<U32> m_NumDropped = 0;
+};
+} // namespace FFV
@@ -0,0 +1,379 @@
+#include "FastFileViewerPCH.h"
+
+#include "PngWriter.h"
+
+#include "util/Log.h"
+#include "util/Profiler.h"
+
+#include <fstream>
+
+namespace FFV
+{
+static constexpr U32 s_BytesPerPixel = 3;
+
+// Deflate limits, the window is kept one byte short of 32 KB so hash chains never reach overwritten entries
+static constexpr U32 s_MinMatch = 3;
+static constexpr U32 s_MaxMatch = 258;
+static constexpr U32 s_WindowSize = 1 << 15;
+static constexpr U32 s_HashSize = 1 << 15;
+static constexpr U32 s_MaxChainLength = 32;
+
+static constexpr std::array<U32, 29> s_LengthBases = { 3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                                       31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static constexpr std::array<U32, 29> s_LengthExtraBits = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                                           2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static constexpr std::array<U32, 30> s_DistanceBases = { 1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+                                                         33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+                                                         1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static constexpr std::array<U32, 30> s_DistanceExtraBits = { 0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                                             6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Deflate packs bits starting at the least significant bit of every byte.
+ */
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<U8>& output) : m_Output(output) {}
+
+    void Write(U32 bits, U32 count)
+    {
+        m_Buffer |= static_cast<U64>(bits) << m_Count;
+        m_Count += count;
+        while (m_Count >= 8)
+        {
+            m_Output.push_back(static_cast<U8>(m_Buffer));
+            m_Buffer >>= 8;
+            m_Count -= 8;
+        }
+    }
+
+    /*
+     * Huffman codes are stored starting at their most significant bit.
+     */
+    void WriteCode(U32 code, U32 length)
+    {
+        U32 reversed = 0;
+        for (U32 i = 0; i < length; i++)
+        {
+            reversed = (reversed << 1) | ((code >> i) & 1);
+        }
+        Write(reversed, length);
+    }
+
+    void Flush()
+    {
+        if (m_Count > 0)
+        {
+            m_Output.push_back(static_cast<U8>(m_Buffer));
+        }
+        m_Buffer = 0;
+        m_Count = 0;
+    }
+
+private:
+    std::vector<U8>& m_Output;
+    U64 m_Buffer = 0;
+    U32 m_Count = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void WriteFixedSymbol(BitWriter& writer, U32 symbol)
+{
+    if (symbol < 144)
+    {
+        writer.WriteCode(0x30 + symbol, 8);
+    }
+    else if (symbol < 256)
+    {
+        writer.WriteCode(0x190 + symbol - 144, 9);
+    }
+    else if (symbol < 280)
+    {
+        writer.WriteCode(symbol - 256, 7);
+    }
+    else
+    {
+        writer.WriteCode(0xC0 + symbol - 280, 8);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void WriteMatch(BitWriter& writer, U32 length, U32 distance)
+{
+    U32 lengthCode = static_cast<U32>(s_LengthBases.size()) - 1;
+    while (s_LengthBases[lengthCode] > length)
+    {
+        lengthCode--;
+    }
+    WriteFixedSymbol(writer, 257 + lengthCode);
+    writer.Write(length - s_LengthBases[lengthCode], s_LengthExtraBits[lengthCode]);
+
+    U32 distanceCode = static_cast<U32>(s_DistanceBases.size()) - 1;
+    while (s_DistanceBases[distanceCode] > distance)
+    {
+        distanceCode--;
+    }
+    writer.WriteCode(distanceCode, 5);
+    writer.Write(distance - s_DistanceBases[distanceCode], s_DistanceExtraBits[distanceCode]);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static U8 PaethPredictor(I32 left, I32 up, I32 upLeft)
+{
+    const I32 estimate = left + up - upLeft;
+    const I32 distanceLeft = std::abs(estimate - left);
+    const I32 distanceUp = std::abs(estimate - up);
+    const I32 distanceUpLeft = std::abs(estimate - upLeft);
+
+    if (distanceLeft <= distanceUp && distanceLeft <= distanceUpLeft)
+    {
+        return static_cast<U8>(left);
+    }
+    return static_cast<U8>(distanceUp <= distanceUpLeft ? up : upLeft);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PngWriter::Write(const std::filesystem::path& path, const U8* rgba, U32 width, U32 height)
+{
+    const std::vector<U8> png = Encode(rgba, width, height);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        FFV_WARN("Couldn't open {0} for writing!", path.string());
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+    return static_cast<bool>(file);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<U8> PngWriter::Encode(const U8* rgba, U32 width, U32 height)
+{
+    FFV_PROFILE_FUNCTION();
+
+    const U64 rowSize = static_cast<U64>(width) * s_BytesPerPixel;
+
+    // Every row starts with its filter type, the one with the smallest sum of absolute differences usually compresses
+    // best (Sub = 1, Up = 2, Paeth = 4)
+    std::vector<U8> filtered;
+    filtered.reserve((rowSize + 1) * height);
+
+    std::vector<U8> previousRow(rowSize, 0);
+    std::vector<U8> row(rowSize);
+    std::array<std::vector<U8>, 3> candidates = { std::vector<U8>(rowSize), std::vector<U8>(rowSize),
+                                                  std::vector<U8>(rowSize) };
+    constexpr std::array<U8, 3> filterTypes = { 1, 2, 4 };
+
+    for (U32 y = 0; y < height; y++)
+    {
+        const U8* source = rgba + static_cast<U64>(y) * width * 4;
+        for (U32 x = 0; x < width; x++)
+        {
+            row[x * 3 + 0] = source[x * 4 + 0];
+            row[x * 3 + 1] = source[x * 4 + 1];
+            row[x * 3 + 2] = source[x * 4 + 2];
+        }
+
+        std::array<U64, 3> costs = { 0, 0, 0 };
+        for (U64 i = 0; i < rowSize; i++)
+        {
+            const U8 left = i >= s_BytesPerPixel ? row[i - s_BytesPerPixel] : 0;
+            const U8 up = previousRow[i];
+            const U8 upLeft = i >= s_BytesPerPixel ? previousRow[i - s_BytesPerPixel] : 0;
+
+            candidates[0][i] = static_cast<U8>(row[i] - left);
+            candidates[1][i] = static_cast<U8>(row[i] - up);
+            candidates[2][i] = static_cast<U8>(row[i] - PaethPredictor(left, up, upLeft));
+
+            for (U32 c = 0; c < 3; c++)
+            {
+                costs[c] += static_cast<U64>(std::abs(static_cast<I32>(static_cast<I8>(candidates[c][i]))));
+            }
+        }
+
+        const U32 best = static_cast<U32>(std::min_element(costs.begin(), costs.end()) - costs.begin());
+        filtered.push_back(filterTypes[best]);
+        filtered.insert(filtered.end(), candidates[best].begin(), candidates[best].end());
+
+        std::swap(previousRow, row);
+    }
+
+    const std::vector<U8> compressed = Compress(filtered);
+
+    std::vector<U8> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    const auto writeU32 = [](std::vector<U8>& output, U32 value)
+    {
+        output.insert(output.end(), { static_cast<U8>(value >> 24), static_cast<U8>(value >> 16),
+                                      static_cast<U8>(value >> 8), static_cast<U8>(value) });
+    };
+    const auto writeChunk = [&](const char* type, const U8* data, U32 size)
+    {
+        writeU32(png, size);
+        const U64 typeOffset = png.size();
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data, data + size);
+        writeU32(png, Crc32(png.data() + typeOffset, size + 4));
+    };
+
+    std::vector<U8> header;
+    writeU32(header, width);
+    writeU32(header, height);
+    header.insert(header.end(), { 8, 2, 0, 0, 0 }); // 8 bit RGB, deflate, adaptive filtering, not interlaced
+
+    writeChunk("IHDR", header.data(), static_cast<U32>(header.size()));
+    writeChunk("IDAT", compressed.data(), static_cast<U32>(compressed.size()));
+    writeChunk("IEND", nullptr, 0);
+
+    return png;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<U8> PngWriter::Compress(const std::vector<U8>& data)
+{
+    FFV_PROFILE_FUNCTION();
+
+    std::vector<U8> output = { 0x78, 0x01 }; // Deflate with a 32 KB window, no dictionary
+    output.reserve(data.size() / 2);
+
+    BitWriter writer(output);
+    writer.Write(1, 1); // Final block
+    writer.Write(1, 2); // Fixed Huffman codes
+
+    const U32 size = static_cast<U32>(data.size());
+    std::vector<I32> head(s_HashSize, -1);
+    std::vector<I32> previous(s_WindowSize, -1);
+
+    const auto hash = [&](U32 position)
+    { return ((data[position] << 10) ^ (data[position + 1] << 5) ^ data[position + 2]) & (s_HashSize - 1); };
+    const auto insert = [&](U32 position)
+    {
+        if (position + s_MinMatch <= size)
+        {
+            const U32 h = hash(position);
+            previous[position & (s_WindowSize - 1)] = head[h];
+            head[h] = static_cast<I32>(position);
+        }
+    };
+
+    U32 position = 0;
+    while (position < size)
+    {
+        U32 bestLength = 0;
+        U32 bestDistance = 0;
+
+        if (position + s_MinMatch <= size)
+        {
+            const U32 maxLength = std::min(s_MaxMatch, size - position);
+            I32 candidate = head[hash(position)];
+            for (U32 chain = 0; chain < s_MaxChainLength && candidate >= 0 &&
+                                position - static_cast<U32>(candidate) < s_WindowSize;
+                 chain++)
+            {
+                U32 length = 0;
+                while (length < maxLength && data[candidate + length] == data[position + length])
+                {
+                    length++;
+                }
+
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    bestDistance = position - static_cast<U32>(candidate);
+                    if (length == maxLength)
+                    {
+                        break;
+                    }
+                }
+
+                candidate = previous[candidate & (s_WindowSize - 1)];
+            }
+        }
+
+        if (bestLength >= s_MinMatch)
+        {
+            WriteMatch(writer, bestLength, bestDistance);
+            for (U32 i = 0; i < bestLength; i++)
+            {
+                insert(position + i);
+            }
+            position += bestLength;
+        }
+        else
+        {
+            WriteFixedSymbol(writer, data[position]);
+            insert(position);
+            position++;
+        }
+    }
+
+    WriteFixedSymbol(writer, 256); // End of block
+    writer.Flush();
+
+    const U32 adler = Adler32(data);
+    output.insert(output.end(), { static_cast<U8>(adler >> 24), static_cast<U8>(adler >> 16),
+                                  static_cast<U8>(adler >> 8), static_cast<U8>(adler) });
+    return output;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U32 PngWriter::Crc32(const U8* data, U64 size, U32 crc)
+{
+    static const std::array<U32, 256> table = []()
+    {
+        std::array<U32, 256> result = {};
+        for (U32 i = 0; i < 256; i++)
+        {
+            U32 value = i;
+            for (U32 bit = 0; bit < 8; bit++)
+            {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            result[i] = value;
+        }
+        return result;
+    }();
+
+    crc = ~crc;
+    for (U64 i = 0; i < size; i++)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U32 PngWriter::Adler32(const std::vector<U8>& data)
+{
+    // 5552 is the largest block before the sums can overflow 32 bits
+    constexpr U32 modulo = 65521;
+    constexpr U64 blockSize = 5552;
+
+    U32 a = 1;
+    U32 b = 0;
+    for (U64 start = 0; start < data.size(); start += blockSize)
+    {
+        const U64 end = std::min<U64>(start + blockSize, data.size());
+        for (U64 i = start; i < end; i++)
+        {
+            a += data[i];
+            b += a;
+        }
+        a %= modulo;
+        b %= modulo;
+    }
+    return (b << 16) | a;
+}
+} // namespace FFV
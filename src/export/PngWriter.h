@@ -0,0 +1,33 @@
+#pragma once
+
+#include "util/Types.h"
+
+#include <filesystem>
+#include <vector>
+
+namespace FFV
+{
+/*
+ * Encodes 8 bit RGB PNG images. Rows are filtered per row and deflated with a greedy LZ77 pass and the fixed Huffman
+ * codes, which compresses rendered images well while staying fast enough to keep up with batch rendering.
+ */
+class PngWriter
+{
+public:
+    /*
+     * Thread safe, the alpha channel is dropped.
+     * @param rgba: tightly packed rows of 4 bytes per pixel
+     * @return: false if the file couldn't be written
+     */
+    static bool Write(const std::filesystem::path& path, const U8* rgba, U32 width, U32 height);
+    static std::vector<U8> Encode(const U8* rgba, U32 width, U32 height);
+
+private:
+    /*
+     * @return: a zlib stream with a single fixed Huffman block
+     */
+    static std::vector<U8> Compress(const std::vector<U8>& data);
+    static U32 Crc32(const U8* data, U64 size, U32 crc = 0);
+    static U32 Adler32(const std::vector<U8>& data);
+};
+} // namespace FFV
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "util/Types.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace FFV
+{
+/*
+ * Geometry of one sub mesh as it comes out of an importer.
+ */
+struct MeshData
+{
+    std::vector<glm::vec3> Positions;
+    std::vector<glm::vec3> Normals; // Empty or one per position
+    std::vector<U32> Indices;
+
+    U64 GetSizeInBytes() const
+    {
+        return Positions.size() * sizeof(glm::vec3) + Normals.size() * sizeof(glm::vec3) + Indices.size() * sizeof(U32);
+    }
+};
+} // namespace FFV
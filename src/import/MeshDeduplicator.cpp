@@ -0,0 +1,254 @@
+#include "FastFileViewerPCH.h"
+
+#include "MeshDeduplicator.h"
+
+#include "util/JobSystem.h"
+#include "util/Profiler.h"
+
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace FFV
+{
+// Position tolerance relative to the mesh radius, plus a multiple of the precision of the input coordinates since
+// parts far from the origin lose the low bits of their positions before they are ever canonicalized
+static constexpr F32 s_RelativeTolerance = 1.0f / 4096.0f;
+static constexpr F32 s_CoordinateErrorFactor = 8.0f;
+static constexpr F32 s_NormalTolerance = 1.0f / 256.0f;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MeshDeduplicator::Result MeshDeduplicator::Deduplicate(const std::vector<MeshData>& meshes)
+{
+    FFV_PROFILE_FUNCTION();
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    const U32 meshCount = static_cast<U32>(meshes.size());
+
+    std::vector<CanonicalMesh> canonicalMeshes(meshCount);
+    JobSystem::ParallelFor(meshCount, [&](U32 index, U32) { canonicalMeshes[index] = Canonicalize(meshes[index]); });
+
+    // Buckets keep the input order, so the first mesh of a bucket is always a representative
+    std::unordered_map<U64, U32> bucketIndices;
+    std::vector<std::vector<U32>> buckets;
+    for (U32 meshIndex = 0; meshIndex < meshCount; meshIndex++)
+    {
+        const auto [it, inserted] =
+            bucketIndices.try_emplace(canonicalMeshes[meshIndex].Hash, static_cast<U32>(buckets.size()));
+        if (inserted)
+        {
+            buckets.emplace_back();
+        }
+        buckets[it->second].push_back(meshIndex);
+    }
+
+    std::vector<U32> representatives(meshCount);
+    JobSystem::ParallelFor(static_cast<U32>(buckets.size()),
+                           [&](U32 bucketIndex, U32)
+                           {
+                               // Almost always a single representative, more only on hash collisions
+                               std::vector<U32> bucketRepresentatives;
+                               for (const U32 meshIndex : buckets[bucketIndex])
+                               {
+                                   representatives[meshIndex] = meshIndex;
+                                   for (const U32 representative : bucketRepresentatives)
+                                   {
+                                       if (Match(canonicalMeshes[representative], canonicalMeshes[meshIndex]))
+                                       {
+                                           representatives[meshIndex] = representative;
+                                           break;
+                                       }
+                                   }
+
+                                   if (representatives[meshIndex] == meshIndex)
+                                   {
+                                       bucketRepresentatives.push_back(meshIndex);
+                                   }
+                               }
+                           });
+
+    Result result;
+    result.Instances.resize(meshCount);
+
+    std::vector<U32> uniqueIndices(meshCount);
+    for (U32 meshIndex = 0; meshIndex < meshCount; meshIndex++)
+    {
+        result.InputBytes += meshes[meshIndex].GetSizeInBytes();
+
+        const U32 representative = representatives[meshIndex];
+        if (representative == meshIndex)
+        {
+            uniqueIndices[meshIndex] = static_cast<U32>(result.Meshes.size());
+            result.OutputBytes += canonicalMeshes[meshIndex].Mesh.GetSizeInBytes();
+            result.Meshes.push_back(std::move(canonicalMeshes[meshIndex].Mesh));
+        }
+
+        result.Instances[meshIndex] = { .MeshIndex = uniqueIndices[representative],
+                                        .Transform = canonicalMeshes[meshIndex].Transform };
+    }
+    result.OutputBytes += meshCount * sizeof(glm::mat4);
+
+    result.TimeMs =
+        std::chrono::duration<F64, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+    const F64 savedBytes = static_cast<F64>(result.InputBytes) - static_cast<F64>(result.OutputBytes);
+    FFV_LOG("Deduplicated {0} meshes into {1} unique meshes in {2:.2f} ms, saved {3:.2f} MB ({4:.1f}%)", meshCount,
+            result.Meshes.size(), result.TimeMs, savedBytes / (1024.0 * 1024.0),
+            result.InputBytes > 0 ? savedBytes / result.InputBytes * 100.0 : 0.0);
+
+    return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MeshDeduplicator::CanonicalMesh MeshDeduplicator::Canonicalize(const MeshData& mesh)
+{
+    CanonicalMesh canonical;
+    canonical.Mesh.Indices = mesh.Indices;
+
+    const std::vector<glm::vec3>& positions = mesh.Positions;
+
+    glm::dvec3 sum(0.0);
+    for (const glm::vec3& position : positions)
+    {
+        sum += glm::dvec3(position);
+    }
+    const glm::vec3 centroid = positions.empty() ? glm::vec3(0.0f) : glm::vec3(sum / static_cast<F64>(positions.size()));
+
+    F32 maxDistanceSquared = 0.0f;
+    F32 maxCoordinate = 0.0f;
+    for (const glm::vec3& position : positions)
+    {
+        const glm::vec3 offset = position - centroid;
+        maxDistanceSquared = std::max(maxDistanceSquared, glm::dot(offset, offset));
+        maxCoordinate = std::max({ maxCoordinate, std::abs(position.x), std::abs(position.y), std::abs(position.z) });
+    }
+
+    // The axes are anchored to the first vertices that are clearly away from the centroid (and the first axis), which
+    // is stable under rotation and, unlike principal axes, also works for rotationally symmetric parts like bolts
+    glm::vec3 axisX(1.0f, 0.0f, 0.0f);
+    for (U32 i = 0; i < positions.size(); i++)
+    {
+        const glm::vec3 offset = positions[i] - centroid;
+        if (maxDistanceSquared > 0.0f && glm::dot(offset, offset) >= 0.25f * maxDistanceSquared)
+        {
+            axisX = glm::normalize(offset);
+            canonical.AnchorX = i;
+            break;
+        }
+    }
+
+    F32 maxOrthogonalSquared = 0.0f;
+    for (const glm::vec3& position : positions)
+    {
+        const glm::vec3 offset = position - centroid;
+        const glm::vec3 orthogonal = offset - axisX * glm::dot(offset, axisX);
+        maxOrthogonalSquared = std::max(maxOrthogonalSquared, glm::dot(orthogonal, orthogonal));
+    }
+
+    glm::vec3 axisY = glm::normalize(
+        glm::cross(axisX, std::abs(axisX.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f)));
+    for (U32 i = 0; i < positions.size(); i++)
+    {
+        const glm::vec3 offset = positions[i] - centroid;
+        const glm::vec3 orthogonal = offset - axisX * glm::dot(offset, axisX);
+        if (maxOrthogonalSquared > 1e-12f * maxDistanceSquared &&
+            glm::dot(orthogonal, orthogonal) >= 0.25f * maxOrthogonalSquared)
+        {
+            axisY = glm::normalize(orthogonal);
+            canonical.AnchorY = i;
+            break;
+        }
+    }
+
+    const glm::mat3 rotation(axisX, axisY, glm::cross(axisX, axisY));
+    const glm::mat3 inverseRotation = glm::transpose(rotation);
+
+    canonical.Transform = glm::mat4(rotation);
+    canonical.Transform[3] = glm::vec4(centroid, 1.0f);
+
+    canonical.Radius = std::sqrt(maxDistanceSquared);
+    canonical.Tolerance = canonical.Radius * s_RelativeTolerance +
+                          maxCoordinate * std::numeric_limits<F32>::epsilon() * s_CoordinateErrorFactor;
+
+    canonical.Mesh.Positions.reserve(positions.size());
+    for (const glm::vec3& position : positions)
+    {
+        canonical.Mesh.Positions.push_back(inverseRotation * (position - centroid));
+    }
+
+    canonical.Mesh.Normals.reserve(mesh.Normals.size());
+    for (const glm::vec3& normal : mesh.Normals)
+    {
+        canonical.Mesh.Normals.push_back(inverseRotation * normal);
+    }
+
+    // Only what rounding can't change, the shape is compared in Match
+    U64 hash = Util::HashBytes(mesh.Indices.data(), mesh.Indices.size() * sizeof(U32));
+    Util::HashCombine(hash, static_cast<U64>(positions.size()));
+    Util::HashCombine(hash, static_cast<U64>(mesh.Normals.size()));
+    canonical.Hash = hash;
+
+    return canonical;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool MeshDeduplicator::Match(const CanonicalMesh& representative, CanonicalMesh& mesh)
+{
+    const CanonicalMesh& a = representative;
+    const CanonicalMesh& b = mesh;
+
+    const F32 tolerance = std::max(a.Tolerance, b.Tolerance);
+    if (a.Mesh.Positions.size() != b.Mesh.Positions.size() || a.Mesh.Normals.size() != b.Mesh.Normals.size() ||
+        std::abs(a.Radius - b.Radius) > tolerance || a.Mesh.Indices != b.Mesh.Indices)
+    {
+        return false;
+    }
+
+    // A vertex right at an anchor threshold can pick different anchors for two duplicates. Their vertices correspond
+    // one to one, so the mesh is turned into the frame the anchors of the representative span in it.
+    glm::mat3 rotation(1.0f);
+    const bool reanchor = (a.AnchorX != b.AnchorX || a.AnchorY != b.AnchorY) &&
+                          a.AnchorX != InvalidAnchor && a.AnchorY != InvalidAnchor;
+    if (reanchor)
+    {
+        const glm::vec3 axisX = glm::normalize(b.Mesh.Positions[a.AnchorX]);
+        const glm::vec3 offsetY = b.Mesh.Positions[a.AnchorY];
+        const glm::vec3 axisY = glm::normalize(offsetY - axisX * glm::dot(offsetY, axisX));
+        rotation = glm::mat3(axisX, axisY, glm::cross(axisX, axisY));
+    }
+    const glm::mat3 inverseRotation = glm::transpose(rotation);
+
+    const auto isClose = [](const glm::vec3& x, const glm::vec3& y, F32 maxDifference)
+    { return glm::all(glm::lessThanEqual(glm::abs(x - y), glm::vec3(maxDifference))); };
+
+    for (U64 i = 0; i < a.Mesh.Positions.size(); i++)
+    {
+        if (!isClose(a.Mesh.Positions[i], inverseRotation * b.Mesh.Positions[i], tolerance))
+        {
+            return false;
+        }
+    }
+
+    // The canonical axes of both meshes are off by about the position tolerance over the radius, which rotates the
+    // normals by as much
+    const F32 normalTolerance = s_NormalTolerance + tolerance / std::max(a.Radius, std::numeric_limits<F32>::min());
+    for (U64 i = 0; i < a.Mesh.Normals.size(); i++)
+    {
+        if (!isClose(a.Mesh.Normals[i], inverseRotation * b.Mesh.Normals[i], normalTolerance))
+        {
+            return false;
+        }
+    }
+
+    // Places the representative, which is in its own frame, where the mesh was
+    if (reanchor)
+    {
+        mesh.Transform = mesh.Transform * glm::mat4(rotation);
+    }
+
+    return true;
+}
+} // namespace FFV
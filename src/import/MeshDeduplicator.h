@@ -0,0 +1,68 @@
+#pragma once
+
+#include "import/MeshData.h"
+#include "util/Types.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace FFV
+{
+/*
+ * Finds sub meshes that are the same geometry placed with a different translation and rotation, which is how CAD
+ * exports flatten assemblies. Every mesh is moved into a canonical frame (centroid at the origin, axes anchored to its
+ * own vertices). Canonical positions of duplicates differ by rounding errors, so anything derived from them would hash
+ * differently near a rounding boundary. The hash only covers the vertex counts and the indices, meshes with the same
+ * hash are then compared within a tolerance relative to their radius and to the precision of their coordinates. If
+ * rounding made two duplicates pick different anchor vertices, the comparison uses the anchors of the representative.
+ * Duplicates need the same vertex and index order, which holds for repeated parts of one export.
+ */
+class MeshDeduplicator
+{
+public:
+    struct Instance
+    {
+        U32 MeshIndex = 0;
+        glm::mat4 Transform = glm::mat4(1.0f); // Canonical frame to the original placement
+    };
+
+    struct Result
+    {
+        std::vector<MeshData> Meshes;    // Unique meshes in their canonical frame
+        std::vector<Instance> Instances; // One per input mesh, in input order
+        U64 InputBytes = 0;
+        U64 OutputBytes = 0; // Unique meshes plus one transform per instance
+        F64 TimeMs = 0.0;
+    };
+
+public:
+    /*
+     * Canonicalization and comparison run on the job system, the result gets logged.
+     */
+    static Result Deduplicate(const std::vector<MeshData>& meshes);
+
+private:
+    static constexpr U32 InvalidAnchor = ~0u;
+
+    struct CanonicalMesh
+    {
+        MeshData Mesh;
+        glm::mat4 Transform = glm::mat4(1.0f);
+        F32 Radius = 0.0f;
+        F32 Tolerance = 0.0f; // How far canonical positions of duplicates may be apart
+        U64 Hash = 0;
+        // Vertices the canonical x and y axes point towards
+        U32 AnchorX = InvalidAnchor;
+        U32 AnchorY = InvalidAnchor;
+    };
+
+private:
+    static CanonicalMesh Canonicalize(const MeshData& mesh);
+    /*
+     * Compares the canonical positions and normals within the tolerance and the indices exactly. The hash doesn't
+     * cover the shape, so the radius rules out most meshes that only share their topology first.
+     * @param mesh: its transform is changed to place the representative if their canonical frames differ
+     */
+    static bool Match(const CanonicalMesh& representative, CanonicalMesh& mesh);
+};
+} // namespace FFV
@@ -0,0 +1,220 @@
+#include "FastFileViewerPCH.h"
+
+#include "ObjImporter.h"
+
+#include "util/Log.h"
+#include "util/Profiler.h"
+
+#include <charconv>
+#include <fstream>
+
+namespace FFV
+{
+bool ObjImporter::Import(const std::filesystem::path& path, std::vector<MeshData>& meshes)
+{
+    FFV_PROFILE_FUNCTION();
+
+    // Reading the whole file at once is a lot faster than line wise stream extraction
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        FFV_WARN("Couldn't open {0}!", path.string());
+        return false;
+    }
+
+    std::string content(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(content.data(), static_cast<std::streamsize>(content.size()));
+
+    Parse(content, meshes);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ObjImporter::Parse(std::string_view content, std::vector<MeshData>& meshes)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+
+    MeshData mesh;
+    bool hasAllNormals = true;
+    std::unordered_map<U64, U32> vertexIndices; // Position and normal index pair to the vertex of the current mesh
+    std::vector<U32> polygon;
+
+    const auto finishMesh = [&]()
+    {
+        if (!mesh.Indices.empty())
+        {
+            if (!hasAllNormals)
+            {
+                GenerateNormals(mesh);
+            }
+            meshes.push_back(std::move(mesh));
+        }
+
+        mesh = {};
+        hasAllNormals = true;
+        vertexIndices.clear();
+    };
+
+    std::string_view text = content;
+    while (!text.empty())
+    {
+        const size_t lineEnd = text.find('\n');
+        std::string_view line = text.substr(0, lineEnd);
+        text = lineEnd == std::string_view::npos ? std::string_view() : text.substr(lineEnd + 1);
+
+        if (line.starts_with("v "))
+        {
+            line.remove_prefix(2);
+            glm::vec3& position = positions.emplace_back(0.0f);
+            ParseFloat(line, position.x);
+            ParseFloat(line, position.y);
+            ParseFloat(line, position.z);
+        }
+        else if (line.starts_with("vn "))
+        {
+            line.remove_prefix(3);
+            glm::vec3& normal = normals.emplace_back(0.0f, 0.0f, 1.0f);
+            ParseFloat(line, normal.x);
+            ParseFloat(line, normal.y);
+            ParseFloat(line, normal.z);
+        }
+        else if (line.starts_with("o ") || line.starts_with("g "))
+        {
+            finishMesh();
+        }
+        else if (line.starts_with("f "))
+        {
+            line.remove_prefix(2);
+            polygon.clear();
+
+            I32 positionIndex = 0;
+            while (ParseInt(line, positionIndex))
+            {
+                I32 normalIndex = 0;
+                if (!line.empty() && line.front() == '/')
+                {
+                    line.remove_prefix(1);
+                    I32 texCoordIndex = 0;
+                    if (!line.empty() && line.front() != '/')
+                    {
+                        ParseInt(line, texCoordIndex);
+                    }
+                    if (!line.empty() && line.front() == '/')
+                    {
+                        line.remove_prefix(1);
+                        ParseInt(line, normalIndex);
+                    }
+                }
+
+                // Indices start at 1, negative ones count back from the last element read so far
+                const I64 position = positionIndex < 0 ? static_cast<I64>(positions.size()) + positionIndex
+                                                       : static_cast<I64>(positionIndex) - 1;
+                I64 normal = normalIndex < 0 ? static_cast<I64>(normals.size()) + normalIndex
+                                             : static_cast<I64>(normalIndex) - 1;
+                if (position < 0 || position >= static_cast<I64>(positions.size()))
+                {
+                    continue;
+                }
+                if (normal < 0 || normal >= static_cast<I64>(normals.size()))
+                {
+                    normal = -1;
+                    hasAllNormals = false;
+                }
+
+                const U64 key = (static_cast<U64>(position) << 32) | static_cast<U32>(normal + 1);
+                const auto [it, inserted] = vertexIndices.try_emplace(key, static_cast<U32>(mesh.Positions.size()));
+                if (inserted)
+                {
+                    mesh.Positions.push_back(positions[position]);
+                    mesh.Normals.push_back(normal < 0 ? glm::vec3(0.0f, 0.0f, 1.0f) : normals[normal]);
+                }
+                polygon.push_back(it->second);
+            }
+
+            for (U32 i = 2; i < polygon.size(); i++)
+            {
+                mesh.Indices.insert(mesh.Indices.end(), { polygon[0], polygon[i - 1], polygon[i] });
+            }
+        }
+    }
+    finishMesh();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ObjImporter::GenerateNormals(MeshData& mesh)
+{
+    mesh.Normals.assign(mesh.Positions.size(), glm::vec3(0.0f));
+
+    for (U32 i = 0; i + 2 < mesh.Indices.size(); i += 3)
+    {
+        const U32 a = mesh.Indices[i];
+        const U32 b = mesh.Indices[i + 1];
+        const U32 c = mesh.Indices[i + 2];
+
+        // Not normalized, so bigger triangles weigh more
+        const glm::vec3 faceNormal =
+            glm::cross(mesh.Positions[b] - mesh.Positions[a], mesh.Positions[c] - mesh.Positions[a]);
+        mesh.Normals[a] += faceNormal;
+        mesh.Normals[b] += faceNormal;
+        mesh.Normals[c] += faceNormal;
+    }
+
+    for (glm::vec3& normal : mesh.Normals)
+    {
+        const F32 length = glm::length(normal);
+        normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ObjImporter::ParseFloat(std::string_view& text, F32& value)
+{
+    const size_t start = text.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos)
+    {
+        return false;
+    }
+    text.remove_prefix(start);
+
+    // from_chars doesn't accept a leading plus
+    if (text.front() == '+')
+    {
+        text.remove_prefix(1);
+    }
+
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc())
+    {
+        return false;
+    }
+
+    text.remove_prefix(static_cast<size_t>(end - text.data()));
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ObjImporter::ParseInt(std::string_view& text, I32& value)
+{
+    const size_t start = text.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos)
+    {
+        return false;
+    }
+    text.remove_prefix(start);
+
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc())
+    {
+        return false;
+    }
+
+    text.remove_prefix(static_cast<size_t>(end - text.data()));
+    return true;
+}
+} // namespace FFV
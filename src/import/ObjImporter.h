@@ -0,0 +1,43 @@
+#pragma once
+
+#include "import/MeshData.h"
+#include "util/Types.h"
+
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace FFV
+{
+/*
+ * Loads the geometry of Wavefront OBJ files. Every object or group becomes its own sub mesh, polygons are triangulated
+ * as fans and materials, texture coordinates and smoothing groups are ignored.
+ */
+class ObjImporter
+{
+public:
+    /*
+     * Thread safe, so many files can be imported in parallel.
+     * @param meshes: receives one sub mesh per non empty object or group
+     * @return: false if the file couldn't be read
+     */
+    static bool Import(const std::filesystem::path& path, std::vector<MeshData>& meshes);
+    /*
+     * Same as Import for OBJ text that is already in memory, e.g. a mapped file.
+     */
+    static void Parse(std::string_view content, std::vector<MeshData>& meshes);
+
+    /*
+     * Averages the area weighted face normals of the triangles around every vertex.
+     */
+    static void GenerateNormals(MeshData& mesh);
+
+private:
+    /*
+     * Parses the next whitespace separated number and advances the text past it.
+     * @return: false if there is no number
+     */
+    static bool ParseFloat(std::string_view& text, F32& value);
+    static bool ParseInt(std::string_view& text, I32& value);
+};
+} // namespace FFV
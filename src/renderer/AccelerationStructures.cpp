@@ -0,0 +1,625 @@
+#include "FastFileViewerPCH.h"
+
+#include "AccelerationStructures.h"
+
+#include "util/Log.h"
+#include "util/Profiler.h"
+
+#include <chrono>
+
+namespace FFV
+{
+// Scratch and uncompacted BLAS memory of one batch, a single mesh that needs more gets a batch of its own
+static constexpr VkDeviceSize s_BatchBudget = 64ull << 20;
+// Required offset alignment of acceleration structures inside their buffer
+static constexpr VkDeviceSize s_AccelerationStructureAlignment = 256;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static VkAccelerationStructureBuildGeometryInfoKHR GetBlasBuildInfo(const VkAccelerationStructureGeometryKHR& geometry)
+{
+    // The scene is static, so tracing speed wins over build speed
+    return { .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
+             .type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+             .flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR |
+                      VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR,
+             .mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
+             .geometryCount = 1,
+             .pGeometries = &geometry };
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static VkAccelerationStructureGeometryKHR GetTlasGeometry(VkDeviceAddress instanceAddress)
+{
+    return { .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
+             .geometryType = VK_GEOMETRY_TYPE_INSTANCES_KHR,
+             .geometry = { .instances = { .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR,
+                                          .arrayOfPointers = VK_FALSE,
+                                          .data = { .deviceAddress = instanceAddress } } } };
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static VkAccelerationStructureBuildGeometryInfoKHR GetTlasBuildInfo(const VkAccelerationStructureGeometryKHR& geometry)
+{
+    return { .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
+             .type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
+             .flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR |
+                      VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR,
+             .mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
+             .geometryCount = 1,
+             .pGeometries = &geometry };
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void RecordBuildBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags2 dstStageMask)
+{
+    const VkMemoryBarrier2 memoryBarrier = { .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                             .srcStageMask = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                                             .srcAccessMask = VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+                                             .dstStageMask = dstStageMask,
+                                             .dstAccessMask = VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR };
+
+    const VkDependencyInfo dependencyInfo = { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                              .memoryBarrierCount = 1,
+                                              .pMemoryBarriers = &memoryBarrier };
+    vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+AccelerationStructures::AccelerationStructures(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices,
+                                               SharedPtr<Queue> queue, VkCommandPool commandBufferPool,
+                                               SharedPtr<BindlessTable> bindlessTable, U32 numFrames)
+    : m_Device(device), m_PhysicalDevices(physicalDevices), m_Queue(queue), m_CommandBufferPool(commandBufferPool),
+      m_BindlessTable(bindlessTable), m_Frames(numFrames)
+{
+    const auto loadFunction = [&](const char* name)
+    {
+        const PFN_vkVoidFunction function = vkGetDeviceProcAddr(m_Device, name);
+        FFV_ASSERT(function, std::format("Cannot find address of {}", name), exit(1));
+        return function;
+    };
+
+    m_CreateAccelerationStructure =
+        reinterpret_cast<PFN_vkCreateAccelerationStructureKHR>(loadFunction("vkCreateAccelerationStructureKHR"));
+    m_DestroyAccelerationStructure =
+        reinterpret_cast<PFN_vkDestroyAccelerationStructureKHR>(loadFunction("vkDestroyAccelerationStructureKHR"));
+    m_GetBuildSizes = reinterpret_cast<PFN_vkGetAccelerationStructureBuildSizesKHR>(
+        loadFunction("vkGetAccelerationStructureBuildSizesKHR"));
+    m_GetDeviceAddress = reinterpret_cast<PFN_vkGetAccelerationStructureDeviceAddressKHR>(
+        loadFunction("vkGetAccelerationStructureDeviceAddressKHR"));
+    m_CmdBuild =
+        reinterpret_cast<PFN_vkCmdBuildAccelerationStructuresKHR>(loadFunction("vkCmdBuildAccelerationStructuresKHR"));
+    m_CmdWriteProperties = reinterpret_cast<PFN_vkCmdWriteAccelerationStructuresPropertiesKHR>(
+        loadFunction("vkCmdWriteAccelerationStructuresPropertiesKHR"));
+    m_CmdCopy =
+        reinterpret_cast<PFN_vkCmdCopyAccelerationStructureKHR>(loadFunction("vkCmdCopyAccelerationStructureKHR"));
+
+    VkPhysicalDeviceAccelerationStructurePropertiesKHR accelerationStructureProperties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR
+    };
+    VkPhysicalDeviceProperties2 properties = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+                                               .pNext = &accelerationStructureProperties };
+    vkGetPhysicalDeviceProperties2(m_PhysicalDevices->GetSelectedPhysicalDevice().PhysicalDevice, &properties);
+    m_ScratchAlignment =
+        std::max<VkDeviceSize>(accelerationStructureProperties.minAccelerationStructureScratchOffsetAlignment, 1);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+AccelerationStructures::~AccelerationStructures() { Clear(); }
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AccelerationStructures::SetScene(const Scene& scene, const std::vector<U32>& vertexCounts,
+                                      const GeometryPool& geometryPool)
+{
+    FFV_PROFILE_FUNCTION();
+
+    Clear();
+    if (scene.GetObjectCount() == 0)
+    {
+        return;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    m_SceneVersion++;
+
+    const std::vector<Scene::Mesh>& sceneMeshes = scene.GetMeshes();
+    FFV_ASSERT(sceneMeshes.size() == vertexCounts.size(), "Every mesh of the scene needs its vertex count!", return);
+
+    const VkDeviceAddress vertexAddress = Util::GetBufferAddress(m_Device, geometryPool.GetVertexBuffer());
+    const VkDeviceAddress indexAddress = Util::GetBufferAddress(m_Device, geometryPool.GetIndexBuffer());
+    const U32 vertexStride = geometryPool.GetVertexStride();
+
+    std::vector<BlasInput> inputs(sceneMeshes.size());
+    std::vector<MeshRange> meshRanges(sceneMeshes.size());
+    VkDeviceSize totalScratch = 0;
+    VkDeviceSize largestScratch = 0;
+    for (U32 meshIndex = 0; meshIndex < sceneMeshes.size(); meshIndex++)
+    {
+        const Scene::Mesh& mesh = sceneMeshes[meshIndex];
+        const U32 vertexCount = vertexCounts[meshIndex];
+        meshRanges[meshIndex] = { .FirstIndex = mesh.FirstIndex, .VertexOffset = static_cast<U32>(mesh.VertexOffset) };
+
+        // The indices are relative to the mesh, so its vertices start at its vertex offset. The position is the first
+        // member of every vertex.
+        const VkDeviceAddress meshVertexAddress =
+            vertexAddress + static_cast<VkDeviceSize>(mesh.VertexOffset) * vertexStride;
+        const VkDeviceAddress meshIndexAddress = indexAddress + sizeof(U32) * static_cast<VkDeviceSize>(mesh.FirstIndex);
+
+        BlasInput& input = inputs[meshIndex];
+        input.Geometry = { .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
+                           .geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR,
+                           .flags = VK_GEOMETRY_OPAQUE_BIT_KHR };
+        input.Geometry.geometry.triangles = {
+            .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR,
+            .vertexFormat = VK_FORMAT_R32G32B32_SFLOAT,
+            .vertexData = { .deviceAddress = meshVertexAddress },
+            .vertexStride = vertexStride,
+            .maxVertex = std::max(vertexCount, 1u) - 1,
+            .indexType = VK_INDEX_TYPE_UINT32,
+            .indexData = { .deviceAddress = meshIndexAddress }
+        };
+        input.Range = { .primitiveCount = mesh.IndexCount / 3 };
+        input.Sizes = { .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR };
+
+        if (input.Range.primitiveCount == 0)
+        {
+            continue;
+        }
+
+        const VkAccelerationStructureBuildGeometryInfoKHR buildInfo = GetBlasBuildInfo(input.Geometry);
+        m_GetBuildSizes(m_Device, VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR, &buildInfo,
+                        &input.Range.primitiveCount, &input.Sizes);
+
+        const VkDeviceSize scratch = AlignUp(input.Sizes.buildScratchSize, m_ScratchAlignment);
+        totalScratch += scratch;
+        largestScratch = std::max(largestScratch, scratch);
+    }
+
+    m_Blases.assign(sceneMeshes.size(), VK_NULL_HANDLE);
+    m_BlasAddresses.assign(sceneMeshes.size(), 0);
+
+    // One scratch buffer for all batches, the largest mesh has to fit on its own
+    const VkDeviceSize scratchSize = std::min(totalScratch, std::max(s_BatchBudget, largestScratch));
+    GpuBuffer scratch = CreateBuffer(scratchSize + m_ScratchAlignment,
+                                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    const VkDeviceAddress scratchAddress = AlignUp(scratch.Address, m_ScratchAlignment);
+    m_Stats.ScratchBytes = scratchSize;
+
+    const VkQueryPoolCreateInfo queryPoolCreateInfo = { .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                                        .queryType =
+                                                            VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR,
+                                                        .queryCount = static_cast<U32>(inputs.size()) };
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    FFV_CHECK_VK_RESULT(vkCreateQueryPool(m_Device, &queryPoolCreateInfo, VK_NULL_HANDLE, &queryPool));
+
+    // A batch ends before the mesh whose scratch or BLAS would exceed the budget, every batch takes at least one mesh
+    U32 first = 0;
+    VkDeviceSize batchScratch = 0;
+    VkDeviceSize batchBytes = 0;
+    for (U32 meshIndex = 0; meshIndex < inputs.size(); meshIndex++)
+    {
+        const VkDeviceSize meshScratch = AlignUp(inputs[meshIndex].Sizes.buildScratchSize, m_ScratchAlignment);
+        const VkDeviceSize meshBytes =
+            AlignUp(inputs[meshIndex].Sizes.accelerationStructureSize, s_AccelerationStructureAlignment);
+
+        if (meshIndex > first && (batchScratch + meshScratch > scratchSize || batchBytes + meshBytes > s_BatchBudget))
+        {
+            BuildBlasBatch(inputs, first, meshIndex - first, scratchAddress, queryPool);
+            first = meshIndex;
+            batchScratch = 0;
+            batchBytes = 0;
+        }
+
+        batchScratch += meshScratch;
+        batchBytes += meshBytes;
+    }
+    BuildBlasBatch(inputs, first, static_cast<U32>(inputs.size()) - first, scratchAddress, queryPool);
+
+    vkDestroyQueryPool(m_Device, queryPool, VK_NULL_HANDLE);
+    DestroyBuffer(scratch);
+
+    // Lets the hit shaders find the triangles of the mesh an instance references
+    const VkDeviceSize meshBufferSize = sizeof(MeshRange) * meshRanges.size();
+    m_MeshBuffer = CreateBuffer(meshBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    GpuBuffer staging = CreateBuffer(meshBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    memcpy(staging.Mapped, meshRanges.data(), meshBufferSize);
+    Util::CopyBuffer(m_Device, m_Queue->GetQueue(), m_CommandBufferPool, staging.Buffer, m_MeshBuffer.Buffer,
+                     meshBufferSize);
+    DestroyBuffer(staging);
+
+    m_MeshBuffer.BindlessIndex = m_BindlessTable->RegisterStorageBuffer(m_MeshBuffer.Buffer);
+    m_VertexBufferIndex = m_BindlessTable->RegisterStorageBuffer(geometryPool.GetVertexBuffer());
+    m_IndexBufferIndex = m_BindlessTable->RegisterStorageBuffer(geometryPool.GetIndexBuffer());
+
+    CreateTlases(scene.GetObjectCount());
+
+    m_Stats.BuildMs = std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    FFV_TRACE("Built {0} BLASes in {1} batches in {2:.1f} ms, compaction shrank them from {3:.1f} MB to {4:.1f} MB!",
+              m_Stats.BlasCount, m_Stats.BatchCount, m_Stats.BuildMs, m_Stats.BuildBytes / (1024.0 * 1024.0),
+              m_Stats.CompactedBytes / (1024.0 * 1024.0));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AccelerationStructures::Clear()
+{
+    for (Frame& frame : m_Frames)
+    {
+        if (frame.Tlas != VK_NULL_HANDLE)
+        {
+            m_DestroyAccelerationStructure(m_Device, frame.Tlas, VK_NULL_HANDLE);
+        }
+
+        DestroyBuffer(frame.TlasBuffer);
+        DestroyBuffer(frame.Scratch);
+        DestroyBuffer(frame.Instances);
+        frame = {};
+    }
+
+    for (const VkAccelerationStructureKHR blas : m_Blases)
+    {
+        if (blas != VK_NULL_HANDLE)
+        {
+            m_DestroyAccelerationStructure(m_Device, blas, VK_NULL_HANDLE);
+        }
+    }
+    m_Blases.clear();
+    m_BlasAddresses.clear();
+
+    for (GpuBuffer& buffer : m_BlasBuffers)
+    {
+        DestroyBuffer(buffer);
+    }
+    m_BlasBuffers.clear();
+
+    DestroyBuffer(m_MeshBuffer);
+    if (m_VertexBufferIndex != BindlessTable::InvalidIndex)
+    {
+        m_BindlessTable->Release(BindlessTable::ResourceType::StorageBuffer, m_VertexBufferIndex);
+        m_BindlessTable->Release(BindlessTable::ResourceType::StorageBuffer, m_IndexBufferIndex);
+        m_VertexBufferIndex = BindlessTable::InvalidIndex;
+        m_IndexBufferIndex = BindlessTable::InvalidIndex;
+    }
+
+    m_InstanceCount = 0;
+    m_Stats = {};
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AccelerationStructures::RecordTlasUpdate(VkCommandBuffer commandBuffer, U32 frameIndex, const Scene& scene)
+{
+    if (IsEmpty())
+    {
+        return;
+    }
+
+    FFV_ASSERT(scene.GetObjectCount() == m_InstanceCount, "The objects of the scene changed since SetScene!", return);
+
+    Frame& frame = m_Frames[frameIndex];
+    const bool build = frame.SceneVersion != m_SceneVersion;
+    if (!build && frame.TransformVersion == scene.GetTransformVersion())
+    {
+        return;
+    }
+
+    // The previous commands of the frame finished before its index was reused, so the instances can be overwritten
+    WriteInstances(frame, scene);
+
+    // An update refits the nodes to the moved instances, the hierarchy is kept
+    const VkAccelerationStructureGeometryKHR geometry = GetTlasGeometry(frame.Instances.Address);
+    VkAccelerationStructureBuildGeometryInfoKHR buildInfo = GetTlasBuildInfo(geometry);
+    buildInfo.mode =
+        build ? VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR : VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR;
+    buildInfo.srcAccelerationStructure = build ? VK_NULL_HANDLE : frame.Tlas;
+    buildInfo.dstAccelerationStructure = frame.Tlas;
+    buildInfo.scratchData.deviceAddress = AlignUp(frame.Scratch.Address, m_ScratchAlignment);
+
+    const VkAccelerationStructureBuildRangeInfoKHR range = { .primitiveCount = m_InstanceCount };
+    const VkAccelerationStructureBuildRangeInfoKHR* ranges = &range;
+    m_CmdBuild(commandBuffer, 1, &buildInfo, &ranges);
+    RecordBuildBarrier(commandBuffer, VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR);
+
+    frame.SceneVersion = m_SceneVersion;
+    frame.TransformVersion = scene.GetTransformVersion();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AccelerationStructures::BuildBlasBatch(const std::vector<BlasInput>& inputs, U32 first, U32 count,
+                                            VkDeviceAddress scratchAddress, VkQueryPool queryPool)
+{
+    FFV_PROFILE_FUNCTION();
+
+    VkDeviceSize buildBufferSize = 0;
+    for (U32 meshIndex = first; meshIndex < first + count; meshIndex++)
+    {
+        buildBufferSize += AlignUp(inputs[meshIndex].Sizes.accelerationStructureSize, s_AccelerationStructureAlignment);
+    }
+
+    if (buildBufferSize == 0)
+    {
+        return;
+    }
+
+    GpuBuffer buildBuffer = CreateBuffer(buildBufferSize,
+                                         VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
+                                             VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    // All BLASes of the batch are built by one command, each one with its own part of the scratch buffer
+    std::vector<U32> meshIndices;
+    std::vector<VkAccelerationStructureKHR> built;
+    std::vector<VkAccelerationStructureBuildGeometryInfoKHR> buildInfos;
+    std::vector<const VkAccelerationStructureBuildRangeInfoKHR*> ranges;
+    VkDeviceSize bufferOffset = 0;
+    VkDeviceSize scratchOffset = 0;
+    for (U32 meshIndex = first; meshIndex < first + count; meshIndex++)
+    {
+        const BlasInput& input = inputs[meshIndex];
+        if (input.Range.primitiveCount == 0)
+        {
+            continue;
+        }
+
+        const VkAccelerationStructureKHR blas =
+            CreateAccelerationStructure(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR, buildBuffer.Buffer,
+                                        bufferOffset, input.Sizes.accelerationStructureSize);
+
+        VkAccelerationStructureBuildGeometryInfoKHR buildInfo = GetBlasBuildInfo(input.Geometry);
+        buildInfo.dstAccelerationStructure = blas;
+        buildInfo.scratchData.deviceAddress = scratchAddress + scratchOffset;
+
+        meshIndices.push_back(meshIndex);
+        built.push_back(blas);
+        buildInfos.push_back(buildInfo);
+        ranges.push_back(&input.Range);
+
+        bufferOffset += AlignUp(input.Sizes.accelerationStructureSize, s_AccelerationStructureAlignment);
+        scratchOffset += AlignUp(input.Sizes.buildScratchSize, m_ScratchAlignment);
+    }
+
+    const U32 builtCount = static_cast<U32>(built.size());
+
+    VkCommandBuffer commandBuffer = BeginCommands();
+    vkCmdResetQueryPool(commandBuffer, queryPool, 0, builtCount);
+    m_CmdBuild(commandBuffer, builtCount, buildInfos.data(), ranges.data());
+    // The compacted sizes are only known once the builds finished
+    RecordBuildBarrier(commandBuffer, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR);
+    m_CmdWriteProperties(commandBuffer, builtCount, built.data(), VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR,
+                         queryPool, 0);
+    SubmitAndWait(commandBuffer);
+
+    std::vector<VkDeviceSize> compactedSizes(builtCount);
+    FFV_CHECK_VK_RESULT(vkGetQueryPoolResults(m_Device, queryPool, 0, builtCount, sizeof(VkDeviceSize) * builtCount,
+                                              compactedSizes.data(), sizeof(VkDeviceSize),
+                                              VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+
+    VkDeviceSize compactedBufferSize = 0;
+    for (const VkDeviceSize compactedSize : compactedSizes)
+    {
+        compactedBufferSize += AlignUp(compactedSize, s_AccelerationStructureAlignment);
+    }
+
+    GpuBuffer compactedBuffer = CreateBuffer(compactedBufferSize,
+                                             VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
+                                                 VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    commandBuffer = BeginCommands();
+    bufferOffset = 0;
+    for (U32 i = 0; i < builtCount; i++)
+    {
+        const U32 meshIndex = meshIndices[i];
+        m_Blases[meshIndex] = CreateAccelerationStructure(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+                                                          compactedBuffer.Buffer, bufferOffset, compactedSizes[i]);
+        bufferOffset += AlignUp(compactedSizes[i], s_AccelerationStructureAlignment);
+
+        const VkCopyAccelerationStructureInfoKHR copyInfo = { .sType =
+                                                                  VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_INFO_KHR,
+                                                              .src = built[i],
+                                                              .dst = m_Blases[meshIndex],
+                                                              .mode = VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_KHR };
+        m_CmdCopy(commandBuffer, &copyInfo);
+    }
+    SubmitAndWait(commandBuffer);
+
+    for (U32 i = 0; i < builtCount; i++)
+    {
+        m_DestroyAccelerationStructure(m_Device, built[i], VK_NULL_HANDLE);
+
+        const VkAccelerationStructureDeviceAddressInfoKHR addressInfo = {
+            .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR,
+            .accelerationStructure = m_Blases[meshIndices[i]]
+        };
+        m_BlasAddresses[meshIndices[i]] = m_GetDeviceAddress(m_Device, &addressInfo);
+    }
+    DestroyBuffer(buildBuffer);
+    m_BlasBuffers.push_back(compactedBuffer);
+
+    m_Stats.BlasCount += builtCount;
+    m_Stats.BatchCount++;
+    m_Stats.BuildBytes += buildBufferSize;
+    m_Stats.CompactedBytes += compactedBufferSize;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AccelerationStructures::CreateTlases(U32 instanceCount)
+{
+    m_InstanceCount = instanceCount;
+
+    // The instance address doesn't change the sizes
+    const VkAccelerationStructureGeometryKHR geometry = GetTlasGeometry(0);
+    const VkAccelerationStructureBuildGeometryInfoKHR buildInfo = GetTlasBuildInfo(geometry);
+    VkAccelerationStructureBuildSizesInfoKHR sizes = { .sType =
+                                                           VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR };
+    m_GetBuildSizes(m_Device, VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR, &buildInfo, &instanceCount, &sizes);
+
+    // Written by the CPU right before the build, every frame has its own so frames in flight keep theirs
+    const VkDeviceSize instanceBytes = sizeof(VkAccelerationStructureInstanceKHR) * static_cast<VkDeviceSize>(instanceCount);
+    const VkDeviceSize scratchBytes = std::max(sizes.buildScratchSize, sizes.updateScratchSize) + m_ScratchAlignment;
+    for (Frame& frame : m_Frames)
+    {
+        frame.Instances = CreateBuffer(instanceBytes,
+                                       VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+                                           VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        frame.TlasBuffer = CreateBuffer(sizes.accelerationStructureSize,
+                                        VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
+                                            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        frame.Scratch = CreateBuffer(scratchBytes,
+                                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        frame.Tlas = CreateAccelerationStructure(VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR, frame.TlasBuffer.Buffer, 0,
+                                                 sizes.accelerationStructureSize);
+
+        m_Stats.TlasBytes += instanceBytes + sizes.accelerationStructureSize + scratchBytes;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AccelerationStructures::WriteInstances(const Frame& frame, const Scene& scene) const
+{
+    FFV_PROFILE_FUNCTION();
+
+    VkAccelerationStructureInstanceKHR* instances = static_cast<VkAccelerationStructureInstanceKHR*>(frame.Instances.Mapped);
+    const std::vector<glm::mat4>& transforms = scene.GetTransforms();
+    const std::vector<U32>& meshIndices = scene.GetMeshIndices();
+
+    for (U32 objectIndex = 0; objectIndex < m_InstanceCount; objectIndex++)
+    {
+        const glm::mat4& transform = transforms[objectIndex];
+        const U32 meshIndex = meshIndices[objectIndex];
+
+        // Row major 3x4, glm is column major
+        VkTransformMatrixKHR matrix;
+        for (U32 row = 0; row < 3; row++)
+        {
+            for (U32 column = 0; column < 4; column++)
+            {
+                matrix.matrix[row][column] = transform[column][row];
+            }
+        }
+
+        // The mesh index lets the hit shader find the triangles, a reference of 0 makes the instance inactive
+        instances[objectIndex] = { .transform = matrix,
+                                   .instanceCustomIndex = meshIndex,
+                                   .mask = 0xFF,
+                                   .instanceShaderBindingTableRecordOffset = 0,
+                                   .flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR,
+                                   .accelerationStructureReference = m_BlasAddresses[meshIndex] };
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+VkAccelerationStructureKHR AccelerationStructures::CreateAccelerationStructure(VkAccelerationStructureTypeKHR type,
+                                                                               VkBuffer buffer, VkDeviceSize offset,
+                                                                               VkDeviceSize size) const
+{
+    const VkAccelerationStructureCreateInfoKHR createInfo = {
+        .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR,
+        .buffer = buffer,
+        .offset = offset,
+        .size = size,
+        .type = type
+    };
+
+    VkAccelerationStructureKHR accelerationStructure = VK_NULL_HANDLE;
+    FFV_CHECK_VK_RESULT(m_CreateAccelerationStructure(m_Device, &createInfo, VK_NULL_HANDLE, &accelerationStructure));
+    return accelerationStructure;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+AccelerationStructures::GpuBuffer AccelerationStructures::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+                                                                       VkMemoryPropertyFlags properties) const
+{
+    GpuBuffer buffer;
+    Util::CreateBuffer(m_Device, m_PhysicalDevices, size, usage, properties, buffer.Buffer, buffer.Memory,
+                       MemoryCategory::RayTracing);
+
+    if (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+    {
+        buffer.Address = Util::GetBufferAddress(m_Device, buffer.Buffer);
+    }
+
+    if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        FFV_CHECK_VK_RESULT(vkMapMemory(m_Device, buffer.Memory, 0, size, 0, &buffer.Mapped));
+    }
+
+    return buffer;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AccelerationStructures::DestroyBuffer(GpuBuffer& buffer) const
+{
+    if (buffer.Buffer == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    if (buffer.BindlessIndex != BindlessTable::InvalidIndex)
+    {
+        m_BindlessTable->Release(BindlessTable::ResourceType::StorageBuffer, buffer.BindlessIndex);
+    }
+
+    if (buffer.Mapped)
+    {
+        vkUnmapMemory(m_Device, buffer.Memory);
+    }
+
+    vkDestroyBuffer(m_Device, buffer.Buffer, VK_NULL_HANDLE);
+    Util::FreeMemory(m_Device, buffer.Memory);
+    buffer = {};
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+VkCommandBuffer AccelerationStructures::BeginCommands() const
+{
+    const VkCommandBufferAllocateInfo allocateInfo = { .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                                                       .commandPool = m_CommandBufferPool,
+                                                       .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                                                       .commandBufferCount = 1 };
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    FFV_CHECK_VK_RESULT(vkAllocateCommandBuffers(m_Device, &allocateInfo, &commandBuffer));
+
+    const VkCommandBufferBeginInfo beginInfo = { .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                                 .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT };
+    FFV_CHECK_VK_RESULT(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+    return commandBuffer;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AccelerationStructures::SubmitAndWait(VkCommandBuffer commandBuffer) const
+{
+    FFV_CHECK_VK_RESULT(vkEndCommandBuffer(commandBuffer));
+    m_Queue->Submit(commandBuffer);
+    FFV_CHECK_VK_RESULT(vkQueueWaitIdle(m_Queue->GetQueue()));
+    vkFreeCommandBuffers(m_Device, m_CommandBufferPool, 1, &commandBuffer);
+}
+} // namespace FFV
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "renderer/BindlessTable.h"
+#include "renderer/GeometryPool.h"
+#include "renderer/PhysicalDevice.h"
+#include "renderer/Queue.h"
+#include "scene/Scene.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * Acceleration structures for hardware ray tracing, needs VK_KHR_acceleration_structure.
+ * Every mesh gets a bottom level acceleration structure (BLAS). They are built in batches that share one scratch
+ * buffer, so the scratch memory stays bounded by the batch budget instead of growing with the scene, and every batch
+ * is compacted right after it was built, which usually about halves its size.
+ * Every frame in flight has its own top level acceleration structure (TLAS) over the objects of the scene, instance i
+ * is object i. It's only fully built for a new scene, moved objects are refit with an update and a static scene keeps
+ * the TLAS as it is.
+ */
+class AccelerationStructures
+{
+public:
+    /*
+     * Usage the geometry pool buffers need, the BLASes are built from them and the hit shaders read them.
+     */
+    static constexpr VkBufferUsageFlags RequiredGeometryUsage =
+        VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+        VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
+
+    /*
+     * Has to match the mesh buffer in raytrace.slang.
+     */
+    struct MeshRange
+    {
+        U32 FirstIndex;
+        U32 VertexOffset;
+    };
+
+    struct Stats
+    {
+        U32 BlasCount = 0;
+        U32 BatchCount = 0;
+        VkDeviceSize BuildBytes = 0;     // All BLASes before compaction
+        VkDeviceSize CompactedBytes = 0; // All BLASes after compaction
+        VkDeviceSize ScratchBytes = 0;   // Shared by all batches
+        VkDeviceSize TlasBytes = 0;      // TLASes, their scratch and instance buffers of all frames
+        F64 BuildMs = 0.0;
+    };
+
+public:
+    AccelerationStructures(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, SharedPtr<Queue> queue,
+                           VkCommandPool commandBufferPool, SharedPtr<BindlessTable> bindlessTable, U32 numFrames);
+    ~AccelerationStructures();
+
+    FFV_DELETE_MOVE_COPY(AccelerationStructures);
+
+    /*
+     * Builds and compacts the BLASes of all meshes and waits for it, the TLASes are built by RecordTlasUpdate.
+     * @param vertexCounts: number of vertices of every mesh of the scene
+     * @param geometryPool: has to be created with RequiredGeometryUsage
+     */
+    void SetScene(const Scene& scene, const std::vector<U32>& vertexCounts, const GeometryPool& geometryPool);
+    /*
+     * The GPU must no longer use the acceleration structures.
+     */
+    void Clear();
+
+    /*
+     * Builds the TLAS of the frame for a new scene or refits it if objects moved since the frame was last recorded,
+     * otherwise nothing is recorded. Ray tracing shaders can trace the TLAS afterwards.
+     */
+    void RecordTlasUpdate(VkCommandBuffer commandBuffer, U32 frameIndex, const Scene& scene);
+
+    bool IsEmpty() const { return m_Frames.front().Tlas == VK_NULL_HANDLE; }
+    VkAccelerationStructureKHR GetTlas(U32 frameIndex) const { return m_Frames[frameIndex].Tlas; }
+    // Bindless indices of the geometry the hit shaders read
+    U32 GetVertexBufferIndex() const { return m_VertexBufferIndex; }
+    U32 GetIndexBufferIndex() const { return m_IndexBufferIndex; }
+    U32 GetMeshBufferIndex() const { return m_MeshBuffer.BindlessIndex; }
+    const Stats& GetStats() const { return m_Stats; }
+
+private:
+    struct GpuBuffer
+    {
+        VkBuffer Buffer = VK_NULL_HANDLE;
+        VkDeviceMemory Memory = VK_NULL_HANDLE;
+        VkDeviceAddress Address = 0;
+        U32 BindlessIndex = BindlessTable::InvalidIndex;
+        void* Mapped = nullptr; // Only host visible buffers
+    };
+
+    struct Frame
+    {
+        VkAccelerationStructureKHR Tlas = VK_NULL_HANDLE;
+        GpuBuffer TlasBuffer;
+        GpuBuffer Scratch;
+        GpuBuffer Instances; // Host visible, rewritten before every build or update
+        U64 SceneVersion = 0; // Of the scene the TLAS was built for, 0 if it was never built
+        U64 TransformVersion = 0;
+    };
+
+    /*
+     * The BLAS build inputs of one mesh.
+     */
+    struct BlasInput
+    {
+        VkAccelerationStructureGeometryKHR Geometry;
+        VkAccelerationStructureBuildRangeInfoKHR Range;
+        VkAccelerationStructureBuildSizesInfoKHR Sizes;
+    };
+
+private:
+    /*
+     * Builds the meshes [first, first + count) into one buffer, compacts them into another and frees the first.
+     * @param scratchAddress: the scratch of the meshes is packed from there, it's reused by the next batch
+     * @param queryPool: at least count compacted size queries
+     */
+    void BuildBlasBatch(const std::vector<BlasInput>& inputs, U32 first, U32 count, VkDeviceAddress scratchAddress,
+                        VkQueryPool queryPool);
+    void CreateTlases(U32 instanceCount);
+    void WriteInstances(const Frame& frame, const Scene& scene) const;
+
+    /*
+     * Creates an acceleration structure at the offset of the buffer, which needs
+     * VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR.
+     */
+    VkAccelerationStructureKHR CreateAccelerationStructure(VkAccelerationStructureTypeKHR type, VkBuffer buffer,
+                                                           VkDeviceSize offset, VkDeviceSize size) const;
+    GpuBuffer CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) const;
+    void DestroyBuffer(GpuBuffer& buffer) const;
+    VkCommandBuffer BeginCommands() const;
+    /*
+     * Submits the command buffer, waits for it and frees it.
+     */
+    void SubmitAndWait(VkCommandBuffer commandBuffer) const;
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    SharedPtr<PhysicalDevices> m_PhysicalDevices;
+    SharedPtr<Queue> m_Queue;
+    VkCommandPool m_CommandBufferPool = VK_NULL_HANDLE;
+    SharedPtr<BindlessTable> m_BindlessTable;
+
+    PFN_vkCreateAccelerationStructureKHR m_CreateAccelerationStructure = nullptr;
+    PFN_vkDestroyAccelerationStructureKHR m_DestroyAccelerationStructure = nullptr;
+    PFN_vkGetAccelerationStructureBuildSizesKHR m_GetBuildSizes = nullptr;
+    PFN_vkGetAccelerationStructureDeviceAddressKHR m_GetDeviceAddress = nullptr;
+    PFN_vkCmdBuildAccelerationStructuresKHR m_CmdBuild = nullptr;
+    PFN_vkCmdWriteAccelerationStructuresPropertiesKHR m_CmdWriteProperties = nullptr;
+    PFN_vkCmdCopyAccelerationStructureKHR m_CmdCopy = nullptr;
+    VkDeviceSize m_ScratchAlignment = 0;
+
+    // Indexed by mesh, meshes without triangles have no BLAS and their objects are inactive instances
+    std::vector<VkAccelerationStructureKHR> m_Blases;
+    std::vector<VkDeviceAddress> m_BlasAddresses;
+    std::vector<GpuBuffer> m_BlasBuffers; // One compacted buffer per batch
+
+    GpuBuffer m_MeshBuffer;
+    U32 m_VertexBufferIndex = BindlessTable::InvalidIndex;
+    U32 m_IndexBufferIndex = BindlessTable::InvalidIndex;
+
+    std::vector<Frame> m_Frames;
+    U32 m_InstanceCount = 0;
+    U64 m_SceneVersion = 0;
+    Stats m_Stats;
+};
+} // namespace FFV
@@ -0,0 +1,238 @@
+#include "FastFileViewerPCH.h"
+
+#include "BindlessTable.h"
+
+#include "vulkan/vulkan_core.h"
+
+namespace FFV
+{
+static constexpr std::array<VkDescriptorType, static_cast<U32>(BindlessTable::ResourceType::Count)> s_DescriptorTypes = {
+    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_DESCRIPTOR_TYPE_SAMPLER
+};
+
+static constexpr std::array<U32, static_cast<U32>(BindlessTable::ResourceType::Count)> s_DesiredCapacities = { 65536, 16384,
+                                                                                                              256 };
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BindlessTable::BindlessTable(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices)
+    : m_Device(device), m_PhysicalDevices(physicalDevices)
+{
+    QueryCapacities();
+    CreateDescriptorSetLayout();
+    CreateDescriptorPool();
+    AllocateDescriptorSet();
+
+    FFV_TRACE("Created bindless table ({0} storage buffers, {1} sampled images, {2} samplers)!",
+              GetCapacity(ResourceType::StorageBuffer), GetCapacity(ResourceType::SampledImage),
+              GetCapacity(ResourceType::Sampler));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BindlessTable::~BindlessTable()
+{
+    vkDestroyDescriptorPool(m_Device, m_DescriptorPool, VK_NULL_HANDLE);
+    vkDestroyDescriptorSetLayout(m_Device, m_DescriptorSetLayout, VK_NULL_HANDLE);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U32 BindlessTable::RegisterStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    const U32 index = AllocateIndex(ResourceType::StorageBuffer);
+    UpdateStorageBuffer(index, buffer, offset, range);
+    return index;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U32 BindlessTable::RegisterSampledImage(VkImageView imageView, VkImageLayout layout)
+{
+    const U32 index = AllocateIndex(ResourceType::SampledImage);
+    const VkDescriptorImageInfo imageInfo = { .imageView = imageView, .imageLayout = layout };
+    WriteDescriptor(ResourceType::SampledImage, index, nullptr, &imageInfo);
+    return index;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U32 BindlessTable::RegisterSampler(VkSampler sampler)
+{
+    const U32 index = AllocateIndex(ResourceType::Sampler);
+    const VkDescriptorImageInfo imageInfo = { .sampler = sampler };
+    WriteDescriptor(ResourceType::Sampler, index, nullptr, &imageInfo);
+    return index;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BindlessTable::UpdateStorageBuffer(U32 index, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    const VkDescriptorBufferInfo bufferInfo = { .buffer = buffer, .offset = offset, .range = range };
+    WriteDescriptor(ResourceType::StorageBuffer, index, &bufferInfo, nullptr);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BindlessTable::Release(ResourceType type, U32 index)
+{
+    Slots& slots = m_Slots[static_cast<U32>(type)];
+    FFV_ASSERT(index < slots.NextIndex, std::format("Bindless index {} was never registered!", index), return);
+
+    // Partially bound bindings allow stale descriptors as long as no shader reads them, so the slot is simply reused
+    slots.FreeIndices.push_back(index);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BindlessTable::Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout,
+                         U32 set) const
+{
+    vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, set, 1, &m_DescriptorSet, 0, nullptr);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BindlessTable::QueryCapacities()
+{
+    VkPhysicalDeviceDescriptorIndexingProperties indexingProperties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES
+    };
+    VkPhysicalDeviceProperties2 properties = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+                                               .pNext = &indexingProperties };
+    vkGetPhysicalDeviceProperties2(m_PhysicalDevices->GetSelectedPhysicalDevice().PhysicalDevice, &properties);
+
+    const std::array<U32, static_cast<U32>(ResourceType::Count)> perStageLimits = {
+        std::min(indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+                 indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers),
+        std::min(indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                 indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages),
+        std::min(indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+                 indexingProperties.maxDescriptorSetUpdateAfterBindSamplers)
+    };
+
+    U32 totalResources = 0;
+    for (U32 i = 0; i < m_Slots.size(); i++)
+    {
+        m_Slots[i].Capacity = std::min(s_DesiredCapacities[i], perStageLimits[i]);
+        totalResources += m_Slots[i].Capacity;
+    }
+
+    // Every stage sees the whole table, so the sum also has to fit into the per stage resource limit
+    if (totalResources > indexingProperties.maxPerStageUpdateAfterBindResources)
+    {
+        const F64 scale = static_cast<F64>(indexingProperties.maxPerStageUpdateAfterBindResources) / totalResources;
+        for (Slots& slots : m_Slots)
+        {
+            slots.Capacity = std::max(1u, static_cast<U32>(slots.Capacity * scale));
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BindlessTable::CreateDescriptorSetLayout()
+{
+    std::array<VkDescriptorSetLayoutBinding, static_cast<U32>(ResourceType::Count)> bindings;
+    std::array<VkDescriptorBindingFlags, static_cast<U32>(ResourceType::Count)> bindingFlags;
+
+    for (U32 i = 0; i < bindings.size(); i++)
+    {
+        bindings[i] = { .binding = i,
+                        .descriptorType = s_DescriptorTypes[i],
+                        .descriptorCount = m_Slots[i].Capacity,
+                        .stageFlags = VK_SHADER_STAGE_ALL,
+                        .pImmutableSamplers = nullptr };
+
+        bindingFlags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                          VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    }
+
+    const VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = static_cast<U32>(bindingFlags.size()),
+        .pBindingFlags = bindingFlags.data()
+    };
+
+    const VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &bindingFlagsCreateInfo,
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        .bindingCount = static_cast<U32>(bindings.size()),
+        .pBindings = bindings.data()
+    };
+
+    FFV_CHECK_VK_RESULT(
+        vkCreateDescriptorSetLayout(m_Device, &descriptorSetLayoutCreateInfo, VK_NULL_HANDLE, &m_DescriptorSetLayout));
+    m_LayoutHash = Util::HashDescriptorSetLayout(descriptorSetLayoutCreateInfo);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BindlessTable::CreateDescriptorPool()
+{
+    std::array<VkDescriptorPoolSize, static_cast<U32>(ResourceType::Count)> poolSizes;
+    for (U32 i = 0; i < poolSizes.size(); i++)
+    {
+        poolSizes[i] = { .type = s_DescriptorTypes[i], .descriptorCount = m_Slots[i].Capacity };
+    }
+
+    const VkDescriptorPoolCreateInfo poolCreateInfo = { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                                                        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+                                                        .maxSets = 1,
+                                                        .poolSizeCount = static_cast<U32>(poolSizes.size()),
+                                                        .pPoolSizes = poolSizes.data() };
+
+    FFV_CHECK_VK_RESULT(vkCreateDescriptorPool(m_Device, &poolCreateInfo, VK_NULL_HANDLE, &m_DescriptorPool));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BindlessTable::AllocateDescriptorSet()
+{
+    const VkDescriptorSetAllocateInfo allocInfo = { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                                                    .descriptorPool = m_DescriptorPool,
+                                                    .descriptorSetCount = 1,
+                                                    .pSetLayouts = &m_DescriptorSetLayout };
+
+    FFV_CHECK_VK_RESULT(vkAllocateDescriptorSets(m_Device, &allocInfo, &m_DescriptorSet));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U32 BindlessTable::AllocateIndex(ResourceType type)
+{
+    Slots& slots = m_Slots[static_cast<U32>(type)];
+
+    if (!slots.FreeIndices.empty())
+    {
+        const U32 index = slots.FreeIndices.back();
+        slots.FreeIndices.pop_back();
+        return index;
+    }
+
+    FFV_ASSERT(slots.NextIndex < slots.Capacity,
+               std::format("Bindless table is full! Capacity: {}", slots.Capacity), return InvalidIndex);
+    return slots.NextIndex++;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BindlessTable::WriteDescriptor(ResourceType type, U32 index, const VkDescriptorBufferInfo* bufferInfo,
+                                    const VkDescriptorImageInfo* imageInfo) const
+{
+    FFV_ASSERT(index < m_Slots[static_cast<U32>(type)].Capacity, "Bindless index is out of bounds!", return);
+
+    const VkWriteDescriptorSet descriptorWrite = { .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                                                   .dstSet = m_DescriptorSet,
+                                                   .dstBinding = static_cast<U32>(type),
+                                                   .dstArrayElement = index,
+                                                   .descriptorCount = 1,
+                                                   .descriptorType = s_DescriptorTypes[static_cast<U32>(type)],
+                                                   .pImageInfo = imageInfo,
+                                                   .pBufferInfo = bufferInfo };
+
+    vkUpdateDescriptorSets(m_Device, 1, &descriptorWrite, 0, nullptr);
+}
+} // namespace FFV
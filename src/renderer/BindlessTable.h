@@ -0,0 +1,87 @@
+#pragma once
+
+#include "renderer/PhysicalDevice.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <array>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * One large update-after-bind descriptor set that holds every storage buffer, sampled image and sampler.
+ * Resources are addressed by the index returned on registration, which shaders receive through push constants,
+ * so the set is bound once per frame instead of once per draw.
+ */
+class BindlessTable
+{
+public:
+    enum class ResourceType : U32
+    {
+        StorageBuffer = 0,
+        SampledImage = 1,
+        Sampler = 2,
+        Count = 3
+    };
+
+    static constexpr U32 InvalidIndex = ~0u;
+
+public:
+    BindlessTable(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices);
+    ~BindlessTable();
+
+    FFV_DELETE_MOVE_COPY(BindlessTable);
+
+    U32 RegisterStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    U32 RegisterSampledImage(VkImageView imageView, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    U32 RegisterSampler(VkSampler sampler);
+
+    void UpdateStorageBuffer(U32 index, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+    /*
+     * The caller has to make sure that no frame in flight still reads the resource.
+     * @param type: the table the index was registered in
+     * @param index: the index returned by one of the Register functions
+     */
+    void Release(ResourceType type, U32 index);
+
+    void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, U32 set) const;
+
+    VkDescriptorSetLayout GetDescriptorSetLayout() const { return m_DescriptorSetLayout; }
+    VkDescriptorSet GetDescriptorSet() const { return m_DescriptorSet; }
+    U32 GetCapacity(ResourceType type) const { return m_Slots[static_cast<U32>(type)].Capacity; }
+    // Hash of the set layout description, part of the layout hash of every pipeline that binds the table
+    U64 GetLayoutHash() const { return m_LayoutHash; }
+
+private:
+    struct Slots
+    {
+        std::vector<U32> FreeIndices;
+        U32 NextIndex = 0;
+        U32 Capacity = 0;
+    };
+
+private:
+    void QueryCapacities();
+    void CreateDescriptorSetLayout();
+    void CreateDescriptorPool();
+    void AllocateDescriptorSet();
+
+    U32 AllocateIndex(ResourceType type);
+    void WriteDescriptor(ResourceType type, U32 index, const VkDescriptorBufferInfo* bufferInfo,
+                         const VkDescriptorImageInfo* imageInfo) const;
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    SharedPtr<PhysicalDevices> m_PhysicalDevices;
+
+    VkDescriptorSetLayout m_DescriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet m_DescriptorSet = VK_NULL_HANDLE;
+    U64 m_LayoutHash = 0;
+
+    std::array<Slots, static_cast<U32>(ResourceType::Count)> m_Slots;
+};
+} // namespace FFV
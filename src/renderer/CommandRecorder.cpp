@@ -0,0 +1,155 @@
+#include "FastFileViewerPCH.h"
+
+#include "CommandRecorder.h"
+
+#include "util/JobSystem.h"
+#include "util/Profiler.h"
+#include "vulkan/vulkan_core.h"
+
+namespace FFV
+{
+CommandRecorder::CommandRecorder(VkDevice device, U32 queueFamily, U32 framesInFlight)
+    : m_Device(device), m_QueueFamily(queueFamily)
+{
+    m_Frames.resize(framesInFlight);
+
+    for (Frame& frame : m_Frames)
+    {
+        frame.PrimaryCommandPool = CreateCommandPool();
+
+        const VkCommandBufferAllocateInfo commandBufferAllocateInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = frame.PrimaryCommandPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1
+        };
+        FFV_CHECK_VK_RESULT(vkAllocateCommandBuffers(m_Device, &commandBufferAllocateInfo, &frame.PrimaryCommandBuffer));
+
+        frame.ThreadPools.resize(JobSystem::GetNumThreads());
+        for (ThreadPool& threadPool : frame.ThreadPools)
+        {
+            threadPool.CommandPool = CreateCommandPool();
+        }
+    }
+
+    FFV_TRACE("Created command recorder with {0} threads and {1} frames in flight!", JobSystem::GetNumThreads(),
+              framesInFlight);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CommandRecorder::~CommandRecorder()
+{
+    // Destroying a pool frees all command buffers allocated from it
+    for (const Frame& frame : m_Frames)
+    {
+        vkDestroyCommandPool(m_Device, frame.PrimaryCommandPool, VK_NULL_HANDLE);
+
+        for (const ThreadPool& threadPool : frame.ThreadPools)
+        {
+            vkDestroyCommandPool(m_Device, threadPool.CommandPool, VK_NULL_HANDLE);
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+VkCommandBuffer CommandRecorder::BeginFrame(U32 frameIndex)
+{
+    Frame& frame = m_Frames[frameIndex];
+
+    FFV_CHECK_VK_RESULT(vkResetCommandPool(m_Device, frame.PrimaryCommandPool, 0));
+
+    for (ThreadPool& threadPool : frame.ThreadPools)
+    {
+        FFV_CHECK_VK_RESULT(vkResetCommandPool(m_Device, threadPool.CommandPool, 0));
+        threadPool.UsedSecondaryCommandBuffers = 0;
+    }
+
+    return frame.PrimaryCommandBuffer;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CommandRecorder::RecordDraws(VkCommandBuffer primaryCommandBuffer, U32 frameIndex,
+                                  const VkCommandBufferInheritanceRenderingInfo& inheritanceRenderingInfo,
+                                  U32 drawCount, U32 drawsPerRange, const RecordRangeFn& recordRange, U32 maxThreads)
+{
+    FFV_PROFILE_FUNCTION();
+
+    if (drawCount == 0)
+    {
+        return;
+    }
+
+    drawsPerRange = std::max(drawsPerRange, 1u);
+    const U32 rangeCount = (drawCount + drawsPerRange - 1) / drawsPerRange;
+
+    Frame& frame = m_Frames[frameIndex];
+    m_RangeCommandBuffers.resize(rangeCount);
+
+    const VkCommandBufferInheritanceInfo inheritanceInfo = { .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+                                                             .pNext = &inheritanceRenderingInfo };
+
+    const VkCommandBufferBeginInfo beginInfo = { .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                                 .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                                                          VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+                                                 .pInheritanceInfo = &inheritanceInfo };
+
+    JobSystem::ParallelFor(
+        rangeCount,
+        [&](U32 rangeIndex, U32 threadIndex)
+        {
+            FFV_PROFILE_SCOPE("RecordDrawRange");
+
+            // Only this thread touches its pool, so no locking is required
+            const VkCommandBuffer commandBuffer = GetSecondaryCommandBuffer(frame.ThreadPools[threadIndex]);
+
+            const U32 first = rangeIndex * drawsPerRange;
+            const U32 count = std::min(drawsPerRange, drawCount - first);
+
+            FFV_CHECK_VK_RESULT(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+            recordRange(commandBuffer, first, count);
+            FFV_CHECK_VK_RESULT(vkEndCommandBuffer(commandBuffer));
+
+            m_RangeCommandBuffers[rangeIndex] = commandBuffer;
+        },
+        maxThreads);
+
+    vkCmdExecuteCommands(primaryCommandBuffer, rangeCount, m_RangeCommandBuffers.data());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+VkCommandPool CommandRecorder::CreateCommandPool() const
+{
+    const VkCommandPoolCreateInfo commandPoolCreateInfo = { .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                                                            .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                                                            .queueFamilyIndex = m_QueueFamily };
+
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    FFV_CHECK_VK_RESULT(vkCreateCommandPool(m_Device, &commandPoolCreateInfo, VK_NULL_HANDLE, &commandPool));
+    return commandPool;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+VkCommandBuffer CommandRecorder::GetSecondaryCommandBuffer(ThreadPool& threadPool) const
+{
+    if (threadPool.UsedSecondaryCommandBuffers == threadPool.SecondaryCommandBuffers.size())
+    {
+        const VkCommandBufferAllocateInfo commandBufferAllocateInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = threadPool.CommandPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+            .commandBufferCount = 1
+        };
+
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        FFV_CHECK_VK_RESULT(vkAllocateCommandBuffers(m_Device, &commandBufferAllocateInfo, &commandBuffer));
+        threadPool.SecondaryCommandBuffers.push_back(commandBuffer);
+    }
+
+    return threadPool.SecondaryCommandBuffers[threadPool.UsedSecondaryCommandBuffers++];
+}
+} // namespace FFV
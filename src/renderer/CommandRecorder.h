@@ -0,0 +1,77 @@
+#pragma once
+
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <functional>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * Records a frame with all job system threads. Every thread owns one command pool per frame in flight, the pools of a
+ * frame are reset as a whole once the GPU is done with it instead of resetting individual command buffers.
+ * Draw ranges are recorded into secondary command buffers which are executed in range order, so the submitted
+ * commands are the same no matter which thread recorded which range.
+ */
+class CommandRecorder
+{
+public:
+    /*
+     * @param commandBuffer: secondary command buffer that is already inside the inherited rendering
+     * @param first: index of the first draw of the range
+     * @param count: number of draws in the range
+     */
+    using RecordRangeFn = std::function<void(VkCommandBuffer commandBuffer, U32 first, U32 count)>;
+
+public:
+    CommandRecorder(VkDevice device, U32 queueFamily, U32 framesInFlight);
+    ~CommandRecorder();
+
+    FFV_DELETE_MOVE_COPY(CommandRecorder);
+
+    /*
+     * Resets all command pools of the frame, the GPU must no longer use any command buffer of it.
+     * @return: the primary command buffer of the frame
+     */
+    VkCommandBuffer BeginFrame(U32 frameIndex);
+
+    /*
+     * Must be called between vkCmdBeginRendering with VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT and
+     * vkCmdEndRendering.
+     * @param inheritanceRenderingInfo: has to match the rendering info of the primary command buffer
+     * @param drawsPerRange: number of draws per secondary command buffer
+     * @param maxThreads: upper limit of threads used for recording, mostly useful for benchmarking
+     */
+    void RecordDraws(VkCommandBuffer primaryCommandBuffer, U32 frameIndex,
+                     const VkCommandBufferInheritanceRenderingInfo& inheritanceRenderingInfo, U32 drawCount,
+                     U32 drawsPerRange, const RecordRangeFn& recordRange, U32 maxThreads = ~0u);
+
+private:
+    struct ThreadPool
+    {
+        VkCommandPool CommandPool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> SecondaryCommandBuffers;
+        U32 UsedSecondaryCommandBuffers = 0;
+    };
+
+    struct Frame
+    {
+        VkCommandPool PrimaryCommandPool = VK_NULL_HANDLE;
+        VkCommandBuffer PrimaryCommandBuffer = VK_NULL_HANDLE;
+        std::vector<ThreadPool> ThreadPools;
+    };
+
+private:
+    VkCommandPool CreateCommandPool() const;
+    VkCommandBuffer GetSecondaryCommandBuffer(ThreadPool& threadPool) const;
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    U32 m_QueueFamily = 0;
+
+    std::vector<Frame> m_Frames;
+    std::vector<VkCommandBuffer> m_RangeCommandBuffers;
+};
+} // namespace FFV
@@ -0,0 +1,64 @@
+#include "FastFileViewerPCH.h"
+
+#include "ComputePipeline.h"
+
+#include "util/Log.h"
+#include "vulkan/vulkan_core.h"
+
+namespace FFV
+{
+ComputePipeline::ComputePipeline(VkDevice device, SharedPtr<BindlessTable> bindlessTable,
+                                 SharedPtr<PipelineCache> pipelineCache, SharedPtr<Shader> shader, U32 pushConstantSize)
+    : m_Device(device), m_BindlessTable(bindlessTable), m_PushConstantSize(pushConstantSize)
+{
+    const VkDescriptorSetLayout setLayout = m_BindlessTable->GetDescriptorSetLayout();
+
+    const VkPushConstantRange pushConstantRange = { .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                                                    .offset = 0,
+                                                    .size = m_PushConstantSize };
+
+    const VkPipelineLayoutCreateInfo layoutCreateInfo = { .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                                                          .setLayoutCount = 1,
+                                                          .pSetLayouts = &setLayout,
+                                                          .pushConstantRangeCount = 1,
+                                                          .pPushConstantRanges = &pushConstantRange };
+
+    FFV_CHECK_VK_RESULT(vkCreatePipelineLayout(m_Device, &layoutCreateInfo, VK_NULL_HANDLE, &m_PipelineLayout));
+
+    const VkComputePipelineCreateInfo computePipelineCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = { .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                  .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                  .module = shader->GetShaderModule(),
+                  .pName = "main" },
+        .layout = m_PipelineLayout
+    };
+
+    // The bindless table is the only set
+    U64 layoutHash = Util::HashBytes(&pushConstantRange, sizeof(pushConstantRange));
+    Util::HashCombine(layoutHash, m_BindlessTable->GetLayoutHash());
+
+    m_Pipeline = pipelineCache->GetOrCreateComputePipeline(computePipelineCreateInfo, shader->GetHash(), layoutHash);
+
+    FFV_TRACE("Created vulkan compute pipeline!");
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ComputePipeline::~ComputePipeline() { vkDestroyPipelineLayout(m_Device, m_PipelineLayout, VK_NULL_HANDLE); }
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ComputePipeline::Bind(VkCommandBuffer commandBuffer) const
+{
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+    m_BindlessTable->Bind(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, BindlessSet);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ComputePipeline::PushConstants(VkCommandBuffer commandBuffer, const void* data) const
+{
+    vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, m_PushConstantSize, data);
+}
+} // namespace FFV
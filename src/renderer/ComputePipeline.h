@@ -0,0 +1,49 @@
+#pragma once
+
+#include "renderer/BindlessTable.h"
+#include "renderer/PipelineCache.h"
+#include "renderer/Shader.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * Compute pipeline that only sees the bindless table and a block of push constants, all buffers are addressed through
+ * indices into the table.
+ */
+class ComputePipeline
+{
+public:
+    static constexpr U32 BindlessSet = 0;
+
+public:
+    /*
+     * @param pushConstantSize: size of the push constant block in bytes, has to be a multiple of 4
+     */
+    ComputePipeline(VkDevice device, SharedPtr<BindlessTable> bindlessTable, SharedPtr<PipelineCache> pipelineCache,
+                    SharedPtr<Shader> shader, U32 pushConstantSize);
+    ~ComputePipeline();
+
+    FFV_DELETE_MOVE_COPY(ComputePipeline);
+
+    /*
+     * Binds the pipeline and the bindless table.
+     */
+    void Bind(VkCommandBuffer commandBuffer) const;
+    void PushConstants(VkCommandBuffer commandBuffer, const void* data) const;
+
+    VkPipelineLayout GetPipelineLayout() const { return m_PipelineLayout; }
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    SharedPtr<BindlessTable> m_BindlessTable;
+    U32 m_PushConstantSize = 0;
+
+    // Owned by the pipeline cache
+    VkPipeline m_Pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+};
+} // namespace FFV
@@ -0,0 +1,425 @@
+#include "FastFileViewerPCH.h"
+
+#include "CullingPass.h"
+
+#include "renderer/Shader.h"
+#include "util/Log.h"
+#include "vulkan/vulkan_core.h"
+
+#include <limits>
+
+namespace FFV
+{
+static constexpr U32 s_WorkgroupSize = 64;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CullingPass::CullingPass(VkDevice device, U32 framesInFlight, SharedPtr<PhysicalDevices> physicalDevices,
+                         SharedPtr<Uploader> uploader, SharedPtr<BindlessTable> bindlessTable,
+                         SharedPtr<PipelineCache> pipelineCache)
+    : m_Device(device), m_PhysicalDevices(physicalDevices), m_Uploader(uploader), m_BindlessTable(bindlessTable)
+{
+    m_Pipeline = MakeUnique<ComputePipeline>(m_Device, m_BindlessTable, pipelineCache,
+                                             MakeShared<Shader>(m_Device, "cull.comp.spv"), sizeof(CullConstants));
+
+    m_Frames.resize(framesInFlight);
+    for (Frame& frame : m_Frames)
+    {
+        frame.FrameData = CreateHostBuffer(sizeof(CullFrameData), MemoryCategory::Uniform);
+        frame.Stats = CreateHostBuffer(sizeof(GpuStats), MemoryCategory::Readback);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CullingPass::~CullingPass()
+{
+    for (GpuBuffer* buffer : GetSceneBuffers())
+    {
+        DestroyBuffer(*buffer);
+    }
+    DestroyRetired(std::numeric_limits<U64>::max());
+
+    for (Frame& frame : m_Frames)
+    {
+        DestroyBuffer(frame.FrameData);
+        DestroyBuffer(frame.Stats);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CullingPass::SetScene(const Scene& scene, U64 retireFrameNumber)
+{
+    RetireBuffers(retireFrameNumber);
+
+    m_ObjectCount = scene.GetObjectCount();
+    m_Meshes = scene.GetMeshes();
+
+    std::vector<U32> instances;
+    scene.BuildBatches(m_Batches, instances);
+
+    if (m_ObjectCount == 0)
+    {
+        return;
+    }
+
+    for (const Scene::Batch& batch : m_Batches)
+    {
+        m_TriangleCount += static_cast<U64>(m_Meshes[batch.MeshIndex].IndexCount / 3) * batch.InstanceCount;
+    }
+
+    std::vector<U32> meshBatches(m_Meshes.size(), ~0u);
+    std::vector<VkDrawIndexedIndirectCommand> drawCommands;
+    drawCommands.reserve(m_Batches.size());
+
+    for (U32 batchIndex = 0; batchIndex < m_Batches.size(); batchIndex++)
+    {
+        const Scene::Batch& batch = m_Batches[batchIndex];
+        const Scene::Mesh& mesh = m_Meshes[batch.MeshIndex];
+
+        meshBatches[batch.MeshIndex] = batchIndex;
+        drawCommands.push_back({ .indexCount = mesh.IndexCount,
+                                 .instanceCount = 0,
+                                 .firstIndex = mesh.FirstIndex,
+                                 .vertexOffset = mesh.VertexOffset,
+                                 .firstInstance = batch.FirstInstance });
+    }
+
+    std::vector<U32> batchIndices(m_ObjectCount);
+    for (U32 objectIndex = 0; objectIndex < m_ObjectCount; objectIndex++)
+    {
+        batchIndices[objectIndex] = meshBatches[scene.GetMeshIndices()[objectIndex]];
+    }
+
+    const VkDeviceSize objectCount = m_ObjectCount;
+    const VkDeviceSize batchCount = m_Batches.size();
+
+    m_Transforms = CreateBuffer(sizeof(glm::mat4) * objectCount, 0, scene.GetTransforms().data());
+    m_Bounds = CreateBuffer(sizeof(glm::vec4) * objectCount, 0, scene.GetBounds().data());
+    m_BatchIndices = CreateBuffer(sizeof(U32) * objectCount, 0, batchIndices.data());
+    m_MaterialIndices = CreateBuffer(sizeof(U32) * objectCount, 0, scene.GetMaterialIndices().data());
+    m_Instances = CreateBuffer(sizeof(U32) * objectCount, 0, instances.data());
+    m_DrawCommandTemplate = CreateBuffer(sizeof(VkDrawIndexedIndirectCommand) * batchCount,
+                                         VK_BUFFER_USAGE_TRANSFER_SRC_BIT, drawCommands.data());
+    // Nothing was visible before the first frame, so the first late pass draws everything in the frustum
+    m_Visibility = CreateBuffer(sizeof(U32) * objectCount, 0, std::vector<U32>(m_ObjectCount, 0).data());
+
+    for (Frame& frame : m_Frames)
+    {
+        for (PhaseBuffers* buffers : { &frame.Early, &frame.Late })
+        {
+            buffers->DrawCommands = CreateBuffer(sizeof(VkDrawIndexedIndirectCommand) * batchCount,
+                                                 VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+            buffers->VisibleInstances = CreateBuffer(sizeof(U32) * objectCount, 0);
+        }
+    }
+
+    FFV_TRACE("Uploaded scene with {0} objects in {1} batches for GPU culling!", m_ObjectCount, m_Batches.size());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CullingPass::DestroyRetired(U64 completedFrameNumber)
+{
+    std::erase_if(m_RetiredBuffers,
+                  [&](RetiredBuffers& retired)
+                  {
+                      if (retired.RetireFrameNumber > completedFrameNumber)
+                      {
+                          return false;
+                      }
+
+                      for (GpuBuffer& buffer : retired.Buffers)
+                      {
+                          DestroyBuffer(buffer);
+                      }
+                      return true;
+                  });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+VkDeviceSize CullingPass::GetSceneBytes(U32 objectCount, U32 batchCount) const
+{
+    const VkDeviceSize objects = objectCount;
+    const VkDeviceSize batches = batchCount;
+
+    // Transforms, bounds, batch indices, material indices, instances, visibility and the draw command template
+    const VkDeviceSize sceneBytes = (sizeof(glm::mat4) + sizeof(glm::vec4) + 4 * sizeof(U32)) * objects +
+                                    sizeof(VkDrawIndexedIndirectCommand) * batches;
+    // Draw commands and visible instances of the early and the late pass
+    const VkDeviceSize frameBytes = 2 * (sizeof(VkDrawIndexedIndirectCommand) * batches + sizeof(U32) * objects);
+
+    return sceneBytes + frameBytes * m_Frames.size();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CullingPass::RecordCulling(VkCommandBuffer commandBuffer, U32 frameIndex, const glm::mat4& viewProjection,
+                                CullPhase phase, const HiZPyramid* pyramid)
+{
+    FFV_ASSERT(phase != CullPhase::Late || pyramid, "The late culling phase needs a depth pyramid!", return);
+
+    Frame& frame = m_Frames[frameIndex];
+    if (phase != CullPhase::Late)
+    {
+        // The GPU is done with the frame index, so its host visible buffers can be read and overwritten
+        CollectStats(frame);
+        frame.StatsPending = !m_Batches.empty();
+        frame.Occlusion = phase == CullPhase::Early;
+
+        const CullFrameData frameData = { .frustumPlanes = ExtractFrustumPlanes(viewProjection),
+                                          .viewProjection = viewProjection,
+                                          .boundsBufferIndex = m_Bounds.BindlessIndex,
+                                          .batchIndexBufferIndex = m_BatchIndices.BindlessIndex,
+                                          .visibilityBufferIndex = m_Visibility.BindlessIndex,
+                                          .statsBufferIndex = frame.Stats.BindlessIndex,
+                                          .objectCount = m_ObjectCount };
+        memcpy(frame.FrameData.Mapped, &frameData, sizeof(frameData));
+    }
+
+    if (m_Batches.empty())
+    {
+        return;
+    }
+
+    const PhaseBuffers& buffers = GetPhaseBuffers(frame, phase);
+
+    const VkBufferCopy copyRegion = { .size = sizeof(VkDrawIndexedIndirectCommand) * m_Batches.size() };
+    vkCmdCopyBuffer(commandBuffer, m_DrawCommandTemplate.Buffer, buffers.DrawCommands.Buffer, 1, &copyRegion);
+
+    // Also orders the visibility reads and writes after the late pass of the previous frame and the early pass
+    const VkMemoryBarrier2 resetBarrier = { .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                            .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT |
+                                                            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT |
+                                                             VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                                            .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                            .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                                                             VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT };
+
+    const VkDependencyInfo resetDependencyInfo = { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                                   .memoryBarrierCount = 1,
+                                                   .pMemoryBarriers = &resetBarrier };
+    vkCmdPipelineBarrier2(commandBuffer, &resetDependencyInfo);
+
+    const CullConstants constants = {
+        .frameDataBufferIndex = frame.FrameData.BindlessIndex,
+        .phase = phase,
+        .drawCommandBufferIndex = buffers.DrawCommands.BindlessIndex,
+        .visibleInstanceBufferIndex = buffers.VisibleInstances.BindlessIndex,
+        .pyramidBufferIndex = pyramid ? pyramid->GetBufferIndex() : BindlessTable::InvalidIndex,
+        .pyramidLevelCount = pyramid ? pyramid->GetLevelCount() : 0,
+        .depthWidth = pyramid ? pyramid->GetDepthExtent().width : 0,
+        .depthHeight = pyramid ? pyramid->GetDepthExtent().height : 0
+    };
+
+    m_Pipeline->Bind(commandBuffer);
+    m_Pipeline->PushConstants(commandBuffer, &constants);
+    vkCmdDispatch(commandBuffer, (m_ObjectCount + s_WorkgroupSize - 1) / s_WorkgroupSize, 1, 1);
+
+    // The host reads the stats once the frame index comes around again
+    const VkMemoryBarrier2 cullBarrier = { .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                           .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                           .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                                           .dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT |
+                                                           VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT |
+                                                           VK_PIPELINE_STAGE_2_HOST_BIT,
+                                           .dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT |
+                                                            VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                                                            VK_ACCESS_2_HOST_READ_BIT };
+
+    const VkDependencyInfo cullDependencyInfo = { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                                  .memoryBarrierCount = 1,
+                                                  .pMemoryBarriers = &cullBarrier };
+    vkCmdPipelineBarrier2(commandBuffer, &cullDependencyInfo);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CullingPass::RecordDrawIndirect(VkCommandBuffer commandBuffer, U32 frameIndex, CullPhase phase) const
+{
+    if (m_Batches.empty())
+    {
+        return;
+    }
+
+    // Batches without visible instances stay in the buffer as zero instance draws
+    vkCmdDrawIndexedIndirect(commandBuffer, GetPhaseBuffers(m_Frames[frameIndex], phase).DrawCommands.Buffer, 0,
+                             static_cast<U32>(m_Batches.size()), sizeof(VkDrawIndexedIndirectCommand));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string CullingPass::FormatStats() const
+{
+    const auto percent = [this](U64 triangles)
+    { return m_Stats.Triangles == 0 ? 0.0 : 100.0 * static_cast<F64>(triangles) / static_cast<F64>(m_Stats.Triangles); };
+    const U64 frustumCulledTriangles = m_Stats.Triangles - std::min(m_Stats.FrustumVisibleTriangles, m_Stats.Triangles);
+
+    return std::format("Culling ({0}): {1} / {2} objects drawn, {3} by the late pass, {4} occluded\n"
+                       "    {5:.3f}M / {6:.3f}M triangles drawn, {7:.1f}% frustum culled, {8:.1f}% occluded",
+                       m_Stats.Occlusion ? "frustum and occlusion" : "frustum", m_Stats.DrawnObjects, m_Stats.Objects,
+                       m_Stats.LateObjects, m_Stats.OccludedObjects, static_cast<F64>(m_Stats.DrawnTriangles) / 1e6,
+                       static_cast<F64>(m_Stats.Triangles) / 1e6, percent(frustumCulledTriangles),
+                       percent(m_Stats.OccludedTriangles));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::array<glm::vec4, 6> CullingPass::ExtractFrustumPlanes(const glm::mat4& viewProjection)
+{
+    // Gribb/Hartmann, glm matrices are column major so rows have to be gathered. The near plane uses the -w..w depth
+    // range, which is a superset of the 0..w range Vulkan clips against.
+    const glm::mat4 rows = glm::transpose(viewProjection);
+
+    std::array<glm::vec4, 6> planes = {
+        rows[3] + rows[0], // Left
+        rows[3] - rows[0], // Right
+        rows[3] + rows[1], // Bottom
+        rows[3] - rows[1], // Top
+        rows[3] + rows[2], // Near
+        rows[3] - rows[2]  // Far
+    };
+
+    for (glm::vec4& plane : planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    return planes;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CullingPass::GpuBuffer CullingPass::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, const void* data) const
+{
+    GpuBuffer buffer;
+    Util::CreateBuffer(m_Device, m_PhysicalDevices, size,
+                       usage | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer.Buffer, buffer.Memory,
+                       MemoryCategory::Storage);
+    buffer.BindlessIndex = m_BindlessTable->RegisterStorageBuffer(buffer.Buffer);
+
+    if (data)
+    {
+        m_Uploader->Upload(buffer.Buffer, 0, data, size);
+    }
+
+    return buffer;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CullingPass::GpuBuffer CullingPass::CreateHostBuffer(VkDeviceSize size, MemoryCategory category) const
+{
+    GpuBuffer buffer;
+    Util::CreateBuffer(m_Device, m_PhysicalDevices, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer.Buffer,
+                       buffer.Memory, category);
+    buffer.BindlessIndex = m_BindlessTable->RegisterStorageBuffer(buffer.Buffer);
+
+    FFV_CHECK_VK_RESULT(vkMapMemory(m_Device, buffer.Memory, 0, size, 0, &buffer.Mapped));
+    memset(buffer.Mapped, 0, size);
+
+    return buffer;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CullingPass::DestroyBuffer(GpuBuffer& buffer) const
+{
+    if (buffer.Buffer == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    if (buffer.Mapped)
+    {
+        vkUnmapMemory(m_Device, buffer.Memory);
+    }
+
+    m_BindlessTable->Release(BindlessTable::ResourceType::StorageBuffer, buffer.BindlessIndex);
+    vkDestroyBuffer(m_Device, buffer.Buffer, VK_NULL_HANDLE);
+    Util::FreeMemory(m_Device, buffer.Memory);
+    buffer = {};
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CullingPass::RetireBuffers(U64 retireFrameNumber)
+{
+    RetiredBuffers retired = { .RetireFrameNumber = retireFrameNumber };
+    for (GpuBuffer* buffer : GetSceneBuffers())
+    {
+        if (buffer->Buffer != VK_NULL_HANDLE)
+        {
+            retired.Buffers.push_back(*buffer);
+            *buffer = {};
+        }
+    }
+    if (!retired.Buffers.empty())
+    {
+        m_RetiredBuffers.push_back(std::move(retired));
+    }
+    m_TriangleCount = 0;
+
+    // Frames in flight still count the old scene, their counters are reset once they're done
+    for (Frame& frame : m_Frames)
+    {
+        frame.StatsOutdated = frame.StatsPending;
+    }
+    m_Stats = {};
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<CullingPass::GpuBuffer*> CullingPass::GetSceneBuffers()
+{
+    std::vector<GpuBuffer*> buffers = { &m_Transforms, &m_Bounds,     &m_BatchIndices,       &m_MaterialIndices,
+                                        &m_Instances,  &m_Visibility, &m_DrawCommandTemplate };
+    for (Frame& frame : m_Frames)
+    {
+        for (PhaseBuffers* phaseBuffers : { &frame.Early, &frame.Late })
+        {
+            buffers.push_back(&phaseBuffers->DrawCommands);
+            buffers.push_back(&phaseBuffers->VisibleInstances);
+        }
+    }
+
+    return buffers;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CullingPass::CollectStats(Frame& frame)
+{
+    if (!frame.StatsPending)
+    {
+        return;
+    }
+
+    GpuStats gpuStats;
+    memcpy(&gpuStats, frame.Stats.Mapped, sizeof(gpuStats));
+    memset(frame.Stats.Mapped, 0, sizeof(gpuStats));
+    frame.StatsPending = false;
+
+    if (frame.StatsOutdated)
+    {
+        frame.StatsOutdated = false;
+        return;
+    }
+
+    m_Stats = { .Objects = m_ObjectCount,
+                .FrustumVisibleObjects = gpuStats.FrustumVisibleObjects,
+                .OccludedObjects = gpuStats.OccludedObjects,
+                .DrawnObjects = gpuStats.DrawnObjects + gpuStats.LateObjects,
+                .LateObjects = gpuStats.LateObjects,
+                .Triangles = m_TriangleCount,
+                .FrustumVisibleTriangles = gpuStats.FrustumVisibleTriangles,
+                .OccludedTriangles = gpuStats.OccludedTriangles,
+                .DrawnTriangles = static_cast<U64>(gpuStats.DrawnTriangles) + gpuStats.LateTriangles,
+                .Occlusion = frame.Occlusion };
+}
+} // namespace FFV
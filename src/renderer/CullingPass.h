@@ -0,0 +1,254 @@
+#pragma once
+
+#include "renderer/BindlessTable.h"
+#include "renderer/ComputePipeline.h"
+#include "renderer/HiZPyramid.h"
+#include "renderer/PhysicalDevice.h"
+#include "renderer/PipelineCache.h"
+#include "renderer/Uploader.h"
+#include "scene/Scene.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <array>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * GPU copy of a scene plus GPU driven frustum culling. The object attributes are uploaded as one storage buffer per
+ * attribute, like Scene stores them. Every mesh batch has one VkDrawIndexedIndirectCommand, a compute pass tests the
+ * bounding spheres against the frustum and appends visible objects to the instance list of their batch, so the whole
+ * scene is drawn with one indirect draw per unique mesh.
+ * With occlusion culling the frame is drawn in two passes. The early pass draws what was visible in the last frame,
+ * a depth pyramid is built from the result and the late pass tests all objects against it. It draws the ones that
+ * became visible and remembers the visible set for the next frame.
+ * The draw commands and visible instance lists exist once per frame in flight and pass.
+ */
+class CullingPass
+{
+public:
+    enum class CullPhase : U32
+    {
+        FrustumOnly = 0, // Single pass without occlusion culling
+        Early = 1,       // Objects that were visible in the last frame
+        Late = 2         // Objects that pass the depth pyramid test and weren't drawn by the early pass
+    };
+
+    /*
+     * Has to match the push constants in cull.slang, what changes between the passes of a frame.
+     */
+    struct CullConstants
+    {
+        U32 frameDataBufferIndex;
+        CullPhase phase;
+        U32 drawCommandBufferIndex;
+        U32 visibleInstanceBufferIndex;
+        U32 pyramidBufferIndex;
+        U32 pyramidLevelCount;
+        U32 depthWidth;
+        U32 depthHeight;
+    };
+
+    /*
+     * Has to match the layout cull.slang loads, written by the CPU once per frame.
+     */
+    struct CullFrameData
+    {
+        std::array<glm::vec4, 6> frustumPlanes;
+        glm::mat4 viewProjection;
+        U32 boundsBufferIndex;
+        U32 batchIndexBufferIndex;
+        U32 visibilityBufferIndex;
+        U32 statsBufferIndex;
+        U32 objectCount;
+    };
+
+    /*
+     * Object and triangle counts of a frame, triangles are counted per object from its mesh.
+     */
+    struct CullStats
+    {
+        U32 Objects = 0;
+        U32 FrustumVisibleObjects = 0;
+        U32 OccludedObjects = 0; // Inside the frustum but hidden behind the depth pyramid, not drawn at all
+        U32 DrawnObjects = 0;
+        U32 LateObjects = 0;     // Drawn by the late pass, part of DrawnObjects
+        U64 Triangles = 0;       // The whole scene
+        U64 FrustumVisibleTriangles = 0;
+        U64 OccludedTriangles = 0;
+        U64 DrawnTriangles = 0;
+        bool Occlusion = false;
+    };
+
+public:
+    CullingPass(VkDevice device, U32 framesInFlight, SharedPtr<PhysicalDevices> physicalDevices,
+                SharedPtr<Uploader> uploader, SharedPtr<BindlessTable> bindlessTable,
+                SharedPtr<PipelineCache> pipelineCache);
+    ~CullingPass();
+
+    FFV_DELETE_MOVE_COPY(CullingPass);
+
+    /*
+     * Uploads the scene through the uploader, the next frame recorded after the call culls it. The buffers of the
+     * previous scene are retired, they get destroyed once the frame timeline reached retireFrameNumber.
+     */
+    void SetScene(const Scene& scene, U64 retireFrameNumber);
+    void DestroyRetired(U64 completedFrameNumber);
+    /*
+     * Device local bytes SetScene allocates for a scene of that size, to check it against the budget up front.
+     */
+    VkDeviceSize GetSceneBytes(U32 objectCount, U32 batchCount) const;
+
+    /*
+     * Records the culling dispatch of the phase and the barriers that make its output visible to indirect draws.
+     * Must be recorded outside of rendering. FrustumOnly or Early has to be the first phase of a frame, it collects the
+     * stats of the last frame that used the frame index, Late has to follow Early in the same frame.
+     * @param pyramid: only used by the late phase, built from the depth of the early pass
+     */
+    void RecordCulling(VkCommandBuffer commandBuffer, U32 frameIndex, const glm::mat4& viewProjection,
+                       CullPhase phase, const HiZPyramid* pyramid = nullptr);
+
+    /*
+     * Draws all objects that survived the culling phase, the graphics pipeline has to be bound with
+     * GetVisibleInstanceBufferIndex(frameIndex, phase) as instance buffer.
+     */
+    void RecordDrawIndirect(VkCommandBuffer commandBuffer, U32 frameIndex, CullPhase phase) const;
+
+    U32 GetTransformBufferIndex() const { return m_Transforms.BindlessIndex; }
+    U32 GetMaterialIndexBufferIndex() const { return m_MaterialIndices.BindlessIndex; }
+    /*
+     * All objects ordered by batch, for drawing without culling.
+     */
+    U32 GetInstanceBufferIndex() const { return m_Instances.BindlessIndex; }
+    U32 GetVisibleInstanceBufferIndex(U32 frameIndex, CullPhase phase) const
+    {
+        return GetPhaseBuffers(m_Frames[frameIndex], phase).VisibleInstances.BindlessIndex;
+    }
+
+    const std::vector<Scene::Batch>& GetBatches() const { return m_Batches; }
+    const std::vector<Scene::Mesh>& GetMeshes() const { return m_Meshes; }
+    U32 GetObjectCount() const { return m_ObjectCount; }
+
+    /*
+     * Stats of the most recent frame that finished on the GPU, a few frames behind the one being recorded.
+     */
+    const CullStats& GetStats() const { return m_Stats; }
+    std::string FormatStats() const;
+
+    /*
+     * Planes point inwards and are normalized, a point p is inside if dot(plane.xyz, p) + plane.w >= 0 for all of them.
+     */
+    static std::array<glm::vec4, 6> ExtractFrustumPlanes(const glm::mat4& viewProjection);
+
+private:
+    struct GpuBuffer
+    {
+        VkBuffer Buffer = VK_NULL_HANDLE;
+        VkDeviceMemory Memory = VK_NULL_HANDLE;
+        U32 BindlessIndex = BindlessTable::InvalidIndex;
+        void* Mapped = nullptr; // Only host visible buffers
+    };
+
+    /*
+     * Has to match the counters in cull.slang. Triangle counts wrap beyond 2^32 per frame.
+     */
+    struct GpuStats
+    {
+        U32 FrustumVisibleObjects;
+        U32 FrustumVisibleTriangles;
+        U32 DrawnObjects; // By the frustum only or the early pass
+        U32 DrawnTriangles;
+        U32 LateObjects;
+        U32 LateTriangles;
+        U32 OccludedObjects;
+        U32 OccludedTriangles;
+    };
+
+    struct PhaseBuffers
+    {
+        GpuBuffer DrawCommands;
+        GpuBuffer VisibleInstances;
+    };
+
+    struct Frame
+    {
+        PhaseBuffers Early; // Also used without occlusion culling
+        PhaseBuffers Late;
+
+        // Host visible and independent of the scene
+        GpuBuffer FrameData;
+        GpuBuffer Stats;
+        bool StatsPending = false;
+        bool StatsOutdated = false; // Pending counters of a previous scene, reset without being collected
+        bool Occlusion = false;
+    };
+
+    struct RetiredBuffers
+    {
+        std::vector<GpuBuffer> Buffers;
+        U64 RetireFrameNumber = 0;
+    };
+
+private:
+    /*
+     * Creates a device local buffer and registers it in the bindless table.
+     * @param data: optional, gets uploaded through a staging buffer
+     */
+    GpuBuffer CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, const void* data = nullptr) const;
+    /*
+     * Creates a persistently mapped, zeroed storage buffer and registers it in the bindless table.
+     */
+    GpuBuffer CreateHostBuffer(VkDeviceSize size, MemoryCategory category) const;
+    void DestroyBuffer(GpuBuffer& buffer) const;
+    /*
+     * Moves the buffers of the current scene into the retired list.
+     */
+    void RetireBuffers(U64 retireFrameNumber);
+    /*
+     * Every buffer that depends on the scene.
+     */
+    std::vector<GpuBuffer*> GetSceneBuffers();
+
+    /*
+     * Reads the stats of the last frame that used the frame index and resets its counters, the frame has to be done.
+     */
+    void CollectStats(Frame& frame);
+
+    static const PhaseBuffers& GetPhaseBuffers(const Frame& frame, CullPhase phase)
+    {
+        return phase == CullPhase::Late ? frame.Late : frame.Early;
+    }
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    SharedPtr<PhysicalDevices> m_PhysicalDevices;
+    SharedPtr<Uploader> m_Uploader;
+    SharedPtr<BindlessTable> m_BindlessTable;
+    UniquePtr<ComputePipeline> m_Pipeline;
+
+    U32 m_ObjectCount = 0;
+    U64 m_TriangleCount = 0;
+    std::vector<Scene::Mesh> m_Meshes;
+    std::vector<Scene::Batch> m_Batches;
+
+    // Indexed by object
+    GpuBuffer m_Transforms;
+    GpuBuffer m_Bounds;
+    GpuBuffer m_BatchIndices;
+    GpuBuffer m_MaterialIndices;
+    // Non-zero for objects that passed the last late pass, read by the next early pass
+    GpuBuffer m_Visibility;
+
+    GpuBuffer m_Instances;
+    // Draw commands with zero instances, copied to the frame before culling
+    GpuBuffer m_DrawCommandTemplate;
+
+    std::vector<Frame> m_Frames;
+    std::vector<RetiredBuffers> m_RetiredBuffers;
+    CullStats m_Stats;
+};
+} // namespace FFV
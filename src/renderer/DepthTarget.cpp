@@ -0,0 +1,119 @@
+#include "FastFileViewerPCH.h"
+
+#include "DepthTarget.h"
+
+#include "util/Log.h"
+
+namespace FFV
+{
+// Both aspects of combined formats have to be transitioned together, the depth only view reads it like this as well
+static constexpr VkImageLayout s_SampledLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DepthTarget::DepthTarget(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices,
+                         SharedPtr<BindlessTable> bindlessTable, VkExtent2D extent, U32 numImages)
+    : m_Device(device), m_BindlessTable(bindlessTable), m_Extent(extent),
+      m_Format(physicalDevices->GetSelectedPhysicalDevice().DepthFormat)
+{
+    if (m_Format == VK_FORMAT_D32_SFLOAT_S8_UINT || m_Format == VK_FORMAT_D24_UNORM_S8_UINT)
+    {
+        m_AspectFlags |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+
+    m_Images.resize(numImages);
+    m_ImagesMemory.resize(numImages);
+    m_ImageViews.resize(numImages);
+    m_SampledImageViews.resize(numImages);
+    m_SampledImageIndices.resize(numImages);
+
+    for (U32 i = 0; i < numImages; i++)
+    {
+        Util::CreateImage(m_Device, physicalDevices, m_Extent, m_Format,
+                          VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Images[i], m_ImagesMemory[i],
+                          MemoryCategory::RenderTarget);
+        m_ImageViews[i] = Util::CreateImageView(m_Device, m_Images[i], m_Format, m_AspectFlags);
+        m_SampledImageViews[i] = Util::CreateImageView(m_Device, m_Images[i], m_Format, VK_IMAGE_ASPECT_DEPTH_BIT);
+        m_SampledImageIndices[i] = m_BindlessTable->RegisterSampledImage(m_SampledImageViews[i], s_SampledLayout);
+    }
+
+    FFV_TRACE("Created {0} depth images ({1}x{2}, {3})!", numImages, m_Extent.width, m_Extent.height,
+              string_VkFormat(m_Format));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DepthTarget::~DepthTarget()
+{
+    for (U32 i = 0; i < m_Images.size(); i++)
+    {
+        m_BindlessTable->Release(BindlessTable::ResourceType::SampledImage, m_SampledImageIndices[i]);
+        vkDestroyImageView(m_Device, m_SampledImageViews[i], VK_NULL_HANDLE);
+        vkDestroyImageView(m_Device, m_ImageViews[i], VK_NULL_HANDLE);
+        vkDestroyImage(m_Device, m_Images[i], VK_NULL_HANDLE);
+        Util::FreeMemory(m_Device, m_ImagesMemory[i]);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DepthTarget::RecordBeginFrameBarrier(VkCommandBuffer commandBuffer, U32 frameIndex) const
+{
+    // The last frame with this index finished its depth tests before the frame index got reused, but the clear still
+    // has to be ordered after them
+    RecordBarrier(commandBuffer, frameIndex, VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                  VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                  VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                  VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                  VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DepthTarget::RecordSampleBarrier(VkCommandBuffer commandBuffer, U32 frameIndex) const
+{
+    RecordBarrier(commandBuffer, frameIndex,
+                  VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                  VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                  VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                  s_SampledLayout);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DepthTarget::RecordAttachmentBarrier(VkCommandBuffer commandBuffer, U32 frameIndex) const
+{
+    // Reads don't have to be made visible, only the depth tests have to wait for them
+    RecordBarrier(commandBuffer, frameIndex, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_NONE,
+                  VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                  VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                  s_SampledLayout, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DepthTarget::RecordBarrier(VkCommandBuffer commandBuffer, U32 frameIndex, VkPipelineStageFlags2 srcStageMask,
+                                VkAccessFlags2 srcAccessMask, VkPipelineStageFlags2 dstStageMask,
+                                VkAccessFlags2 dstAccessMask, VkImageLayout oldLayout, VkImageLayout newLayout) const
+{
+    const VkImageMemoryBarrier2 imageBarrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .srcStageMask = srcStageMask,
+        .srcAccessMask = srcAccessMask,
+        .dstStageMask = dstStageMask,
+        .dstAccessMask = dstAccessMask,
+        .oldLayout = oldLayout,
+        .newLayout = newLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_Images[frameIndex],
+        .subresourceRange = { .aspectMask = m_AspectFlags, .levelCount = 1, .layerCount = 1 }
+    };
+
+    const VkDependencyInfo dependencyInfo = { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                              .imageMemoryBarrierCount = 1,
+                                              .pImageMemoryBarriers = &imageBarrier };
+    vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+} // namespace FFV
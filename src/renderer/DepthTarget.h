@@ -0,0 +1,70 @@
+#pragma once
+
+#include "renderer/BindlessTable.h"
+#include "renderer/PhysicalDevice.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * One depth image per frame in flight, so a frame never has to wait for the depth tests of the previous one. The
+ * content only lives for one frame, it's cleared when rendering starts. In between it can be sampled through a depth
+ * only view, which the occlusion culling builds its depth pyramid from.
+ */
+class DepthTarget
+{
+public:
+    /*
+     * @param extent: has to match the color target
+     */
+    DepthTarget(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, SharedPtr<BindlessTable> bindlessTable,
+                VkExtent2D extent, U32 numImages);
+    ~DepthTarget();
+
+    FFV_DELETE_MOVE_COPY(DepthTarget);
+
+    /*
+     * Transitions the image of the frame into the attachment layout, the previous content is discarded.
+     */
+    void RecordBeginFrameBarrier(VkCommandBuffer commandBuffer, U32 frameIndex) const;
+    /*
+     * Makes the depth written so far readable by compute shaders, the rendering has to store it.
+     */
+    void RecordSampleBarrier(VkCommandBuffer commandBuffer, U32 frameIndex) const;
+    /*
+     * Returns the image to the attachment layout after sampling, the content is kept for a rendering that loads it.
+     */
+    void RecordAttachmentBarrier(VkCommandBuffer commandBuffer, U32 frameIndex) const;
+
+    const VkExtent2D& GetExtent() const { return m_Extent; }
+    VkFormat GetFormat() const { return m_Format; }
+    VkImageView GetImageView(U32 frameIndex) const { return m_ImageViews[frameIndex]; }
+    /*
+     * Bindless index of the depth only view, valid while the image is in the layout of RecordSampleBarrier.
+     */
+    U32 GetSampledImageIndex(U32 frameIndex) const { return m_SampledImageIndices[frameIndex]; }
+
+private:
+    void RecordBarrier(VkCommandBuffer commandBuffer, U32 frameIndex, VkPipelineStageFlags2 srcStageMask,
+                       VkAccessFlags2 srcAccessMask, VkPipelineStageFlags2 dstStageMask, VkAccessFlags2 dstAccessMask,
+                       VkImageLayout oldLayout, VkImageLayout newLayout) const;
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    SharedPtr<BindlessTable> m_BindlessTable;
+    VkExtent2D m_Extent = { 0, 0 };
+    VkFormat m_Format = VK_FORMAT_UNDEFINED;
+    VkImageAspectFlags m_AspectFlags = VK_IMAGE_ASPECT_DEPTH_BIT; // Includes stencil for combined formats
+
+    std::vector<VkImage> m_Images;
+    std::vector<VkDeviceMemory> m_ImagesMemory;
+    std::vector<VkImageView> m_ImageViews;
+    // Sampling needs a view with only the depth aspect
+    std::vector<VkImageView> m_SampledImageViews;
+    std::vector<U32> m_SampledImageIndices;
+};
+} // namespace FFV
@@ -0,0 +1,119 @@
+#include "FastFileViewerPCH.h"
+
+#include "FramePacer.h"
+
+#include "util/Log.h"
+
+#include <thread>
+
+namespace FFV
+{
+// Bounds how long a frame can block on the present of the previous one, presents of a recreated swapchain never finish
+static constexpr U64 s_PresentWaitTimeout = 100'000'000;
+// Frames that are still not reported after this many newer frames are dropped from the latency measurement
+static constexpr U32 s_MaxPendingFrames = 16;
+// The last part of the limiter wait is spun, sleeping is not precise enough for high frame rates
+static constexpr auto s_SpinDuration = std::chrono::microseconds(1000);
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FramePacer::FramePacer(SharedPtr<Queue> queue) : m_Queue(queue), m_NextFrameTime(Clock::now()) {}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FramePacer::SetTargetFps(F64 targetFps)
+{
+    m_FramePeriod = Clock::duration::zero();
+    if (targetFps > 0.0)
+    {
+        m_FramePeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<F64>(1.0 / targetFps));
+    }
+
+    m_NextFrameTime = Clock::now();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FramePacer::WaitForFrameStart()
+{
+    LimitFrameRate();
+
+    const U64 frameNumber = m_Queue->GetFrameNumber();
+    if (m_LatencyOptimized && frameNumber > 1)
+    {
+        m_Queue->WaitForPresent(frameNumber - 1, s_PresentWaitTimeout);
+    }
+
+    CollectLatencies();
+
+    m_PendingFrames.push_back({ .FrameNumber = frameNumber, .InputTime = Clock::now() });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FramePacer::EndFrame()
+{
+    CollectLatencies();
+
+    while (m_PendingFrames.size() > s_MaxPendingFrames)
+    {
+        m_PendingFrames.pop_front();
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FramePacer::LatencyStats FramePacer::TakeLatencyStats()
+{
+    const LatencyStats stats = { .AverageMs = m_NumLatencies > 0 ? m_LatencySumMs / m_NumLatencies : 0.0,
+                                 .MaxMs = m_LatencyMaxMs,
+                                 .NumFrames = m_NumLatencies };
+
+    m_LatencySumMs = 0.0;
+    m_LatencyMaxMs = 0.0;
+    m_NumLatencies = 0;
+
+    return stats;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FramePacer::LimitFrameRate()
+{
+    if (m_FramePeriod == Clock::duration::zero())
+    {
+        return;
+    }
+
+    if (Clock::now() < m_NextFrameTime - s_SpinDuration)
+    {
+        std::this_thread::sleep_until(m_NextFrameTime - s_SpinDuration);
+    }
+
+    while (Clock::now() < m_NextFrameTime)
+    {
+        std::this_thread::yield();
+    }
+
+    // A frame that took too long moves the schedule instead of letting the following frames catch up in a burst
+    m_NextFrameTime = std::max(m_NextFrameTime + m_FramePeriod, Clock::now());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FramePacer::CollectLatencies()
+{
+    // Frames are presented in order, so the first frame that is not done yet ends the search
+    while (!m_PendingFrames.empty() && m_PendingFrames.front().FrameNumber < m_Queue->GetFrameNumber() &&
+           m_Queue->WaitForPresent(m_PendingFrames.front().FrameNumber, 0))
+    {
+        const F64 latencyMs =
+            std::chrono::duration<F64, std::milli>(Clock::now() - m_PendingFrames.front().InputTime).count();
+        m_PendingFrames.pop_front();
+
+        m_LatencySumMs += latencyMs;
+        m_LatencyMaxMs = std::max(m_LatencyMaxMs, latencyMs);
+        m_NumLatencies++;
+    }
+}
+} // namespace FFV
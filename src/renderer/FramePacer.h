@@ -0,0 +1,86 @@
+#pragma once
+
+#include "renderer/Queue.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <chrono>
+#include <deque>
+
+namespace FFV
+{
+/*
+ * Decides when the CPU starts a frame and measures the input to present latency of every frame.
+ * The latency is the time from sampling input until the frame was presented (VK_KHR_present_wait) or, without present
+ * wait, until the GPU finished it, which leaves out the time the image waits in the swapchain.
+ */
+class FramePacer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct LatencyStats
+    {
+        F64 AverageMs = 0.0;
+        F64 MaxMs = 0.0;
+        U32 NumFrames = 0;
+    };
+
+public:
+    FramePacer(SharedPtr<Queue> queue);
+    ~FramePacer() = default;
+
+    FFV_DELETE_MOVE_COPY(FramePacer);
+
+    /*
+     * @param targetFps: 0 disables the frame limiter
+     */
+    void SetTargetFps(F64 targetFps);
+    /*
+     * Waits for the previous frame to be presented before the next one samples input, so at most one frame is queued.
+     */
+    void SetLatencyOptimized(bool latencyOptimized) { m_LatencyOptimized = latencyOptimized; }
+
+    /*
+     * Has to be called right before input is sampled for the next frame of the queue.
+     */
+    void WaitForFrameStart();
+    /*
+     * Has to be called after the frame was presented, collects the latencies of frames that finished presenting
+     * without blocking.
+     */
+    void EndFrame();
+
+    /*
+     * @return: the latencies measured since the last call
+     */
+    LatencyStats TakeLatencyStats();
+
+private:
+    struct PendingFrame
+    {
+        U64 FrameNumber = 0;
+        Clock::time_point InputTime;
+    };
+
+private:
+    void LimitFrameRate();
+    /*
+     * Doesn't block, frames that are not presented yet are checked again later.
+     */
+    void CollectLatencies();
+
+private:
+    SharedPtr<Queue> m_Queue;
+
+    bool m_LatencyOptimized = false;
+    Clock::duration m_FramePeriod = Clock::duration::zero();
+    Clock::time_point m_NextFrameTime;
+
+    std::deque<PendingFrame> m_PendingFrames;
+
+    F64 m_LatencySumMs = 0.0;
+    F64 m_LatencyMaxMs = 0.0;
+    U32 m_NumLatencies = 0;
+};
+} // namespace FFV
@@ -0,0 +1,162 @@
+#include "FastFileViewerPCH.h"
+
+#include "GeometryPool.h"
+
+#include "util/Log.h"
+#include "util/Profiler.h"
+
+namespace FFV
+{
+GeometryPool::FreeList::FreeList(U32 capacity) : m_FreeCount(capacity)
+{
+    if (capacity > 0)
+    {
+        m_FreeRanges.emplace(0, capacity);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U32 GeometryPool::FreeList::Allocate(U32 count)
+{
+    for (auto it = m_FreeRanges.begin(); it != m_FreeRanges.end(); it++)
+    {
+        const auto [offset, rangeCount] = *it;
+        if (rangeCount < count)
+        {
+            continue;
+        }
+
+        m_FreeRanges.erase(it);
+        if (rangeCount > count)
+        {
+            m_FreeRanges.emplace(offset + count, rangeCount - count);
+        }
+
+        m_FreeCount -= count;
+        return offset;
+    }
+
+    return InvalidOffset;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GeometryPool::FreeList::Free(U32 offset, U32 count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    m_FreeCount += count;
+
+    auto next = m_FreeRanges.lower_bound(offset);
+    if (next != m_FreeRanges.end() && offset + count == next->first)
+    {
+        count += next->second;
+        next = m_FreeRanges.erase(next);
+    }
+
+    if (next != m_FreeRanges.begin())
+    {
+        const auto previous = std::prev(next);
+        if (previous->first + previous->second == offset)
+        {
+            previous->second += count;
+            return;
+        }
+    }
+
+    m_FreeRanges.emplace_hint(next, offset, count);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool GeometryPool::FreeList::CanAllocate(U32 count) const
+{
+    return count == 0 || std::ranges::any_of(m_FreeRanges, [&](const auto& range) { return range.second >= count; });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GeometryPool::GeometryPool(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, SharedPtr<Uploader> uploader,
+                           U32 vertexStride, U32 vertexCapacity, U32 indexCapacity, VkBufferUsageFlags additionalUsage)
+    : m_Device(device), m_PhysicalDevices(physicalDevices), m_Uploader(uploader), m_VertexStride(vertexStride),
+      m_VertexCapacity(vertexCapacity), m_IndexCapacity(indexCapacity), m_FreeVertices(vertexCapacity),
+      m_FreeIndices(indexCapacity)
+{
+    Util::CreateBuffer(m_Device, m_PhysicalDevices, static_cast<VkDeviceSize>(m_VertexStride) * m_VertexCapacity,
+                       VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | additionalUsage,
+                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_VertexBuffer, m_VertexBufferMemory,
+                       MemoryCategory::Vertex);
+
+    Util::CreateBuffer(m_Device, m_PhysicalDevices, sizeof(U32) * static_cast<VkDeviceSize>(m_IndexCapacity),
+                       VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | additionalUsage,
+                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_IndexBuffer, m_IndexBufferMemory,
+                       MemoryCategory::Index);
+
+    FFV_TRACE("Created geometry pool for {0} vertices and {1} indices!", m_VertexCapacity, m_IndexCapacity);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GeometryPool::~GeometryPool()
+{
+    vkDestroyBuffer(m_Device, m_VertexBuffer, VK_NULL_HANDLE);
+    Util::FreeMemory(m_Device, m_VertexBufferMemory);
+    vkDestroyBuffer(m_Device, m_IndexBuffer, VK_NULL_HANDLE);
+    Util::FreeMemory(m_Device, m_IndexBufferMemory);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GeometryPool::Allocation GeometryPool::Allocate(const void* vertices, U32 vertexCount, const U32* indices,
+                                                U32 indexCount)
+{
+    FFV_PROFILE_FUNCTION();
+
+    Allocation allocation = { .VertexOffset = InvalidOffset };
+
+    const U32 vertexOffset = m_FreeVertices.Allocate(vertexCount);
+    FFV_ASSERT(vertexOffset != InvalidOffset, "Geometry pool has no room for the vertices!", return allocation);
+
+    const U32 firstIndex = m_FreeIndices.Allocate(indexCount);
+    FFV_ASSERT(firstIndex != InvalidOffset, "Geometry pool has no room for the indices!",
+               m_FreeVertices.Free(vertexOffset, vertexCount);
+               return allocation);
+
+    m_Uploader->Upload(m_VertexBuffer, static_cast<VkDeviceSize>(vertexOffset) * m_VertexStride, vertices,
+                       static_cast<VkDeviceSize>(vertexCount) * m_VertexStride);
+    m_Uploader->Upload(m_IndexBuffer, sizeof(U32) * static_cast<VkDeviceSize>(firstIndex), indices,
+                       sizeof(U32) * static_cast<VkDeviceSize>(indexCount));
+
+    allocation = { .VertexOffset = vertexOffset,
+                   .VertexCount = vertexCount,
+                   .FirstIndex = firstIndex,
+                   .IndexCount = indexCount };
+    return allocation;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GeometryPool::Free(const Allocation& allocation)
+{
+    if (allocation.VertexOffset == InvalidOffset)
+    {
+        return;
+    }
+
+    m_FreeVertices.Free(allocation.VertexOffset, allocation.VertexCount);
+    m_FreeIndices.Free(allocation.FirstIndex, allocation.IndexCount);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GeometryPool::Bind(VkCommandBuffer commandBuffer) const
+{
+    const VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_VertexBuffer, &offset);
+    vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+}
+} // namespace FFV
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "renderer/PhysicalDevice.h"
+#include "renderer/Uploader.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <map>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * One device local vertex buffer and one index buffer shared by all meshes. Meshes get ranges of them from a free list
+ * and are drawn with vertexOffset/firstIndex, so the buffers only have to be bound once.
+ */
+class GeometryPool
+{
+public:
+    /*
+     * Offsets and counts are in vertices and indices, not bytes.
+     */
+    struct Allocation
+    {
+        U32 VertexOffset = 0;
+        U32 VertexCount = 0;
+        U32 FirstIndex = 0;
+        U32 IndexCount = 0;
+    };
+
+    static constexpr U32 InvalidOffset = ~0u;
+
+public:
+    /*
+     * @param vertexStride: size of one vertex in bytes
+     * @param vertexCapacity: number of vertices the pool can hold
+     * @param indexCapacity: number of indices the pool can hold
+     * @param additionalUsage: added to the usage of both buffers, e.g. to build acceleration structures from them
+     */
+    GeometryPool(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, SharedPtr<Uploader> uploader,
+                 U32 vertexStride, U32 vertexCapacity, U32 indexCapacity, VkBufferUsageFlags additionalUsage = 0);
+    ~GeometryPool();
+
+    FFV_DELETE_MOVE_COPY(GeometryPool);
+
+    /*
+     * Uploads the geometry into free ranges of the pool, it's ready for the next frame recorded after the call.
+     * @return: an allocation with InvalidOffset as VertexOffset when the pool is full
+     */
+    Allocation Allocate(const void* vertices, U32 vertexCount, const U32* indices, U32 indexCount);
+    bool CanAllocate(U32 vertexCount, U32 indexCount) const
+    {
+        return m_FreeVertices.CanAllocate(vertexCount) && m_FreeIndices.CanAllocate(indexCount);
+    }
+    /*
+     * The GPU must no longer use the geometry.
+     */
+    void Free(const Allocation& allocation);
+
+    void Bind(VkCommandBuffer commandBuffer) const;
+
+    VkBuffer GetVertexBuffer() const { return m_VertexBuffer; }
+    VkBuffer GetIndexBuffer() const { return m_IndexBuffer; }
+    U32 GetVertexStride() const { return m_VertexStride; }
+    U32 GetUsedVertices() const { return m_VertexCapacity - m_FreeVertices.GetFreeCount(); }
+    U32 GetUsedIndices() const { return m_IndexCapacity - m_FreeIndices.GetFreeCount(); }
+
+private:
+    /*
+     * First fit allocator over [0, capacity), adjacent free ranges are merged again when freed.
+     */
+    class FreeList
+    {
+    public:
+        explicit FreeList(U32 capacity);
+
+        U32 Allocate(U32 count);
+        void Free(U32 offset, U32 count);
+        bool CanAllocate(U32 count) const;
+
+        U32 GetFreeCount() const { return m_FreeCount; }
+
+    private:
+        std::map<U32, U32> m_FreeRanges; // Offset to count
+        U32 m_FreeCount = 0;
+    };
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    SharedPtr<PhysicalDevices> m_PhysicalDevices;
+    SharedPtr<Uploader> m_Uploader;
+
+    U32 m_VertexStride = 0;
+    U32 m_VertexCapacity = 0;
+    U32 m_IndexCapacity = 0;
+    FreeList m_FreeVertices;
+    FreeList m_FreeIndices;
+
+    VkBuffer m_VertexBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_VertexBufferMemory = VK_NULL_HANDLE;
+    VkBuffer m_IndexBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_IndexBufferMemory = VK_NULL_HANDLE;
+};
+} // namespace FFV
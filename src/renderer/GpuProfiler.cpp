@@ -0,0 +1,260 @@
+#include "FastFileViewerPCH.h"
+
+#include "GpuProfiler.h"
+
+#include "util/Log.h"
+
+#include <fstream>
+
+namespace FFV
+{
+GpuProfiler::Scope::Scope(GpuProfiler* profiler, VkCommandBuffer commandBuffer, U32 frameIndex, const char* name)
+    : m_Profiler(profiler), m_CommandBuffer(commandBuffer), m_FrameIndex(frameIndex)
+{
+    m_ScopeIndex = m_Profiler ? m_Profiler->BeginScope(commandBuffer, frameIndex, name) : InvalidScope;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GpuProfiler::Scope::~Scope()
+{
+    if (m_Profiler)
+    {
+        m_Profiler->EndScope(m_CommandBuffer, m_FrameIndex, m_ScopeIndex);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GpuProfiler::GpuProfiler(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, U32 queueFamily,
+                         U32 framesInFlight)
+    : m_Device(device), m_Frames(framesInFlight)
+{
+    const PhysicalDevice& physicalDevice = physicalDevices->GetSelectedPhysicalDevice();
+    m_TimestampPeriodNs = physicalDevice.DeviceProperties.limits.timestampPeriod;
+
+    const U32 validBits = physicalDevice.QueueFamiliyProperties[queueFamily].timestampValidBits;
+    m_TimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    if (!IsSupported())
+    {
+        FFV_WARN("The queue family doesn't support timestamps, GPU profiling is disabled!");
+        return;
+    }
+
+    const VkQueryPoolCreateInfo queryPoolCreateInfo = { .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                                        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+                                                        .queryCount = MaxScopesPerFrame * 2 };
+    for (FrameQueries& frame : m_Frames)
+    {
+        FFV_CHECK_VK_RESULT(vkCreateQueryPool(m_Device, &queryPoolCreateInfo, VK_NULL_HANDLE, &frame.QueryPool));
+    }
+
+    FFV_TRACE("Created GPU profiler with {0} scopes per frame!", MaxScopesPerFrame);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GpuProfiler::~GpuProfiler()
+{
+    for (const FrameQueries& frame : m_Frames)
+    {
+        vkDestroyQueryPool(m_Device, frame.QueryPool, VK_NULL_HANDLE);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, U32 frameIndex)
+{
+    if (!IsSupported())
+    {
+        return;
+    }
+
+    FrameQueries& frame = m_Frames[frameIndex];
+    if (frame.Submitted)
+    {
+        Collect(frame);
+    }
+
+    frame.ScopeNames.clear();
+    frame.Submitted = true;
+    vkCmdResetQueryPool(commandBuffer, frame.QueryPool, 0, MaxScopesPerFrame * 2);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U32 GpuProfiler::BeginScope(VkCommandBuffer commandBuffer, U32 frameIndex, const char* name)
+{
+    FrameQueries& frame = m_Frames[frameIndex];
+    if (!IsSupported() || frame.ScopeNames.size() >= MaxScopesPerFrame)
+    {
+        return InvalidScope;
+    }
+
+    const U32 scopeIndex = static_cast<U32>(frame.ScopeNames.size());
+    frame.ScopeNames.push_back(name);
+
+    // Both timestamps wait for all previous work, so a scope covers exactly the commands recorded inside it
+    vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, frame.QueryPool, scopeIndex * 2);
+    return scopeIndex;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::EndScope(VkCommandBuffer commandBuffer, U32 frameIndex, U32 scopeIndex)
+{
+    if (scopeIndex == InvalidScope)
+    {
+        return;
+    }
+
+    vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, m_Frames[frameIndex].QueryPool,
+                         scopeIndex * 2 + 1);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::Collect(FrameQueries& frame)
+{
+    if (frame.ScopeNames.empty())
+    {
+        return;
+    }
+
+    // Value and availability per query, unavailable scopes (never submitted frames) are skipped instead of waited for
+    const U32 numQueries = static_cast<U32>(frame.ScopeNames.size()) * 2;
+    std::array<U64, MaxScopesPerFrame * 4> results = {};
+    const VkResult result =
+        vkGetQueryPoolResults(m_Device, frame.QueryPool, 0, numQueries, sizeof(U64) * numQueries * 2, results.data(),
+                              sizeof(U64) * 2, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    FFV_ASSERT(result == VK_SUCCESS || result == VK_NOT_READY, "Couldn't read the GPU timestamps!", return);
+
+    for (U32 scopeIndex = 0; scopeIndex < frame.ScopeNames.size(); scopeIndex++)
+    {
+        const U64* begin = &results[scopeIndex * 4];
+        const U64* end = &results[scopeIndex * 4 + 2];
+        if (begin[1] == 0 || end[1] == 0)
+        {
+            continue;
+        }
+
+        const U64 ticks = ((end[0] & m_TimestampMask) - (begin[0] & m_TimestampMask)) & m_TimestampMask;
+        AddSample(frame.ScopeNames[scopeIndex], static_cast<F64>(ticks) * m_TimestampPeriodNs * 1e-6);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::AddSample(const char* name, F64 milliseconds)
+{
+    const auto [it, inserted] = m_HistoryIndices.try_emplace(name, static_cast<U32>(m_Histories.size()));
+    if (inserted)
+    {
+        m_Histories.push_back({ .Name = name });
+    }
+
+    History& history = m_Histories[it->second];
+    history.SamplesMs[history.NextSample] = milliseconds;
+    history.NextSample = (history.NextSample + 1) % HistorySize;
+    history.NumSamples = std::min(history.NumSamples + 1, HistorySize);
+
+    if (m_SampleCallback)
+    {
+        m_SampleCallback(name, milliseconds);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<GpuProfiler::ScopeStats> GpuProfiler::GetStats() const
+{
+    std::vector<ScopeStats> stats;
+    stats.reserve(m_Histories.size());
+
+    for (const History& history : m_Histories)
+    {
+        ScopeStats& scope = stats.emplace_back(ScopeStats{ .Name = history.Name,
+                                                           .MinMs = std::numeric_limits<F64>::max(),
+                                                           .NumSamples = history.NumSamples });
+        for (U32 i = 0; i < history.NumSamples; i++)
+        {
+            scope.MinMs = std::min(scope.MinMs, history.SamplesMs[i]);
+            scope.MaxMs = std::max(scope.MaxMs, history.SamplesMs[i]);
+            scope.AverageMs += history.SamplesMs[i];
+        }
+        scope.AverageMs /= std::max(history.NumSamples, 1u);
+    }
+
+    return stats;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+F64 GpuProfiler::GetAverageMs(const std::string& name) const
+{
+    const auto it = m_HistoryIndices.find(name);
+    if (it == m_HistoryIndices.end())
+    {
+        return 0.0;
+    }
+
+    const History& history = m_Histories[it->second];
+    F64 totalMs = 0.0;
+    for (U32 i = 0; i < history.NumSamples; i++)
+    {
+        totalMs += history.SamplesMs[i];
+    }
+    return totalMs / std::max(history.NumSamples, 1u);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string GpuProfiler::FormatStats() const
+{
+    std::string text = std::format("GPU timings over the last {0} frames (min / avg / max ms):", HistorySize);
+    for (const ScopeStats& scope : GetStats())
+    {
+        text += std::format("\n    {0:<12} {1:7.3f} / {2:7.3f} / {3:7.3f}", scope.Name, scope.MinMs, scope.AverageMs,
+                            scope.MaxMs);
+    }
+
+    return text;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool GpuProfiler::WriteReport(const std::filesystem::path& path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        FFV_WARN("Couldn't open {0} for writing!", path.string());
+        return false;
+    }
+
+    file << "{\n    \"scopes\": [";
+    const std::vector<ScopeStats> stats = GetStats();
+    for (U32 scopeIndex = 0; scopeIndex < stats.size(); scopeIndex++)
+    {
+        const ScopeStats& scope = stats[scopeIndex];
+        const History& history = m_Histories[scopeIndex];
+
+        // Oldest sample first
+        std::string samples;
+        const U32 firstSample = history.NumSamples < HistorySize ? 0 : history.NextSample;
+        for (U32 i = 0; i < history.NumSamples; i++)
+        {
+            samples += std::format("{0}{1:.4f}", i == 0 ? "" : ", ", history.SamplesMs[(firstSample + i) % HistorySize]);
+        }
+
+        file << std::format("{0}\n        {{ \"name\": \"{1}\", \"minMs\": {2:.4f}, \"avgMs\": {3:.4f}, \"maxMs\": {4:.4f}, "
+                            "\"samplesMs\": [{5}] }}",
+                            scopeIndex == 0 ? "" : ",", scope.Name, scope.MinMs, scope.AverageMs, scope.MaxMs, samples);
+    }
+    file << "\n    ]\n}\n";
+
+    FFV_LOG("Wrote the GPU profile to {0}", path.string());
+    return static_cast<bool>(file);
+}
+} // namespace FFV
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "renderer/PhysicalDevice.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <array>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * Measures GPU time of named scopes with one timestamp query pool per frame in flight. The timestamps of a frame are
+ * read when its frame index comes around again, the frame completed by then, so reading never waits for the GPU.
+ */
+class GpuProfiler
+{
+public:
+    struct ScopeStats
+    {
+        std::string Name;
+        F64 MinMs = 0.0;
+        F64 AverageMs = 0.0;
+        F64 MaxMs = 0.0;
+        U32 NumSamples = 0;
+    };
+
+    using SampleFn = std::function<void(const char* name, F64 milliseconds)>;
+
+    /*
+     * Ends the scope when it goes out of scope, does nothing when the profiler is nullptr.
+     */
+    class Scope
+    {
+    public:
+        /*
+         * @param name: has to outlive the frame, string literals are expected
+         */
+        Scope(GpuProfiler* profiler, VkCommandBuffer commandBuffer, U32 frameIndex, const char* name);
+        ~Scope();
+
+        FFV_DELETE_MOVE_COPY(Scope);
+
+    private:
+        GpuProfiler* m_Profiler = nullptr;
+        VkCommandBuffer m_CommandBuffer = VK_NULL_HANDLE;
+        U32 m_FrameIndex = 0;
+        U32 m_ScopeIndex = 0;
+    };
+
+public:
+    static constexpr U32 MaxScopesPerFrame = 32;
+    static constexpr U32 HistorySize = 128; // Frames the rolling min/avg/max cover
+    static constexpr U32 InvalidScope = ~0u;
+
+public:
+    GpuProfiler(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, U32 queueFamily, U32 framesInFlight);
+    ~GpuProfiler();
+
+    FFV_DELETE_MOVE_COPY(GpuProfiler);
+
+    /*
+     * Collects the timestamps of the last frame that used the frame index and resets its queries. Has to be the first
+     * command of the frame, after the frame index is no longer in use by the GPU.
+     */
+    void BeginFrame(VkCommandBuffer commandBuffer, U32 frameIndex);
+
+    /*
+     * @return: InvalidScope if timestamps aren't supported or the frame has no queries left
+     */
+    U32 BeginScope(VkCommandBuffer commandBuffer, U32 frameIndex, const char* name);
+    void EndScope(VkCommandBuffer commandBuffer, U32 frameIndex, U32 scopeIndex);
+
+    bool IsSupported() const { return m_TimestampMask != 0; }
+
+    /*
+     * Called for every measured scope when its frame gets collected, frames arrive in submission order but a few
+     * frames late. Unlike the rolling stats it sees every sample, e.g. to compute percentiles over a long run.
+     */
+    void SetSampleCallback(SampleFn callback) { m_SampleCallback = std::move(callback); }
+
+    /*
+     * Rolling stats in the order the scopes first appeared.
+     */
+    std::vector<ScopeStats> GetStats() const;
+    /*
+     * @return: 0 if the scope hasn't been measured yet
+     */
+    F64 GetAverageMs(const std::string& name) const;
+    std::string FormatStats() const;
+    /*
+     * Writes the rolling stats and the recent samples of every scope as JSON.
+     */
+    bool WriteReport(const std::filesystem::path& path) const;
+
+private:
+    struct FrameQueries
+    {
+        VkQueryPool QueryPool = VK_NULL_HANDLE;
+        std::vector<const char*> ScopeNames; // Scope i uses the queries 2i and 2i+1
+        bool Submitted = false;
+    };
+
+    struct History
+    {
+        std::string Name;
+        std::array<F64, HistorySize> SamplesMs = {};
+        U32 NumSamples = 0;
+        U32 NextSample = 0;
+    };
+
+private:
+    void Collect(FrameQueries& frame);
+    void AddSample(const char* name, F64 milliseconds);
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    F64 m_TimestampPeriodNs = 1.0;
+    U64 m_TimestampMask = 0; // Valid bits of the queue family, 0 if it has no timestamps
+
+    std::vector<FrameQueries> m_Frames;
+    std::vector<History> m_Histories;
+    std::unordered_map<std::string, U32> m_HistoryIndices;
+    SampleFn m_SampleCallback;
+};
+} // namespace FFV
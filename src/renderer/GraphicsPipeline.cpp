@@ -11,21 +11,26 @@
 
 namespace FFV
 {
-GraphicsPipeline::GraphicsPipeline(VkDevice device, SharedPtr<Swapchain> swapchain,
-                                   SharedPtr<PhysicalDevices> physicalDevice, SharedPtr<Window> window,
+GraphicsPipeline::GraphicsPipeline(VkDevice device, U32 framesInFlight, VkFormat colorFormat, VkFormat depthFormat,
+                                   DepthMode depthMode, SharedPtr<PhysicalDevices> physicalDevice,
+                                   SharedPtr<BindlessTable> bindlessTable, SharedPtr<PipelineCache> pipelineCache,
+                                   SharedPtr<TransientAllocator> transientAllocator,
                                    std::vector<SharedPtr<Shader>> shaders)
-    : m_Device(device), m_Swapchain(swapchain), m_PhysicalDevice(physicalDevice), m_Window(window)
+    : m_Device(device), m_FramesInFlight(framesInFlight), m_PhysicalDevice(physicalDevice),
+      m_BindlessTable(bindlessTable), m_PipelineCache(pipelineCache), m_TransientAllocator(transientAllocator)
 {
     CreateDescriptorSetLayout();
-    CreateUniformBuffers();
     CreateDescriptorPool();
     CreateDescriptorSets();
 
     std::vector<VkPipelineShaderStageCreateInfo> shaderStageCreateInfos;
+    std::vector<U64> shaderHashes;
     shaderStageCreateInfos.reserve(shaders.size());
+    shaderHashes.reserve(shaders.size());
 
     for (const auto& shaderStage : shaders)
     {
+        shaderHashes.push_back(shaderStage->GetHash());
         shaderStageCreateInfos.emplace_back(
             VkPipelineShaderStageCreateInfo{ .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
                                              .stage = shaderStage->GetShaderStage(),
@@ -75,11 +80,25 @@ GraphicsPipeline::GraphicsPipeline(VkDevice device, SharedPtr<Swapchain> swapcha
         .minSampleShading = 1.0f
     };
 
-    VkPipelineColorBlendAttachmentState colorBlendStateAttachment = { .blendEnable = VK_FALSE,
-                                                                      .colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
-                                                                                        VK_COLOR_COMPONENT_G_BIT |
-                                                                                        VK_COLOR_COMPONENT_B_BIT |
-                                                                                        VK_COLOR_COMPONENT_A_BIT };
+    VkPipelineDepthStencilStateCreateInfo depthStencilStateCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .depthTestEnable = VK_TRUE,
+        .depthWriteEnable = depthMode == DepthMode::ShadeVisible ? VK_FALSE : VK_TRUE,
+        // The vertex shader computes the position as precise, so both passes produce bit identical depth and the
+        // winning fragment passes. Less or equal only tolerates the shading pass coming out nearer, a fragment that
+        // comes out farther is still discarded.
+        .depthCompareOp = depthMode == DepthMode::ShadeVisible ? VK_COMPARE_OP_LESS_OR_EQUAL : VK_COMPARE_OP_LESS,
+        .depthBoundsTestEnable = VK_FALSE,
+        .stencilTestEnable = VK_FALSE
+    };
+
+    // The pre-pass keeps the color attachment, so it can run inside the same rendering as the shading pass
+    VkPipelineColorBlendAttachmentState colorBlendStateAttachment = {
+        .blendEnable = VK_FALSE,
+        .colorWriteMask = depthMode == DepthMode::PrePass ? 0u
+                                                          : VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                                                VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+    };
 
     VkPipelineColorBlendStateCreateInfo colorBlendeStateCreateInfo = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
@@ -89,14 +108,25 @@ GraphicsPipeline::GraphicsPipeline(VkDevice device, SharedPtr<Swapchain> swapcha
         .pAttachments = &colorBlendStateAttachment
     };
 
+    const std::array<VkDescriptorSetLayout, 2> setLayouts = { m_DescriptorSetLayout,
+                                                              m_BindlessTable->GetDescriptorSetLayout() };
+
+    const VkPushConstantRange pushConstantRange = { .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                                                    .offset = 0,
+                                                    .size = sizeof(DrawConstants) };
+
     VkPipelineLayoutCreateInfo layoutCreateInfo = { .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-                                                    .setLayoutCount = 1,
-                                                    .pSetLayouts = &m_DescriptorSetLayout,
-                                                    .pushConstantRangeCount = 0 };
+                                                    .setLayoutCount = static_cast<U32>(setLayouts.size()),
+                                                    .pSetLayouts = setLayouts.data(),
+                                                    .pushConstantRangeCount = 1,
+                                                    .pPushConstantRanges = &pushConstantRange };
 
     FFV_CHECK_VK_RESULT(vkCreatePipelineLayout(m_Device, &layoutCreateInfo, VK_NULL_HANDLE, &m_PipelineLayout));
 
-    VkPipelineRenderingCreateInfo renderingCreateInfo = { .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO };
+    VkPipelineRenderingCreateInfo renderingCreateInfo = { .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+                                                          .colorAttachmentCount = 1,
+                                                          .pColorAttachmentFormats = &colorFormat,
+                                                          .depthAttachmentFormat = depthFormat };
 
     VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo = { .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
                                                                 .pNext = &renderingCreateInfo,
@@ -108,13 +138,20 @@ GraphicsPipeline::GraphicsPipeline(VkDevice device, SharedPtr<Swapchain> swapcha
                                                                 .pViewportState = &viewportStateCreateInfo,
                                                                 .pRasterizationState = &rasterizationStateCreateInfo,
                                                                 .pMultisampleState = &multiSampleStateCreateInfo,
+                                                                .pDepthStencilState = &depthStencilStateCreateInfo,
                                                                 .pColorBlendState = &colorBlendeStateCreateInfo,
 
                                                                 .pDynamicState = &dynamicStateCreateInfo,
                                                                 .layout = m_PipelineLayout };
 
-    FFV_CHECK_VK_RESULT(
-        vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, VK_NULL_HANDLE, &m_Pipeline));
+    // Layouts that are created from identical descriptions are compatible, so cached pipelines can be shared
+    U64 layoutHash = Util::HashBytes(&pushConstantRange, sizeof(pushConstantRange));
+    Util::HashCombine(layoutHash, m_DescriptorSetLayoutHash);
+    Util::HashCombine(layoutHash, m_BindlessTable->GetLayoutHash());
+
+    const U64 stateHash =
+        PipelineCache::HashGraphicsPipelineState(graphicsPipelineCreateInfo, shaderHashes, layoutHash);
+    m_Pipeline = m_PipelineCache->GetOrCreateGraphicsPipeline(graphicsPipelineCreateInfo, stateHash);
 
     FFV_TRACE("Created vulkan graphics pipeline!");
 }
@@ -133,13 +170,6 @@ GraphicsPipeline::~GraphicsPipeline()
     vkDestroyDescriptorPool(m_Device, m_DescriptorPool, VK_NULL_HANDLE);
 
     vkDestroyPipelineLayout(m_Device, m_PipelineLayout, VK_NULL_HANDLE);
-    vkDestroyPipeline(m_Device, m_Pipeline, VK_NULL_HANDLE);
-
-    for (U32 i = 0; i < m_UniformBuffers.size(); i++)
-    {
-        vkDestroyBuffer(m_Device, m_UniformBuffers[i], VK_NULL_HANDLE);
-        vkFreeMemory(m_Device, m_UniformBuffersMemory[i], VK_NULL_HANDLE);
-    }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -151,25 +181,18 @@ void GraphicsPipeline::Bind(VkCommandBuffer commandBuffer) const
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void GraphicsPipeline::UpdateUniformBuffer(U32 imageIndex)
+void GraphicsPipeline::PushDrawConstants(VkCommandBuffer commandBuffer, const DrawConstants& constants) const
 {
-    static auto startTime = std::chrono::high_resolution_clock::now();
-
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
-
-    UniformBufferObject ubo = {
-        .model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
-        .view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
-        .proj = glm::perspective(glm::radians(45.0f),
-                                 static_cast<float>(std::max(m_Window->GetWidth(), 1u)) /
-                                     static_cast<float>(std::max(m_Window->GetHeight(), 1u)),
-                                 0.1f, 10.0f)
-    };
+    vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+                       sizeof(DrawConstants), &constants);
+}
 
-    ubo.proj[1][1] *= -1.0f;
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    std::memcpy(m_UniformBuffersMapped[imageIndex], &ubo, sizeof(ubo));
+void GraphicsPipeline::BindUniformBuffer(VkCommandBuffer commandBuffer, U32 frameIndex, U32 uniformOffset) const
+{
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1,
+                            &m_DescriptorSets[frameIndex], 1, &uniformOffset);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -177,7 +200,7 @@ void GraphicsPipeline::UpdateUniformBuffer(U32 imageIndex)
 void GraphicsPipeline::CreateDescriptorSetLayout()
 {
     const VkDescriptorSetLayoutBinding uboLayoutBinding = { .binding = 0,
-                                                            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                                            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
                                                             .descriptorCount = 1,
                                                             .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
                                                             .pImmutableSamplers = nullptr };
@@ -188,43 +211,20 @@ void GraphicsPipeline::CreateDescriptorSetLayout()
 
     FFV_CHECK_VK_RESULT(
         vkCreateDescriptorSetLayout(m_Device, &descriptorSetLayoutCreateInfo, VK_NULL_HANDLE, &m_DescriptorSetLayout));
-}
-
-/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void GraphicsPipeline::CreateUniformBuffers()
-{
-    m_UniformBuffers.clear();
-    m_UniformBuffersMemory.clear();
-    m_UniformBuffersMapped.clear();
-
-    for (U32 i = 0; i < m_Swapchain->GetNumImagesInFlight(); i++)
-    {
-        VkBuffer uniformBuffer;
-        VkDeviceMemory uniformBufferMemory;
-        VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-        Util::CreateBuffer(m_Device, m_PhysicalDevice, bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffer,
-                           uniformBufferMemory);
-        void* data;
-        FFV_CHECK_VK_RESULT(vkMapMemory(m_Device, uniformBufferMemory, 0, bufferSize, 0, &data));
-        m_UniformBuffersMapped.push_back(data);
-        m_UniformBuffers.push_back(uniformBuffer);
-        m_UniformBuffersMemory.push_back(uniformBufferMemory);
-    }
+    m_DescriptorSetLayoutHash = Util::HashDescriptorSetLayout(descriptorSetLayoutCreateInfo);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void GraphicsPipeline::CreateDescriptorPool()
 {
-    const VkDescriptorPoolSize poolSize = { .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                                            .descriptorCount = m_Swapchain->GetNumImagesInFlight() };
+    const VkDescriptorPoolSize poolSize = { .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                                            .descriptorCount = m_FramesInFlight };
 
     const VkDescriptorPoolCreateInfo poolCreateInfo = {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
         .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
-        .maxSets = m_Swapchain->GetNumImagesInFlight(),
+        .maxSets = m_FramesInFlight,
         .poolSizeCount = 1,
         .pPoolSizes = &poolSize,
     };
@@ -236,7 +236,7 @@ void GraphicsPipeline::CreateDescriptorPool()
 
 void GraphicsPipeline::CreateDescriptorSets()
 {
-    const std::vector<VkDescriptorSetLayout> layouts(m_Swapchain->GetNumImagesInFlight(), m_DescriptorSetLayout);
+    const std::vector<VkDescriptorSetLayout> layouts(m_FramesInFlight, m_DescriptorSetLayout);
     const VkDescriptorSetAllocateInfo allocInfo = {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
         .descriptorPool = m_DescriptorPool,
@@ -249,7 +249,7 @@ void GraphicsPipeline::CreateDescriptorSets()
 
     for (U32 i = 0; i < layouts.size(); i++)
     {
-        const VkDescriptorBufferInfo bufferInfo = { .buffer = m_UniformBuffers[i],
+        const VkDescriptorBufferInfo bufferInfo = { .buffer = m_TransientAllocator->GetBuffer(i),
                                                     .offset = 0,
                                                     .range = sizeof(UniformBufferObject) };
 
@@ -258,7 +258,7 @@ void GraphicsPipeline::CreateDescriptorSets()
                                                        .dstBinding = 0,
                                                        .dstArrayElement = 0,
                                                        .descriptorCount = 1,
-                                                       .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                                       .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
                                                        .pBufferInfo = &bufferInfo };
 
         vkUpdateDescriptorSets(m_Device, 1, &descriptorWrite, 0, nullptr);
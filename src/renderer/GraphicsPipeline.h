@@ -1,13 +1,13 @@
 #pragma once
 
+#include "renderer/BindlessTable.h"
 #include "renderer/PhysicalDevice.h"
+#include "renderer/PipelineCache.h"
 #include "renderer/Shader.h"
-#include "renderer/Swapchain.h"
+#include "renderer/TransientAllocator.h"
 #include "util/Types.h"
 #include "util/Util.h"
 
-#include <Window.h>
-#include <chrono>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <vector>
@@ -20,44 +20,78 @@ class GraphicsPipeline
 public:
     struct UniformBufferObject
     {
-        glm::mat4 model;
         glm::mat4 view;
         glm::mat4 proj;
     };
 
+    struct MaterialData
+    {
+        glm::vec4 baseColor;
+    };
+
+    /*
+     * Per pass data, the buffer indices address the bindless storage buffer table.
+     * The instance buffer maps the instances of a draw to object indices.
+     */
+    struct DrawConstants
+    {
+        U32 transformBufferIndex;
+        U32 materialIndexBufferIndex;
+        U32 instanceBufferIndex;
+        U32 materialBufferIndex;
+    };
+
+    enum class DepthMode
+    {
+        TestAndWrite, // Nearest fragment wins, used without a depth pre-pass
+        PrePass,      // Only writes depth, color writes are masked and no fragment shader is needed
+        ShadeVisible  // Shades only the fragments that won the pre-pass, depth is read only
+    };
+
+    static constexpr U32 BindlessSet = 1;
+
 public:
-    GraphicsPipeline(VkDevice device, SharedPtr<Swapchain> swapchain, SharedPtr<PhysicalDevices> physicalDevice,
-                     SharedPtr<Window> window, std::vector<SharedPtr<Shader>> shaders);
+    /*
+     * @param transientAllocator: the uniform buffer object of a frame is allocated from it
+     * @param shaders: the depth pre-pass has to use the same vertex shader as the shading pass, otherwise the depth
+     *                 values may differ and visible fragments fail the depth test
+     */
+    GraphicsPipeline(VkDevice device, U32 framesInFlight, VkFormat colorFormat, VkFormat depthFormat,
+                     DepthMode depthMode, SharedPtr<PhysicalDevices> physicalDevice,
+                     SharedPtr<BindlessTable> bindlessTable, SharedPtr<PipelineCache> pipelineCache,
+                     SharedPtr<TransientAllocator> transientAllocator, std::vector<SharedPtr<Shader>> shaders);
     ~GraphicsPipeline();
 
     FFV_DELETE_MOVE_COPY(GraphicsPipeline);
 
     void Bind(VkCommandBuffer commandBuffer) const;
-    void UpdateUniformBuffer(U32 imageIndex);
+    void PushDrawConstants(VkCommandBuffer commandBuffer, const DrawConstants& constants) const;
+    /*
+     * @param uniformOffset: offset of the UniformBufferObject in the transient allocator buffer of the frame
+     */
+    void BindUniformBuffer(VkCommandBuffer commandBuffer, U32 frameIndex, U32 uniformOffset) const;
 
-    const std::vector<VkDescriptorSet>& GetDescriptorSets() const { return m_DescriptorSets; }
     VkPipelineLayout GetPipelineLayout() const { return m_PipelineLayout; }
 
 private:
     void CreateDescriptorSetLayout();
-    void CreateUniformBuffers();
     void CreateDescriptorPool();
     void CreateDescriptorSets();
 
 private:
     VkDevice m_Device = VK_NULL_HANDLE;
-    SharedPtr<Swapchain> m_Swapchain;
+    U32 m_FramesInFlight = 0;
     SharedPtr<PhysicalDevices> m_PhysicalDevice;
-    SharedPtr<Window> m_Window;
+    SharedPtr<BindlessTable> m_BindlessTable;
+    SharedPtr<PipelineCache> m_PipelineCache;
+    SharedPtr<TransientAllocator> m_TransientAllocator;
 
+    // Owned by the pipeline cache
     VkPipeline m_Pipeline = VK_NULL_HANDLE;
     VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
     VkDescriptorSetLayout m_DescriptorSetLayout = VK_NULL_HANDLE;
+    U64 m_DescriptorSetLayoutHash = 0;
     VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
-    std::vector<VkDescriptorSet> m_DescriptorSets;
-
-    std::vector<VkBuffer> m_UniformBuffers;
-    std::vector<VkDeviceMemory> m_UniformBuffersMemory;
-    std::vector<void*> m_UniformBuffersMapped;
+    std::vector<VkDescriptorSet> m_DescriptorSets; // Per frame in flight, only the dynamic offset changes
 };
 } // namespace FFV
@@ -0,0 +1,94 @@
+#include "FastFileViewerPCH.h"
+
+#include "HiZPyramid.h"
+
+#include "renderer/Shader.h"
+#include "util/Log.h"
+
+namespace FFV
+{
+static constexpr U32 s_WorkgroupSize = 8;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HiZPyramid::HiZPyramid(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices,
+                       SharedPtr<BindlessTable> bindlessTable, SharedPtr<PipelineCache> pipelineCache,
+                       VkExtent2D depthExtent)
+    : m_Device(device), m_BindlessTable(bindlessTable), m_DepthExtent(depthExtent)
+{
+    m_Pipeline = MakeUnique<ComputePipeline>(m_Device, m_BindlessTable, pipelineCache,
+                                             MakeShared<Shader>(m_Device, "hiz.comp.spv"), sizeof(ReduceConstants));
+
+    // Halving with rounding up until a single texel is left, cull.slang derives the same layout from the depth extent
+    U32 offset = 0;
+    U32 width = std::max(m_DepthExtent.width, 1u);
+    U32 height = std::max(m_DepthExtent.height, 1u);
+    do
+    {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        m_Levels.push_back({ .Offset = offset, .Width = width, .Height = height });
+        offset += width * height;
+    } while (width > 1 || height > 1);
+
+    Util::CreateBuffer(m_Device, physicalDevices, sizeof(F32) * offset, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Buffer, m_BufferMemory, MemoryCategory::RenderTarget);
+    m_BindlessIndex = m_BindlessTable->RegisterStorageBuffer(m_Buffer);
+
+    FFV_TRACE("Created depth pyramid with {0} levels for {1}x{2}!", m_Levels.size(), m_DepthExtent.width,
+              m_DepthExtent.height);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HiZPyramid::~HiZPyramid()
+{
+    m_BindlessTable->Release(BindlessTable::ResourceType::StorageBuffer, m_BindlessIndex);
+    vkDestroyBuffer(m_Device, m_Buffer, VK_NULL_HANDLE);
+    Util::FreeMemory(m_Device, m_BufferMemory);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HiZPyramid::RecordBuild(VkCommandBuffer commandBuffer, U32 depthImageIndex) const
+{
+    // Orders the first level after the occlusion tests of the previous frame and every level after the one it reduces
+    const VkMemoryBarrier2 levelBarrier = { .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                            .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                            .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                                            .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                            .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                                                             VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT };
+
+    const VkDependencyInfo levelDependencyInfo = { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                                   .memoryBarrierCount = 1,
+                                                   .pMemoryBarriers = &levelBarrier };
+
+    m_Pipeline->Bind(commandBuffer);
+
+    for (U32 levelIndex = 0; levelIndex < m_Levels.size(); levelIndex++)
+    {
+        const Level& level = m_Levels[levelIndex];
+        const bool fromDepth = levelIndex == 0;
+        const Level& source = fromDepth ? level : m_Levels[levelIndex - 1];
+
+        const ReduceConstants constants = {
+            .sourceImageIndex = fromDepth ? depthImageIndex : BindlessTable::InvalidIndex,
+            .sourceOffset = fromDepth ? 0 : source.Offset,
+            .sourceWidth = fromDepth ? m_DepthExtent.width : source.Width,
+            .sourceHeight = fromDepth ? m_DepthExtent.height : source.Height,
+            .pyramidBufferIndex = m_BindlessIndex,
+            .destinationOffset = level.Offset,
+            .destinationWidth = level.Width,
+            .destinationHeight = level.Height
+        };
+
+        vkCmdPipelineBarrier2(commandBuffer, &levelDependencyInfo);
+        m_Pipeline->PushConstants(commandBuffer, &constants);
+        vkCmdDispatch(commandBuffer, (level.Width + s_WorkgroupSize - 1) / s_WorkgroupSize,
+                      (level.Height + s_WorkgroupSize - 1) / s_WorkgroupSize, 1);
+    }
+
+    vkCmdPipelineBarrier2(commandBuffer, &levelDependencyInfo);
+}
+} // namespace FFV
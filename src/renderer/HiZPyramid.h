@@ -0,0 +1,79 @@
+#pragma once
+
+#include "renderer/BindlessTable.h"
+#include "renderer/ComputePipeline.h"
+#include "renderer/PhysicalDevice.h"
+#include "renderer/PipelineCache.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * Hierarchical depth for occlusion culling. Every texel of a level holds the farthest depth of the 2x2 texels below it,
+ * level 0 is half the size of the depth target, the last level is 1x1. Sizes are rounded up, so a texel of level n
+ * covers exactly the 2^(n+1) x 2^(n+1) depth pixels at its position.
+ * The levels are packed into one storage buffer instead of a mip chain, the bindless table has no storage images.
+ */
+class HiZPyramid
+{
+public:
+    /*
+     * Has to match the push constants in hiz.slang.
+     */
+    struct ReduceConstants
+    {
+        U32 sourceImageIndex; // BindlessTable::InvalidIndex when the source is the previous level
+        U32 sourceOffset;     // In texels
+        U32 sourceWidth;
+        U32 sourceHeight;
+        U32 pyramidBufferIndex;
+        U32 destinationOffset;
+        U32 destinationWidth;
+        U32 destinationHeight;
+    };
+
+public:
+    /*
+     * @param depthExtent: size of the depth target the pyramid gets built from
+     */
+    HiZPyramid(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, SharedPtr<BindlessTable> bindlessTable,
+               SharedPtr<PipelineCache> pipelineCache, VkExtent2D depthExtent);
+    ~HiZPyramid();
+
+    FFV_DELETE_MOVE_COPY(HiZPyramid);
+
+    /*
+     * Records one reduction dispatch per level. The depth has to be readable by compute shaders, see
+     * DepthTarget::RecordSampleBarrier, the pyramid is readable by compute shaders afterwards.
+     * @param depthImageIndex: bindless index of the sampled depth view
+     */
+    void RecordBuild(VkCommandBuffer commandBuffer, U32 depthImageIndex) const;
+
+    U32 GetBufferIndex() const { return m_BindlessIndex; }
+    U32 GetLevelCount() const { return static_cast<U32>(m_Levels.size()); }
+    const VkExtent2D& GetDepthExtent() const { return m_DepthExtent; }
+
+private:
+    struct Level
+    {
+        U32 Offset = 0; // In texels
+        U32 Width = 0;
+        U32 Height = 0;
+    };
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    SharedPtr<BindlessTable> m_BindlessTable;
+    UniquePtr<ComputePipeline> m_Pipeline;
+    VkExtent2D m_DepthExtent = { 0, 0 };
+
+    std::vector<Level> m_Levels;
+    VkBuffer m_Buffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_BufferMemory = VK_NULL_HANDLE;
+    U32 m_BindlessIndex = BindlessTable::InvalidIndex;
+};
+} // namespace FFV
@@ -1,7 +1,6 @@
 #pragma once
 
-#include "PhysicalDevice.h"
-#include "Queue.h"
+#include "renderer/GeometryPool.h"
 #include "renderer/GraphicsPipeline.h"
 #include "util/Types.h"
 #include "util/Util.h"
@@ -16,8 +15,8 @@ class Model
 public:
     struct Vertex
     {
-        glm::vec2 position;
-        glm::vec3 color;
+        glm::vec3 position;
+        glm::vec3 normal;
 
         static VkVertexInputBindingDescription GetBindingDescription()
         {
@@ -28,36 +27,32 @@ public:
         {
             return {
                 VkVertexInputAttributeDescription{
-                                                  .location = 0, .binding = 0, .format = VK_FORMAT_R32G32_SFLOAT,    .offset = offsetof(Vertex, position) },
+                                                  .location = 0, .binding = 0, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = offsetof(Vertex, position) },
                 VkVertexInputAttributeDescription{
-                                                  .location = 1, .binding = 0, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = offsetof(Vertex, color)    }
+                                                  .location = 1, .binding = 0, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = offsetof(Vertex, normal)   }
             };
         }
     };
 
 public:
-    Model(const std::vector<Vertex>& vertices, const std::vector<U32>& indices, VkDevice device,
-          SharedPtr<PhysicalDevices> physicalDevice, SharedPtr<Queue> queue, VkCommandPool commandBufferPool);
+    /*
+     * Uploads the geometry into the pool, the offsets of the sub meshes are relative to GetVertexOffset/GetFirstIndex.
+     */
+    Model(const std::vector<Vertex>& vertices, const std::vector<U32>& indices, SharedPtr<GeometryPool> geometryPool);
     ~Model();
 
     FFV_DELETE_MOVE_COPY(Model);
 
-    VkBuffer GetVertexBuffer() const { return m_VertexBuffer; }
-    VkBuffer GetIndexBuffer() const { return m_IndexBuffer; }
+    U32 GetVertexOffset() const { return m_Allocation.VertexOffset; }
+    U32 GetFirstIndex() const { return m_Allocation.FirstIndex; }
+    U32 GetIndexCount() const { return m_Allocation.IndexCount; }
+    /*
+     * False if the geometry pool had no room for the model.
+     */
+    bool IsValid() const { return m_Allocation.VertexOffset != GeometryPool::InvalidOffset; }
 
 private:
-    void CreateVertexBuffer(const std::vector<Vertex>& vertices);
-    void CreateIndexBuffer(const std::vector<U32>& indices);
-
-private:
-    VkDevice m_Device = VK_NULL_HANDLE;
-    VkCommandPool m_CommandBufferPool = VK_NULL_HANDLE;
-    SharedPtr<PhysicalDevices> m_PhysicalDevices;
-    SharedPtr<Queue> m_Queue;
-
-    VkBuffer m_VertexBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory m_VertexBufferMemory = VK_NULL_HANDLE;
-    VkBuffer m_IndexBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory m_IndexBufferMemory = VK_NULL_HANDLE;
+    SharedPtr<GeometryPool> m_GeometryPool;
+    GeometryPool::Allocation m_Allocation;
 };
 } // namespace FFV
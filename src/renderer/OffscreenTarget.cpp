@@ -0,0 +1,41 @@
+#include "FastFileViewerPCH.h"
+
+#include "OffscreenTarget.h"
+
+#include "util/Log.h"
+
+namespace FFV
+{
+OffscreenTarget::OffscreenTarget(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, VkExtent2D extent,
+                                 U32 numImages)
+    : m_Device(device), m_Extent(extent)
+{
+    m_Images.resize(numImages);
+    m_ImagesMemory.resize(numImages);
+    m_ImageViews.resize(numImages);
+
+    for (U32 i = 0; i < numImages; i++)
+    {
+        Util::CreateImage(m_Device, physicalDevices, m_Extent, Format,
+                          VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                              VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Images[i], m_ImagesMemory[i],
+                          MemoryCategory::RenderTarget);
+        m_ImageViews[i] = Util::CreateImageView(m_Device, m_Images[i], Format, VK_IMAGE_ASPECT_COLOR_BIT);
+    }
+
+    FFV_TRACE("Created {0} offscreen images ({1}x{2})!", numImages, m_Extent.width, m_Extent.height);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+OffscreenTarget::~OffscreenTarget()
+{
+    for (U32 i = 0; i < m_Images.size(); i++)
+    {
+        vkDestroyImageView(m_Device, m_ImageViews[i], VK_NULL_HANDLE);
+        vkDestroyImage(m_Device, m_Images[i], VK_NULL_HANDLE);
+        Util::FreeMemory(m_Device, m_ImagesMemory[i]);
+    }
+}
+} // namespace FFV
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "renderer/PhysicalDevice.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * Stands in for the swapchain when rendering headless. There is one color image per frame in flight, which are used
+ * as transfer source after rendering so the result can be read back.
+ */
+class OffscreenTarget
+{
+public:
+    static constexpr VkFormat Format = VK_FORMAT_R8G8B8A8_SRGB;
+
+public:
+    OffscreenTarget(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, VkExtent2D extent, U32 numImages);
+    ~OffscreenTarget();
+
+    FFV_DELETE_MOVE_COPY(OffscreenTarget);
+
+    const VkExtent2D& GetExtent() const { return m_Extent; }
+    const std::vector<VkImage>& GetImages() const { return m_Images; }
+    const std::vector<VkImageView>& GetImageViews() const { return m_ImageViews; }
+    U32 GetNumImages() const { return static_cast<U32>(m_Images.size()); }
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    VkExtent2D m_Extent = { 0, 0 };
+
+    std::vector<VkImage> m_Images;
+    std::vector<VkDeviceMemory> m_ImagesMemory;
+    std::vector<VkImageView> m_ImageViews;
+};
+} // namespace FFV
@@ -52,57 +52,68 @@ PhysicalDevices::PhysicalDevices(const VkInstance& instance, const VkSurfaceKHR&
                                << ((queueFamiliyProperties.queueFlags & VK_QUEUE_SPARSE_BINDING_BIT) ? "True" : "False")
                                << "\n";
 
-            FFV_CHECK_VK_RESULT(
-                vkGetPhysicalDeviceSurfaceSupportKHR(device, j, surface, &(m_PhysicalDevices[i].QueueSupportsPresent[j])));
+            if (surface != VK_NULL_HANDLE)
+            {
+                FFV_CHECK_VK_RESULT(vkGetPhysicalDeviceSurfaceSupportKHR(device, j, surface,
+                                                                         &(m_PhysicalDevices[i].QueueSupportsPresent[j])));
+            }
         }
 
-        U32 numFormats = 0;
-        FFV_CHECK_VK_RESULT(vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &numFormats, VK_NULL_HANDLE));
+        std::stringstream formatsDebugSs;
+        std::stringstream imageUsageFlagsDebugSs;
+        U32 numPresentModes = 0;
 
-        FFV_ASSERT(numFormats > 0, "", exit(1));
+        // Headless rendering has no surface to query
+        if (surface != VK_NULL_HANDLE)
+        {
+            U32 numFormats = 0;
+            FFV_CHECK_VK_RESULT(vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &numFormats, VK_NULL_HANDLE));
 
-        m_PhysicalDevices[i].SurfaceFormats.resize(numFormats);
+            FFV_ASSERT(numFormats > 0, "", exit(1));
 
-        FFV_CHECK_VK_RESULT(
-            vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &numFormats, m_PhysicalDevices[i].SurfaceFormats.data()));
+            m_PhysicalDevices[i].SurfaceFormats.resize(numFormats);
 
-        std::stringstream formatsDebugSs;
-        for (U32 j = 0; j < numFormats; j++)
-        {
-            const VkSurfaceFormatKHR& surfaceFormat = m_PhysicalDevices[i].SurfaceFormats[j];
-            formatsDebugSs << "                Surface " << j << ":\n                  Format: " << surfaceFormat.format
-                           << "\n                  Color Space: " << surfaceFormat.colorSpace << "\n";
-        }
+            FFV_CHECK_VK_RESULT(vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &numFormats,
+                                                                     m_PhysicalDevices[i].SurfaceFormats.data()));
 
-        FFV_CHECK_VK_RESULT(
-            vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &(m_PhysicalDevices[i].SurfaceCapabilities)));
-        const VkImageUsageFlags& imageUsageFlags = m_PhysicalDevices[i].SurfaceCapabilities.supportedUsageFlags;
+            for (U32 j = 0; j < numFormats; j++)
+            {
+                const VkSurfaceFormatKHR& surfaceFormat = m_PhysicalDevices[i].SurfaceFormats[j];
+                formatsDebugSs << "                Surface " << j
+                               << ":\n                  Format: " << surfaceFormat.format
+                               << "\n                  Color Space: " << surfaceFormat.colorSpace << "\n";
+            }
 
-        std::stringstream imageUsageFlagsDebugSs;
-        imageUsageFlagsDebugSs << "                Transfer src: "
-                               << ((imageUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) ? "True" : "False");
-        imageUsageFlagsDebugSs << "\n                Transfer dst: "
-                               << ((imageUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) ? "True" : "False");
-        imageUsageFlagsDebugSs << "\n                Sampled: "
-                               << ((imageUsageFlags & VK_IMAGE_USAGE_SAMPLED_BIT) ? "True" : "False");
-        imageUsageFlagsDebugSs << "\n                Color attachment: "
-                               << ((imageUsageFlags & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) ? "True" : "False");
-        imageUsageFlagsDebugSs << "\n                Depth stencil attachment: "
-                               << ((imageUsageFlags & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) ? "True" : "False");
-        imageUsageFlagsDebugSs << "\n                Transient attachment: "
-                               << ((imageUsageFlags & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) ? "True" : "False");
-        imageUsageFlagsDebugSs << "\n                Input attachment: "
-                               << ((imageUsageFlags & VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT) ? "True" : "False") << "\n";
+            FFV_CHECK_VK_RESULT(
+                vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &(m_PhysicalDevices[i].SurfaceCapabilities)));
+            const VkImageUsageFlags& imageUsageFlags = m_PhysicalDevices[i].SurfaceCapabilities.supportedUsageFlags;
+
+            imageUsageFlagsDebugSs << "                Transfer src: "
+                                   << ((imageUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) ? "True" : "False");
+            imageUsageFlagsDebugSs << "\n                Transfer dst: "
+                                   << ((imageUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) ? "True" : "False");
+            imageUsageFlagsDebugSs << "\n                Sampled: "
+                                   << ((imageUsageFlags & VK_IMAGE_USAGE_SAMPLED_BIT) ? "True" : "False");
+            imageUsageFlagsDebugSs << "\n                Color attachment: "
+                                   << ((imageUsageFlags & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) ? "True" : "False");
+            imageUsageFlagsDebugSs
+                << "\n                Depth stencil attachment: "
+                << ((imageUsageFlags & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) ? "True" : "False");
+            imageUsageFlagsDebugSs << "\n                Transient attachment: "
+                                   << ((imageUsageFlags & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) ? "True" : "False");
+            imageUsageFlagsDebugSs << "\n                Input attachment: "
+                                   << ((imageUsageFlags & VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT) ? "True" : "False") << "\n";
 
-        U32 numPresentModes = 0;
-        FFV_CHECK_VK_RESULT(vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &numPresentModes, VK_NULL_HANDLE));
+            FFV_CHECK_VK_RESULT(
+                vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &numPresentModes, VK_NULL_HANDLE));
 
-        FFV_ASSERT(numPresentModes != 0, "", exit(1));
+            FFV_ASSERT(numPresentModes != 0, "", exit(1));
 
-        m_PhysicalDevices[i].PresentModes.resize(numPresentModes);
+            m_PhysicalDevices[i].PresentModes.resize(numPresentModes);
 
-        FFV_CHECK_VK_RESULT(vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &numPresentModes,
-                                                                      m_PhysicalDevices[i].PresentModes.data()));
+            FFV_CHECK_VK_RESULT(vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &numPresentModes,
+                                                                          m_PhysicalDevices[i].PresentModes.data()));
+        }
 
         vkGetPhysicalDeviceMemoryProperties(device, &(m_PhysicalDevices[i].MemoryProperties));
 
@@ -124,8 +135,10 @@ PhysicalDevices::PhysicalDevices(const VkInstance& instance, const VkSurfaceKHR&
             VkFormatProperties properties;
             vkGetPhysicalDeviceFormatProperties(device, format, &properties);
 
-            if ((properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) ==
-                VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+            // Sampled to build the depth pyramid of the occlusion culling
+            const VkFormatFeatureFlags requiredFeatures =
+                VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+            if ((properties.optimalTilingFeatures & requiredFeatures) == requiredFeatures)
             {
                 m_PhysicalDevices[i].DepthFormat = format;
                 break;
@@ -162,7 +175,7 @@ U32 PhysicalDevices::SelectDevice(VkQueueFlags requiredQueueType, bool supportsP
             const VkQueueFamilyProperties& queueFamilyProperty = m_PhysicalDevices[i].QueueFamiliyProperties[j];
 
             if ((queueFamilyProperty.queueFlags & requiredQueueType) &&
-                (static_cast<bool>(m_PhysicalDevices[i].QueueSupportsPresent[j]) == supportsPresent))
+                (!supportsPresent || m_PhysicalDevices[i].QueueSupportsPresent[j]))
             {
                 m_SelectedDeviceIndex = i;
                 FFV_LOG("Using GFX device {0} and queue family {1}", i, j);
@@ -27,11 +27,18 @@ class PhysicalDevices
 {
 public:
     PhysicalDevices() = default;
+    /*
+     * @param surface: may be VK_NULL_HANDLE for headless rendering, the surface properties stay empty then
+     */
     PhysicalDevices(const VkInstance& instance, const VkSurfaceKHR& surface);
     ~PhysicalDevices() = default;
 
     // FFV_DELETE_MOVE_COPY(PhysicalDevices);
 
+    /*
+     * @param supportsPresent: only accept queue families that can present to the surface
+     * @return: the queue family index
+     */
     U32 SelectDevice(VkQueueFlags requiredQueueType, bool supportsPresent);
     const PhysicalDevice& GetSelectedPhysicalDevice() const;
 
@@ -0,0 +1,405 @@
+#include "FastFileViewerPCH.h"
+
+#include "PipelineCache.h"
+
+#include "vulkan/vulkan_core.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace FFV
+{
+static constexpr U32 s_FileMagic = 0x50564646; // "FFVP"
+static constexpr U32 s_FileVersion = 1;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PipelineCache::PipelineCache(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, const std::string& path)
+    : m_Device(device), m_PhysicalDevices(physicalDevices), m_Path(path)
+{
+    const std::vector<char> initialData = LoadCacheData();
+
+    const VkPipelineCacheCreateInfo pipelineCacheCreateInfo = { .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                                                                .initialDataSize = initialData.size(),
+                                                                .pInitialData = initialData.data() };
+
+    FFV_CHECK_VK_RESULT(vkCreatePipelineCache(m_Device, &pipelineCacheCreateInfo, VK_NULL_HANDLE, &m_PipelineCache));
+
+    FFV_TRACE("Created pipeline cache ({0} bytes loaded from '{1}')!", initialData.size(), m_Path);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PipelineCache::~PipelineCache()
+{
+    Save();
+
+    for (const auto& [hash, pipeline] : m_Pipelines)
+    {
+        vkDestroyPipeline(m_Device, pipeline, VK_NULL_HANDLE);
+    }
+
+    vkDestroyPipelineCache(m_Device, m_PipelineCache, VK_NULL_HANDLE);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+VkPipeline PipelineCache::GetOrCreateGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo, U64 stateHash)
+{
+    if (const auto it = m_Pipelines.find(stateHash); it != m_Pipelines.end())
+    {
+        m_CacheHits++;
+        return it->second;
+    }
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    FFV_CHECK_VK_RESULT(vkCreateGraphicsPipelines(m_Device, m_PipelineCache, 1, &createInfo, VK_NULL_HANDLE, &pipeline));
+
+    AddCreationTime(startTime);
+
+    m_Pipelines.emplace(stateHash, pipeline);
+    return pipeline;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+VkPipeline PipelineCache::GetOrCreateComputePipeline(const VkComputePipelineCreateInfo& createInfo, U64 shaderHash,
+                                                     U64 layoutHash)
+{
+    U64 stateHash = Util::HashBytes(&layoutHash, sizeof(layoutHash));
+    Util::HashCombine(stateHash, createInfo.flags);
+    Util::HashCombine(stateHash, createInfo.stage.stage);
+    Util::HashCombine(stateHash, shaderHash);
+
+    if (const auto it = m_Pipelines.find(stateHash); it != m_Pipelines.end())
+    {
+        m_CacheHits++;
+        return it->second;
+    }
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    FFV_CHECK_VK_RESULT(vkCreateComputePipelines(m_Device, m_PipelineCache, 1, &createInfo, VK_NULL_HANDLE, &pipeline));
+
+    AddCreationTime(startTime);
+
+    m_Pipelines.emplace(stateHash, pipeline);
+    return pipeline;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+VkPipeline PipelineCache::GetOrCreateRayTracingPipeline(const VkRayTracingPipelineCreateInfoKHR& createInfo,
+                                                        const std::vector<U64>& shaderHashes, U64 layoutHash)
+{
+    FFV_ASSERT(shaderHashes.size() == createInfo.stageCount, "Every shader stage needs a hash!", ;);
+
+    U64 stateHash = Util::HashBytes(&layoutHash, sizeof(layoutHash));
+    Util::HashCombine(stateHash, createInfo.flags);
+    Util::HashCombine(stateHash, createInfo.maxPipelineRayRecursionDepth);
+
+    for (U32 i = 0; i < createInfo.stageCount; i++)
+    {
+        Util::HashCombine(stateHash, createInfo.pStages[i].stage);
+        Util::HashCombine(stateHash, shaderHashes[i]);
+    }
+
+    // The groups only reference stages by index, so hashing their fields covers them
+    for (U32 i = 0; i < createInfo.groupCount; i++)
+    {
+        const VkRayTracingShaderGroupCreateInfoKHR& group = createInfo.pGroups[i];
+        Util::HashCombine(stateHash, group.type);
+        Util::HashCombine(stateHash, group.generalShader);
+        Util::HashCombine(stateHash, group.closestHitShader);
+        Util::HashCombine(stateHash, group.anyHitShader);
+        Util::HashCombine(stateHash, group.intersectionShader);
+    }
+
+    if (const auto it = m_Pipelines.find(stateHash); it != m_Pipelines.end())
+    {
+        m_CacheHits++;
+        return it->second;
+    }
+
+    if (!m_CreateRayTracingPipelines)
+    {
+        m_CreateRayTracingPipelines = reinterpret_cast<PFN_vkCreateRayTracingPipelinesKHR>(
+            vkGetDeviceProcAddr(m_Device, "vkCreateRayTracingPipelinesKHR"));
+        FFV_ASSERT(m_CreateRayTracingPipelines, "Cannot find address of vkCreateRayTracingPipelinesKHR",
+                   return VK_NULL_HANDLE);
+    }
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    FFV_CHECK_VK_RESULT(m_CreateRayTracingPipelines(m_Device, VK_NULL_HANDLE, m_PipelineCache, 1, &createInfo,
+                                                    VK_NULL_HANDLE, &pipeline));
+
+    AddCreationTime(startTime);
+
+    m_Pipelines.emplace(stateHash, pipeline);
+    return pipeline;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U64 PipelineCache::HashGraphicsPipelineState(const VkGraphicsPipelineCreateInfo& createInfo,
+                                             const std::vector<U64>& shaderHashes, U64 layoutHash)
+{
+    FFV_ASSERT(shaderHashes.size() == createInfo.stageCount, "Every shader stage needs a hash!", ;);
+
+    U64 hash = Util::HashBytes(&layoutHash, sizeof(layoutHash));
+    Util::HashCombine(hash, createInfo.flags);
+
+    for (U32 i = 0; i < createInfo.stageCount; i++)
+    {
+        Util::HashCombine(hash, createInfo.pStages[i].stage);
+        Util::HashCombine(hash, shaderHashes[i]);
+    }
+
+    if (const VkPipelineVertexInputStateCreateInfo* vertexInput = createInfo.pVertexInputState)
+    {
+        for (U32 i = 0; i < vertexInput->vertexBindingDescriptionCount; i++)
+        {
+            Util::HashCombine(hash, vertexInput->pVertexBindingDescriptions[i]);
+        }
+
+        for (U32 i = 0; i < vertexInput->vertexAttributeDescriptionCount; i++)
+        {
+            Util::HashCombine(hash, vertexInput->pVertexAttributeDescriptions[i]);
+        }
+    }
+
+    if (const VkPipelineInputAssemblyStateCreateInfo* inputAssembly = createInfo.pInputAssemblyState)
+    {
+        Util::HashCombine(hash, inputAssembly->topology);
+        Util::HashCombine(hash, inputAssembly->primitiveRestartEnable);
+    }
+
+    if (const VkPipelineRasterizationStateCreateInfo* rasterization = createInfo.pRasterizationState)
+    {
+        Util::HashCombine(hash, rasterization->depthClampEnable);
+        Util::HashCombine(hash, rasterization->rasterizerDiscardEnable);
+        Util::HashCombine(hash, rasterization->polygonMode);
+        Util::HashCombine(hash, rasterization->cullMode);
+        Util::HashCombine(hash, rasterization->frontFace);
+        Util::HashCombine(hash, rasterization->depthBiasEnable);
+        Util::HashCombine(hash, rasterization->depthBiasConstantFactor);
+        Util::HashCombine(hash, rasterization->depthBiasClamp);
+        Util::HashCombine(hash, rasterization->depthBiasSlopeFactor);
+        Util::HashCombine(hash, rasterization->lineWidth);
+    }
+
+    if (const VkPipelineMultisampleStateCreateInfo* multisample = createInfo.pMultisampleState)
+    {
+        Util::HashCombine(hash, multisample->rasterizationSamples);
+        Util::HashCombine(hash, multisample->sampleShadingEnable);
+        Util::HashCombine(hash, multisample->minSampleShading);
+        Util::HashCombine(hash, multisample->alphaToCoverageEnable);
+    }
+
+    if (const VkPipelineDepthStencilStateCreateInfo* depthStencil = createInfo.pDepthStencilState)
+    {
+        Util::HashCombine(hash, depthStencil->depthTestEnable);
+        Util::HashCombine(hash, depthStencil->depthWriteEnable);
+        Util::HashCombine(hash, depthStencil->depthCompareOp);
+        Util::HashCombine(hash, depthStencil->stencilTestEnable);
+    }
+
+    if (const VkPipelineColorBlendStateCreateInfo* colorBlend = createInfo.pColorBlendState)
+    {
+        Util::HashCombine(hash, colorBlend->logicOpEnable);
+        Util::HashCombine(hash, colorBlend->logicOp);
+
+        for (U32 i = 0; i < colorBlend->attachmentCount; i++)
+        {
+            Util::HashCombine(hash, colorBlend->pAttachments[i]);
+        }
+    }
+
+    if (const VkPipelineDynamicStateCreateInfo* dynamicState = createInfo.pDynamicState)
+    {
+        for (U32 i = 0; i < dynamicState->dynamicStateCount; i++)
+        {
+            Util::HashCombine(hash, dynamicState->pDynamicStates[i]);
+        }
+    }
+
+    // Dynamic rendering stores the attachment formats in the pNext chain
+    for (const VkBaseInStructure* next = static_cast<const VkBaseInStructure*>(createInfo.pNext); next;
+         next = next->pNext)
+    {
+        if (next->sType != VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO)
+        {
+            continue;
+        }
+
+        const VkPipelineRenderingCreateInfo* rendering = reinterpret_cast<const VkPipelineRenderingCreateInfo*>(next);
+        Util::HashCombine(hash, rendering->viewMask);
+        for (U32 i = 0; i < rendering->colorAttachmentCount; i++)
+        {
+            Util::HashCombine(hash, rendering->pColorAttachmentFormats[i]);
+        }
+        Util::HashCombine(hash, rendering->depthAttachmentFormat);
+        Util::HashCombine(hash, rendering->stencilAttachmentFormat);
+    }
+
+    return hash;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PipelineCache::LogCreationTime() const
+{
+    if (m_ColdCreationTimeMs < 0.0)
+    {
+        FFV_LOG("Created {0} pipelines in {1:.2f} ms without a warm pipeline cache ({2} in memory cache hits)",
+                m_Pipelines.size(), m_CreationTimeMs, m_CacheHits);
+        return;
+    }
+
+    FFV_LOG("Created {0} pipelines in {1:.2f} ms, the cold run took {2:.2f} ms (saved {3:.2f} ms, {4} in memory cache "
+            "hits)",
+            m_Pipelines.size(), m_CreationTimeMs, m_ColdCreationTimeMs, m_ColdCreationTimeMs - m_CreationTimeMs,
+            m_CacheHits);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PipelineCache::Save() const
+{
+    size_t dataSize = 0;
+    FFV_CHECK_VK_RESULT(vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, nullptr));
+
+    std::vector<char> data(dataSize);
+    FFV_CHECK_VK_RESULT(vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, data.data()));
+
+    const VkPhysicalDeviceProperties& properties = m_PhysicalDevices->GetSelectedPhysicalDevice().DeviceProperties;
+
+    FileHeader header = { .Magic = s_FileMagic,
+                          .Version = s_FileVersion,
+                          .VendorID = properties.vendorID,
+                          .DeviceID = properties.deviceID,
+                          .DriverVersion = properties.driverVersion,
+                          .Padding = 0,
+                          // Keep the time of the run that had to compile everything so later runs can compare against it
+                          .ColdCreationTimeMs = m_ColdCreationTimeMs < 0.0 ? m_CreationTimeMs : m_ColdCreationTimeMs,
+                          .DataSize = dataSize };
+    std::memcpy(header.PipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    // The cache only saves time on the next start, so failing to write it isn't fatal
+    std::error_code error;
+    const std::filesystem::path directory = std::filesystem::path(m_Path).parent_path();
+    if (!directory.empty())
+    {
+        std::filesystem::create_directories(directory, error);
+        if (error)
+        {
+            FFV_WARN("Failed to create the pipeline cache directory '{0}': {1}", directory.string(), error.message());
+            return;
+        }
+    }
+
+    // Write to a temporary file first so a crash while saving never leaves a truncated cache behind
+    const std::string tmpPath = m_Path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            FFV_WARN("Failed to write pipeline cache to '{0}'", tmpPath);
+            return;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    std::filesystem::rename(tmpPath, m_Path, error);
+    if (error)
+    {
+        FFV_WARN("Failed to replace pipeline cache '{0}': {1}", m_Path, error.message());
+        return;
+    }
+
+    FFV_TRACE("Saved pipeline cache ({0} bytes) to '{1}'", dataSize, m_Path);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<char> PipelineCache::LoadCacheData()
+{
+    std::vector<char> data;
+
+    std::ifstream file(m_Path, std::ios::binary);
+    if (!file.is_open())
+    {
+        FFV_TRACE("No pipeline cache found at '{0}'", m_Path);
+        return data;
+    }
+
+    FileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        FFV_WARN("Pipeline cache '{0}' is truncated, ignoring it", m_Path);
+        return data;
+    }
+
+    const U64 fileSize = std::filesystem::file_size(m_Path);
+    if (header.Magic != s_FileMagic || header.DataSize != fileSize - sizeof(header))
+    {
+        FFV_WARN("Pipeline cache '{0}' is corrupt, ignoring it", m_Path);
+        return data;
+    }
+
+    data.resize(header.DataSize);
+    if (!file.read(data.data(), static_cast<std::streamsize>(data.size())) || !IsHeaderValid(header, data))
+    {
+        FFV_WARN("Pipeline cache '{0}' was created by a different device or driver, ignoring it", m_Path);
+        data.clear();
+        return data;
+    }
+
+    m_ColdCreationTimeMs = header.ColdCreationTimeMs;
+    return data;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PipelineCache::AddCreationTime(std::chrono::high_resolution_clock::time_point startTime)
+{
+    m_CreationTimeMs +=
+        std::chrono::duration<F64, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PipelineCache::IsHeaderValid(const FileHeader& header, const std::vector<char>& data) const
+{
+    const VkPhysicalDeviceProperties& properties = m_PhysicalDevices->GetSelectedPhysicalDevice().DeviceProperties;
+
+    if (header.Version != s_FileVersion || header.VendorID != properties.vendorID ||
+        header.DeviceID != properties.deviceID || header.DriverVersion != properties.driverVersion ||
+        std::memcmp(header.PipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        return false;
+    }
+
+    // The driver validates its own header as well, but a corrupt blob is cheaper to catch here
+    if (data.size() < sizeof(VkPipelineCacheHeaderVersionOne))
+    {
+        return false;
+    }
+
+    VkPipelineCacheHeaderVersionOne driverHeader;
+    std::memcpy(&driverHeader, data.data(), sizeof(driverHeader));
+
+    return driverHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           driverHeader.vendorID == properties.vendorID && driverHeader.deviceID == properties.deviceID &&
+           std::memcmp(driverHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+} // namespace FFV
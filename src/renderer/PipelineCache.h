@@ -0,0 +1,101 @@
+#pragma once
+
+#include "renderer/PhysicalDevice.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * Owns the VkPipelineCache that gets persisted to disk between runs and an in memory cache of created pipelines,
+ * keyed by a hash of their state description, so identical pipelines are only created once.
+ * Pipelines returned by this class are owned by it and destroyed together with it.
+ */
+class PipelineCache
+{
+public:
+    /*
+     * @param path: file the cache gets loaded from and saved to, a missing or stale file is ignored
+     */
+    PipelineCache(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, const std::string& path);
+    ~PipelineCache();
+
+    FFV_DELETE_MOVE_COPY(PipelineCache);
+
+    /*
+     * @param createInfo: must describe the same state as stateHash
+     * @param stateHash: result of HashGraphicsPipelineState
+     */
+    VkPipeline GetOrCreateGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo, U64 stateHash);
+
+    /*
+     * @param shaderHash: content hash of the compute shader
+     * @param layoutHash: hash of the pipeline layout description, its push constant ranges and every set layout
+     */
+    VkPipeline GetOrCreateComputePipeline(const VkComputePipelineCreateInfo& createInfo, U64 shaderHash, U64 layoutHash);
+
+    /*
+     * The device needs VK_KHR_ray_tracing_pipeline.
+     * @param shaderHashes: content hash of every stage in createInfo.pStages, in the same order
+     * @param layoutHash: hash of the pipeline layout description, its push constant ranges and every set layout
+     */
+    VkPipeline GetOrCreateRayTracingPipeline(const VkRayTracingPipelineCreateInfoKHR& createInfo,
+                                             const std::vector<U64>& shaderHashes, U64 layoutHash);
+
+    /*
+     * Hashes everything that influences the created pipeline. Shader modules and the layout are only handles, so their
+     * content has to be hashed by the caller.
+     * @param shaderHashes: content hash of every stage in createInfo.pStages, in the same order
+     * @param layoutHash: hash of the pipeline layout description, its push constant ranges and every set layout
+     */
+    static U64 HashGraphicsPipelineState(const VkGraphicsPipelineCreateInfo& createInfo,
+                                         const std::vector<U64>& shaderHashes, U64 layoutHash);
+
+    /*
+     * Logs how long pipeline creation took in this run compared to the run that created the cache file.
+     */
+    void LogCreationTime() const;
+
+    void Save() const;
+
+    VkPipelineCache GetPipelineCache() const { return m_PipelineCache; }
+
+private:
+    struct FileHeader
+    {
+        U32 Magic;
+        U32 Version;
+        U32 VendorID;
+        U32 DeviceID;
+        U32 DriverVersion;
+        U8 PipelineCacheUUID[VK_UUID_SIZE];
+        U32 Padding;
+        F64 ColdCreationTimeMs;
+        U64 DataSize;
+    };
+
+private:
+    std::vector<char> LoadCacheData();
+    void AddCreationTime(std::chrono::high_resolution_clock::time_point startTime);
+    bool IsHeaderValid(const FileHeader& header, const std::vector<char>& data) const;
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    SharedPtr<PhysicalDevices> m_PhysicalDevices;
+    std::string m_Path;
+
+    VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
+    std::unordered_map<U64, VkPipeline> m_Pipelines;
+    PFN_vkCreateRayTracingPipelinesKHR m_CreateRayTracingPipelines = nullptr; // Loaded on first use
+
+    F64 m_CreationTimeMs = 0.0;
+    F64 m_ColdCreationTimeMs = -1.0;
+    U32 m_CacheHits = 0;
+};
+} // namespace FFV
@@ -2,13 +2,16 @@
 
 #include "Queue.h"
 
+#include "util/Profiler.h"
 #include "vulkan/vulkan_core.h"
 
 namespace FFV
 {
-Queue::Queue(VkDevice device, SharedPtr<Swapchain> swapchain, U32 queueFamily, U32 queueIndex)
-    : m_Device(device), m_Swapchain(swapchain)
+Queue::Queue(VkDevice device, SharedPtr<Swapchain> swapchain, U32 queueFamily, U32 queueIndex, U32 framesInFlight)
+    : m_Device(device), m_Swapchain(swapchain), m_FramesInFlight(framesInFlight)
 {
+    FFV_ASSERT(m_FramesInFlight > 0, "At least one frame has to be in flight!", m_FramesInFlight = 1);
+
     vkGetDeviceQueue(m_Device, queueFamily, queueIndex, &m_Queue);
     FFV_TRACE("Queue acquired!");
     CreateSyncObjects();
@@ -18,20 +21,42 @@ Queue::Queue(VkDevice device, SharedPtr<Swapchain> swapchain, U32 queueFamily, U
 
 Queue::~Queue()
 {
-    for (U32 i = 0; i < m_Swapchain->GetNumImagesInFlight(); i++)
+    // Presents have no completion signal, only an idle queue guarantees they no longer wait on the image semaphores
+    WaitIdle();
+    DestroyRetired(std::numeric_limits<U64>::max());
+    DestroyImageSemaphores();
+
+    for (U32 i = 0; i < m_PresentCompleteSemaphores.size(); i++)
     {
-        vkDestroySemaphore(m_Device, m_RenderCompleteSemaphores[i], VK_NULL_HANDLE);
         vkDestroySemaphore(m_Device, m_PresentCompleteSemaphores[i], VK_NULL_HANDLE);
-        vkDestroyFence(m_Device, m_InFlightFences[i], VK_NULL_HANDLE);
     }
+
+    vkDestroySemaphore(m_Device, m_FrameTimeline, VK_NULL_HANDLE);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-U32 Queue::AquireNextImage() const
+U32 Queue::AquireNextImage()
 {
-    FFV_CHECK_VK_RESULT(
-        vkWaitForFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame], VK_TRUE, std::numeric_limits<U64>::max()));
+    FFV_PROFILE_FUNCTION();
+
+    if (m_FrameNumber > m_FramesInFlight)
+    {
+        WaitForFrame(m_FrameNumber - m_FramesInFlight);
+    }
+
+    DestroyRetired(GetCompletedFrameNumber());
+
+    // Headless rendering uses one offscreen image per frame in flight
+    if (!m_Swapchain)
+    {
+        return m_CurrentFrame;
+    }
+
+    if (m_Swapchain->IsRecreateRequested())
+    {
+        RecreateSwapchain();
+    }
 
     U32 imageIndex = 0;
     const VkResult result = vkAcquireNextImageKHR(m_Device, m_Swapchain->GetSwapchain(), std::numeric_limits<U64>::max(),
@@ -39,15 +64,24 @@ U32 Queue::AquireNextImage() const
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR)
     {
-        m_Swapchain->Recreate();
+        RecreateSwapchain();
         return AquireNextImage(); // Retry acquiring the next image after swapchain recreation
     }
-    else
+    else if (result != VK_SUBOPTIMAL_KHR)
     {
         FFV_CHECK_VK_RESULT(result);
     }
 
-    FFV_CHECK_VK_RESULT(vkResetFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame]));
+    // Presents of the old swapchain may still wait on the semaphores, so every image of a new swapchain gets new ones
+    if (m_SwapchainGeneration != m_Swapchain->GetGeneration())
+    {
+        m_RetiredSemaphores.push_back({ .Semaphores = std::move(m_RenderCompleteSemaphores),
+                                        .RetireFrameNumber = m_FrameNumber - 1 + m_FramesInFlight });
+        m_RenderCompleteSemaphores.clear();
+        CreateImageSemaphores();
+
+        m_SwapchainGeneration = m_Swapchain->GetGeneration();
+    }
 
     return imageIndex;
 }
@@ -67,30 +101,59 @@ void Queue::Submit(VkCommandBuffer commandBuffer) const
 
 void Queue::SubmitAsync(VkCommandBuffer commandBuffer, U32 imageIndex) const
 {
-    const VkPipelineStageFlags waitFlags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    const VkSemaphoreSubmitInfo waitSemaphoreInfo = { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                                                      .semaphore = m_PresentCompleteSemaphores[m_CurrentFrame],
+                                                      .stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT };
 
-    const VkSubmitInfo submitInfo = { .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                                      .waitSemaphoreCount = 1,
-                                      .pWaitSemaphores = &m_PresentCompleteSemaphores[m_CurrentFrame],
-                                      .pWaitDstStageMask = &waitFlags,
-                                      .commandBufferCount = 1,
-                                      .pCommandBuffers = &commandBuffer,
-                                      .signalSemaphoreCount = 1,
-                                      .pSignalSemaphores = &m_RenderCompleteSemaphores[imageIndex] };
+    // Headless frames neither wait for an acquired image nor signal a present, only the frame timeline
+    const bool hasSwapchain = m_Swapchain != nullptr;
 
-    FFV_CHECK_VK_RESULT(vkQueueSubmit(m_Queue, 1, &submitInfo, m_InFlightFences[m_CurrentFrame]));
+    const std::array<VkSemaphoreSubmitInfo, 2> signalSemaphoreInfos = {
+        VkSemaphoreSubmitInfo{ .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                              .semaphore = m_FrameTimeline,
+                              .value = m_FrameNumber,
+                              .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT },
+        VkSemaphoreSubmitInfo{ .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                              .semaphore = hasSwapchain ? m_RenderCompleteSemaphores[imageIndex] : VK_NULL_HANDLE,
+                              .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT }
+    };
+
+    const VkCommandBufferSubmitInfo commandBufferInfo = { .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+                                                          .commandBuffer = commandBuffer };
+
+    const VkSubmitInfo2 submitInfo = { .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+                                       .waitSemaphoreInfoCount = hasSwapchain ? 1u : 0u,
+                                       .pWaitSemaphoreInfos = &waitSemaphoreInfo,
+                                       .commandBufferInfoCount = 1,
+                                       .pCommandBufferInfos = &commandBufferInfo,
+                                       .signalSemaphoreInfoCount = hasSwapchain ? 2u : 1u,
+                                       .pSignalSemaphoreInfos = signalSemaphoreInfos.data() };
+
+    FFV_CHECK_VK_RESULT(vkQueueSubmit2(m_Queue, 1, &submitInfo, VK_NULL_HANDLE));
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Queue::Present(U32 imageIndex)
 {
+    if (!m_Swapchain)
+    {
+        m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
+        m_FrameNumber++;
+        return;
+    }
+
     FFV_ASSERT(imageIndex < m_Swapchain->GetNumImagesInFlight(),
                std::format("Image index {} is out of bounds! Swapchain images in flight: {}", imageIndex,
                            m_Swapchain->GetNumImagesInFlight()),
                return);
 
+    const VkPresentIdKHR presentId = { .sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+                                       .swapchainCount = 1,
+                                       .pPresentIds = &m_FrameNumber };
+
     const VkPresentInfoKHR presentInfo = { .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+                                           .pNext = IsPresentWaitEnabled() ? &presentId : nullptr,
                                            .waitSemaphoreCount = 1,
                                            .pWaitSemaphores = &m_RenderCompleteSemaphores[imageIndex],
                                            .swapchainCount = 1,
@@ -99,17 +162,86 @@ void Queue::Present(U32 imageIndex)
 
     const VkResult result = vkQueuePresentKHR(m_Queue, &presentInfo);
 
+    // The frame was submitted either way, so the timeline has to advance even if the swapchain gets recreated
+    m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
+    m_FrameNumber++;
+
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
     {
-        m_Swapchain->Recreate();
-        return;
+        RecreateSwapchain();
     }
     else
     {
         FFV_CHECK_VK_RESULT(result);
     }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Queue::WaitForFrame(U64 frameNumber) const
+{
+    FFV_PROFILE_FUNCTION();
+
+    const VkSemaphoreWaitInfo waitInfo = { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                                           .semaphoreCount = 1,
+                                           .pSemaphores = &m_FrameTimeline,
+                                           .pValues = &frameNumber };
+
+    FFV_CHECK_VK_RESULT(vkWaitSemaphores(m_Device, &waitInfo, std::numeric_limits<U64>::max()));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Queue::EnablePresentWait()
+{
+    m_WaitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(m_Device, "vkWaitForPresentKHR"));
+    FFV_ASSERT(m_WaitForPresent, "Cannot find address of vkWaitForPresentKHR", return);
+
+    FFV_TRACE("Enabled present wait!");
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Queue::WaitForPresent(U64 frameNumber, U64 timeout) const
+{
+    if (!IsPresentWaitEnabled())
+    {
+        const VkSemaphoreWaitInfo waitInfo = { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                                               .semaphoreCount = 1,
+                                               .pSemaphores = &m_FrameTimeline,
+                                               .pValues = &frameNumber };
+
+        const VkResult result = vkWaitSemaphores(m_Device, &waitInfo, timeout);
+        if (result != VK_TIMEOUT)
+        {
+            FFV_CHECK_VK_RESULT(result);
+        }
+
+        return result == VK_SUCCESS;
+    }
+
+    const VkResult result = m_WaitForPresent(m_Device, m_Swapchain->GetSwapchain(), frameNumber, timeout);
+
+    // An out of date swapchain doesn't report presents anymore, so the frame counts as done
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+    {
+        return true;
+    }
+    else if (result != VK_TIMEOUT)
+    {
+        FFV_CHECK_VK_RESULT(result);
+    }
+
+    return result == VK_SUCCESS;
+}
 
-    m_CurrentFrame = (m_CurrentFrame + 1) % m_Swapchain->GetNumImagesInFlight();
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U64 Queue::GetCompletedFrameNumber() const
+{
+    U64 value = 0;
+    FFV_CHECK_VK_RESULT(vkGetSemaphoreCounterValue(m_Device, m_FrameTimeline, &value));
+    return value;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -117,26 +249,91 @@ void Queue::Present(U32 imageIndex)
 void Queue::CreateSyncObjects()
 {
     m_PresentCompleteSemaphores.clear();
-    m_RenderCompleteSemaphores.clear();
-    m_InFlightFences.clear();
 
     const VkSemaphoreCreateInfo semaphoreCreateInfo = { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
-    const VkFenceCreateInfo fenceCreateInfo = { .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-                                                .flags = VK_FENCE_CREATE_SIGNALED_BIT };
+
+    for (U32 i = 0; i < m_FramesInFlight; i++)
+    {
+        VkSemaphore presentCompleteSemaphore;
+        FFV_CHECK_VK_RESULT(vkCreateSemaphore(m_Device, &semaphoreCreateInfo, VK_NULL_HANDLE, &presentCompleteSemaphore));
+        m_PresentCompleteSemaphores.push_back(presentCompleteSemaphore);
+    }
+
+    const VkSemaphoreTypeCreateInfo timelineCreateInfo = { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+                                                           .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+                                                           .initialValue = 0 };
+    const VkSemaphoreCreateInfo timelineSemaphoreCreateInfo = { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                                                                .pNext = &timelineCreateInfo };
+    FFV_CHECK_VK_RESULT(vkCreateSemaphore(m_Device, &timelineSemaphoreCreateInfo, VK_NULL_HANDLE, &m_FrameTimeline));
+
+    CreateImageSemaphores();
+
+    FFV_TRACE("Created sync objects for {0} frames in flight!", m_FramesInFlight);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Queue::CreateImageSemaphores()
+{
+    if (!m_Swapchain)
+    {
+        return;
+    }
+
+    const VkSemaphoreCreateInfo semaphoreCreateInfo = { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
 
     for (U32 i = 0; i < m_Swapchain->GetNumImagesInFlight(); i++)
     {
         VkSemaphore renderCompleteSemaphore;
         FFV_CHECK_VK_RESULT(vkCreateSemaphore(m_Device, &semaphoreCreateInfo, VK_NULL_HANDLE, &renderCompleteSemaphore));
         m_RenderCompleteSemaphores.push_back(renderCompleteSemaphore);
+    }
+}
 
-        VkSemaphore presentCompleteSemaphore;
-        FFV_CHECK_VK_RESULT(vkCreateSemaphore(m_Device, &semaphoreCreateInfo, VK_NULL_HANDLE, &presentCompleteSemaphore));
-        m_PresentCompleteSemaphores.push_back(presentCompleteSemaphore);
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Queue::DestroyImageSemaphores()
+{
+    for (U32 i = 0; i < m_RenderCompleteSemaphores.size(); i++)
+    {
+        vkDestroySemaphore(m_Device, m_RenderCompleteSemaphores[i], VK_NULL_HANDLE);
+    }
+
+    m_RenderCompleteSemaphores.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Queue::RecreateSwapchain()
+{
+    // Every frame up to m_FrameNumber - 1 has been submitted and may use the old swapchain. Presents don't signal when
+    // they are done with an image, so the old swapchain is kept for another frames in flight worth of frames
+    m_Swapchain->Recreate(m_FrameNumber - 1 + m_FramesInFlight);
+}
 
-        VkFence inFlightFence;
-        FFV_CHECK_VK_RESULT(vkCreateFence(m_Device, &fenceCreateInfo, VK_NULL_HANDLE, &inFlightFence));
-        m_InFlightFences.push_back(inFlightFence);
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Queue::DestroyRetired(U64 completedFrameNumber)
+{
+    if (m_Swapchain)
+    {
+        m_Swapchain->DestroyRetired(completedFrameNumber);
     }
+
+    std::erase_if(m_RetiredSemaphores,
+                  [&](const RetiredSemaphores& retired)
+                  {
+                      if (retired.RetireFrameNumber > completedFrameNumber)
+                      {
+                          return false;
+                      }
+
+                      for (const VkSemaphore semaphore : retired.Semaphores)
+                      {
+                          vkDestroySemaphore(m_Device, semaphore, VK_NULL_HANDLE);
+                      }
+
+                      return true;
+                  });
 }
 } // namespace FFV
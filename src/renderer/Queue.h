@@ -8,34 +8,97 @@
 
 namespace FFV
 {
+/*
+ * Frames are paced with a timeline semaphore: frame N signals the value N once the GPU finished it and the CPU only
+ * starts frame N after frame N - framesInFlight is done. Per frame resources are indexed with GetFrameIndex(), per
+ * swapchain image resources with the image index returned by AquireNextImage().
+ */
 class Queue
 {
+public:
+    static constexpr U32 DefaultFramesInFlight = 2;
+
 public:
     Queue() = default;
-    Queue(VkDevice device, SharedPtr<Swapchain> swapchain, U32 queueFamily, U32 queueIndex);
+    /*
+     * @param swapchain: nullptr for headless rendering, AquireNextImage then returns the frame index and nothing is
+     * presented
+     */
+    Queue(VkDevice device, SharedPtr<Swapchain> swapchain, U32 queueFamily, U32 queueIndex,
+          U32 framesInFlight = DefaultFramesInFlight);
     ~Queue();
 
     FFV_DELETE_MOVE_COPY(Queue);
 
-    U32 AquireNextImage() const;
+    /*
+     * Waits until the resources of the current frame index are no longer used by the GPU and acquires the next
+     * swapchain image.
+     */
+    U32 AquireNextImage();
     void Submit(VkCommandBuffer commandBuffer) const;
     void SubmitAsync(VkCommandBuffer commandBuffer, U32 imageIndex) const;
+    /*
+     * Presents with the frame number as present id when present wait is enabled. Headless it only ends the frame.
+     */
     void Present(U32 imageIndex);
     void WaitIdle() const { vkQueueWaitIdle(m_Queue); }
+
+    /*
+     * Blocks until the GPU finished the given frame number.
+     */
+    void WaitForFrame(U64 frameNumber) const;
+
+    /*
+     * Requires VK_KHR_present_id and VK_KHR_present_wait to be enabled on the device.
+     */
+    void EnablePresentWait();
+    bool IsPresentWaitEnabled() const { return m_WaitForPresent != nullptr; }
+
+    /*
+     * Waits until the frame was presented, or only until the GPU finished it when present wait is not enabled.
+     * @param timeout: in nanoseconds
+     * @return: false on timeout
+     */
+    bool WaitForPresent(U64 frameNumber, U64 timeout) const;
+
     const VkQueue& GetQueue() const { return m_Queue; }
+    U32 GetFramesInFlight() const { return m_FramesInFlight; }
+    U32 GetFrameIndex() const { return m_CurrentFrame; }
+    U64 GetFrameNumber() const { return m_FrameNumber; }
+    U64 GetCompletedFrameNumber() const;
+    VkSemaphore GetFrameTimeline() const { return m_FrameTimeline; }
 
 private:
     void CreateSyncObjects();
+    void CreateImageSemaphores();
+    void DestroyImageSemaphores();
+    /*
+     * Retires the swapchain and the semaphores of its images, they get destroyed once the frames using them retired.
+     */
+    void RecreateSwapchain();
+    void DestroyRetired(U64 completedFrameNumber);
+
+private:
+    struct RetiredSemaphores
+    {
+        std::vector<VkSemaphore> Semaphores;
+        U64 RetireFrameNumber = 0;
+    };
 
 private:
     VkDevice m_Device = VK_NULL_HANDLE;
     SharedPtr<Swapchain> m_Swapchain;
 
     VkQueue m_Queue = VK_NULL_HANDLE;
-    std::vector<VkSemaphore> m_RenderCompleteSemaphores;
-    std::vector<VkSemaphore> m_PresentCompleteSemaphores;
-    std::vector<VkFence> m_InFlightFences;
+    std::vector<VkSemaphore> m_RenderCompleteSemaphores; // Per swapchain image
+    std::vector<RetiredSemaphores> m_RetiredSemaphores;
+    U64 m_SwapchainGeneration = 0;
+    std::vector<VkSemaphore> m_PresentCompleteSemaphores; // Per frame in flight
+    VkSemaphore m_FrameTimeline = VK_NULL_HANDLE;
+    PFN_vkWaitForPresentKHR m_WaitForPresent = nullptr;
 
+    U32 m_FramesInFlight = DefaultFramesInFlight;
     U32 m_CurrentFrame = 0;
+    U64 m_FrameNumber = 1;
 };
 } // namespace FFV
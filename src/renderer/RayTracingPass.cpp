@@ -0,0 +1,399 @@
+#include "FastFileViewerPCH.h"
+
+#include "RayTracingPass.h"
+
+#include "renderer/Shader.h"
+#include "util/Log.h"
+
+#include <array>
+#include <limits>
+
+namespace FFV
+{
+// Shader groups in the order of the shader binding table
+static constexpr U32 s_RayGenGroup = 0;
+static constexpr U32 s_MissGroup = 1;
+static constexpr U32 s_HitGroup = 2;
+static constexpr U32 s_GroupCount = 3;
+
+static constexpr VkShaderStageFlags s_PushConstantStages =
+    VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void RecordImageBarrier(VkCommandBuffer commandBuffer, VkImage image, VkPipelineStageFlags2 srcStageMask,
+                               VkAccessFlags2 srcAccessMask, VkPipelineStageFlags2 dstStageMask,
+                               VkAccessFlags2 dstAccessMask, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+    const VkImageMemoryBarrier2 imageBarrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .srcStageMask = srcStageMask,
+        .srcAccessMask = srcAccessMask,
+        .dstStageMask = dstStageMask,
+        .dstAccessMask = dstAccessMask,
+        .oldLayout = oldLayout,
+        .newLayout = newLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .levelCount = 1, .layerCount = 1 }
+    };
+
+    const VkDependencyInfo dependencyInfo = { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                              .imageMemoryBarrierCount = 1,
+                                              .pImageMemoryBarriers = &imageBarrier };
+    vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RayTracingPass::RayTracingPass(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices,
+                               SharedPtr<BindlessTable> bindlessTable, SharedPtr<PipelineCache> pipelineCache,
+                               VkExtent2D extent, U32 numFrames)
+    : m_Device(device), m_PhysicalDevices(physicalDevices), m_BindlessTable(bindlessTable), m_Extent(extent)
+{
+    m_GetShaderGroupHandles = reinterpret_cast<PFN_vkGetRayTracingShaderGroupHandlesKHR>(
+        vkGetDeviceProcAddr(m_Device, "vkGetRayTracingShaderGroupHandlesKHR"));
+    FFV_ASSERT(m_GetShaderGroupHandles, "Cannot find address of vkGetRayTracingShaderGroupHandlesKHR", exit(1));
+    m_CmdTraceRays = reinterpret_cast<PFN_vkCmdTraceRaysKHR>(vkGetDeviceProcAddr(m_Device, "vkCmdTraceRaysKHR"));
+    FFV_ASSERT(m_CmdTraceRays, "Cannot find address of vkCmdTraceRaysKHR", exit(1));
+
+    CreatePipeline(pipelineCache);
+    CreateShaderBindingTable();
+    CreateDescriptorSets(numFrames);
+    CreateOutputImage();
+
+    FFV_TRACE("Created ray tracing pass ({0}x{1})!", m_Extent.width, m_Extent.height);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RayTracingPass::~RayTracingPass()
+{
+    DestroyRetired(std::numeric_limits<U64>::max());
+    DestroyOutputImage();
+
+    vkDestroyBuffer(m_Device, m_ShaderBindingTable, VK_NULL_HANDLE);
+    Util::FreeMemory(m_Device, m_ShaderBindingTableMemory);
+
+    vkDestroyDescriptorPool(m_Device, m_DescriptorPool, VK_NULL_HANDLE);
+    vkDestroyDescriptorSetLayout(m_Device, m_DescriptorSetLayout, VK_NULL_HANDLE);
+    vkDestroyPipelineLayout(m_Device, m_PipelineLayout, VK_NULL_HANDLE);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool RayTracingPass::IsSupported(const SharedPtr<PhysicalDevices>& physicalDevices, VkFormat targetFormat)
+{
+    const VkPhysicalDevice physicalDevice = physicalDevices->GetSelectedPhysicalDevice().PhysicalDevice;
+
+    VkFormatProperties sourceProperties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, Format, &sourceProperties);
+    VkFormatProperties targetProperties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, targetFormat, &targetProperties);
+
+    return (sourceProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) &&
+           (sourceProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT) &&
+           (targetProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RayTracingPass::Resize(VkExtent2D extent, U64 retireFrameNumber)
+{
+    // The descriptor set of a frame is rewritten before it's bound again, so only the image itself has to outlive the
+    // frames in flight
+    m_RetiredImages.push_back({ .Image = m_OutputImage,
+                                .Memory = m_OutputImageMemory,
+                                .ImageView = m_OutputImageView,
+                                .RetireFrameNumber = retireFrameNumber });
+    m_Extent = extent;
+    CreateOutputImage();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RayTracingPass::DestroyRetired(U64 completedFrameNumber)
+{
+    std::erase_if(m_RetiredImages,
+                  [&](const RetiredImage& retired)
+                  {
+                      if (retired.RetireFrameNumber > completedFrameNumber)
+                      {
+                          return false;
+                      }
+
+                      vkDestroyImageView(m_Device, retired.ImageView, VK_NULL_HANDLE);
+                      vkDestroyImage(m_Device, retired.Image, VK_NULL_HANDLE);
+                      Util::FreeMemory(m_Device, retired.Memory);
+
+                      return true;
+                  });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RayTracingPass::RecordTrace(VkCommandBuffer commandBuffer, U32 frameIndex, VkAccelerationStructureKHR tlas,
+                                 const TraceConstants& constants) const
+{
+    // The previous commands of the frame finished before its index was reused, so its set can be rewritten
+    const VkWriteDescriptorSetAccelerationStructureKHR tlasWrite = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR,
+        .accelerationStructureCount = 1,
+        .pAccelerationStructures = &tlas
+    };
+    const VkDescriptorImageInfo imageInfo = { .imageView = m_OutputImageView, .imageLayout = VK_IMAGE_LAYOUT_GENERAL };
+    const std::array<VkWriteDescriptorSet, 2> descriptorWrites = {
+        VkWriteDescriptorSet{ .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                              .pNext = &tlasWrite,
+                              .dstSet = m_DescriptorSets[frameIndex],
+                              .dstBinding = 0,
+                              .descriptorCount = 1,
+                              .descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR },
+        VkWriteDescriptorSet{ .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                              .dstSet = m_DescriptorSets[frameIndex],
+                              .dstBinding = 1,
+                              .descriptorCount = 1,
+                              .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                              .pImageInfo = &imageInfo }
+    };
+    vkUpdateDescriptorSets(m_Device, static_cast<U32>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+    // The image is shared by all frames, the rays only have to wait for the blit of the previous frame to read it
+    RecordImageBarrier(commandBuffer, m_OutputImage, VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_NONE,
+                       VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                       VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_Pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_PipelineLayout, 0, 1,
+                            &m_DescriptorSets[frameIndex], 0, nullptr);
+    m_BindlessTable->Bind(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_PipelineLayout, BindlessSet);
+    vkCmdPushConstants(commandBuffer, m_PipelineLayout, s_PushConstantStages, 0, sizeof(TraceConstants), &constants);
+
+    m_CmdTraceRays(commandBuffer, &m_RayGenRegion, &m_MissRegion, &m_HitRegion, &m_CallableRegion, m_Extent.width,
+                   m_Extent.height, 1);
+
+    RecordImageBarrier(commandBuffer, m_OutputImage, VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR,
+                       VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+                       VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RayTracingPass::RecordBlit(VkCommandBuffer commandBuffer, VkImage targetImage, VkExtent2D targetExtent) const
+{
+    const VkImageSubresourceLayers subresource = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .layerCount = 1 };
+    const VkImageBlit2 region = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_BLIT_2,
+        .srcSubresource = subresource,
+        .srcOffsets = { { 0, 0, 0 },
+                        { static_cast<I32>(m_Extent.width), static_cast<I32>(m_Extent.height), 1 } },
+        .dstSubresource = subresource,
+        .dstOffsets = { { 0, 0, 0 },
+                        { static_cast<I32>(targetExtent.width), static_cast<I32>(targetExtent.height), 1 } }
+    };
+
+    const VkBlitImageInfo2 blitInfo = { .sType = VK_STRUCTURE_TYPE_BLIT_IMAGE_INFO_2,
+                                        .srcImage = m_OutputImage,
+                                        .srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                        .dstImage = targetImage,
+                                        .dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                        .regionCount = 1,
+                                        .pRegions = &region,
+                                        .filter = VK_FILTER_LINEAR };
+    vkCmdBlitImage2(commandBuffer, &blitInfo);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RayTracingPass::CreatePipeline(SharedPtr<PipelineCache> pipelineCache)
+{
+    const std::array<VkDescriptorSetLayoutBinding, 2> bindings = {
+        VkDescriptorSetLayoutBinding{ .binding = 0,
+                                      .descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR,
+                                      .descriptorCount = 1,
+                                      .stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR },
+        VkDescriptorSetLayoutBinding{ .binding = 1,
+                                      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                                      .descriptorCount = 1,
+                                      .stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR }
+    };
+
+    const VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = static_cast<U32>(bindings.size()),
+        .pBindings = bindings.data()
+    };
+    FFV_CHECK_VK_RESULT(
+        vkCreateDescriptorSetLayout(m_Device, &descriptorSetLayoutCreateInfo, VK_NULL_HANDLE, &m_DescriptorSetLayout));
+
+    const std::array<VkDescriptorSetLayout, 2> setLayouts = { m_DescriptorSetLayout,
+                                                              m_BindlessTable->GetDescriptorSetLayout() };
+    const VkPushConstantRange pushConstantRange = { .stageFlags = s_PushConstantStages,
+                                                    .offset = 0,
+                                                    .size = sizeof(TraceConstants) };
+
+    const VkPipelineLayoutCreateInfo layoutCreateInfo = { .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                                                          .setLayoutCount = static_cast<U32>(setLayouts.size()),
+                                                          .pSetLayouts = setLayouts.data(),
+                                                          .pushConstantRangeCount = 1,
+                                                          .pPushConstantRanges = &pushConstantRange };
+    FFV_CHECK_VK_RESULT(vkCreatePipelineLayout(m_Device, &layoutCreateInfo, VK_NULL_HANDLE, &m_PipelineLayout));
+
+    // In group order, every group uses the stage with its index
+    const std::array<SharedPtr<Shader>, s_GroupCount> shaders = { MakeShared<Shader>(m_Device, "raytrace.rgen.spv"),
+                                                                  MakeShared<Shader>(m_Device, "raytrace.rmiss.spv"),
+                                                                  MakeShared<Shader>(m_Device, "raytrace.rchit.spv") };
+
+    std::vector<VkPipelineShaderStageCreateInfo> stages;
+    std::vector<U64> shaderHashes;
+    for (const SharedPtr<Shader>& shader : shaders)
+    {
+        shaderHashes.push_back(shader->GetHash());
+        stages.push_back({ .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                           .stage = shader->GetShaderStage(),
+                           .module = shader->GetShaderModule(),
+                           .pName = "main" });
+    }
+
+    const std::array<VkRayTracingShaderGroupCreateInfoKHR, s_GroupCount> groups = {
+        VkRayTracingShaderGroupCreateInfoKHR{ .sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR,
+                                              .type = VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_KHR,
+                                              .generalShader = s_RayGenGroup,
+                                              .closestHitShader = VK_SHADER_UNUSED_KHR,
+                                              .anyHitShader = VK_SHADER_UNUSED_KHR,
+                                              .intersectionShader = VK_SHADER_UNUSED_KHR },
+        VkRayTracingShaderGroupCreateInfoKHR{ .sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR,
+                                              .type = VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_KHR,
+                                              .generalShader = s_MissGroup,
+                                              .closestHitShader = VK_SHADER_UNUSED_KHR,
+                                              .anyHitShader = VK_SHADER_UNUSED_KHR,
+                                              .intersectionShader = VK_SHADER_UNUSED_KHR },
+        VkRayTracingShaderGroupCreateInfoKHR{ .sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR,
+                                              .type = VK_RAY_TRACING_SHADER_GROUP_TYPE_TRIANGLES_HIT_GROUP_KHR,
+                                              .generalShader = VK_SHADER_UNUSED_KHR,
+                                              .closestHitShader = s_HitGroup,
+                                              .anyHitShader = VK_SHADER_UNUSED_KHR,
+                                              .intersectionShader = VK_SHADER_UNUSED_KHR }
+    };
+
+    // Shadow rays are traced by the ray generation shader, so hit shaders never trace
+    const VkRayTracingPipelineCreateInfoKHR pipelineCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR,
+        .stageCount = static_cast<U32>(stages.size()),
+        .pStages = stages.data(),
+        .groupCount = static_cast<U32>(groups.size()),
+        .pGroups = groups.data(),
+        .maxPipelineRayRecursionDepth = 1,
+        .layout = m_PipelineLayout
+    };
+
+    // Layouts that are created from identical descriptions are compatible, so cached pipelines can be shared
+    U64 layoutHash = Util::HashBytes(&pushConstantRange, sizeof(pushConstantRange));
+    Util::HashCombine(layoutHash, Util::HashDescriptorSetLayout(descriptorSetLayoutCreateInfo));
+    Util::HashCombine(layoutHash, m_BindlessTable->GetLayoutHash());
+
+    m_Pipeline = pipelineCache->GetOrCreateRayTracingPipeline(pipelineCreateInfo, shaderHashes, layoutHash);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RayTracingPass::CreateShaderBindingTable()
+{
+    VkPhysicalDeviceRayTracingPipelinePropertiesKHR rayTracingProperties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_PROPERTIES_KHR
+    };
+    VkPhysicalDeviceProperties2 properties = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+                                               .pNext = &rayTracingProperties };
+    vkGetPhysicalDeviceProperties2(m_PhysicalDevices->GetSelectedPhysicalDevice().PhysicalDevice, &properties);
+
+    const U32 handleSize = rayTracingProperties.shaderGroupHandleSize;
+    const VkDeviceSize handleStride = AlignUp(handleSize, rayTracingProperties.shaderGroupHandleAlignment);
+    const VkDeviceSize baseAlignment = rayTracingProperties.shaderGroupBaseAlignment;
+
+    std::vector<U8> handles(static_cast<size_t>(handleSize) * s_GroupCount);
+    FFV_CHECK_VK_RESULT(
+        m_GetShaderGroupHandles(m_Device, m_Pipeline, 0, s_GroupCount, handles.size(), handles.data()));
+
+    // Every region starts at the base alignment, the ray generation region has to be exactly one record
+    const VkDeviceSize regionSize = AlignUp(handleStride, baseAlignment);
+    const VkDeviceSize tableSize = regionSize * s_GroupCount;
+
+    // The address of the allocation may be less aligned than the regions need, so the table starts within the slack
+    Util::CreateBuffer(m_Device, m_PhysicalDevices, tableSize + baseAlignment,
+                       VK_BUFFER_USAGE_SHADER_BINDING_TABLE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_ShaderBindingTable,
+                       m_ShaderBindingTableMemory, MemoryCategory::RayTracing);
+
+    const VkDeviceAddress bufferAddress = Util::GetBufferAddress(m_Device, m_ShaderBindingTable);
+    const VkDeviceAddress tableAddress = AlignUp(bufferAddress, baseAlignment);
+
+    void* mapped;
+    FFV_CHECK_VK_RESULT(vkMapMemory(m_Device, m_ShaderBindingTableMemory, 0, VK_WHOLE_SIZE, 0, &mapped));
+    U8* table = static_cast<U8*>(mapped) + (tableAddress - bufferAddress);
+    for (U32 group = 0; group < s_GroupCount; group++)
+    {
+        memcpy(table + regionSize * group, handles.data() + static_cast<size_t>(handleSize) * group, handleSize);
+    }
+    vkUnmapMemory(m_Device, m_ShaderBindingTableMemory);
+
+    m_RayGenRegion = { .deviceAddress = tableAddress + regionSize * s_RayGenGroup,
+                       .stride = regionSize,
+                       .size = regionSize };
+    m_MissRegion = { .deviceAddress = tableAddress + regionSize * s_MissGroup,
+                     .stride = handleStride,
+                     .size = regionSize };
+    m_HitRegion = { .deviceAddress = tableAddress + regionSize * s_HitGroup, .stride = handleStride, .size = regionSize };
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RayTracingPass::CreateDescriptorSets(U32 numFrames)
+{
+    const std::array<VkDescriptorPoolSize, 2> poolSizes = {
+        VkDescriptorPoolSize{ .type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, .descriptorCount = numFrames },
+        VkDescriptorPoolSize{ .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, .descriptorCount = numFrames }
+    };
+
+    const VkDescriptorPoolCreateInfo poolCreateInfo = { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                                                        .maxSets = numFrames,
+                                                        .poolSizeCount = static_cast<U32>(poolSizes.size()),
+                                                        .pPoolSizes = poolSizes.data() };
+    FFV_CHECK_VK_RESULT(vkCreateDescriptorPool(m_Device, &poolCreateInfo, VK_NULL_HANDLE, &m_DescriptorPool));
+
+    // Written right before they're bound, the TLAS and the output image may change in between
+    const std::vector<VkDescriptorSetLayout> layouts(numFrames, m_DescriptorSetLayout);
+    const VkDescriptorSetAllocateInfo allocateInfo = { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                                                       .descriptorPool = m_DescriptorPool,
+                                                       .descriptorSetCount = numFrames,
+                                                       .pSetLayouts = layouts.data() };
+    m_DescriptorSets.resize(numFrames);
+    FFV_CHECK_VK_RESULT(vkAllocateDescriptorSets(m_Device, &allocateInfo, m_DescriptorSets.data()));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RayTracingPass::CreateOutputImage()
+{
+    Util::CreateImage(m_Device, m_PhysicalDevices, m_Extent, Format,
+                      VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                      m_OutputImage, m_OutputImageMemory, MemoryCategory::RenderTarget);
+    m_OutputImageView = Util::CreateImageView(m_Device, m_OutputImage, Format, VK_IMAGE_ASPECT_COLOR_BIT);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RayTracingPass::DestroyOutputImage()
+{
+    vkDestroyImageView(m_Device, m_OutputImageView, VK_NULL_HANDLE);
+    vkDestroyImage(m_Device, m_OutputImage, VK_NULL_HANDLE);
+    Util::FreeMemory(m_Device, m_OutputImageMemory);
+}
+} // namespace FFV
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "renderer/BindlessTable.h"
+#include "renderer/PhysicalDevice.h"
+#include "renderer/PipelineCache.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * Traces one primary ray per pixel with the ray tracing pipeline, needs VK_KHR_ray_tracing_pipeline. The hit shader
+ * returns the material color and normal, the ray generation shader adds a shadow ray towards the light.
+ * The rays write into a storage image bound by the pass itself, the bindless table has no storage images. It gets
+ * blitted onto the render target like the image of the CPU path tracer.
+ */
+class RayTracingPass
+{
+public:
+    static constexpr VkFormat Format = VK_FORMAT_R16G16B16A16_SFLOAT; // Declared in raytrace.slang as well
+    static constexpr U32 BindlessSet = 1;
+
+    /*
+     * Has to match the push constants in raytrace.slang.
+     */
+    struct TraceConstants
+    {
+        glm::mat4 inverseViewProjection;
+        U32 vertexBufferIndex;
+        U32 indexBufferIndex;
+        U32 meshBufferIndex;
+        U32 vertexStride; // In bytes
+        U32 materialIndexBufferIndex;
+        U32 materialBufferIndex;
+    };
+
+public:
+    RayTracingPass(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, SharedPtr<BindlessTable> bindlessTable,
+                   SharedPtr<PipelineCache> pipelineCache, VkExtent2D extent, U32 numFrames);
+    ~RayTracingPass();
+
+    FFV_DELETE_MOVE_COPY(RayTracingPass);
+
+    /*
+     * Whether the output image can be written by the rays and blitted onto images of the target format.
+     */
+    static bool IsSupported(const SharedPtr<PhysicalDevices>& physicalDevices, VkFormat targetFormat);
+
+    /*
+     * Creates an output image of the new size, the old one is destroyed once frames up to retireFrameNumber completed,
+     * see DestroyRetired.
+     * @param retireFrameNumber: the last frame that may still trace into or blit from the old image
+     */
+    void Resize(VkExtent2D extent, U64 retireFrameNumber);
+    /*
+     * Destroys the retired output images whose frames completed.
+     */
+    void DestroyRetired(U64 completedFrameNumber);
+    /*
+     * @param tlas: has to be built and readable by ray tracing shaders
+     */
+    void RecordTrace(VkCommandBuffer commandBuffer, U32 frameIndex, VkAccelerationStructureKHR tlas,
+                     const TraceConstants& constants) const;
+    /*
+     * Scales the traced image onto the whole target.
+     * @param targetImage: has to be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+     */
+    void RecordBlit(VkCommandBuffer commandBuffer, VkImage targetImage, VkExtent2D targetExtent) const;
+
+    const VkExtent2D& GetExtent() const { return m_Extent; }
+
+private:
+    void CreatePipeline(SharedPtr<PipelineCache> pipelineCache);
+    void CreateShaderBindingTable();
+    void CreateDescriptorSets(U32 numFrames);
+    void CreateOutputImage();
+    void DestroyOutputImage();
+
+private:
+    struct RetiredImage
+    {
+        VkImage Image = VK_NULL_HANDLE;
+        VkDeviceMemory Memory = VK_NULL_HANDLE;
+        VkImageView ImageView = VK_NULL_HANDLE;
+        U64 RetireFrameNumber = 0;
+    };
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    SharedPtr<PhysicalDevices> m_PhysicalDevices;
+    SharedPtr<BindlessTable> m_BindlessTable;
+    VkExtent2D m_Extent = { 0, 0 };
+
+    PFN_vkGetRayTracingShaderGroupHandlesKHR m_GetShaderGroupHandles = nullptr;
+    PFN_vkCmdTraceRaysKHR m_CmdTraceRays = nullptr;
+
+    // Owned by the pipeline cache
+    VkPipeline m_Pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_DescriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> m_DescriptorSets; // Per frame in flight, the TLAS differs between frames
+
+    // One ray generation, miss and hit group record each
+    VkBuffer m_ShaderBindingTable = VK_NULL_HANDLE;
+    VkDeviceMemory m_ShaderBindingTableMemory = VK_NULL_HANDLE;
+    VkStridedDeviceAddressRegionKHR m_RayGenRegion = {};
+    VkStridedDeviceAddressRegionKHR m_MissRegion = {};
+    VkStridedDeviceAddressRegionKHR m_HitRegion = {};
+    VkStridedDeviceAddressRegionKHR m_CallableRegion = {};
+
+    VkImage m_OutputImage = VK_NULL_HANDLE;
+    VkDeviceMemory m_OutputImageMemory = VK_NULL_HANDLE;
+    VkImageView m_OutputImageView = VK_NULL_HANDLE;
+    std::vector<RetiredImage> m_RetiredImages;
+};
+} // namespace FFV
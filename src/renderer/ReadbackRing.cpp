@@ -0,0 +1,107 @@
+#include "FastFileViewerPCH.h"
+
+#include "ReadbackRing.h"
+
+#include "util/Log.h"
+
+namespace FFV
+{
+ReadbackRing::ReadbackRing(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, U32 numSlots,
+                           VkExtent2D extent, U32 bytesPerPixel)
+    : m_Device(device), m_Extent(extent), m_Slots(numSlots)
+{
+    m_SlotSize = static_cast<U64>(m_Extent.width) * m_Extent.height * bytesPerPixel;
+
+    // Uncached memory is very slow to read on the CPU, so cached memory is used whenever the device has it
+    VkMemoryPropertyFlags propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    const VkPhysicalDeviceMemoryProperties& memoryProperties =
+        physicalDevices->GetSelectedPhysicalDevice().MemoryProperties;
+    for (U32 i = 0; i < memoryProperties.memoryTypeCount; i++)
+    {
+        const VkMemoryPropertyFlags cachedFlags = propertyFlags | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        if ((memoryProperties.memoryTypes[i].propertyFlags & cachedFlags) == cachedFlags)
+        {
+            propertyFlags = cachedFlags;
+            break;
+        }
+    }
+
+    for (Slot& slot : m_Slots)
+    {
+        Util::CreateBuffer(m_Device, physicalDevices, m_SlotSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, propertyFlags,
+                           slot.Buffer, slot.Memory, MemoryCategory::Readback);
+        FFV_CHECK_VK_RESULT(vkMapMemory(m_Device, slot.Memory, 0, m_SlotSize, 0, &slot.Mapped));
+    }
+
+    FFV_TRACE("Created readback ring with {0} slots of {1} bytes!", numSlots, m_SlotSize);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ReadbackRing::~ReadbackRing()
+{
+    for (const Slot& slot : m_Slots)
+    {
+        vkUnmapMemory(m_Device, slot.Memory);
+        vkDestroyBuffer(m_Device, slot.Buffer, VK_NULL_HANDLE);
+        Util::FreeMemory(m_Device, slot.Memory);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ReadbackRing::RecordCopy(VkCommandBuffer commandBuffer, U32 slot, VkImage image, U64 frameNumber)
+{
+    FFV_ASSERT(m_Slots[slot].PendingFrameNumber == 0, "Readback slot is still pending, collect it first!", ;);
+
+    const VkBufferImageCopy region = { .bufferOffset = 0,
+                                       .bufferRowLength = 0,
+                                       .bufferImageHeight = 0,
+                                       .imageSubresource = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                                             .mipLevel = 0,
+                                                             .baseArrayLayer = 0,
+                                                             .layerCount = 1 },
+                                       .imageExtent = { m_Extent.width, m_Extent.height, 1 } };
+    vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_Slots[slot].Buffer, 1, &region);
+
+    // Makes the copy visible to the host once the timeline value of the frame is reached
+    const VkMemoryBarrier2 hostBarrier = { .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                           .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                                           .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                           .dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+                                           .dstAccessMask = VK_ACCESS_2_HOST_READ_BIT };
+    const VkDependencyInfo dependencyInfo = { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                              .memoryBarrierCount = 1,
+                                              .pMemoryBarriers = &hostBarrier };
+    vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+    m_Slots[slot].PendingFrameNumber = frameNumber;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ReadbackRing::Collect(U64 completedFrameNumber, const ReadbackFn& readback)
+{
+    std::vector<Slot*> completedSlots;
+    for (Slot& slot : m_Slots)
+    {
+        if (slot.PendingFrameNumber != 0 && slot.PendingFrameNumber <= completedFrameNumber)
+        {
+            completedSlots.push_back(&slot);
+        }
+    }
+
+    std::sort(completedSlots.begin(), completedSlots.end(),
+              [](const Slot* a, const Slot* b) { return a->PendingFrameNumber < b->PendingFrameNumber; });
+
+    for (Slot* slot : completedSlots)
+    {
+        if (readback)
+        {
+            readback(slot->PendingFrameNumber, static_cast<const U8*>(slot->Mapped), m_Extent);
+        }
+
+        slot->PendingFrameNumber = 0;
+    }
+}
+} // namespace FFV
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "renderer/PhysicalDevice.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <functional>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * Copies rendered images into persistently mapped host buffers without stalling the GPU. Every frame in flight has its
+ * own slot, the CPU reads a slot once the frame timeline says the frame that filled it completed.
+ */
+class ReadbackRing
+{
+public:
+    /*
+     * @param pixels: tightly packed rows, only valid during the call
+     */
+    using ReadbackFn = std::function<void(U64 frameNumber, const U8* pixels, VkExtent2D extent)>;
+
+public:
+    ReadbackRing(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, U32 numSlots, VkExtent2D extent,
+                 U32 bytesPerPixel);
+    ~ReadbackRing();
+
+    FFV_DELETE_MOVE_COPY(ReadbackRing);
+
+    /*
+     * The slot must have been collected since its last copy.
+     * @param image: has to be in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+     * @param frameNumber: timeline value of the frame the copy is submitted with
+     */
+    void RecordCopy(VkCommandBuffer commandBuffer, U32 slot, VkImage image, U64 frameNumber);
+
+    /*
+     * Calls readback in frame order for every pending copy of a completed frame.
+     */
+    void Collect(U64 completedFrameNumber, const ReadbackFn& readback);
+
+    const VkExtent2D& GetExtent() const { return m_Extent; }
+    U64 GetSlotSize() const { return m_SlotSize; }
+
+private:
+    struct Slot
+    {
+        VkBuffer Buffer = VK_NULL_HANDLE;
+        VkDeviceMemory Memory = VK_NULL_HANDLE;
+        void* Mapped = nullptr;
+        U64 PendingFrameNumber = 0; // 0 when nothing is pending
+    };
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    VkExtent2D m_Extent = { 0, 0 };
+    U64 m_SlotSize = 0;
+
+    std::vector<Slot> m_Slots;
+};
+} // namespace FFV
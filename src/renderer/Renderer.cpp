@@ -3,63 +3,192 @@
 #include "Renderer.h"
 
 #include "GLFW/glfw3.h"
+#include "import/MeshDeduplicator.h"
+#include "scene/MeshGenerator.h"
 #include "renderer/Shader.h"
+#include "util/JobSystem.h"
 #include "util/Log.h"
+#include "util/MemoryTracker.h"
+#include "util/Profiler.h"
 #include "util/Types.h"
 #include "util/Util.h"
 #include "vulkan/vulkan_core.h"
 
 #include <chrono>
+#include <glm/gtc/matrix_transform.hpp>
 #include <vector>
 
 namespace FFV
 {
-Renderer::Renderer(SharedPtr<Window> window) : m_Window(window)
+static constexpr U32 s_DrawsPerCommandBuffer = 256;
+// 24 MB of vertices and 16 MB of indices
+static constexpr U32 s_GeometryPoolVertexCapacity = 1 << 20;
+static constexpr U32 s_GeometryPoolIndexCapacity = 1 << 22;
+// Room for thousands of per draw constants on top of the camera
+static constexpr U32 s_TransientBytesPerFrame = 1 << 20;
+// Imported models carry no materials, their parts cycle through the default materials
+static constexpr U32 s_DefaultMaterialCount = 2;
+#if defined(FFV_ENABLE_RAY_TRACING)
+static constexpr bool s_RayTracingEnabled = true;
+#else
+// The ray tracing shaders and passes haven't run under the validation layers on a device yet, builds have to opt in
+static constexpr bool s_RayTracingEnabled = false;
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Renderer::Renderer(SharedPtr<Window> window, PresentPolicy presentPolicy, F64 targetFps) : m_Window(window)
+{
+    Init(presentPolicy, targetFps);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Renderer::Renderer(VkExtent2D extent, U32 framesInFlight) : m_OffscreenExtent(extent), m_FramesInFlight(framesInFlight)
+{
+    Init(PresentPolicy::VSync, 0.0);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::Init(PresentPolicy presentPolicy, F64 targetFps)
 {
     CreateInstance();
 #if defined(FFV_DEBUG)
     CreateDebugCallback();
 #endif
-    CreateSurface(m_Window->GetNativeWindow());
+    if (!IsHeadless())
+    {
+        CreateSurface(m_Window->GetNativeWindow());
+    }
 
     m_PhysicalDevices = MakeShared<PhysicalDevices>(m_Instance, m_Surface);
-    m_QueueFamily = m_PhysicalDevices->SelectDevice(VK_QUEUE_GRAPHICS_BIT, true);
+    m_QueueFamily = m_PhysicalDevices->SelectDevice(VK_QUEUE_GRAPHICS_BIT, !IsHeadless());
 
     CreateDevice();
-    m_Swapchain = MakeShared<Swapchain>(m_Device, m_PhysicalDevices, m_Window, m_Surface, m_QueueFamily);
-    m_Queue = MakeShared<Queue>(m_Device, m_Swapchain, m_QueueFamily, 0);
+    if (IsHeadless())
+    {
+        m_Queue = MakeShared<Queue>(m_Device, nullptr, m_QueueFamily, 0, m_FramesInFlight);
+        m_OffscreenTarget =
+            MakeShared<OffscreenTarget>(m_Device, m_PhysicalDevices, m_OffscreenExtent, m_Queue->GetFramesInFlight());
+        m_ReadbackRing = MakeShared<ReadbackRing>(m_Device, m_PhysicalDevices, m_Queue->GetFramesInFlight(),
+                                                  m_OffscreenExtent, 4);
+    }
+    else
+    {
+        m_Swapchain =
+            MakeShared<Swapchain>(m_Device, m_PhysicalDevices, m_Window, m_Surface, m_QueueFamily, presentPolicy);
+        m_Queue = MakeShared<Queue>(m_Device, m_Swapchain, m_QueueFamily, 0, m_FramesInFlight);
+    }
 
-    std::vector<SharedPtr<Shader>> shaders = { MakeShared<Shader>(m_Device, "default.vert.spv"),
-                                               MakeShared<Shader>(m_Device, "default.frag.spv") };
-    m_GraphicsPipeline = MakeShared<GraphicsPipeline>(m_Device, m_Swapchain, m_PhysicalDevices, m_Window, shaders);
+    if (m_PresentWaitSupported)
+    {
+        m_Queue->EnablePresentWait();
+    }
+
+    m_GpuProfiler = MakeShared<GpuProfiler>(m_Device, m_PhysicalDevices, m_QueueFamily, m_Queue->GetFramesInFlight());
+    m_FramePacer = MakeShared<FramePacer>(m_Queue);
+    m_FramePacer->SetTargetFps(targetFps);
+    m_FramePacer->SetLatencyOptimized(presentPolicy == PresentPolicy::LatencyOptimized);
+    m_BindlessTable = MakeShared<BindlessTable>(m_Device, m_PhysicalDevices);
+    m_PipelineCache = MakeShared<PipelineCache>(m_Device, m_PhysicalDevices,
+                                                (std::filesystem::current_path() / "bin" / "PipelineCache.bin").string());
+
+    m_TransientAllocator = MakeShared<TransientAllocator>(m_Device, m_PhysicalDevices, m_Queue->GetFramesInFlight(),
+                                                          s_TransientBytesPerFrame);
+
+    m_DepthTarget = MakeShared<DepthTarget>(m_Device, m_PhysicalDevices, m_BindlessTable, GetTargetExtent(),
+                                            m_Queue->GetFramesInFlight());
+    m_HiZPyramid = MakeShared<HiZPyramid>(m_Device, m_PhysicalDevices, m_BindlessTable, m_PipelineCache,
+                                          m_DepthTarget->GetExtent());
+
+    const SharedPtr<Shader> vertexShader = MakeShared<Shader>(m_Device, "default.vert.spv");
+    const SharedPtr<Shader> fragmentShader = MakeShared<Shader>(m_Device, "default.frag.spv");
+    const auto createGraphicsPipeline = [&](GraphicsPipeline::DepthMode depthMode,
+                                            const std::vector<SharedPtr<Shader>>& shaders)
+    {
+        return MakeShared<GraphicsPipeline>(m_Device, m_Queue->GetFramesInFlight(), GetTargetFormat(),
+                                            m_DepthTarget->GetFormat(), depthMode, m_PhysicalDevices, m_BindlessTable,
+                                            m_PipelineCache, m_TransientAllocator, shaders);
+    };
+    m_GraphicsPipeline =
+        createGraphicsPipeline(GraphicsPipeline::DepthMode::TestAndWrite, { vertexShader, fragmentShader });
+    m_DepthPrePassPipeline = createGraphicsPipeline(GraphicsPipeline::DepthMode::PrePass, { vertexShader });
+    m_ShadeVisiblePipeline =
+        createGraphicsPipeline(GraphicsPipeline::DepthMode::ShadeVisible, { vertexShader, fragmentShader });
 
     CreateCommandBufferPool();
+    m_Uploader = MakeShared<Uploader>(m_Device, m_PhysicalDevices, m_Queue, m_CommandBufferPool);
+    m_GeometryPool = MakeShared<GeometryPool>(m_Device, m_PhysicalDevices, m_Uploader,
+                                              static_cast<U32>(sizeof(Model::Vertex)), s_GeometryPoolVertexCapacity,
+                                              s_GeometryPoolIndexCapacity,
+                                              m_RayTracingSupported ? AccelerationStructures::RequiredGeometryUsage : 0);
+    CreateMaterialBuffer({ { .baseColor = { 0.9f, 0.6f, 0.2f, 1.0f } }, { .baseColor = { 0.3f, 0.5f, 0.9f, 1.0f } } });
+    FFV_ASSERT(m_MaterialColors.size() == s_DefaultMaterialCount,
+               "The material buffer has to hold every default material!", ;);
+
+    m_CullingPass = MakeShared<CullingPass>(m_Device, m_Queue->GetFramesInFlight(), m_PhysicalDevices, m_Uploader,
+                                            m_BindlessTable, m_PipelineCache);
+    if (m_RayTracingSupported)
+    {
+        m_AccelerationStructures = MakeShared<AccelerationStructures>(
+            m_Device, m_PhysicalDevices, m_Queue, m_CommandBufferPool, m_BindlessTable, m_Queue->GetFramesInFlight());
+    }
+    m_PipelineCache->LogCreationTime();
 
-    m_Model = MakeShared<Model>(m_Vertices, m_Indices, m_Device, m_PhysicalDevices, m_Queue, m_CommandBufferPool);
+    CreateDefaultScene();
 
-    CreateCommandBuffers(m_Swapchain->GetNumImagesInFlight());
+    m_CommandRecorder = MakeShared<CommandRecorder>(m_Device, m_QueueFamily, m_Queue->GetFramesInFlight());
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 Renderer::~Renderer()
 {
+    // Retired resources and the staging buffers of the uploader are only destroyed once the GPU is done with them
+    WaitIdle();
+
+    m_FramePacer.reset();
     m_Queue.reset();
 
-    vkFreeCommandBuffers(m_Device, m_CommandBufferPool, static_cast<U32>(m_CommandBuffers.size()), m_CommandBuffers.data());
+    m_CommandRecorder.reset();
+    m_GpuProfiler.reset();
     vkDestroyCommandPool(m_Device, m_CommandBufferPool, VK_NULL_HANDLE);
 
     m_Model.reset();
+    m_RayTracingPass.reset();
+    m_AccelerationStructures.reset();
+    m_GeometryPool.reset();
+    m_CullingPass.reset();
+    m_Uploader.reset();
+
+    m_BindlessTable->Release(BindlessTable::ResourceType::StorageBuffer, m_MaterialBufferIndex);
+    vkDestroyBuffer(m_Device, m_MaterialBuffer, VK_NULL_HANDLE);
+    Util::FreeMemory(m_Device, m_MaterialBufferMemory);
 
     m_GraphicsPipeline.reset();
+    m_DepthPrePassPipeline.reset();
+    m_ShadeVisiblePipeline.reset();
+    m_TransientAllocator.reset();
+    m_RetiredResources.clear();
+    m_HiZPyramid.reset();
+    m_DepthTarget.reset();
+    m_PipelineCache.reset();
+    m_BindlessTable.reset();
+    m_ReadbackRing.reset();
+    m_PathTracerImage.reset();
+    m_OffscreenTarget.reset();
     m_Swapchain.reset();
 
     vkDestroyDevice(m_Device, VK_NULL_HANDLE);
 
-    const PFN_vkDestroySurfaceKHR vkDestroySurface =
-        reinterpret_cast<PFN_vkDestroySurfaceKHR>(vkGetInstanceProcAddr(m_Instance, "vkDestroySurfaceKHR"));
-    FFV_ASSERT(vkDestroySurface, "Cannot find address of vkDestroySurface", ;);
-    vkDestroySurface(m_Instance, m_Surface, VK_NULL_HANDLE);
+    if (m_Surface != VK_NULL_HANDLE)
+    {
+        const PFN_vkDestroySurfaceKHR vkDestroySurface =
+            reinterpret_cast<PFN_vkDestroySurfaceKHR>(vkGetInstanceProcAddr(m_Instance, "vkDestroySurfaceKHR"));
+        FFV_ASSERT(vkDestroySurface, "Cannot find address of vkDestroySurface", ;);
+        vkDestroySurface(m_Instance, m_Surface, VK_NULL_HANDLE);
+    }
 
 #if defined(FFV_DEBUG)
     const PFN_vkDestroyDebugUtilsMessengerEXT vkDestroyDebugUtilsMessenger =
@@ -76,28 +205,232 @@ Renderer::~Renderer()
 
 void Renderer::Update()
 {
+    FFV_PROFILE_FUNCTION();
+
     static U32 frameCount = 0;
-    static F64 lastTime = glfwGetTime();
+    static auto lastTime = std::chrono::steady_clock::now();
     static F64 fps = 0.0;
+    static FramePacer::LatencyStats latency;
+    static std::string memorySummary = MemoryTracker::FormatSummary();
+
+    const U32 imageIndex = m_Queue->AquireNextImage();
+    const U32 frameIndex = m_Queue->GetFrameIndex();
+    const auto cpuStartTime = std::chrono::steady_clock::now();
+    DestroyRetired(m_Queue->GetCompletedFrameNumber());
 
-    U32 imageIndex = m_Queue->AquireNextImage();
+    // The readback slot of this frame is reused below, the frame that filled it is done after the acquire
+    if (m_ReadbackRing)
+    {
+        m_ReadbackRing->Collect(m_Queue->GetCompletedFrameNumber(), m_ReadbackCallback);
+    }
+    m_CaptureFrame = IsHeadless() ? static_cast<bool>(m_ReadbackCallback) : PrepareCapture();
+    m_ProfileFrame = true;
+    m_RecordUploads = true;
+
+    // The acquire recreates the swapchain after a resize, frames in flight still test against the old depth images
+    const VkExtent2D targetExtent = GetTargetExtent();
+    if (m_DepthTarget->GetExtent().width != targetExtent.width ||
+        m_DepthTarget->GetExtent().height != targetExtent.height)
+    {
+        Retire(std::move(m_HiZPyramid));
+        Retire(std::move(m_DepthTarget));
+        m_DepthTarget = MakeShared<DepthTarget>(m_Device, m_PhysicalDevices, m_BindlessTable, targetExtent,
+                                                m_Queue->GetFramesInFlight());
+        m_HiZPyramid =
+            MakeShared<HiZPyramid>(m_Device, m_PhysicalDevices, m_BindlessTable, m_PipelineCache, targetExtent);
+    }
 
-    RecordCommandBuffer(imageIndex);
-    m_GraphicsPipeline->UpdateUniformBuffer(imageIndex);
-    m_Queue->SubmitAsync(m_CommandBuffers[imageIndex], imageIndex);
-    m_Queue->Present(imageIndex);
+    UpdateCamera();
+
+    if (m_RenderMode == RenderMode::CpuPathTraced)
+    {
+        RenderPathTraced(frameIndex);
+    }
+    else if (m_RenderMode == RenderMode::RayTraced)
+    {
+        PrepareRayTracing();
+    }
+
+    const VkCommandBuffer commandBuffer = m_CommandRecorder->BeginFrame(frameIndex);
+    m_TransientAllocator->BeginFrame(frameIndex);
+    m_CameraOffset = m_TransientAllocator->Push(frameIndex, m_Camera);
+    FFV_ASSERT(m_CameraOffset != TransientAllocator::InvalidOffset,
+               "The transient allocator has no room for the camera, the frame only gets cleared!", ;);
+
+    RecordCommandBuffer(commandBuffer, imageIndex, frameIndex, m_DrawPath,
+                        static_cast<U32>(m_CullingPass->GetBatches().size()));
+    {
+        FFV_PROFILE_SCOPE("SubmitAndPresent");
+        m_Queue->SubmitAsync(commandBuffer, imageIndex);
+        m_Queue->Present(imageIndex);
+    }
+    m_FramePacer->EndFrame();
+    m_LastCpuMs = std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - cpuStartTime).count();
+
+    if (IsHeadless())
+    {
+        return;
+    }
 
     // FPS calculation
     frameCount++;
-    F64 currentTime = glfwGetTime();
-    if (currentTime - lastTime >= 1.0)
+    const auto currentTime = std::chrono::steady_clock::now();
+    const F64 elapsedTime = std::chrono::duration<F64>(currentTime - lastTime).count();
+    if (elapsedTime >= 1.0)
     {
-        fps = frameCount / (currentTime - lastTime);
+        fps = frameCount / elapsedTime;
         frameCount = 0;
         lastTime = currentTime;
+        latency = m_FramePacer->TakeLatencyStats();
+
+        // Queried once per second, the budget query and the resident size aren't free
+        memorySummary = MemoryTracker::FormatSummary();
+
+        if (m_LogGpuProfile)
+        {
+            FFV_LOG("{0}", m_GpuProfiler->FormatStats());
+        }
+        if (m_LogMemory)
+        {
+            FFV_LOG("{0}", MemoryTracker::FormatReport());
+        }
+        if (m_LogCullStats)
+        {
+            FFV_LOG("{0}", m_CullingPass->FormatStats());
+        }
+    }
+
+    const std::string pathTracerSummary =
+        m_RenderMode == RenderMode::CpuPathTraced
+            ? std::format(" - CPU: {:.1f} Mrays/s, {} spp", m_PathTracer.GetStats().MraysPerSecond,
+                          m_PathTracer.GetStats().SampleCount)
+            : "";
+    glfwSetWindowTitle(
+        m_Window->GetNativeWindow(),
+        std::format("Fast File Viewer - FPS: {:.1f} - GPU: {:.2f} ms - Latency: {:.1f} ms (max {:.1f} ms){} - {}", fps,
+                    m_GpuProfiler->GetAverageMs("Frame"), latency.AverageMs, latency.MaxMs, pathTracerSummary,
+                    memorySummary)
+            .c_str());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::FinishReadbacks()
+{
+    WaitIdle();
+
+    if (m_ReadbackRing)
+    {
+        m_ReadbackRing->Collect(m_Queue->GetCompletedFrameNumber(), m_ReadbackCallback);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::SetRenderMode(RenderMode renderMode)
+{
+    if (renderMode == RenderMode::CpuPathTraced && !StreamingImage::IsBlitSupported(m_PhysicalDevices, GetTargetFormat()))
+    {
+        FFV_WARN("{0} can't be blitted to, the CPU path tracer is disabled!", string_VkFormat(GetTargetFormat()));
+        return;
+    }
+    if (renderMode == RenderMode::RayTraced &&
+        (!m_RayTracingSupported || !RayTracingPass::IsSupported(m_PhysicalDevices, GetTargetFormat())))
+    {
+        FFV_WARN("The selected device can't ray trace onto {0}, hardware ray tracing is disabled!",
+                 string_VkFormat(GetTargetFormat()));
+        return;
+    }
+    if (renderMode == RenderMode::CpuPathTraced && m_Model && m_SceneMeshes.empty())
+    {
+        FFV_WARN("The scene was loaded without keeping its meshes, the CPU path tracer is disabled until the next load!");
+        return;
+    }
+
+    m_RenderMode = renderMode;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Renderer::PrepareCapture()
+{
+    if (!m_CaptureNextFrame && !m_ContinuousCapture)
+    {
+        return false;
+    }
+    m_CaptureNextFrame = false;
+
+    if (!m_Swapchain->IsTransferSrcSupported())
+    {
+        FFV_WARN("The swapchain images can't be copied, capturing is disabled!");
+        m_ContinuousCapture = false;
+        return false;
+    }
+
+    // Only happens when the window got resized while capturing, the pending copies have the old size
+    const VkExtent2D extent = m_Swapchain->GetExtent();
+    if (!m_ReadbackRing || m_ReadbackRing->GetExtent().width != extent.width ||
+        m_ReadbackRing->GetExtent().height != extent.height)
+    {
+        if (m_ReadbackRing)
+        {
+            FinishReadbacks();
+        }
+
+        m_ReadbackRing =
+            MakeShared<ReadbackRing>(m_Device, m_PhysicalDevices, m_Queue->GetFramesInFlight(), extent, 4);
     }
 
-    glfwSetWindowTitle(m_Window->GetNativeWindow(), std::format("Fast File Viewer - FPS: {:.1f}", fps).c_str());
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::RunRecordingBenchmark()
+{
+    constexpr std::array<U32, 3> drawCounts = { 1'000, 10'000, 100'000 };
+    constexpr U32 iterations = 20;
+
+    WaitIdle();
+
+    // The recorded command buffers are never submitted, so they must not leave copies pending in the readback ring,
+    // timestamps in the profiler or take the pending uploads
+    m_CaptureFrame = false;
+    m_ProfileFrame = false;
+    m_RecordUploads = false;
+
+    FFV_LOG("Command recording benchmark ({0} iterations per run, up to {1} threads):", iterations,
+            JobSystem::GetNumThreads());
+
+    for (const U32 drawCount : drawCounts)
+    {
+        F64 singleThreadMs = 0.0;
+
+        for (U32 threads = 1; threads <= JobSystem::GetNumThreads(); threads *= 2)
+        {
+            F64 totalMs = 0.0;
+
+            for (U32 i = 0; i < iterations; i++)
+            {
+                const auto startTime = std::chrono::high_resolution_clock::now();
+
+                const VkCommandBuffer commandBuffer = m_CommandRecorder->BeginFrame(0);
+                RecordCommandBuffer(commandBuffer, 0, 0, DrawPath::CpuRecorded, drawCount, threads);
+
+                totalMs += std::chrono::duration<F64, std::milli>(std::chrono::high_resolution_clock::now() - startTime)
+                               .count();
+            }
+
+            const F64 averageMs = totalMs / iterations;
+            if (threads == 1)
+            {
+                singleThreadMs = averageMs;
+            }
+
+            FFV_LOG("    {0:>7} draws, {1:>2} threads: {2:8.3f} ms ({3:6.2f} Mdraws/s, {4:4.2f}x)", drawCount, threads,
+                    averageMs, drawCount / averageMs / 1000.0, singleThreadMs / averageMs);
+        }
+    }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -110,16 +443,21 @@ void Renderer::CreateInstance()
 #endif
     };
 
-    const std::vector<const char*> extensions = { VK_KHR_SURFACE_EXTENSION_NAME,
-#if defined(FFV_LINUX)
-                                                  "VK_KHR_xcb_surface",
-#elif defined(FFV_WINDOWS)
-                                                  "VK_KHR_win32_surface",
-#endif
+    std::vector<const char*> extensions = {
 #if defined(FFV_DEBUG)
-                                                  VK_EXT_DEBUG_UTILS_EXTENSION_NAME, VK_EXT_DEBUG_REPORT_EXTENSION_NAME
+        VK_EXT_DEBUG_UTILS_EXTENSION_NAME, VK_EXT_DEBUG_REPORT_EXTENSION_NAME
 #endif
     };
+    if (!IsHeadless())
+    {
+        extensions.insert(extensions.end(), { VK_KHR_SURFACE_EXTENSION_NAME,
+#if defined(FFV_LINUX)
+                                              "VK_KHR_xcb_surface"
+#elif defined(FFV_WINDOWS)
+                                              "VK_KHR_win32_surface"
+#endif
+                                            });
+    }
 
     const VkApplicationInfo appInfo = { .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
                                         .pApplicationName = "Fast File Viewer",
@@ -239,20 +577,125 @@ void Renderer::CreateDevice()
                                                       .queueCount = 1,
                                                       .pQueuePriorities = &queuePriorities[0] };
 
-    const std::vector<const char*> extensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-                                                  VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME,
-                                                  VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME };
+    std::vector<const char*> extensions = { VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME,
+                                            VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME };
+    if (!IsHeadless())
+    {
+        extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
+
+    const VkPhysicalDevice physicalDevice = m_PhysicalDevices->GetSelectedPhysicalDevice().PhysicalDevice;
 
-    VkPhysicalDeviceVulkan13Features vk13Features = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+    U32 numExtensions = 0;
+    FFV_CHECK_VK_RESULT(vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &numExtensions, VK_NULL_HANDLE));
+    std::vector<VkExtensionProperties> availableExtensions(numExtensions);
+    FFV_CHECK_VK_RESULT(
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &numExtensions, availableExtensions.data()));
+
+    const auto isExtensionAvailable = [&](const char* name)
+    {
+        return std::any_of(availableExtensions.begin(), availableExtensions.end(),
+                           [&](const VkExtensionProperties& extension)
+                           { return strcmp(extension.extensionName, name) == 0; });
+    };
+
+    // Optional, the frame pacer falls back to waiting for the GPU to finish a frame
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR
+    };
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = { .sType =
+                                                                   VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+                                                               .pNext = &presentWaitFeatures };
+    const bool presentWaitAvailable = !IsHeadless() && isExtensionAvailable(VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+                                      isExtensionAvailable(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+
+    VkPhysicalDeviceVulkan13Features vk13Features = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+                                                      .pNext = presentWaitAvailable ? &presentIdFeatures : nullptr };
     VkPhysicalDeviceVulkan12Features vk12Features = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
                                                       .pNext = &vk13Features };
     VkPhysicalDeviceVulkan11Features vk11Features = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES,
                                                       .pNext = &vk12Features };
 
-    VkPhysicalDeviceFeatures2 deviceFeatures = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
-                                                 .pNext = &vk11Features };
+    // Optional, without it RenderMode::RayTraced is unavailable
+    VkPhysicalDeviceRayTracingPipelineFeaturesKHR rayTracingPipelineFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR,
+        .pNext = &vk11Features
+    };
+    VkPhysicalDeviceAccelerationStructureFeaturesKHR accelerationStructureFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR,
+        .pNext = &rayTracingPipelineFeatures
+    };
+    const bool rayTracingAvailable = isExtensionAvailable(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME) &&
+                                     isExtensionAvailable(VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME) &&
+                                     isExtensionAvailable(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME);
+
+    VkPhysicalDeviceFeatures2 deviceFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = rayTracingAvailable ? static_cast<void*>(&accelerationStructureFeatures) : &vk11Features
+    };
+
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &deviceFeatures);
 
-    vkGetPhysicalDeviceFeatures2(m_PhysicalDevices->GetSelectedPhysicalDevice().PhysicalDevice, &deviceFeatures);
+    FFV_ASSERT(vk12Features.descriptorIndexing && vk12Features.runtimeDescriptorArray &&
+                   vk12Features.descriptorBindingPartiallyBound && vk12Features.descriptorBindingUpdateUnusedWhilePending &&
+                   vk12Features.descriptorBindingStorageBufferUpdateAfterBind &&
+                   vk12Features.descriptorBindingSampledImageUpdateAfterBind &&
+                   vk12Features.shaderStorageBufferArrayNonUniformIndexing &&
+                   vk12Features.shaderSampledImageArrayNonUniformIndexing,
+               "The selected device doesn't support descriptor indexing which is required for bindless resources!",
+               exit(1));
+    FFV_ASSERT(vk12Features.timelineSemaphore && vk13Features.synchronization2,
+               "The selected device doesn't support timeline semaphores which are required for frame pacing!", exit(1));
+
+    if (!deviceFeatures.features.multiDrawIndirect || !deviceFeatures.features.drawIndirectFirstInstance)
+    {
+        FFV_WARN("The selected device doesn't support multi draw indirect, falling back to CPU recorded draws!");
+        m_DrawPath = DrawPath::CpuRecorded;
+    }
+
+    m_PresentWaitSupported = presentWaitAvailable && presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+    if (m_PresentWaitSupported)
+    {
+        extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    }
+    else
+    {
+        // Unsupported features must not be requested
+        vk13Features.pNext = nullptr;
+        FFV_WARN("The selected device doesn't support present wait, latency is measured until the GPU finished a frame!");
+    }
+
+    // The BLASes are built from buffer device addresses
+    const bool rayTracingFeaturesSupported = rayTracingAvailable && accelerationStructureFeatures.accelerationStructure &&
+                                             rayTracingPipelineFeatures.rayTracingPipeline &&
+                                             vk12Features.bufferDeviceAddress;
+    m_RayTracingSupported = s_RayTracingEnabled && rayTracingFeaturesSupported;
+    if (m_RayTracingSupported)
+    {
+        extensions.push_back(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME);
+    }
+    else
+    {
+        deviceFeatures.pNext = &vk11Features;
+        if (rayTracingFeaturesSupported)
+        {
+            FFV_WARN("Hardware ray tracing isn't validated yet, it's only enabled by the ray-tracing premake option!");
+        }
+        else
+        {
+            FFV_WARN("The selected device doesn't support hardware ray tracing, only the CPU path tracer is available!");
+        }
+    }
+
+    // Optional, without it the memory tracker estimates the budget from the heap sizes
+    const bool memoryBudgetSupported = isExtensionAvailable(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (memoryBudgetSupported)
+    {
+        extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
 
     const VkDeviceCreateInfo deviceCreateInfo = { .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
                                                   .pNext = &deviceFeatures,
@@ -261,8 +704,8 @@ void Renderer::CreateDevice()
                                                   .enabledExtensionCount = static_cast<U32>(extensions.size()),
                                                   .ppEnabledExtensionNames = extensions.data() };
 
-    FFV_CHECK_VK_RESULT(vkCreateDevice(m_PhysicalDevices->GetSelectedPhysicalDevice().PhysicalDevice, &deviceCreateInfo,
-                                       VK_NULL_HANDLE, &m_Device));
+    FFV_CHECK_VK_RESULT(vkCreateDevice(physicalDevice, &deviceCreateInfo, VK_NULL_HANDLE, &m_Device));
+    MemoryTracker::Init(physicalDevice, memoryBudgetSupported);
 
     FFV_TRACE("Created vulkan device!");
 }
@@ -281,82 +724,641 @@ void Renderer::CreateCommandBufferPool()
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Renderer::CreateCommandBuffers(U32 count)
+void Renderer::CreateMaterialBuffer(const std::vector<GraphicsPipeline::MaterialData>& materials)
+{
+    const VkDeviceSize bufferSize = sizeof(materials[0]) * materials.size();
+
+    Util::CreateBuffer(m_Device, m_PhysicalDevices, bufferSize,
+                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_MaterialBuffer, m_MaterialBufferMemory,
+                       MemoryCategory::Storage);
+
+    m_Uploader->Upload(m_MaterialBuffer, 0, materials.data(), bufferSize);
+
+    m_MaterialBufferIndex = m_BindlessTable->RegisterStorageBuffer(m_MaterialBuffer);
+
+    m_MaterialColors.clear();
+    for (const GraphicsPipeline::MaterialData& material : materials)
+    {
+        m_MaterialColors.push_back(glm::vec3(material.baseColor));
+    }
+
+    FFV_TRACE("Created material buffer with {0} materials!", materials.size());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::CreateDefaultScene()
 {
-    const VkCommandBufferAllocateInfo commandBufferAllocateInfo = { .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-                                                                    .commandPool = m_CommandBufferPool,
-                                                                    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-                                                                    .commandBufferCount = count };
+    const MeshData cube = MeshGenerator::CreateCube();
+    const MeshData quad = MeshGenerator::CreateQuad();
 
-    m_CommandBuffers.resize(count);
+    constexpr U32 gridSize = 64;
+    constexpr float spacing = 0.1f;
+
+    std::vector<MeshData> flattenedMeshes;
+    flattenedMeshes.reserve(gridSize * gridSize);
+    for (U32 y = 0; y < gridSize; y++)
+    {
+        for (U32 x = 0; x < gridSize; x++)
+        {
+            const glm::vec3 position =
+                glm::vec3(static_cast<float>(x) - (gridSize - 1) * 0.5f, static_cast<float>(y) - (gridSize - 1) * 0.5f,
+                          0.0f) *
+                spacing;
+            const float angle = glm::radians(static_cast<float>((x * 37 + y * 11) % 360));
+
+            glm::mat4 transform = glm::translate(glm::mat4(1.0f), position);
+            transform = glm::rotate(transform, angle, glm::normalize(glm::vec3(1.0f, 2.0f, 3.0f)));
+            transform = glm::scale(transform, glm::vec3(spacing * 0.5f));
+
+            flattenedMeshes.push_back(MeshGenerator::Transform((x + y) % 2 == 0 ? cube : quad, transform));
+        }
+    }
 
-    FFV_CHECK_VK_RESULT(vkAllocateCommandBuffers(m_Device, &commandBufferAllocateInfo, m_CommandBuffers.data()));
-    FFV_TRACE("Created {0} command buffers!", count);
+    LoadScene(flattenedMeshes);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Renderer::RecordCommandBuffer(U32 imageIndex)
+bool Renderer::LoadScene(const std::vector<MeshData>& meshes)
 {
-    FFV_ASSERT(imageIndex < m_CommandBuffers.size(),
-               std::format("Image index {} is out of bounds! Command buffers size: {}", imageIndex, m_CommandBuffers.size()),
-               ;);
+    FFV_PROFILE_FUNCTION();
 
-    const VkExtent2D swapchainExtent = m_Swapchain->GetExtent();
+    if (meshes.empty())
+    {
+        return LoadScene({}, {});
+    }
+
+    const MeshDeduplicator::Result deduplicated = MeshDeduplicator::Deduplicate(meshes);
+    return LoadScene(deduplicated.Meshes, deduplicated.Instances);
+}
 
-    const VkCommandBufferBeginInfo beginInfo = { .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-    FFV_CHECK_VK_RESULT(vkBeginCommandBuffer(m_CommandBuffers[imageIndex], &beginInfo));
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    CreateImageBarrier(imageIndex, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_2_NONE,
-                       VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
-                       VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+bool Renderer::LoadScene(const std::vector<MeshData>& meshes, const std::vector<MeshDeduplicator::Instance>& instances)
+{
+    // Frames in flight may still read the geometry and the culling buffers of the previous scene, so they're retired
+    // and the new scene is uploaded next to them
+    Retire(std::move(m_Model));
+    m_Scene.Clear();
+    m_SceneMeshes.clear();
+    m_SceneVertexCounts.clear();
+    m_PathTracer.Clear();
+    m_PathTracerOutdated = true;
+    MemoryTracker::SetCpuBytes(CpuMemoryCategory::PathTracer, m_PathTracer.GetMemoryUsage());
+    if (m_AccelerationStructures)
+    {
+        // Only built while ray tracing, frames in flight may still trace them
+        if (!m_AccelerationStructuresOutdated)
+        {
+            m_Queue->WaitForFrame(m_Queue->GetFrameNumber() - 1);
+        }
+        m_AccelerationStructures->Clear();
+    }
+    m_AccelerationStructuresOutdated = true;
+    m_CullingPass->SetScene(m_Scene, m_Queue->GetFrameNumber());
+
+    if (meshes.empty() || instances.empty())
+    {
+        return false;
+    }
+
+    U64 vertexCount = 0;
+    U64 indexCount = 0;
+    for (const MeshData& mesh : meshes)
+    {
+        vertexCount += mesh.Positions.size();
+        indexCount += mesh.Indices.size();
+    }
+
+    // Running out of device memory halfway through the upload is fatal, so scenes over the budget are refused up front
+    const VkDeviceSize deviceBytes =
+        m_CullingPass->GetSceneBytes(static_cast<U32>(instances.size()), static_cast<U32>(meshes.size()));
+    // All staging buffers live until the next frame completed, the culling buffers are staged at most at device size
+    const VkDeviceSize stagingBytes = vertexCount * sizeof(Model::Vertex) + indexCount * sizeof(U32) + deviceBytes;
+    const auto fitsBudget = [&]()
+    {
+        return MemoryTracker::Fits(deviceBytes, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) &&
+               MemoryTracker::Fits(stagingBytes,
+                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    };
+    // The previous scene holds its memory until the frames in flight are done, it's only waited for when it's needed
+    if (!fitsBudget())
+    {
+        FlushRetired();
+    }
+    if (!fitsBudget())
+    {
+        FFV_WARN("The scene needs {0:.1f} MB of device memory and {1:.1f} MB of staging memory, which exceeds the memory "
+                 "budget!\n{2}",
+                 deviceBytes / (1024.0 * 1024.0), stagingBytes / (1024.0 * 1024.0), MemoryTracker::FormatReport());
+        return false;
+    }
+
+    std::vector<Model::Vertex> vertices;
+    std::vector<U32> indices;
+    vertices.reserve(vertexCount);
+    indices.reserve(indexCount);
+
+    for (const MeshData& mesh : meshes)
+    {
+        for (U32 i = 0; i < mesh.Positions.size(); i++)
+        {
+            vertices.push_back({ .position = mesh.Positions[i],
+                                 .normal = mesh.Normals.empty() ? glm::vec3(0.0f, 0.0f, 1.0f) : mesh.Normals[i] });
+        }
+        indices.insert(indices.end(), mesh.Indices.begin(), mesh.Indices.end());
+    }
+
+    if (!m_GeometryPool->CanAllocate(static_cast<U32>(vertices.size()), static_cast<U32>(indices.size())))
+    {
+        FlushRetired();
+    }
+
+    // All unique meshes share one allocation, each one is addressed relative to where the model landed in the pool
+    m_Model = MakeShared<Model>(vertices, indices, m_GeometryPool);
+    if (!m_Model->IsValid())
+    {
+        m_Model.reset();
+        return false;
+    }
+
+    U32 firstIndex = m_Model->GetFirstIndex();
+    U32 vertexOffset = m_Model->GetVertexOffset();
+    for (const MeshData& mesh : meshes)
+    {
+        m_Scene.AddMesh({ .IndexCount = static_cast<U32>(mesh.Indices.size()),
+                          .FirstIndex = firstIndex,
+                          .VertexOffset = static_cast<I32>(vertexOffset),
+                          .BoundingSphere = Scene::ComputeBoundingSphere(mesh.Positions) });
+
+        firstIndex += static_cast<U32>(mesh.Indices.size());
+        vertexOffset += static_cast<U32>(mesh.Positions.size());
+    }
+
+    m_Scene.Reserve(static_cast<U32>(instances.size()));
+    for (const MeshDeduplicator::Instance& instance : instances)
+    {
+        // Instances of one part share a material, so repeated parts stay recognizable and neighbouring parts differ
+        m_Scene.AddObject(instance.MeshIndex, instance.Transform, instance.MeshIndex % s_DefaultMaterialCount);
+    }
+
+    m_CullingPass->SetScene(m_Scene, m_Queue->GetFrameNumber());
+
+    m_SceneVertexCounts.reserve(meshes.size());
+    for (const MeshData& mesh : meshes)
+    {
+        m_SceneVertexCounts.push_back(static_cast<U32>(mesh.Positions.size()));
+    }
+
+    // Normals aren't needed, the path tracer shades with the geometric normal
+    U64 sceneMeshBytes = 0;
+    if (m_KeepSceneMeshes || m_RenderMode == RenderMode::CpuPathTraced)
+    {
+        m_SceneMeshes.reserve(meshes.size());
+        for (const MeshData& mesh : meshes)
+        {
+            m_SceneMeshes.push_back({ .Positions = mesh.Positions, .Indices = mesh.Indices });
+            sceneMeshBytes += m_SceneMeshes.back().GetSizeInBytes();
+        }
+    }
+
+    MemoryTracker::SetCpuBytes(CpuMemoryCategory::Scene, m_Scene.GetMemoryUsage() + sceneMeshBytes);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::FitCameraToScene(F32 azimuth, F32 elevation, F32 fovY)
+{
+    const std::vector<glm::vec4>& bounds = m_Scene.GetBounds();
+    if (bounds.empty())
+    {
+        return;
+    }
+
+    // Sphere around the box of all object spheres, loose but stable for every view direction
+    glm::vec3 minimum(std::numeric_limits<F32>::max());
+    glm::vec3 maximum(std::numeric_limits<F32>::lowest());
+    for (const glm::vec4& sphere : bounds)
+    {
+        minimum = glm::min(minimum, glm::vec3(sphere) - sphere.w);
+        maximum = glm::max(maximum, glm::vec3(sphere) + sphere.w);
+    }
+
+    const glm::vec3 center = (minimum + maximum) * 0.5f;
+    F32 radius = 0.0f;
+    for (const glm::vec4& sphere : bounds)
+    {
+        radius = std::max(radius, glm::distance(center, glm::vec3(sphere)) + sphere.w);
+    }
+    radius = std::max(radius, 1e-4f);
+
+    const F32 azimuthRadians = glm::radians(azimuth);
+    const F32 elevationRadians = glm::radians(elevation);
+    const glm::vec3 direction = { std::cos(elevationRadians) * std::cos(azimuthRadians),
+                                  std::cos(elevationRadians) * std::sin(azimuthRadians), std::sin(elevationRadians) };
+
+    // The sphere touches the vertical field of view, a small margin keeps silhouettes off the border
+    const F32 distance = radius * 1.1f / std::sin(glm::radians(fovY) * 0.5f);
+
+    m_FixedCamera = FixedCamera{ .View = glm::lookAt(center + direction * distance, center, glm::vec3(0.0f, 0.0f, 1.0f)),
+                                 .FovY = glm::radians(fovY),
+                                 .Near = std::max(distance - radius * 1.1f, distance * 1e-3f),
+                                 .Far = distance + radius * 1.1f };
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::UpdateCamera()
+{
+    const F32 aspectRatio = static_cast<F32>(std::max(GetTargetExtent().width, 1u)) /
+                            static_cast<F32>(std::max(GetTargetExtent().height, 1u));
+
+    if (m_FixedCamera)
+    {
+        m_Camera = { .view = m_FixedCamera->View,
+                     .proj = glm::perspectiveRH_ZO(m_FixedCamera->FovY, aspectRatio, m_FixedCamera->Near,
+                                                   m_FixedCamera->Far) };
+        m_Camera.proj[1][1] *= -1.0f;
+        return;
+    }
+
+    static auto lastTime = std::chrono::high_resolution_clock::now();
+    static float time = 0.0f;
+
+    // The path tracer restarts accumulating whenever the camera moves, so the orbit pauses while it renders
+    const auto currentTime = std::chrono::high_resolution_clock::now();
+    if (m_RenderMode != RenderMode::CpuPathTraced)
+    {
+        time += std::chrono::duration<float, std::chrono::seconds::period>(currentTime - lastTime).count();
+    }
+    lastTime = currentTime;
+
+    // The camera orbits instead of the objects spinning, so the object buffer doesn't change every frame
+    const glm::vec3 eye = glm::vec3(glm::rotate(glm::mat4(1.0f), -time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f)) *
+                                    glm::vec4(4.0f, 4.0f, 4.0f, 1.0f));
+
+    m_Camera = { .view = glm::lookAt(eye, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
+                 .proj = glm::perspectiveRH_ZO(glm::radians(45.0f), aspectRatio, 0.1f, 100.0f) };
+
+    m_Camera.proj[1][1] *= -1.0f;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::RenderPathTraced(U32 frameIndex)
+{
+    FFV_PROFILE_FUNCTION();
+
+    if (m_PathTracerOutdated)
+    {
+        m_PathTracer.SetScene(m_SceneMeshes, m_Scene, m_MaterialColors);
+        m_PathTracerOutdated = false;
+    }
+
+    // Frames in flight may still copy from the staging buffers of the old size, so the old image is retired
+    const VkExtent2D targetExtent = GetTargetExtent();
+    if (!m_PathTracerImage || m_PathTracerImage->GetExtent().width != targetExtent.width ||
+        m_PathTracerImage->GetExtent().height != targetExtent.height)
+    {
+        Retire(std::move(m_PathTracerImage));
+        m_PathTracerImage =
+            MakeShared<StreamingImage>(m_Device, m_PhysicalDevices, targetExtent, m_Queue->GetFramesInFlight());
+    }
+
+    m_PathTracer.Render(m_Camera.view, m_Camera.proj, targetExtent.width, targetExtent.height,
+                        m_PathTracerImage->GetPixels(frameIndex));
+    MemoryTracker::SetCpuBytes(CpuMemoryCategory::PathTracer, m_PathTracer.GetMemoryUsage());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::PrepareRayTracing()
+{
+    FFV_PROFILE_FUNCTION();
+
+    if (m_AccelerationStructuresOutdated)
+    {
+        // The builds are submitted on their own and read the geometry, which may still wait for the next frame
+        m_Uploader->Flush();
+        m_AccelerationStructures->SetScene(m_Scene, m_SceneVertexCounts, *m_GeometryPool);
+        m_AccelerationStructuresOutdated = false;
+    }
+
+    // Frames in flight may still trace into the image of the old size, so the pass retires it
+    const VkExtent2D targetExtent = GetTargetExtent();
+    if (!m_RayTracingPass)
+    {
+        m_RayTracingPass = MakeShared<RayTracingPass>(m_Device, m_PhysicalDevices, m_BindlessTable, m_PipelineCache,
+                                                      targetExtent, m_Queue->GetFramesInFlight());
+    }
+    else if (m_RayTracingPass->GetExtent().width != targetExtent.width ||
+             m_RayTracingPass->GetExtent().height != targetExtent.height)
+    {
+        m_RayTracingPass->Resize(targetExtent, m_Queue->GetFrameNumber() - 1);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::RecordCommandBuffer(VkCommandBuffer commandBuffer, U32 imageIndex, U32 frameIndex, DrawPath drawPath,
+                                   U32 drawCount, U32 maxThreads)
+{
+    FFV_PROFILE_FUNCTION();
+
+    FFV_ASSERT(imageIndex < GetNumTargetImages(),
+               std::format("Image index {} is out of bounds! Target images: {}", imageIndex, GetNumTargetImages()), ;);
+
+    const VkCommandBufferBeginInfo beginInfo = { .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                                 .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT };
+    FFV_CHECK_VK_RESULT(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+    GpuProfiler* profiler = m_ProfileFrame ? m_GpuProfiler.get() : nullptr;
+    if (profiler)
+    {
+        profiler->BeginFrame(commandBuffer, frameIndex);
+    }
+
+    {
+        GpuProfiler::Scope frameScope(profiler, commandBuffer, frameIndex, "Frame");
+
+        // Only frames after a scene load have copies, so the scope gets fewer samples than the others
+        if (m_RecordUploads && m_Uploader->HasPendingCopies())
+        {
+            GpuProfiler::Scope uploadScope(profiler, commandBuffer, frameIndex, "Upload");
+            m_Uploader->RecordCopies(commandBuffer, m_Queue->GetFrameNumber());
+        }
+
+        // Where drawing leaves the target image, the transitions for the capture and the present start from there
+        VkImageLayout targetLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        VkAccessFlags2 targetAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+        VkPipelineStageFlags2 targetStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+        if (m_RenderMode == RenderMode::CpuPathTraced)
+        {
+            GpuProfiler::Scope uploadScope(profiler, commandBuffer, frameIndex, "PathTracerUpload");
+            m_PathTracerImage->RecordUpload(commandBuffer, frameIndex);
+            CreateImageBarrier(commandBuffer, imageIndex, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               VK_ACCESS_2_NONE, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                               VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_2_BLIT_BIT);
+            m_PathTracerImage->RecordBlit(commandBuffer, GetTargetImage(imageIndex), GetTargetExtent());
+
+            targetLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            targetAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            targetStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+        }
+        else if (m_RenderMode == RenderMode::RayTraced && !m_AccelerationStructures->IsEmpty())
+        {
+            GpuProfiler::Scope rayTracingScope(profiler, commandBuffer, frameIndex, "RayTracing");
+            m_AccelerationStructures->RecordTlasUpdate(commandBuffer, frameIndex, m_Scene);
+
+            const RayTracingPass::TraceConstants constants = {
+                .inverseViewProjection = glm::inverse(m_Camera.proj * m_Camera.view),
+                .vertexBufferIndex = m_AccelerationStructures->GetVertexBufferIndex(),
+                .indexBufferIndex = m_AccelerationStructures->GetIndexBufferIndex(),
+                .meshBufferIndex = m_AccelerationStructures->GetMeshBufferIndex(),
+                .vertexStride = m_GeometryPool->GetVertexStride(),
+                .materialIndexBufferIndex = m_CullingPass->GetMaterialIndexBufferIndex(),
+                .materialBufferIndex = m_MaterialBufferIndex
+            };
+            m_RayTracingPass->RecordTrace(commandBuffer, frameIndex, m_AccelerationStructures->GetTlas(frameIndex),
+                                          constants);
+            CreateImageBarrier(commandBuffer, imageIndex, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               VK_ACCESS_2_NONE, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                               VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_2_BLIT_BIT);
+            m_RayTracingPass->RecordBlit(commandBuffer, GetTargetImage(imageIndex), GetTargetExtent());
+
+            targetLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            targetAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            targetStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+        }
+        else
+        {
+            const bool occlusionCulling = drawPath == DrawPath::GpuDriven && m_OcclusionCulling;
+            const CullingPass::CullPhase firstPhase =
+                occlusionCulling ? CullingPass::CullPhase::Early : CullingPass::CullPhase::FrustumOnly;
+            const glm::mat4 viewProjection = m_Camera.proj * m_Camera.view;
+
+            if (drawPath == DrawPath::GpuDriven)
+            {
+                GpuProfiler::Scope cullingScope(profiler, commandBuffer, frameIndex, "Culling");
+                m_CullingPass->RecordCulling(commandBuffer, frameIndex, viewProjection, firstPhase);
+            }
+
+            {
+                GpuProfiler::Scope renderScope(profiler, commandBuffer, frameIndex, "Render");
+                RecordRendering(commandBuffer, imageIndex, frameIndex, drawPath, firstPhase, drawCount, maxThreads);
+            }
+
+            // Objects that became visible are found with the depth of the early pass and drawn on top of it
+            if (occlusionCulling)
+            {
+                {
+                    GpuProfiler::Scope occlusionScope(profiler, commandBuffer, frameIndex, "OcclusionCulling");
+                    m_DepthTarget->RecordSampleBarrier(commandBuffer, frameIndex);
+                    m_HiZPyramid->RecordBuild(commandBuffer, m_DepthTarget->GetSampledImageIndex(frameIndex));
+                    m_CullingPass->RecordCulling(commandBuffer, frameIndex, viewProjection, CullingPass::CullPhase::Late,
+                                                 m_HiZPyramid.get());
+                    m_DepthTarget->RecordAttachmentBarrier(commandBuffer, frameIndex);
+                }
+
+                GpuProfiler::Scope lateRenderScope(profiler, commandBuffer, frameIndex, "RenderLate");
+                RecordRendering(commandBuffer, imageIndex, frameIndex, drawPath, CullingPass::CullPhase::Late, drawCount,
+                                maxThreads);
+            }
+        }
+
+        if (m_CaptureFrame)
+        {
+            GpuProfiler::Scope readbackScope(profiler, commandBuffer, frameIndex, "Readback");
+            CreateImageBarrier(commandBuffer, imageIndex, targetLayout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                               targetAccessMask, VK_ACCESS_2_TRANSFER_READ_BIT, targetStageMask,
+                               VK_PIPELINE_STAGE_2_COPY_BIT);
+            m_ReadbackRing->RecordCopy(commandBuffer, frameIndex, GetTargetImage(imageIndex),
+                                       m_Queue->GetFrameNumber());
+        }
+
+        if (!IsHeadless())
+        {
+            // After a capture only the copy has to finish, the layout transition orders itself after it
+            if (m_CaptureFrame)
+            {
+                CreateImageBarrier(commandBuffer, imageIndex, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                   VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_ACCESS_2_NONE, VK_ACCESS_2_NONE,
+                                   VK_PIPELINE_STAGE_2_COPY_BIT, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT);
+            }
+            else
+            {
+                CreateImageBarrier(commandBuffer, imageIndex, targetLayout, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                                   targetAccessMask, VK_ACCESS_2_NONE, targetStageMask,
+                                   VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT);
+            }
+        }
+    }
+
+    FFV_CHECK_VK_RESULT(vkEndCommandBuffer(commandBuffer));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::RecordRendering(VkCommandBuffer commandBuffer, U32 imageIndex, U32 frameIndex, DrawPath drawPath,
+                               CullingPass::CullPhase phase, U32 drawCount, U32 maxThreads)
+{
+    const VkExtent2D targetExtent = GetTargetExtent();
+    const bool latePass = phase == CullingPass::CullPhase::Late;
+
+    if (latePass)
+    {
+        // The depth target was already transitioned back after the late culling
+        CreateImageBarrier(commandBuffer, imageIndex, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                           VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                           VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                           VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                           VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+    }
+    else
+    {
+        CreateImageBarrier(commandBuffer, imageIndex, VK_IMAGE_LAYOUT_UNDEFINED,
+                           VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_2_NONE,
+                           VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
+                           VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+        m_DepthTarget->RecordBeginFrameBarrier(commandBuffer, frameIndex);
+    }
 
     const VkClearValue clearColor = { .color = { .float32 = { 0.1f, 0.1f, 0.1f, 1.0f } } };
-    const VkRenderingAttachmentInfoKHR colorAttachment = { .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
-                                                           .imageView = m_Swapchain->GetImageViews()[imageIndex],
-                                                           .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-                                                           .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-                                                           .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-                                                           .clearValue = clearColor };
+    const VkRenderingAttachmentInfoKHR colorAttachment = {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
+        .imageView = GetTargetImageView(imageIndex),
+        .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .loadOp = latePass ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .clearValue = clearColor
+    };
+
+    // The depth pyramid is built from the depth of the early pass
+    const VkRenderingAttachmentInfo depthAttachment = {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .imageView = m_DepthTarget->GetImageView(frameIndex),
+        .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .loadOp = latePass ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = phase == CullingPass::CullPhase::Early ? VK_ATTACHMENT_STORE_OP_STORE
+                                                          : VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .clearValue = { .depthStencil = { .depth = 1.0f } }
+    };
 
     const VkRenderingInfoKHR renderingInfo = {
         .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
-        .renderArea = { { 0, 0 }, swapchainExtent },
+        .flags = drawPath == DrawPath::CpuRecorded ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0u,
+        .renderArea = { { 0, 0 }, targetExtent },
         .layerCount = 1,
         .viewMask = 0,
         .colorAttachmentCount = 1,
-        .pColorAttachments = &colorAttachment
+        .pColorAttachments = &colorAttachment,
+        .pDepthAttachment = &depthAttachment
+    };
+    vkCmdBeginRendering(commandBuffer, &renderingInfo);
+
+    const VkFormat colorFormat = GetTargetFormat();
+    const VkCommandBufferInheritanceRenderingInfo inheritanceRenderingInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &colorFormat,
+        .depthAttachmentFormat = m_DepthTarget->GetFormat(),
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT
+    };
+
+    const auto recordPass = [&](const GraphicsPipeline& pipeline)
+    {
+        // Without the camera the draws would read a dynamic offset outside the buffer, the attachments are still cleared
+        if (m_CameraOffset == TransientAllocator::InvalidOffset)
+        {
+            return;
+        }
+
+        if (drawPath == DrawPath::GpuDriven)
+        {
+            RecordDrawState(commandBuffer, frameIndex, pipeline,
+                            m_CullingPass->GetVisibleInstanceBufferIndex(frameIndex, phase));
+            m_CullingPass->RecordDrawIndirect(commandBuffer, frameIndex, phase);
+            return;
+        }
+
+        m_CommandRecorder->RecordDraws(
+            commandBuffer, frameIndex, inheritanceRenderingInfo, drawCount, s_DrawsPerCommandBuffer,
+            [this, frameIndex, &pipeline](VkCommandBuffer secondaryCommandBuffer, U32 first, U32 count)
+            { RecordDrawRange(secondaryCommandBuffer, frameIndex, pipeline, first, count); }, maxThreads);
     };
-    vkCmdBeginRendering(m_CommandBuffers[imageIndex], &renderingInfo);
 
-    m_GraphicsPipeline->Bind(m_CommandBuffers[imageIndex]);
+    // With the pre-pass every pixel is shaded once, by the fragment that ended up nearest. Both passes run in the same
+    // rendering, so rasterization order makes the pre-pass depth visible to the shading pass without a barrier.
+    if (m_DepthPrePass)
+    {
+        recordPass(*m_DepthPrePassPipeline);
+        recordPass(*m_ShadeVisiblePipeline);
+    }
+    else
+    {
+        recordPass(*m_GraphicsPipeline);
+    }
+
+    vkCmdEndRendering(commandBuffer);
+}
 
-    const VkViewport viewport = { .width = static_cast<float>(swapchainExtent.width),
-                                  .height = static_cast<float>(swapchainExtent.height) };
-    vkCmdSetViewport(m_CommandBuffers[imageIndex], 0, 1, &viewport);
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    const VkRect2D scissorRect = { .extent = swapchainExtent };
-    vkCmdSetScissor(m_CommandBuffers[imageIndex], 0, 1, &scissorRect);
+void Renderer::RecordDrawState(VkCommandBuffer commandBuffer, U32 frameIndex, const GraphicsPipeline& pipeline,
+                               U32 instanceBufferIndex) const
+{
+    const VkExtent2D targetExtent = GetTargetExtent();
+
+    pipeline.Bind(commandBuffer);
+
+    const VkViewport viewport = { .width = static_cast<float>(targetExtent.width),
+                                  .height = static_cast<float>(targetExtent.height),
+                                  .minDepth = 0.0f,
+                                  .maxDepth = 1.0f };
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+    const VkRect2D scissorRect = { .extent = targetExtent };
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissorRect);
+
+    m_GeometryPool->Bind(commandBuffer);
+    pipeline.BindUniformBuffer(commandBuffer, frameIndex, m_CameraOffset);
+    m_BindlessTable->Bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.GetPipelineLayout(),
+                          GraphicsPipeline::BindlessSet);
+    pipeline.PushDrawConstants(commandBuffer,
+                               { .transformBufferIndex = m_CullingPass->GetTransformBufferIndex(),
+                                 .materialIndexBufferIndex = m_CullingPass->GetMaterialIndexBufferIndex(),
+                                 .instanceBufferIndex = instanceBufferIndex,
+                                 .materialBufferIndex = m_MaterialBufferIndex });
+}
 
-    VkDeviceSize offset = 0;
-    VkBuffer vertexBuffer = m_Model->GetVertexBuffer();
-    vkCmdBindVertexBuffers(m_CommandBuffers[imageIndex], 0, 1, &vertexBuffer, &offset);
-    vkCmdBindIndexBuffer(m_CommandBuffers[imageIndex], m_Model->GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
-    vkCmdBindDescriptorSets(m_CommandBuffers[imageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            m_GraphicsPipeline->GetPipelineLayout(), 0, 1,
-                            &m_GraphicsPipeline->GetDescriptorSets()[imageIndex], 0, nullptr);
-    vkCmdDrawIndexed(m_CommandBuffers[imageIndex], static_cast<U32>(m_Indices.size()), 1, 0, 0, 0);
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    vkCmdEndRendering(m_CommandBuffers[imageIndex]);
+void Renderer::RecordDrawRange(VkCommandBuffer commandBuffer, U32 frameIndex, const GraphicsPipeline& pipeline,
+                               U32 first, U32 count) const
+{
+    // Secondary command buffers don't inherit any state from the primary one
+    RecordDrawState(commandBuffer, frameIndex, pipeline, m_CullingPass->GetInstanceBufferIndex());
 
-    CreateImageBarrier(imageIndex, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-                       VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_2_NONE,
-                       VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT);
+    const std::vector<Scene::Batch>& batches = m_CullingPass->GetBatches();
+    const std::vector<Scene::Mesh>& meshes = m_CullingPass->GetMeshes();
 
-    FFV_CHECK_VK_RESULT(vkEndCommandBuffer(m_CommandBuffers[imageIndex]));
+    for (U32 i = first; i < first + count; i++)
+    {
+        const Scene::Batch& batch = batches[i % batches.size()];
+        const Scene::Mesh& mesh = meshes[batch.MeshIndex];
+        vkCmdDrawIndexed(commandBuffer, mesh.IndexCount, batch.InstanceCount, mesh.FirstIndex, mesh.VertexOffset,
+                         batch.FirstInstance);
+    }
 }
-void Renderer::CreateImageBarrier(U32 imageIndex, VkImageLayout oldLayout, VkImageLayout newLayout,
-                                  VkAccessFlags2 srcAccessMask, VkAccessFlags2 dstAccessMask,
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::CreateImageBarrier(VkCommandBuffer commandBuffer, U32 imageIndex, VkImageLayout oldLayout,
+                                  VkImageLayout newLayout, VkAccessFlags2 srcAccessMask, VkAccessFlags2 dstAccessMask,
                                   VkPipelineStageFlags2 srcStageMask, VkPipelineStageFlags2 dstStageMask)
 {
     VkImageMemoryBarrier2 imageBarrier = {
@@ -369,7 +1371,7 @@ void Renderer::CreateImageBarrier(U32 imageIndex, VkImageLayout oldLayout, VkIma
         .newLayout = newLayout,
         .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
         .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .image = m_Swapchain->GetImages()[imageIndex],
+        .image = GetTargetImage(imageIndex),
         .subresourceRange = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
                              .baseMipLevel = 0,
                              .levelCount = 1,
@@ -381,6 +1383,41 @@ void Renderer::CreateImageBarrier(U32 imageIndex, VkImageLayout oldLayout, VkIma
                                         .imageMemoryBarrierCount = 1,
                                         .pImageMemoryBarriers = &imageBarrier };
 
-    vkCmdPipelineBarrier2(m_CommandBuffers[imageIndex], &dependencyInfo);
+    vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::Retire(SharedPtr<void> resource)
+{
+    // The frame being recorded, or the next one between frames, copies the pending uploads into it
+    m_RetiredResources.push_back({ .Resource = std::move(resource), .RetireFrameNumber = m_Queue->GetFrameNumber() });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::DestroyRetired(U64 completedFrameNumber)
+{
+    std::erase_if(m_RetiredResources,
+                  [&](const RetiredResource& retired) { return retired.RetireFrameNumber <= completedFrameNumber; });
+    m_CullingPass->DestroyRetired(completedFrameNumber);
+    m_Uploader->DestroyRetired(completedFrameNumber);
+
+    // Retired here rather than in PrepareRayTracing, so switching the render mode doesn't keep them alive
+    if (m_RayTracingPass)
+    {
+        m_RayTracingPass->DestroyRetired(completedFrameNumber);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Renderer::FlushRetired()
+{
+    FFV_PROFILE_FUNCTION();
+
+    m_Uploader->Flush();
+    m_Queue->WaitIdle();
+    DestroyRetired(std::numeric_limits<U64>::max());
 }
 } // namespace FFV
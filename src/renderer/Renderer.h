@@ -2,41 +2,281 @@
 
 #include "Model.h"
 #include "Window.h"
+#include "import/MeshData.h"
+#include "import/MeshDeduplicator.h"
+#include "renderer/AccelerationStructures.h"
+#include "renderer/BindlessTable.h"
+#include "renderer/CommandRecorder.h"
+#include "renderer/CullingPass.h"
+#include "renderer/DepthTarget.h"
+#include "renderer/FramePacer.h"
+#include "renderer/GeometryPool.h"
+#include "renderer/GpuProfiler.h"
 #include "renderer/GraphicsPipeline.h"
+#include "renderer/HiZPyramid.h"
+#include "renderer/OffscreenTarget.h"
 #include "renderer/PhysicalDevice.h"
+#include "renderer/PipelineCache.h"
 #include "renderer/Queue.h"
+#include "renderer/RayTracingPass.h"
+#include "renderer/ReadbackRing.h"
+#include "renderer/StreamingImage.h"
 #include "renderer/Swapchain.h"
+#include "renderer/TransientAllocator.h"
+#include "renderer/Uploader.h"
+#include "scene/PathTracer.h"
+#include "scene/Scene.h"
 #include "util/Types.h"
 #include "util/Util.h"
 
 #include <GLFW/glfw3.h>
+#include <optional>
 
 namespace FFV
 {
 class Renderer
 {
 public:
-    Renderer(SharedPtr<Window> window);
+    enum class RenderMode
+    {
+        Rasterized,
+        CpuPathTraced, // Traced on the job system and uploaded every frame, for devices without ray tracing
+        RayTraced      // Traced by the GPU with the ray tracing pipeline, needs VK_KHR_ray_tracing_pipeline
+    };
+
+public:
+    /*
+     * @param targetFps: frame limiter target, 0 disables it
+     */
+    Renderer(SharedPtr<Window> window, PresentPolicy presentPolicy = PresentPolicy::Mailbox, F64 targetFps = 0.0);
+    /*
+     * Headless renderer without window and surface, frames are rendered offscreen and read back asynchronously.
+     * @param extent: size of the offscreen images
+     * @param framesInFlight: how far the GPU may run ahead of the readbacks, each frame has its own offscreen image
+     */
+    explicit Renderer(VkExtent2D extent, U32 framesInFlight = Queue::DefaultFramesInFlight);
     ~Renderer();
 
     FFV_DELETE_MOVE_COPY(Renderer);
 
+    /*
+     * Paces the frames, has to be called right before input is polled for the next Update.
+     */
+    void WaitForFrameStart() { m_FramePacer->WaitForFrameStart(); }
     void Update();
     void WaitIdle() const { vkDeviceWaitIdle(m_Device); }
 
+    bool IsHeadless() const { return !m_Window; }
+    /*
+     * Called from Update for every completed frame that was captured, in frame order. Headless renderers capture
+     * every frame while a callback is set.
+     */
+    void SetReadbackCallback(ReadbackRing::ReadbackFn callback) { m_ReadbackCallback = std::move(callback); }
+    /*
+     * Waits for all submitted frames and hands their pending readbacks to the callback.
+     */
+    void FinishReadbacks();
+    /*
+     * Copies the next frame into a readback buffer, it reaches the readback callback once the GPU finished it.
+     */
+    void CaptureNextFrame() { m_CaptureNextFrame = true; }
+    void SetContinuousCapture(bool enabled) { m_ContinuousCapture = enabled; }
+    bool IsContinuousCapture() const { return m_ContinuousCapture; }
+
+    /*
+     * Logs the rolling GPU timings of every scope once per second.
+     */
+    void SetGpuProfileLogging(bool enabled) { m_LogGpuProfile = enabled; }
+    bool WriteGpuProfile(const std::filesystem::path& path) const { return m_GpuProfiler->WriteReport(path); }
+    bool IsGpuProfilingSupported() const { return m_GpuProfiler->IsSupported(); }
+    void SetGpuSampleCallback(GpuProfiler::SampleFn callback) { m_GpuProfiler->SetSampleCallback(std::move(callback)); }
+    /*
+     * Logs the heap budgets and the memory of every category once per second, see MemoryTracker.
+     */
+    void SetMemoryLogging(bool enabled) { m_LogMemory = enabled; }
+    bool IsMemoryLogging() const { return m_LogMemory; }
+    /*
+     * Renders depth only before shading, so expensive fragments run once per pixel instead of once per overlapping
+     * triangle. Costs a second geometry pass, which only pays off for dense, self occluding scenes.
+     */
+    void SetDepthPrePass(bool enabled) { m_DepthPrePass = enabled; }
+    bool IsDepthPrePass() const { return m_DepthPrePass; }
+    /*
+     * Skips objects hidden behind the depth of the objects that were visible in the last frame, see CullingPass. Only
+     * used by the GPU driven draw path.
+     */
+    void SetOcclusionCulling(bool enabled) { m_OcclusionCulling = enabled; }
+    bool IsOcclusionCulling() const { return m_OcclusionCulling; }
+    /*
+     * Logs the drawn, frustum culled and occluded objects and triangles once per second.
+     */
+    void SetCullStatsLogging(bool enabled) { m_LogCullStats = enabled; }
+    bool IsCullStatsLogging() const { return m_LogCullStats; }
+    const CullingPass::CullStats& GetCullStats() const { return m_CullingPass->GetStats(); }
+    /*
+     * The path traced image accumulates samples while the camera stands still. Stays rasterized if the target format
+     * can't be blitted to or, for RenderMode::RayTraced, if the device has no hardware ray tracing.
+     */
+    void SetRenderMode(RenderMode renderMode);
+    RenderMode GetRenderMode() const { return m_RenderMode; }
+    /*
+     * Keeps a CPU copy of the positions and indices of loaded scenes, which the CPU path tracer is built from. Without
+     * it only scenes loaded in RenderMode::CpuPathTraced can be path traced. Enabled by default, renderers that never
+     * switch modes can save the memory.
+     */
+    void SetKeepSceneMeshes(bool enabled) { m_KeepSceneMeshes = enabled; }
+    bool IsRayTracingSupported() const { return m_RayTracingSupported; }
+    const PathTracer::Stats& GetPathTracerStats() const { return m_PathTracer.GetStats(); }
+    /*
+     * Main thread time of the last Update, without waiting for the GPU to release the frame's resources.
+     */
+    F64 GetLastCpuMs() const { return m_LastCpuMs; }
+    const char* GetDeviceName() const
+    {
+        return m_PhysicalDevices->GetSelectedPhysicalDevice().DeviceProperties.deviceName;
+    }
+    /*
+     * Frame number the next Update submits, readbacks report it back.
+     */
+    U64 GetFrameNumber() const { return m_Queue->GetFrameNumber(); }
+    U32 GetFramesInFlight() const { return m_Queue->GetFramesInFlight(); }
+
+    /*
+     * Replaces the scene, duplicate meshes get instanced. The old geometry and culling buffers are retired rather than
+     * waited for, the new scene is uploaded by the next frame. Only waits when the memory of the old scene is needed.
+     * @return: false if there is nothing to draw, the geometry doesn't fit into the geometry pool or the scene would
+     *          exceed the memory budget
+     */
+    bool LoadScene(const std::vector<MeshData>& meshes);
+    /*
+     * Same as above for meshes that are already unique, e.g. generated ones, placed by the instances.
+     */
+    bool LoadScene(const std::vector<MeshData>& meshes, const std::vector<MeshDeduplicator::Instance>& instances);
+    /*
+     * Replaces the orbiting camera with a fixed one that has the whole scene in view, z is up.
+     * @param azimuth: degrees around the z axis, 0 looks from +x
+     * @param elevation: degrees above the xy plane
+     * @param fovY: vertical field of view in degrees
+     */
+    void FitCameraToScene(F32 azimuth, F32 elevation, F32 fovY = 45.0f);
+
+    // The swapchain format, or the offscreen format when headless
+    VkFormat GetTargetFormat() const
+    {
+        return IsHeadless() ? OffscreenTarget::Format : m_Swapchain->GetSurfaceFormat().format;
+    }
+
+    /*
+     * Measures the CPU time of recording a frame for increasing draw and thread counts and logs the results.
+     * Nothing gets submitted, so this must not be called while frames are in flight.
+     */
+    void RunRecordingBenchmark();
+
+private:
+    enum class DrawPath
+    {
+        GpuDriven,  // Culled by a compute pass and drawn with one indirect draw per mesh
+        CpuRecorded // Every draw recorded on the CPU, used when indirect count draws are not supported
+    };
+
+    struct FixedCamera
+    {
+        glm::mat4 View = glm::mat4(1.0f);
+        F32 FovY = 0.0f; // Radians
+        F32 Near = 0.0f;
+        F32 Far = 0.0f;
+    };
+
 private:
+    void Init(PresentPolicy presentPolicy, F64 targetFps);
     void CreateInstance();
     void CreateDebugCallback();
     void CreateSurface(GLFWwindow* window);
     void CreateDevice();
     void CreateCommandBufferPool();
-    void CreateCommandBuffers(U32 count);
-    void RecordCommandBuffer(U32 imageIndex);
+    void CreateMaterialBuffer(const std::vector<GraphicsPipeline::MaterialData>& materials);
+    /*
+     * The scene shown until a model is loaded: a grid of cubes and quads that are flattened into world space the way
+     * CAD exports store repeated parts, so loading it goes through the same deduplication as an imported model.
+     */
+    void CreateDefaultScene();
+    void UpdateCamera();
+    /*
+     * Adds a sample to the path traced image and writes it into the staging buffer of the frame, the scene of the path
+     * tracer is only built once it's needed.
+     */
+    void RenderPathTraced(U32 frameIndex);
+    /*
+     * Builds the BLASes of the scene once it's first ray traced and makes sure the traced image fits the target.
+     */
+    void PrepareRayTracing();
+    /*
+     * Decides whether the current windowed frame gets captured and makes sure the readback ring fits the swapchain.
+     */
+    bool PrepareCapture();
+    /*
+     * @param drawCount: only used by DrawPath::CpuRecorded, draws beyond the batch count wrap around
+     * @param maxThreads: upper limit of threads recording the draws
+     */
+    void RecordCommandBuffer(VkCommandBuffer commandBuffer, U32 imageIndex, U32 frameIndex, DrawPath drawPath,
+                             U32 drawCount, U32 maxThreads = ~0u);
+    /*
+     * Records the draws of the draw path, after a depth pre-pass if enabled. The late culling phase draws on top of the
+     * early one, every other phase clears the color and depth target first.
+     * @param phase: the culling phase whose output gets drawn, DrawPath::CpuRecorded uses CullPhase::FrustumOnly
+     */
+    void RecordRendering(VkCommandBuffer commandBuffer, U32 imageIndex, U32 frameIndex, DrawPath drawPath,
+                         CullingPass::CullPhase phase, U32 drawCount, U32 maxThreads);
+    /*
+     * Binds everything the draws of the graphics pipeline need.
+     * @param instanceBufferIndex: bindless index of the buffer mapping instances to objects
+     */
+    void RecordDrawState(VkCommandBuffer commandBuffer, U32 frameIndex, const GraphicsPipeline& pipeline,
+                         U32 instanceBufferIndex) const;
+    void RecordDrawRange(VkCommandBuffer commandBuffer, U32 frameIndex, const GraphicsPipeline& pipeline, U32 first,
+                         U32 count) const;
+
+    // The swapchain, or the offscreen target when headless
+    VkExtent2D GetTargetExtent() const
+    {
+        return IsHeadless() ? m_OffscreenTarget->GetExtent() : m_Swapchain->GetExtent();
+    }
+    VkImage GetTargetImage(U32 index) const
+    {
+        return IsHeadless() ? m_OffscreenTarget->GetImages()[index] : m_Swapchain->GetImages()[index];
+    }
+    VkImageView GetTargetImageView(U32 index) const
+    {
+        return IsHeadless() ? m_OffscreenTarget->GetImageViews()[index] : m_Swapchain->GetImageViews()[index];
+    }
+    U32 GetNumTargetImages() const
+    {
+        return IsHeadless() ? m_OffscreenTarget->GetNumImages() : m_Swapchain->GetNumImagesInFlight();
+    }
 
-    void CreateImageBarrier(U32 imageIndex, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags2 srcAccessMask,
+    void CreateImageBarrier(VkCommandBuffer commandBuffer, U32 imageIndex, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags2 srcAccessMask,
                             VkAccessFlags2 dstAccessMask, VkPipelineStageFlags2 srcStageMask,
                             VkPipelineStageFlags2 dstStageMask);
 
+    /*
+     * Keeps a replaced resource alive until the frames submitted so far and the next one completed, so it can be
+     * recreated without waiting for the GPU. The next frame records the pending uploads, which may still write to it.
+     */
+    void Retire(SharedPtr<void> resource);
+    void DestroyRetired(U64 completedFrameNumber);
+    /*
+     * Flushes the pending uploads and waits for the GPU, so everything retired can be destroyed right away. Only for
+     * when the memory of retired resources is needed.
+     */
+    void FlushRetired();
+
+private:
+    struct RetiredResource
+    {
+        SharedPtr<void> Resource;
+        U64 RetireFrameNumber = 0;
+    };
+
 private:
     VkInstance m_Instance = VK_NULL_HANDLE;
     VkDebugUtilsMessengerEXT m_DebugMessenger = VK_NULL_HANDLE;
@@ -48,21 +288,67 @@ private:
     SharedPtr<PhysicalDevices> m_PhysicalDevices;
     SharedPtr<Swapchain> m_Swapchain;
     SharedPtr<Queue> m_Queue;
-    SharedPtr<GraphicsPipeline> m_GraphicsPipeline;
+    SharedPtr<FramePacer> m_FramePacer;
+    SharedPtr<GpuProfiler> m_GpuProfiler;
+    SharedPtr<BindlessTable> m_BindlessTable;
+    SharedPtr<PipelineCache> m_PipelineCache;
+    SharedPtr<GraphicsPipeline> m_GraphicsPipeline; // Depth test and write, used without the pre-pass
+    SharedPtr<GraphicsPipeline> m_DepthPrePassPipeline;
+    SharedPtr<GraphicsPipeline> m_ShadeVisiblePipeline;
+    SharedPtr<CommandRecorder> m_CommandRecorder;
+    SharedPtr<CullingPass> m_CullingPass;
+    SharedPtr<GeometryPool> m_GeometryPool;
+    SharedPtr<Uploader> m_Uploader;
+    SharedPtr<TransientAllocator> m_TransientAllocator;
+    SharedPtr<OffscreenTarget> m_OffscreenTarget;
+    SharedPtr<DepthTarget> m_DepthTarget;
+    SharedPtr<HiZPyramid> m_HiZPyramid; // Built from the depth target, recreated with it
+    SharedPtr<ReadbackRing> m_ReadbackRing;
+    SharedPtr<StreamingImage> m_PathTracerImage; // Recreated with the target size
+    SharedPtr<AccelerationStructures> m_AccelerationStructures; // Only with hardware ray tracing
+    SharedPtr<RayTracingPass> m_RayTracingPass; // Created when the scene is first ray traced, resized with the target
+    std::vector<RetiredResource> m_RetiredResources;
+
+    ReadbackRing::ReadbackFn m_ReadbackCallback;
+    VkExtent2D m_OffscreenExtent = { 0, 0 };
+    bool m_CaptureNextFrame = false;
+    bool m_ContinuousCapture = false;
+    bool m_CaptureFrame = false; // Whether the frame being recorded gets copied into the readback ring
+    bool m_ProfileFrame = false; // Whether the frame being recorded writes timestamps
+    bool m_RecordUploads = false; // Whether the frame being recorded copies the pending uploads
+    bool m_LogGpuProfile = false;
+    bool m_LogMemory = false;
+    bool m_DepthPrePass = false;
+    bool m_OcclusionCulling = true;
+    bool m_LogCullStats = false;
+    F64 m_LastCpuMs = 0.0;
 
     U32 m_QueueFamily = 0;
-    std::vector<VkCommandBuffer> m_CommandBuffers;
+    U32 m_FramesInFlight = Queue::DefaultFramesInFlight;
+    bool m_PresentWaitSupported = false;
+    bool m_RayTracingSupported = false;
+    DrawPath m_DrawPath = DrawPath::GpuDriven;
+    RenderMode m_RenderMode = RenderMode::Rasterized;
 
-    // Tmp
-    SharedPtr<Model> m_Model;
+    GraphicsPipeline::UniformBufferObject m_Camera = {};
+    std::optional<FixedCamera> m_FixedCamera; // Orbits around the origin when empty
+    U32 m_CameraOffset = 0; // In the transient allocator buffer of the current frame
+    Scene m_Scene;
+    // Positions and indices of the unique meshes, the path tracer flattens them when it's first used. Empty if the
+    // scene was loaded without keeping them.
+    std::vector<MeshData> m_SceneMeshes;
+    std::vector<U32> m_SceneVertexCounts; // Per unique mesh, the BLAS builds need them
+    bool m_KeepSceneMeshes = true;
+    std::vector<glm::vec3> m_MaterialColors;
+    PathTracer m_PathTracer;
+    bool m_PathTracerOutdated = true;
+    bool m_AccelerationStructuresOutdated = true;
 
-    const std::vector<Model::Vertex> m_Vertices = {
-        { { -0.5f, -0.5f }, { 1.0f, 0.0f, 0.0f } },
-        { { 0.5f, -0.5f },  { 0.0f, 1.0f, 0.0f } },
-        { { 0.5f, 0.5f },   { 0.0f, 0.0f, 1.0f } },
-        { { -0.5f, 0.5f },  { 1.0f, 1.0f, 1.0f } }
-    };
+    VkBuffer m_MaterialBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_MaterialBufferMemory = VK_NULL_HANDLE;
+    U32 m_MaterialBufferIndex = BindlessTable::InvalidIndex;
 
-    const std::vector<U32> m_Indices = { 0, 3, 2, 2, 1, 0 };
+    // Tmp
+    SharedPtr<Model> m_Model;
 };
 } // namespace FFV
@@ -23,6 +23,7 @@ Shader::Shader(VkDevice device, const std::string& path) : m_Device(device)
                                                               .pCode = reinterpret_cast<const U32*>(buffer.data()) };
 
     FFV_CHECK_VK_RESULT(vkCreateShaderModule(m_Device, &shaderModuleCreateInfo, VK_NULL_HANDLE, &m_Module));
+    m_Hash = Util::HashBytes(buffer.data(), buffer.size());
 
     SetShaderStageFromName(path);
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "util/Types.h"
+
 #include <string>
 #include <vulkan/vulkan.h>
 
@@ -17,6 +19,7 @@ public:
     VkShaderModule GetShaderModule() const { return m_Module; }
     VkShaderStageFlagBits GetShaderStage() const { return m_ShaderStage; }
     const std::string& GetShaderStageName() const { return m_ShaderStageName; }
+    U64 GetHash() const { return m_Hash; }
 
 private:
     /*
@@ -29,5 +32,6 @@ private:
     VkShaderModule m_Module = VK_NULL_HANDLE;
     VkShaderStageFlagBits m_ShaderStage;
     std::string m_ShaderStageName;
+    U64 m_Hash = 0;
 };
 } // namespace FFV
@@ -0,0 +1,138 @@
+#include "FastFileViewerPCH.h"
+
+#include "StreamingImage.h"
+
+#include "util/Log.h"
+
+namespace FFV
+{
+static void RecordImageBarrier(VkCommandBuffer commandBuffer, VkImage image, VkPipelineStageFlags2 srcStageMask,
+                               VkAccessFlags2 srcAccessMask, VkPipelineStageFlags2 dstStageMask,
+                               VkAccessFlags2 dstAccessMask, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+    const VkImageMemoryBarrier2 imageBarrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .srcStageMask = srcStageMask,
+        .srcAccessMask = srcAccessMask,
+        .dstStageMask = dstStageMask,
+        .dstAccessMask = dstAccessMask,
+        .oldLayout = oldLayout,
+        .newLayout = newLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .levelCount = 1, .layerCount = 1 }
+    };
+
+    const VkDependencyInfo dependencyInfo = { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                              .imageMemoryBarrierCount = 1,
+                                              .pImageMemoryBarriers = &imageBarrier };
+    vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StreamingImage::StreamingImage(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, VkExtent2D extent,
+                               U32 numFrames)
+    : m_Device(device), m_Extent(extent), m_StagingBuffers(numFrames)
+{
+    const VkDeviceSize size = static_cast<VkDeviceSize>(m_Extent.width) * m_Extent.height * 4;
+
+    // Only ever written sequentially by the CPU, so uncached memory is fine
+    for (StagingBuffer& stagingBuffer : m_StagingBuffers)
+    {
+        Util::CreateBuffer(m_Device, physicalDevices, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                           stagingBuffer.Buffer, stagingBuffer.Memory, MemoryCategory::Staging);
+        FFV_CHECK_VK_RESULT(vkMapMemory(m_Device, stagingBuffer.Memory, 0, size, 0, &stagingBuffer.Mapped));
+    }
+
+    Util::CreateImage(m_Device, physicalDevices, m_Extent, Format,
+                      VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Image, m_ImageMemory, MemoryCategory::RenderTarget);
+
+    FFV_TRACE("Created streaming image ({0}x{1}) with {2} staging buffers!", m_Extent.width, m_Extent.height,
+              numFrames);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StreamingImage::~StreamingImage()
+{
+    for (const StagingBuffer& stagingBuffer : m_StagingBuffers)
+    {
+        vkUnmapMemory(m_Device, stagingBuffer.Memory);
+        vkDestroyBuffer(m_Device, stagingBuffer.Buffer, VK_NULL_HANDLE);
+        Util::FreeMemory(m_Device, stagingBuffer.Memory);
+    }
+
+    vkDestroyImage(m_Device, m_Image, VK_NULL_HANDLE);
+    Util::FreeMemory(m_Device, m_ImageMemory);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool StreamingImage::IsBlitSupported(const SharedPtr<PhysicalDevices>& physicalDevices, VkFormat targetFormat)
+{
+    const VkPhysicalDevice physicalDevice = physicalDevices->GetSelectedPhysicalDevice().PhysicalDevice;
+
+    VkFormatProperties sourceProperties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, Format, &sourceProperties);
+    VkFormatProperties targetProperties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, targetFormat, &targetProperties);
+
+    return (sourceProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT) &&
+           (targetProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void StreamingImage::RecordUpload(VkCommandBuffer commandBuffer, U32 frameIndex) const
+{
+    // The image is shared by all frames, the copy only has to wait for the blit of the previous frame to read it
+    RecordImageBarrier(commandBuffer, m_Image, VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_NONE,
+                       VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    const VkBufferImageCopy region = { .bufferOffset = 0,
+                                       .bufferRowLength = 0,
+                                       .bufferImageHeight = 0,
+                                       .imageSubresource = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                                             .mipLevel = 0,
+                                                             .baseArrayLayer = 0,
+                                                             .layerCount = 1 },
+                                       .imageExtent = { m_Extent.width, m_Extent.height, 1 } };
+    vkCmdCopyBufferToImage(commandBuffer, m_StagingBuffers[frameIndex].Buffer, m_Image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    RecordImageBarrier(commandBuffer, m_Image, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                       VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void StreamingImage::RecordBlit(VkCommandBuffer commandBuffer, VkImage targetImage, VkExtent2D targetExtent) const
+{
+    const VkImageSubresourceLayers subresource = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .layerCount = 1 };
+    const VkImageBlit2 region = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_BLIT_2,
+        .srcSubresource = subresource,
+        .srcOffsets = { { 0, 0, 0 },
+                        { static_cast<I32>(m_Extent.width), static_cast<I32>(m_Extent.height), 1 } },
+        .dstSubresource = subresource,
+        .dstOffsets = { { 0, 0, 0 },
+                        { static_cast<I32>(targetExtent.width), static_cast<I32>(targetExtent.height), 1 } }
+    };
+
+    const VkBlitImageInfo2 blitInfo = { .sType = VK_STRUCTURE_TYPE_BLIT_IMAGE_INFO_2,
+                                        .srcImage = m_Image,
+                                        .srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                        .dstImage = targetImage,
+                                        .dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                        .regionCount = 1,
+                                        .pRegions = &region,
+                                        .filter = VK_FILTER_LINEAR };
+    vkCmdBlitImage2(commandBuffer, &blitInfo);
+}
+} // namespace FFV
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "renderer/PhysicalDevice.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * An image the CPU writes every frame, e.g. the output of the CPU path tracer. Every frame in flight has its own
+ * persistently mapped staging buffer, so the CPU fills the next frame while the GPU still copies the previous one. The
+ * copy lands in a device local image, which is blitted onto the render target and converted to its format on the way.
+ */
+class StreamingImage
+{
+public:
+    static constexpr VkFormat Format = VK_FORMAT_R8G8B8A8_SRGB;
+
+public:
+    StreamingImage(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, VkExtent2D extent, U32 numFrames);
+    ~StreamingImage();
+
+    FFV_DELETE_MOVE_COPY(StreamingImage);
+
+    /*
+     * Whether the images of the target format can be the destination of the blit.
+     */
+    static bool IsBlitSupported(const SharedPtr<PhysicalDevices>& physicalDevices, VkFormat targetFormat);
+
+    /*
+     * Tightly packed RGBA rows of the frame's staging buffer. The frame's previous upload has to be complete, which it
+     * is once the frame index gets reused.
+     */
+    U8* GetPixels(U32 frameIndex) const { return static_cast<U8*>(m_StagingBuffers[frameIndex].Mapped); }
+    /*
+     * Copies the staging buffer of the frame into the image.
+     */
+    void RecordUpload(VkCommandBuffer commandBuffer, U32 frameIndex) const;
+    /*
+     * Scales the uploaded image onto the whole target.
+     * @param targetImage: has to be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+     */
+    void RecordBlit(VkCommandBuffer commandBuffer, VkImage targetImage, VkExtent2D targetExtent) const;
+
+    const VkExtent2D& GetExtent() const { return m_Extent; }
+
+private:
+    struct StagingBuffer
+    {
+        VkBuffer Buffer = VK_NULL_HANDLE;
+        VkDeviceMemory Memory = VK_NULL_HANDLE;
+        void* Mapped = nullptr;
+    };
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    VkExtent2D m_Extent = { 0, 0 };
+
+    std::vector<StagingBuffer> m_StagingBuffers;
+    VkImage m_Image = VK_NULL_HANDLE;
+    VkDeviceMemory m_ImageMemory = VK_NULL_HANDLE;
+};
+} // namespace FFV
@@ -5,8 +5,9 @@
 namespace FFV
 {
 Swapchain::Swapchain(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, SharedPtr<Window> window,
-                     VkSurfaceKHR surface, U32 queueFamily)
-    : m_Device(device), m_PhysicalDevices(physicalDevices), m_Window(window), m_Surface(surface), m_QueueFamily(queueFamily)
+                     VkSurfaceKHR surface, U32 queueFamily, PresentPolicy presentPolicy)
+    : m_Device(device), m_PhysicalDevices(physicalDevices), m_Window(window), m_Surface(surface), m_QueueFamily(queueFamily),
+      m_PresentPolicy(presentPolicy)
 {
     CreateSwapchain();
     CreateImageViews();
@@ -14,11 +15,15 @@ Swapchain::Swapchain(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Swapchain::~Swapchain() { CleanSwapchain(); }
+Swapchain::~Swapchain()
+{
+    DestroyRetired(std::numeric_limits<U64>::max());
+    CleanSwapchain();
+}
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Swapchain::Recreate()
+void Swapchain::Recreate(U64 retireFrameNumber)
 {
     I32 width = 0;
     I32 height = 0;
@@ -30,17 +35,51 @@ void Swapchain::Recreate()
         glfwWaitEvents();
     }
 
-    vkDeviceWaitIdle(m_Device);
-
-    CleanSwapchain();
+    // Handing over the old swapchain lets the driver reuse its resources and keeps queued presents valid, so the GPU
+    // doesn't have to drain
+    const VkSwapchainKHR oldSwapchain = m_Swapchain;
+    RetireSwapchain(retireFrameNumber);
 
-    CreateSwapchain();
+    CreateSwapchain(oldSwapchain);
     CreateImageViews();
+
+    m_RecreateRequested = false;
+    m_Generation++;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Swapchain::DestroyRetired(U64 completedFrameNumber)
+{
+    std::erase_if(m_RetiredSwapchains,
+                  [&](const RetiredSwapchain& retired)
+                  {
+                      if (retired.RetireFrameNumber > completedFrameNumber)
+                      {
+                          return false;
+                      }
+
+                      for (const VkImageView imageView : retired.ImageViews)
+                      {
+                          vkDestroyImageView(m_Device, imageView, VK_NULL_HANDLE);
+                      }
+                      vkDestroySwapchainKHR(m_Device, retired.Swapchain, VK_NULL_HANDLE);
+
+                      return true;
+                  });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Swapchain::SetPresentPolicy(PresentPolicy presentPolicy)
+{
+    m_PresentPolicy = presentPolicy;
+    m_RecreateRequested = true;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Swapchain::CreateSwapchain()
+void Swapchain::CreateSwapchain(VkSwapchainKHR oldSwapchain)
 {
     VkSurfaceCapabilitiesKHR surfaceCapabilities;
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_PhysicalDevices->GetSelectedPhysicalDevice().PhysicalDevice, m_Surface,
@@ -49,11 +88,15 @@ void Swapchain::CreateSwapchain()
     m_ImagesInFlight = ChooseNumImages(surfaceCapabilities);
 
     const std::vector<VkPresentModeKHR>& presentModes = m_PhysicalDevices->GetSelectedPhysicalDevice().PresentModes;
-    const VkPresentModeKHR presentMode = ChoosePresentMode(presentModes);
+    m_PresentMode = ChoosePresentMode(presentModes);
 
     m_SurfaceFormat = ChooseSurfaceFormatAndColorSpace(m_PhysicalDevices->GetSelectedPhysicalDevice().SurfaceFormats);
     m_Extent = ChooseSwapchainExtent(surfaceCapabilities);
 
+    // Frames can only be captured when the images can be copied from
+    m_ImageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                   (surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+
     const VkSwapchainCreateInfoKHR swapchainCreateInfo = { .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
                                                            .surface = m_Surface,
                                                            .minImageCount = m_ImagesInFlight,
@@ -61,19 +104,19 @@ void Swapchain::CreateSwapchain()
                                                            .imageColorSpace = m_SurfaceFormat.colorSpace,
                                                            .imageExtent = m_Extent,
                                                            .imageArrayLayers = 1,
-                                                           .imageUsage = (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
-                                                                          VK_IMAGE_USAGE_TRANSFER_DST_BIT),
+                                                           .imageUsage = m_ImageUsage,
                                                            .imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
                                                            .queueFamilyIndexCount = 1,
                                                            .pQueueFamilyIndices = &m_QueueFamily,
                                                            .preTransform = surfaceCapabilities.currentTransform,
                                                            .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
-                                                           .presentMode = presentMode,
-                                                           .clipped = VK_TRUE };
+                                                           .presentMode = m_PresentMode,
+                                                           .clipped = VK_TRUE,
+                                                           .oldSwapchain = oldSwapchain };
 
     FFV_CHECK_VK_RESULT(vkCreateSwapchainKHR(m_Device, &swapchainCreateInfo, VK_NULL_HANDLE, &m_Swapchain));
 
-    FFV_TRACE("Created vulkan swapchain!");
+    FFV_TRACE("Created vulkan swapchain with present mode {0}!", string_VkPresentModeKHR(m_PresentMode));
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -101,6 +144,18 @@ void Swapchain::CreateImageViews()
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Swapchain::RetireSwapchain(U64 retireFrameNumber)
+{
+    m_RetiredSwapchains.push_back(
+        { .Swapchain = m_Swapchain, .ImageViews = std::move(m_ImageViews), .RetireFrameNumber = retireFrameNumber });
+
+    m_Swapchain = VK_NULL_HANDLE;
+    m_ImageViews.clear();
+    m_Images.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Swapchain::CleanSwapchain()
 {
     for (U32 i = 0; i < m_ImageViews.size(); i++)
@@ -159,14 +214,21 @@ U32 Swapchain::ChooseNumImages(const VkSurfaceCapabilitiesKHR& capabilities) con
 
 VkPresentModeKHR Swapchain::ChoosePresentMode(const std::vector<VkPresentModeKHR>& presentModes) const
 {
-    for (const VkPresentModeKHR& presentMode : presentModes)
+    const auto isSupported = [&](VkPresentModeKHR presentMode)
+    { return std::find(presentModes.begin(), presentModes.end(), presentMode) != presentModes.end(); };
+
+    if (m_PresentPolicy == PresentPolicy::Immediate && isSupported(VK_PRESENT_MODE_IMMEDIATE_KHR))
     {
-        if (presentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-        {
-            return presentMode;
-        }
+        return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    }
+
+    if ((m_PresentPolicy == PresentPolicy::Immediate || m_PresentPolicy == PresentPolicy::Mailbox) &&
+        isSupported(VK_PRESENT_MODE_MAILBOX_KHR))
+    {
+        return VK_PRESENT_MODE_MAILBOX_KHR;
     }
 
+    // FIFO is the only mode every implementation has to support
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
@@ -8,26 +8,63 @@
 #include <vector>
 namespace FFV
 {
+/*
+ * Trades throughput against responsiveness, unsupported present modes fall back to the next safer one.
+ */
+enum class PresentPolicy
+{
+    VSync,           // FIFO, never tears, frames can queue up to the number of swapchain images
+    Mailbox,         // Newest frame replaces queued ones, falls back to VSync
+    Immediate,       // May tear, highest throughput and lowest latency, falls back to Mailbox
+    LatencyOptimized // FIFO, the CPU waits for the previous present before it samples input (see FramePacer)
+};
+
 class Swapchain
 {
 public:
     Swapchain(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, SharedPtr<Window> window, VkSurfaceKHR surface,
-              U32 queueFamily);
+              U32 queueFamily, PresentPolicy presentPolicy = PresentPolicy::Mailbox);
     ~Swapchain();
 
     FFV_DELETE_MOVE_COPY(Swapchain);
 
-    void Recreate();
+    /*
+     * The old swapchain is handed to the new one and destroyed with its image views once frames up to
+     * retireFrameNumber completed, see DestroyRetired.
+     * @param retireFrameNumber: the last frame that may still use the old swapchain
+     */
+    void Recreate(U64 retireFrameNumber);
+    /*
+     * Destroys the retired swapchains whose frames completed.
+     */
+    void DestroyRetired(U64 completedFrameNumber);
+    /*
+     * The swapchain gets recreated with the present mode of the policy the next time an image is acquired.
+     */
+    void SetPresentPolicy(PresentPolicy presentPolicy);
 
     const VkExtent2D& GetExtent() const { return m_Extent; }
     const std::vector<VkImage>& GetImages() const { return m_Images; };
     const std::vector<VkImageView>& GetImageViews() const { return m_ImageViews; }
     const VkSwapchainKHR& GetSwapchain() const { return m_Swapchain; }
+    const VkSurfaceFormatKHR& GetSurfaceFormat() const { return m_SurfaceFormat; }
     U32 GetNumImagesInFlight() const { return m_ImagesInFlight; }
+    PresentPolicy GetPresentPolicy() const { return m_PresentPolicy; }
+    VkPresentModeKHR GetPresentMode() const { return m_PresentMode; }
+    bool IsRecreateRequested() const { return m_RecreateRequested; }
+    /*
+     * Whether the images can be copied, which capturing them needs.
+     */
+    bool IsTransferSrcSupported() const { return m_ImageUsage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT; }
+    /*
+     * Changes whenever the swapchain gets recreated, per image resources have to be recreated when it differs.
+     */
+    U64 GetGeneration() const { return m_Generation; }
 
 private:
-    void CreateSwapchain();
+    void CreateSwapchain(VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE);
     void CreateImageViews();
+    void RetireSwapchain(U64 retireFrameNumber);
     void CleanSwapchain();
 
     VkExtent2D ChooseSwapchainExtent(const VkSurfaceCapabilitiesKHR& capabilities) const;
@@ -37,12 +74,22 @@ private:
     VkImageView CreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags,
                                 VkImageViewType viewType, U32 layerCount, U32 mipLevels) const;
 
+private:
+    struct RetiredSwapchain
+    {
+        VkSwapchainKHR Swapchain = VK_NULL_HANDLE;
+        std::vector<VkImageView> ImageViews;
+        U64 RetireFrameNumber = 0;
+    };
+
 private:
     VkDevice m_Device = VK_NULL_HANDLE;
     SharedPtr<PhysicalDevices> m_PhysicalDevices;
     SharedPtr<Window> m_Window;
     VkSurfaceKHR m_Surface = VK_NULL_HANDLE;
     U32 m_QueueFamily = 0;
+    PresentPolicy m_PresentPolicy = PresentPolicy::Mailbox;
+    VkPresentModeKHR m_PresentMode = VK_PRESENT_MODE_FIFO_KHR;
 
     VkSwapchainKHR m_Swapchain = VK_NULL_HANDLE;
     VkExtent2D m_Extent = { 0, 0 };
@@ -50,6 +97,11 @@ private:
     std::vector<VkImageView> m_ImageViews;
 
     VkSurfaceFormatKHR m_SurfaceFormat;
+    VkImageUsageFlags m_ImageUsage = 0;
     U32 m_ImagesInFlight = 0;
+
+    bool m_RecreateRequested = false;
+    U64 m_Generation = 0;
+    std::vector<RetiredSwapchain> m_RetiredSwapchains;
 };
 } // namespace FFV
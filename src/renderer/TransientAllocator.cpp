@@ -0,0 +1,60 @@
+#include "FastFileViewerPCH.h"
+
+#include "TransientAllocator.h"
+
+#include "util/Log.h"
+
+namespace FFV
+{
+TransientAllocator::TransientAllocator(VkDevice device, SharedPtr<PhysicalDevices> physicalDevice, U32 framesInFlight,
+                                       U32 bytesPerFrame)
+    : m_Device(device), m_BytesPerFrame(bytesPerFrame), m_Frames(framesInFlight)
+{
+    const VkDeviceSize alignment =
+        physicalDevice->GetSelectedPhysicalDevice().DeviceProperties.limits.minUniformBufferOffsetAlignment;
+    m_Alignment = std::max(static_cast<U32>(alignment), 1u);
+
+    for (Frame& frame : m_Frames)
+    {
+        Util::CreateBuffer(m_Device, physicalDevice, m_BytesPerFrame, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.Buffer,
+                           frame.Memory, MemoryCategory::Uniform);
+        FFV_CHECK_VK_RESULT(vkMapMemory(m_Device, frame.Memory, 0, m_BytesPerFrame, 0, &frame.Mapped));
+    }
+
+    FFV_TRACE("Created transient allocator with {0} bytes per frame!", m_BytesPerFrame);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TransientAllocator::~TransientAllocator()
+{
+    for (const Frame& frame : m_Frames)
+    {
+        vkUnmapMemory(m_Device, frame.Memory);
+        vkDestroyBuffer(m_Device, frame.Buffer, VK_NULL_HANDLE);
+        Util::FreeMemory(m_Device, frame.Memory);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TransientAllocator::BeginFrame(U32 frameIndex)
+{
+    m_Frames[frameIndex].Offset.store(0, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U32 TransientAllocator::Allocate(U32 frameIndex, U32 size)
+{
+    // The alignment is a power of two, rounding up the size keeps every offset aligned without a compare exchange loop
+    const U32 alignedSize = (size + m_Alignment - 1) & ~(m_Alignment - 1);
+    const U32 offset = m_Frames[frameIndex].Offset.fetch_add(alignedSize, std::memory_order_relaxed);
+
+    FFV_ASSERT(offset + size <= m_BytesPerFrame, "Transient allocator ran out of space for this frame!",
+               return InvalidOffset);
+
+    return offset;
+}
+} // namespace FFV
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "renderer/PhysicalDevice.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <atomic>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * Linear allocator for constants that only live for one frame. Every frame in flight has one persistently mapped
+ * uniform buffer that gets reset in BeginFrame, allocations only bump an offset which is then used as the dynamic offset
+ * of a VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptor. Allocating is thread safe, so draws that are recorded in
+ * parallel can push their own constants.
+ */
+class TransientAllocator
+{
+public:
+    static constexpr U32 InvalidOffset = ~0u;
+
+public:
+    /*
+     * @param bytesPerFrame: capacity of the buffer of each frame in flight
+     */
+    TransientAllocator(VkDevice device, SharedPtr<PhysicalDevices> physicalDevice, U32 framesInFlight,
+                       U32 bytesPerFrame);
+    ~TransientAllocator();
+
+    FFV_DELETE_MOVE_COPY(TransientAllocator);
+
+    /*
+     * Frees all allocations of the frame, the GPU must no longer use its buffer.
+     */
+    void BeginFrame(U32 frameIndex);
+
+    /*
+     * The offset is aligned to minUniformBufferOffsetAlignment.
+     * @return: offset into the buffer of the frame or InvalidOffset when the frame ran out of space
+     */
+    U32 Allocate(U32 frameIndex, U32 size);
+
+    /*
+     * Copies the value into a new allocation.
+     * @return: the dynamic offset of the value
+     */
+    template<typename T>
+    U32 Push(U32 frameIndex, const T& value)
+    {
+        const U32 offset = Allocate(frameIndex, sizeof(T));
+        if (offset != InvalidOffset)
+        {
+            std::memcpy(static_cast<U8*>(m_Frames[frameIndex].Mapped) + offset, &value, sizeof(T));
+        }
+
+        return offset;
+    }
+
+    VkBuffer GetBuffer(U32 frameIndex) const { return m_Frames[frameIndex].Buffer; }
+    U32 GetUsedBytes(U32 frameIndex) const { return m_Frames[frameIndex].Offset.load(std::memory_order_relaxed); }
+
+private:
+    struct Frame
+    {
+        VkBuffer Buffer = VK_NULL_HANDLE;
+        VkDeviceMemory Memory = VK_NULL_HANDLE;
+        void* Mapped = nullptr;
+        std::atomic<U32> Offset = 0;
+    };
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+
+    U32 m_BytesPerFrame = 0;
+    U32 m_Alignment = 1;
+    std::vector<Frame> m_Frames;
+};
+} // namespace FFV
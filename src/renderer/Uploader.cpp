@@ -0,0 +1,163 @@
+#include "FastFileViewerPCH.h"
+
+#include "Uploader.h"
+
+#include "util/Log.h"
+#include "util/Profiler.h"
+
+namespace FFV
+{
+Uploader::Uploader(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, SharedPtr<Queue> queue,
+                   VkCommandPool commandBufferPool)
+    : m_Device(device), m_CommandBufferPool(commandBufferPool), m_PhysicalDevices(physicalDevices), m_Queue(queue)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Uploader::~Uploader()
+{
+    // Copies that never got recorded are dropped, the destinations are destroyed along with the renderer
+    for (const Copy& copy : m_PendingCopies)
+    {
+        DestroyStaging(copy);
+    }
+    for (const Copy& copy : m_RetiredCopies)
+    {
+        DestroyStaging(copy);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Uploader::Upload(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    FFV_PROFILE_FUNCTION();
+
+    Copy copy = { .Buffer = buffer, .Offset = offset, .Size = size };
+    Util::CreateBuffer(m_Device, m_PhysicalDevices, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, copy.StagingBuffer,
+                       copy.StagingMemory, MemoryCategory::Staging);
+
+    void* dataStaging;
+    FFV_CHECK_VK_RESULT(vkMapMemory(m_Device, copy.StagingMemory, 0, size, 0, &dataStaging));
+
+    memcpy(dataStaging, data, size);
+    vkUnmapMemory(m_Device, copy.StagingMemory);
+
+    m_PendingCopies.push_back(copy);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Uploader::RecordCopies(VkCommandBuffer commandBuffer, U64 frameNumber)
+{
+    if (m_PendingCopies.empty())
+    {
+        return;
+    }
+
+    RecordPendingCopies(commandBuffer);
+
+    for (Copy& copy : m_PendingCopies)
+    {
+        copy.RetireFrameNumber = frameNumber;
+        m_RetiredCopies.push_back(copy);
+    }
+    m_PendingCopies.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Uploader::Flush()
+{
+    if (m_PendingCopies.empty())
+    {
+        return;
+    }
+
+    FFV_PROFILE_FUNCTION();
+
+    const VkCommandBufferAllocateInfo commandBufferAllocateInfo = { .sType =
+                                                                        VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                                                                    .commandPool = m_CommandBufferPool,
+                                                                    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                                                                    .commandBufferCount = 1 };
+    VkCommandBuffer commandBuffer;
+    FFV_CHECK_VK_RESULT(vkAllocateCommandBuffers(m_Device, &commandBufferAllocateInfo, &commandBuffer));
+
+    const VkCommandBufferBeginInfo beginInfo = { .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                                 .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT };
+    FFV_CHECK_VK_RESULT(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+    RecordPendingCopies(commandBuffer);
+    FFV_CHECK_VK_RESULT(vkEndCommandBuffer(commandBuffer));
+
+    const VkSubmitInfo submitInfo = { .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                                      .commandBufferCount = 1,
+                                      .pCommandBuffers = &commandBuffer };
+    FFV_CHECK_VK_RESULT(vkQueueSubmit(m_Queue->GetQueue(), 1, &submitInfo, VK_NULL_HANDLE));
+    FFV_CHECK_VK_RESULT(vkQueueWaitIdle(m_Queue->GetQueue()));
+
+    vkFreeCommandBuffers(m_Device, m_CommandBufferPool, 1, &commandBuffer);
+
+    for (const Copy& copy : m_PendingCopies)
+    {
+        DestroyStaging(copy);
+    }
+    m_PendingCopies.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Uploader::DestroyRetired(U64 completedFrameNumber)
+{
+    std::erase_if(m_RetiredCopies,
+                  [&](const Copy& copy)
+                  {
+                      if (copy.RetireFrameNumber > completedFrameNumber)
+                      {
+                          return false;
+                      }
+
+                      DestroyStaging(copy);
+                      return true;
+                  });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Uploader::RecordPendingCopies(VkCommandBuffer commandBuffer) const
+{
+    for (const Copy& copy : m_PendingCopies)
+    {
+        const VkBufferCopy copyRegion = { .srcOffset = 0, .dstOffset = copy.Offset, .size = copy.Size };
+        vkCmdCopyBuffer(commandBuffer, copy.StagingBuffer, copy.Buffer, 1, &copyRegion);
+    }
+
+    // The destinations are read as vertices, indices, indirect commands or storage buffers, and a later upload may
+    // overwrite a range that was freed in between
+    const VkMemoryBarrier2 uploadBarrier = { .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                             .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                                             .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                             .dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                                             .dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT |
+                                                              VK_ACCESS_2_MEMORY_WRITE_BIT };
+    const VkDependencyInfo dependencyInfo = { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                              .memoryBarrierCount = 1,
+                                              .pMemoryBarriers = &uploadBarrier };
+    vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Uploader::DestroyStaging(const Copy& copy) const
+{
+    vkDestroyBuffer(m_Device, copy.StagingBuffer, VK_NULL_HANDLE);
+    Util::FreeMemory(m_Device, copy.StagingMemory);
+}
+} // namespace FFV
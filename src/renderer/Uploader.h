@@ -0,0 +1,70 @@
+#pragma once
+
+#include "renderer/PhysicalDevice.h"
+#include "renderer/Queue.h"
+#include "util/Types.h"
+#include "util/Util.h"
+
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * Uploads buffer data without waiting for the GPU. The data is copied into a staging buffer of its own right away, the
+ * copies are recorded at the start of the next frame and the staging buffers are freed once the frame timeline says
+ * that frame completed. Destination buffers may only be read by that frame and the ones after it.
+ */
+class Uploader
+{
+public:
+    Uploader(VkDevice device, SharedPtr<PhysicalDevices> physicalDevices, SharedPtr<Queue> queue,
+             VkCommandPool commandBufferPool);
+    ~Uploader();
+
+    FFV_DELETE_MOVE_COPY(Uploader);
+
+    /*
+     * @param offset: byte offset into buffer, which needs VK_BUFFER_USAGE_TRANSFER_DST_BIT
+     */
+    void Upload(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size);
+
+    /*
+     * Records the pending copies and a barrier that makes them visible to every command after it.
+     * @param frameNumber: timeline value of the frame the command buffer is submitted with
+     */
+    void RecordCopies(VkCommandBuffer commandBuffer, U64 frameNumber);
+    /*
+     * Submits the pending copies on their own and waits for them, for GPU work that runs outside of a frame.
+     */
+    void Flush();
+
+    void DestroyRetired(U64 completedFrameNumber);
+
+    bool HasPendingCopies() const { return !m_PendingCopies.empty(); }
+
+private:
+    struct Copy
+    {
+        VkBuffer StagingBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory StagingMemory = VK_NULL_HANDLE;
+        VkBuffer Buffer = VK_NULL_HANDLE;
+        VkDeviceSize Offset = 0;
+        VkDeviceSize Size = 0;
+        U64 RetireFrameNumber = 0;
+    };
+
+private:
+    void RecordPendingCopies(VkCommandBuffer commandBuffer) const;
+    void DestroyStaging(const Copy& copy) const;
+
+private:
+    VkDevice m_Device = VK_NULL_HANDLE;
+    VkCommandPool m_CommandBufferPool = VK_NULL_HANDLE;
+    SharedPtr<PhysicalDevices> m_PhysicalDevices;
+    SharedPtr<Queue> m_Queue;
+
+    std::vector<Copy> m_PendingCopies;
+    std::vector<Copy> m_RetiredCopies;
+};
+} // namespace FFV
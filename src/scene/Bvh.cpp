@@ -0,0 +1,633 @@
+#include "FastFileViewerPCH.h"
+
+#include "Bvh.h"
+
+#include "util/JobSystem.h"
+#include "util/Profiler.h"
+
+#include <chrono>
+#include <cmath>
+
+namespace FFV
+{
+static constexpr U32 s_BinCount = 32;
+static constexpr U32 s_MinBinCount = 8;
+// Relative to testing one triangle
+static constexpr F32 s_TraversalCost = 1.0f;
+
+// Triangles per job while setting up the references, and the least a job bins at the top levels
+static constexpr U32 s_ChunkSize = 16 * 1024;
+// The top levels stop once the ranges are small enough for this many subtrees per thread, which balances the load
+static constexpr U32 s_SubtreesPerThread = 16;
+static constexpr U32 s_MinSubtreeSize = 4 * 1024;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Möller-Trumbore, both sides count as hits since the meshes aren't guaranteed to be closed or consistently wound.
+ */
+static bool IntersectTriangle(const Bvh::Ray& ray, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c,
+                              F32 maxDistance, F32& distance, glm::vec2& barycentrics)
+{
+    const glm::vec3 edge1 = b - a;
+    const glm::vec3 edge2 = c - a;
+    const glm::vec3 p = glm::cross(ray.Direction, edge2);
+    const F32 determinant = glm::dot(edge1, p);
+    if (determinant == 0.0f)
+    {
+        return false;
+    }
+
+    const F32 inverseDeterminant = 1.0f / determinant;
+    const glm::vec3 s = ray.Origin - a;
+    const F32 u = glm::dot(s, p) * inverseDeterminant;
+    if (u < 0.0f || u > 1.0f)
+    {
+        return false;
+    }
+
+    const glm::vec3 q = glm::cross(s, edge1);
+    const F32 v = glm::dot(ray.Direction, q) * inverseDeterminant;
+    if (v < 0.0f || u + v > 1.0f)
+    {
+        return false;
+    }
+
+    const F32 t = glm::dot(edge2, q) * inverseDeterminant;
+    if (t < 0.0f || t >= maxDistance)
+    {
+        return false;
+    }
+
+    distance = t;
+    barycentrics = glm::vec2(u, v);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Bvh::Bvh(const std::vector<glm::vec3>& positions, const std::vector<U32>& indices)
+{
+    FFV_PROFILE_FUNCTION();
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    const U32 triangleCount = static_cast<U32>(indices.size() / 3);
+    m_Stats.TriangleCount = triangleCount;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    std::vector<Reference> references(triangleCount);
+    const U32 chunkCount = (triangleCount + s_ChunkSize - 1) / s_ChunkSize;
+    std::vector<BuildRange> chunkRanges(chunkCount);
+    JobSystem::ParallelFor(chunkCount,
+                           [&](U32 chunk, U32)
+                           {
+                               BuildRange& chunkRange = chunkRanges[chunk];
+                               const U32 end = std::min((chunk + 1) * s_ChunkSize, triangleCount);
+                               for (U32 triangle = chunk * s_ChunkSize; triangle < end; triangle++)
+                               {
+                                   const glm::vec3& a = positions[indices[triangle * 3]];
+                                   const glm::vec3& b = positions[indices[triangle * 3 + 1]];
+                                   const glm::vec3& c = positions[indices[triangle * 3 + 2]];
+
+                                   Reference& reference = references[triangle];
+                                   reference = { .Min = glm::min(glm::min(a, b), c),
+                                                 .TriangleIndex = triangle,
+                                                 .Max = glm::max(glm::max(a, b), c) };
+                                   chunkRange.TriangleBounds.Grow(reference.Min);
+                                   chunkRange.TriangleBounds.Grow(reference.Max);
+                                   chunkRange.CentroidBounds.Grow((reference.Min + reference.Max) * 0.5f);
+                               }
+                           });
+
+    BuildRange root = { .Begin = 0, .End = triangleCount };
+    for (const BuildRange& chunkRange : chunkRanges)
+    {
+        root.TriangleBounds.Grow(chunkRange.TriangleBounds);
+        root.CentroidBounds.Grow(chunkRange.CentroidBounds);
+    }
+    m_Bounds = root.TriangleBounds;
+
+    const U32 subtreeThreshold = triangleCount / (JobSystem::GetNumThreads() * s_SubtreesPerThread);
+    TopLevel topLevel = { .SubtreeThreshold = std::max(subtreeThreshold, s_MinSubtreeSize) };
+
+    BuildRange left;
+    BuildRange right;
+    if (Split(references, root, true, left, right))
+    {
+        BuildNode(m_Nodes, references, left, right, &topLevel);
+    }
+    else
+    {
+        m_Nodes.push_back(CreateEmptyNode());
+        SetChild(m_Nodes[0], 0, root.TriangleBounds, 0, triangleCount);
+    }
+
+    // Largest first, so the small subtrees fill the gaps at the end
+    std::vector<SubtreeTask>& tasks = topLevel.Tasks;
+    std::sort(tasks.begin(), tasks.end(),
+              [](const SubtreeTask& a, const SubtreeTask& b) { return a.Range.GetCount() > b.Range.GetCount(); });
+
+    std::vector<std::vector<Node>> subtreeNodes(tasks.size());
+    JobSystem::ParallelFor(static_cast<U32>(tasks.size()),
+                           [&](U32 taskIndex, U32)
+                           {
+                               BuildRange subtreeLeft;
+                               BuildRange subtreeRight;
+                               if (Split(references, tasks[taskIndex].Range, false, subtreeLeft, subtreeRight))
+                               {
+                                   BuildNode(subtreeNodes[taskIndex], references, subtreeLeft, subtreeRight, nullptr);
+                               }
+                           });
+
+    // The subtrees go behind the top levels, their node indices only have to be offset
+    std::vector<U32> subtreeOffsets(tasks.size());
+    U32 nodeCount = static_cast<U32>(m_Nodes.size());
+    for (U32 taskIndex = 0; taskIndex < tasks.size(); taskIndex++)
+    {
+        const SubtreeTask& task = tasks[taskIndex];
+        subtreeOffsets[taskIndex] = nodeCount;
+        if (subtreeNodes[taskIndex].empty())
+        {
+            SetChild(m_Nodes[task.NodeIndex], task.Slot, task.Range.TriangleBounds, task.Range.Begin,
+                     task.Range.GetCount());
+        }
+        else
+        {
+            m_Nodes[task.NodeIndex].Children[task.Slot] = nodeCount;
+            nodeCount += static_cast<U32>(subtreeNodes[taskIndex].size());
+        }
+    }
+
+    m_Nodes.resize(nodeCount);
+    JobSystem::ParallelFor(static_cast<U32>(tasks.size()),
+                           [&](U32 taskIndex, U32)
+                           {
+                               const U32 offset = subtreeOffsets[taskIndex];
+                               const std::vector<Node>& nodes = subtreeNodes[taskIndex];
+                               for (U32 i = 0; i < nodes.size(); i++)
+                               {
+                                   Node& node = m_Nodes[offset + i];
+                                   node = nodes[i];
+                                   for (U32 slot = 0; slot < Width; slot++)
+                                   {
+                                       if (node.IsUsed(slot) && !node.IsLeaf(slot))
+                                       {
+                                           node.Children[slot] += offset;
+                                       }
+                                   }
+                               }
+                               subtreeNodes[taskIndex] = {};
+                           });
+
+    m_TriangleIndices.resize(triangleCount);
+    JobSystem::ParallelFor(chunkCount,
+                           [&](U32 chunk, U32)
+                           {
+                               const U32 end = std::min((chunk + 1) * s_ChunkSize, triangleCount);
+                               for (U32 i = chunk * s_ChunkSize; i < end; i++)
+                               {
+                                   m_TriangleIndices[i] = references[i].TriangleIndex;
+                               }
+                           });
+
+    m_Stats.SubtreeCount = static_cast<U32>(tasks.size());
+    m_Stats.BuildMs =
+        std::chrono::duration<F64, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    ComputeStats();
+
+    // Trace level since the import benchmark builds one per mesh, callers log the stats they care about
+    FFV_TRACE("Built a BVH over {0} triangles in {1:.2f} ms: {2} nodes, {3} leaves, {4} subtrees, {5:.1f} MB, SAH cost "
+              "{6:.2f}",
+              triangleCount, m_Stats.BuildMs, m_Stats.NodeCount, m_Stats.LeafCount, m_Stats.SubtreeCount,
+              GetSizeInBytes() / (1024.0 * 1024.0), m_Stats.SahCost);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<Bvh::Hit> Bvh::Intersect(const Ray& ray, const std::vector<glm::vec3>& positions,
+                                       const std::vector<U32>& indices) const
+{
+    if (m_Nodes.empty())
+    {
+        return std::nullopt;
+    }
+
+    const glm::vec3 inverseDirection = 1.0f / ray.Direction;
+    F32 maxDistance = ray.MaxDistance;
+    std::optional<Hit> closestHit;
+
+    std::vector<U32> stack = { 0 };
+    while (!stack.empty())
+    {
+        const Node& node = m_Nodes[stack.back()];
+        stack.pop_back();
+
+        for (U32 slot = 0; slot < Width; slot++)
+        {
+            if (!node.IsUsed(slot))
+            {
+                continue;
+            }
+
+            const glm::vec3 t0 =
+                (glm::vec3(node.MinX[slot], node.MinY[slot], node.MinZ[slot]) - ray.Origin) * inverseDirection;
+            const glm::vec3 t1 =
+                (glm::vec3(node.MaxX[slot], node.MaxY[slot], node.MaxZ[slot]) - ray.Origin) * inverseDirection;
+            const glm::vec3 tNear = glm::min(t0, t1);
+            const glm::vec3 tFar = glm::max(t0, t1);
+            if (std::max({ tNear.x, tNear.y, tNear.z, 0.0f }) > std::min({ tFar.x, tFar.y, tFar.z, maxDistance }))
+            {
+                continue;
+            }
+
+            if (!node.IsLeaf(slot))
+            {
+                stack.push_back(node.Children[slot]);
+                continue;
+            }
+
+            const U32 end = node.Children[slot] + node.TriangleCounts[slot];
+            for (U32 i = node.Children[slot]; i < end; i++)
+            {
+                const U32 triangle = m_TriangleIndices[i];
+                F32 distance = 0.0f;
+                glm::vec2 barycentrics;
+                if (IntersectTriangle(ray, positions[indices[triangle * 3]], positions[indices[triangle * 3 + 1]],
+                                      positions[indices[triangle * 3 + 2]], maxDistance, distance, barycentrics))
+                {
+                    maxDistance = distance;
+                    closestHit = Hit{ .Distance = distance, .TriangleIndex = triangle, .Barycentrics = barycentrics };
+                }
+            }
+        }
+    }
+
+    return closestHit;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Bvh::Split(std::vector<Reference>& references, const BuildRange& range, bool parallel, BuildRange& left,
+                BuildRange& right)
+{
+    const U32 count = range.GetCount();
+    if (count <= 1)
+    {
+        return false;
+    }
+
+    // Trivial, so only the bins in use get initialized. Most splits are small and only need a few.
+    struct Bin
+    {
+        glm::vec3 Min;
+        glm::vec3 Max;
+        U32 Count;
+
+        Bounds GetBounds() const { return { .Min = Min, .Max = Max }; }
+    };
+    using Bins = std::array<std::array<Bin, s_BinCount>, 3>;
+
+    const U32 binCount = std::clamp(count, s_MinBinCount, s_BinCount);
+    const auto resetBins = [&](Bins& bins)
+    {
+        for (U32 axis = 0; axis < 3; axis++)
+        {
+            for (U32 binIndex = 0; binIndex < binCount; binIndex++)
+            {
+                const Bounds empty;
+                bins[axis][binIndex] = { .Min = empty.Min, .Max = empty.Max, .Count = 0 };
+            }
+        }
+    };
+
+    // Axes without extent can't be split, their scale stays 0
+    const glm::vec3 centroidMin = range.CentroidBounds.Min;
+    const glm::vec3 centroidExtent = range.CentroidBounds.Max - centroidMin;
+    glm::vec3 scale(0.0f);
+    for (U32 axis = 0; axis < 3; axis++)
+    {
+        const F32 axisScale = static_cast<F32>(binCount) / centroidExtent[axis];
+        scale[axis] = centroidExtent[axis] > 0.0f && std::isfinite(axisScale) ? axisScale : 0.0f;
+    }
+
+    // Binning and partitioning have to compute the same index
+    const auto getBinIndex = [&](const Reference& reference, U32 axis)
+    {
+        const F32 centroid = (reference.Min[axis] + reference.Max[axis]) * 0.5f;
+        return std::min(static_cast<U32>((centroid - centroidMin[axis]) * scale[axis]), binCount - 1);
+    };
+    const auto binReferences = [&](U32 begin, U32 end, Bins& bins)
+    {
+        for (U32 i = begin; i < end; i++)
+        {
+            const Reference& reference = references[i];
+            for (U32 axis = 0; axis < 3; axis++)
+            {
+                if (scale[axis] > 0.0f)
+                {
+                    Bin& bin = bins[axis][getBinIndex(reference, axis)];
+                    bin.Min = glm::min(bin.Min, reference.Min);
+                    bin.Max = glm::max(bin.Max, reference.Max);
+                    bin.Count++;
+                }
+            }
+        }
+    };
+
+    Bins bins;
+    resetBins(bins);
+    const U32 chunkCount = parallel ? std::min(count / s_ChunkSize, JobSystem::GetNumThreads() * 4) : 1;
+    if (chunkCount > 1)
+    {
+        std::vector<Bins> chunkBins(chunkCount);
+        JobSystem::ParallelFor(chunkCount,
+                               [&](U32 chunk, U32)
+                               {
+                                   const U32 begin = range.Begin + static_cast<U32>(static_cast<U64>(count) * chunk /
+                                                                                    chunkCount);
+                                   const U32 end = range.Begin + static_cast<U32>(static_cast<U64>(count) *
+                                                                                  (chunk + 1) / chunkCount);
+                                   resetBins(chunkBins[chunk]);
+                                   binReferences(begin, end, chunkBins[chunk]);
+                               });
+
+        for (const Bins& chunk : chunkBins)
+        {
+            for (U32 axis = 0; axis < 3; axis++)
+            {
+                for (U32 binIndex = 0; binIndex < binCount; binIndex++)
+                {
+                    Bin& bin = bins[axis][binIndex];
+                    bin.Min = glm::min(bin.Min, chunk[axis][binIndex].Min);
+                    bin.Max = glm::max(bin.Max, chunk[axis][binIndex].Max);
+                    bin.Count += chunk[axis][binIndex].Count;
+                }
+            }
+        }
+    }
+    else
+    {
+        binReferences(range.Begin, range.End, bins);
+    }
+
+    // Sweeps from the right to get the cost of every right side, then from the left to evaluate the splits
+    F32 bestCost = std::numeric_limits<F32>::max();
+    U32 bestAxis = InvalidIndex;
+    U32 bestBin = 0; // First bin of the right side
+    for (U32 axis = 0; axis < 3; axis++)
+    {
+        if (scale[axis] == 0.0f)
+        {
+            continue;
+        }
+
+        std::array<F32, s_BinCount> rightCosts;
+        Bounds rightBounds;
+        U32 rightCount = 0;
+        for (U32 binIndex = binCount - 1; binIndex > 0; binIndex--)
+        {
+            rightBounds.Grow(bins[axis][binIndex].GetBounds());
+            rightCount += bins[axis][binIndex].Count;
+            rightCosts[binIndex] = rightBounds.GetHalfArea() * static_cast<F32>(rightCount);
+        }
+
+        Bounds leftBounds;
+        U32 leftCount = 0;
+        for (U32 binIndex = 1; binIndex < binCount; binIndex++)
+        {
+            leftBounds.Grow(bins[axis][binIndex - 1].GetBounds());
+            leftCount += bins[axis][binIndex - 1].Count;
+            if (leftCount == 0 || leftCount == count)
+            {
+                continue;
+            }
+
+            const F32 cost = leftBounds.GetHalfArea() * static_cast<F32>(leftCount) + rightCosts[binIndex];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = binIndex;
+            }
+        }
+    }
+
+    if (bestAxis == InvalidIndex)
+    {
+        // All centroids are in one bin, only splitting by count is left
+        if (count <= MaxLeafSize)
+        {
+            return false;
+        }
+
+        const U32 middle = range.Begin + count / 2;
+        left = { .Begin = range.Begin, .End = middle };
+        right = { .Begin = middle, .End = range.End };
+        for (BuildRange* half : { &left, &right })
+        {
+            for (U32 i = half->Begin; i < half->End; i++)
+            {
+                half->TriangleBounds.Grow(references[i].Min);
+                half->TriangleBounds.Grow(references[i].Max);
+                half->CentroidBounds.Grow((references[i].Min + references[i].Max) * 0.5f);
+            }
+        }
+        return true;
+    }
+
+    const F32 parentArea = range.TriangleBounds.GetHalfArea();
+    const F32 splitCost = s_TraversalCost + (parentArea > 0.0f ? bestCost / parentArea : 0.0f);
+    if (count <= MaxLeafSize && splitCost >= static_cast<F32>(count))
+    {
+        return false;
+    }
+
+    // Looks at every reference once and collects the centroid bounds of both sides on the way, the triangle bounds are
+    // already known from the bins
+    left = {};
+    right = {};
+    U32 begin = range.Begin;
+    U32 end = range.End;
+    while (begin < end)
+    {
+        const glm::vec3 centroid = (references[begin].Min + references[begin].Max) * 0.5f;
+        if (getBinIndex(references[begin], bestAxis) < bestBin)
+        {
+            left.CentroidBounds.Grow(centroid);
+            begin++;
+        }
+        else
+        {
+            right.CentroidBounds.Grow(centroid);
+            std::swap(references[begin], references[--end]);
+        }
+    }
+
+    left.Begin = range.Begin;
+    left.End = begin;
+    right.Begin = begin;
+    right.End = range.End;
+    for (U32 binIndex = 0; binIndex < binCount; binIndex++)
+    {
+        Bounds& bounds = binIndex < bestBin ? left.TriangleBounds : right.TriangleBounds;
+        bounds.Grow(bins[bestAxis][binIndex].GetBounds());
+    }
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U32 Bvh::BuildNode(std::vector<Node>& nodes, std::vector<Reference>& references, const BuildRange& left,
+                   const BuildRange& right, TopLevel* topLevel)
+{
+    struct Child
+    {
+        BuildRange Range;
+        bool Leaf = false; // Splitting it failed
+    };
+
+    std::array<Child, Width> children = { Child{ .Range = left }, Child{ .Range = right } };
+    U32 childCount = 2;
+
+    // Splits the child with the largest surface until the node is full, like collapsing a binary SAH tree would
+    while (childCount < Width)
+    {
+        U32 largest = InvalidIndex;
+        F32 largestArea = -1.0f;
+        for (U32 i = 0; i < childCount; i++)
+        {
+            const F32 area = children[i].Range.TriangleBounds.GetHalfArea();
+            if (!children[i].Leaf && area > largestArea)
+            {
+                largest = i;
+                largestArea = area;
+            }
+        }
+
+        if (largest == InvalidIndex)
+        {
+            break;
+        }
+
+        BuildRange childLeft;
+        BuildRange childRight;
+        const bool parallel = topLevel && children[largest].Range.GetCount() >= topLevel->SubtreeThreshold;
+        if (!Split(references, children[largest].Range, parallel, childLeft, childRight))
+        {
+            children[largest].Leaf = true;
+            continue;
+        }
+
+        children[largest] = { .Range = childLeft };
+        children[childCount++] = { .Range = childRight };
+    }
+
+    const U32 nodeIndex = static_cast<U32>(nodes.size());
+    nodes.push_back(CreateEmptyNode());
+
+    for (U32 slot = 0; slot < childCount; slot++)
+    {
+        const BuildRange& range = children[slot].Range;
+        if (topLevel && !children[slot].Leaf && range.GetCount() < topLevel->SubtreeThreshold)
+        {
+            // The child gets linked once the subtree is built
+            SetChild(nodes[nodeIndex], slot, range.TriangleBounds, InvalidIndex, 0);
+            topLevel->Tasks.push_back({ .NodeIndex = nodeIndex, .Slot = slot, .Range = range });
+            continue;
+        }
+
+        BuildRange childLeft;
+        BuildRange childRight;
+        if (children[slot].Leaf || !Split(references, range, topLevel != nullptr, childLeft, childRight))
+        {
+            SetChild(nodes[nodeIndex], slot, range.TriangleBounds, range.Begin, range.GetCount());
+            continue;
+        }
+
+        // The recursion can reallocate the nodes, so the parent is only accessed by index
+        const U32 childIndex = BuildNode(nodes, references, childLeft, childRight, topLevel);
+        SetChild(nodes[nodeIndex], slot, range.TriangleBounds, childIndex, 0);
+    }
+
+    return nodeIndex;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Bvh::Node Bvh::CreateEmptyNode()
+{
+    Node node;
+    node.MinX.fill(std::numeric_limits<F32>::max());
+    node.MinY.fill(std::numeric_limits<F32>::max());
+    node.MinZ.fill(std::numeric_limits<F32>::max());
+    node.MaxX.fill(-std::numeric_limits<F32>::max());
+    node.MaxY.fill(-std::numeric_limits<F32>::max());
+    node.MaxZ.fill(-std::numeric_limits<F32>::max());
+    node.Children.fill(InvalidIndex);
+    node.TriangleCounts.fill(0);
+    return node;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Bvh::SetChild(Node& node, U32 slot, const Bounds& bounds, U32 child, U32 triangleCount)
+{
+    node.MinX[slot] = bounds.Min.x;
+    node.MinY[slot] = bounds.Min.y;
+    node.MinZ[slot] = bounds.Min.z;
+    node.MaxX[slot] = bounds.Max.x;
+    node.MaxY[slot] = bounds.Max.y;
+    node.MaxZ[slot] = bounds.Max.z;
+    node.Children[slot] = child;
+    node.TriangleCounts[slot] = triangleCount;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Bvh::ComputeStats()
+{
+    // A ray hits a box with a probability proportional to its surface. Every child slot is either a node that has to
+    // be traversed or a leaf whose triangles have to be tested, the root is always traversed.
+    const F64 rootArea = std::max(static_cast<F64>(m_Bounds.GetHalfArea()), 1e-30);
+    F64 cost = s_TraversalCost;
+    U32 leafCount = 0;
+
+    // Parents are always stored before their children, so the depths are known when a node is reached
+    std::vector<U32> depths(m_Nodes.size(), 1);
+    U32 maxDepth = 0;
+    for (U32 nodeIndex = 0; nodeIndex < m_Nodes.size(); nodeIndex++)
+    {
+        const Node& node = m_Nodes[nodeIndex];
+        maxDepth = std::max(maxDepth, depths[nodeIndex]);
+        for (U32 slot = 0; slot < Width; slot++)
+        {
+            if (!node.IsUsed(slot))
+            {
+                continue;
+            }
+
+            const Bounds bounds = { .Min = glm::vec3(node.MinX[slot], node.MinY[slot], node.MinZ[slot]),
+                                    .Max = glm::vec3(node.MaxX[slot], node.MaxY[slot], node.MaxZ[slot]) };
+            const F64 probability = bounds.GetHalfArea() / rootArea;
+            if (node.IsLeaf(slot))
+            {
+                cost += probability * node.TriangleCounts[slot];
+                leafCount++;
+            }
+            else
+            {
+                cost += probability * s_TraversalCost;
+                depths[node.Children[slot]] = depths[nodeIndex] + 1;
+            }
+        }
+    }
+
+    m_Stats.NodeCount = static_cast<U32>(m_Nodes.size());
+    m_Stats.LeafCount = leafCount;
+    m_Stats.MaxDepth = maxDepth;
+    m_Stats.SahCost = cost;
+}
+} // namespace FFV
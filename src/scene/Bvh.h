@@ -0,0 +1,187 @@
+#pragma once
+
+#include "util/Types.h"
+
+#include <array>
+#include <glm/glm.hpp>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace FFV
+{
+/*
+ * Bounding volume hierarchy over triangles for ray queries on the CPU, the base for picking and ray tracing.
+ * It's built top down with binned SAH: every node takes the best binned split of its triangles and then splits its
+ * largest child again until it has 4 children, so the 4-wide nodes come out directly without a binary tree in between.
+ * The top levels bin in parallel, the subtrees below them are built as independent jobs and appended afterwards.
+ * Leaves aren't nodes of their own, a child slot points to a range of triangles instead.
+ */
+class Bvh
+{
+public:
+    static constexpr U32 Width = 4;
+    static constexpr U32 MaxLeafSize = 4;
+    static constexpr U32 InvalidIndex = ~0u;
+
+    struct Bounds
+    {
+        glm::vec3 Min = glm::vec3(std::numeric_limits<F32>::max());
+        glm::vec3 Max = glm::vec3(-std::numeric_limits<F32>::max());
+
+        void Grow(const glm::vec3& point)
+        {
+            Min = glm::min(Min, point);
+            Max = glm::max(Max, point);
+        }
+        void Grow(const Bounds& bounds)
+        {
+            Min = glm::min(Min, bounds.Min);
+            Max = glm::max(Max, bounds.Max);
+        }
+
+        bool IsEmpty() const { return Min.x > Max.x; }
+        /*
+         * Half the surface area, the SAH only compares ratios.
+         */
+        F32 GetHalfArea() const
+        {
+            const glm::vec3 extent = glm::max(Max - Min, glm::vec3(0.0f));
+            return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+        }
+    };
+
+    /*
+     * The bounds of all children are stored as structure of arrays, so a single SIMD test covers the whole node.
+     * Exactly two cache lines. Unused slots have inverted bounds, which no ray can hit.
+     */
+    struct alignas(64) Node
+    {
+        std::array<F32, Width> MinX;
+        std::array<F32, Width> MinY;
+        std::array<F32, Width> MinZ;
+        std::array<F32, Width> MaxX;
+        std::array<F32, Width> MaxY;
+        std::array<F32, Width> MaxZ;
+        std::array<U32, Width> Children;       // Node index, first entry of GetTriangleIndices() for leaves
+        std::array<U32, Width> TriangleCounts; // 0 for inner children and unused slots
+
+        bool IsLeaf(U32 slot) const { return TriangleCounts[slot] > 0; }
+        bool IsUsed(U32 slot) const { return Children[slot] != InvalidIndex; }
+    };
+
+    struct Stats
+    {
+        U32 TriangleCount = 0;
+        U32 NodeCount = 0;
+        U32 LeafCount = 0;
+        U32 SubtreeCount = 0; // Built as independent jobs
+        U32 MaxDepth = 0;     // Nodes on the longest path from the root, bounds the traversal stack
+        // Expected cost of a random ray relative to testing one triangle, lower is better
+        F64 SahCost = 0.0;
+        F64 BuildMs = 0.0;
+    };
+
+    struct Ray
+    {
+        glm::vec3 Origin = glm::vec3(0.0f);
+        glm::vec3 Direction = glm::vec3(0.0f, 0.0f, 1.0f);
+        F32 MaxDistance = std::numeric_limits<F32>::max();
+    };
+
+    struct Hit
+    {
+        F32 Distance = 0.0f;
+        U32 TriangleIndex = 0;
+        glm::vec2 Barycentrics = glm::vec2(0.0f); // Weights of the second and third vertex
+    };
+
+public:
+    Bvh() = default;
+    /*
+     * Runs on the job system, the stats get logged.
+     * @param indices: three per triangle, the geometry isn't copied and has to be passed again for queries
+     */
+    Bvh(const std::vector<glm::vec3>& positions, const std::vector<U32>& indices);
+
+    /*
+     * Closest hit along the ray, for picking and other single queries.
+     * @param positions, indices: the geometry the hierarchy was built for
+     */
+    std::optional<Hit> Intersect(const Ray& ray, const std::vector<glm::vec3>& positions,
+                                 const std::vector<U32>& indices) const;
+
+    bool IsEmpty() const { return m_Nodes.empty(); }
+    /*
+     * The root is the first node.
+     */
+    const std::vector<Node>& GetNodes() const { return m_Nodes; }
+    /*
+     * Triangles in leaf order, leaves reference ranges of this.
+     */
+    const std::vector<U32>& GetTriangleIndices() const { return m_TriangleIndices; }
+    const Bounds& GetBounds() const { return m_Bounds; }
+    const Stats& GetStats() const { return m_Stats; }
+    U64 GetSizeInBytes() const { return m_Nodes.size() * sizeof(Node) + m_TriangleIndices.size() * sizeof(U32); }
+
+private:
+    // 28 bytes, partitioning moves these instead of indices into a separate bounds array to stay cache friendly
+    struct Reference
+    {
+        glm::vec3 Min;
+        U32 TriangleIndex;
+        glm::vec3 Max;
+    };
+
+    // Consecutive references with the bounds of the triangles and of their centroids
+    struct BuildRange
+    {
+        U32 Begin = 0;
+        U32 End = 0;
+        Bounds TriangleBounds;
+        Bounds CentroidBounds;
+
+        U32 GetCount() const { return End - Begin; }
+    };
+
+    struct SubtreeTask
+    {
+        U32 NodeIndex = 0;
+        U32 Slot = 0;
+        BuildRange Range;
+    };
+
+    // Top levels of the build, nullptr while building a subtree
+    struct TopLevel
+    {
+        std::vector<SubtreeTask> Tasks;
+        U32 SubtreeThreshold = 0; // Smaller ranges become subtree tasks
+    };
+
+private:
+    /*
+     * Binned SAH over all three axes, partitions the references of the range on success.
+     * Splits that are more expensive than a leaf are only taken when the range is too large for one.
+     * @param parallel: bins on the job system, for the large ranges at the top
+     * @return false if the range should become a leaf
+     */
+    static bool Split(std::vector<Reference>& references, const BuildRange& range, bool parallel, BuildRange& left,
+                      BuildRange& right);
+    /*
+     * Builds the node for a range that was split into left and right, and everything below it.
+     * @return index of the node
+     */
+    static U32 BuildNode(std::vector<Node>& nodes, std::vector<Reference>& references, const BuildRange& left,
+                         const BuildRange& right, TopLevel* topLevel);
+
+    static Node CreateEmptyNode();
+    static void SetChild(Node& node, U32 slot, const Bounds& bounds, U32 child, U32 triangleCount);
+    void ComputeStats();
+
+private:
+    std::vector<Node> m_Nodes;
+    std::vector<U32> m_TriangleIndices;
+    Bounds m_Bounds;
+    Stats m_Stats;
+};
+} // namespace FFV
@@ -0,0 +1,131 @@
+#include "FastFileViewerPCH.h"
+
+#include "MeshGenerator.h"
+
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+
+namespace FFV
+{
+MeshData MeshGenerator::CreateQuad()
+{
+    MeshData mesh;
+    mesh.Positions = { { -0.5f, -0.5f, 0.0f }, { 0.5f, -0.5f, 0.0f }, { 0.5f, 0.5f, 0.0f }, { -0.5f, 0.5f, 0.0f } };
+    mesh.Normals.assign(4, glm::vec3(0.0f, 0.0f, 1.0f));
+    mesh.Indices = { 0, 1, 2, 2, 3, 0 };
+    return mesh;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MeshData MeshGenerator::CreateCube()
+{
+    MeshData mesh;
+    mesh.Positions.reserve(24);
+    mesh.Normals.reserve(24);
+    mesh.Indices.reserve(36);
+
+    for (U32 axis = 0; axis < 3; axis++)
+    {
+        for (const F32 sign : { 1.0f, -1.0f })
+        {
+            glm::vec3 normal(0.0f);
+            normal[axis] = sign;
+
+            // Two axes spanning the face, ordered so the winding is counter clockwise seen from outside
+            glm::vec3 tangent(0.0f);
+            tangent[(axis + 1) % 3] = 1.0f;
+            const glm::vec3 bitangent = glm::cross(normal, tangent);
+
+            const U32 firstVertex = static_cast<U32>(mesh.Positions.size());
+            for (const glm::vec2 corner : { glm::vec2(-1.0f, -1.0f), glm::vec2(1.0f, -1.0f), glm::vec2(1.0f, 1.0f),
+                                            glm::vec2(-1.0f, 1.0f) })
+            {
+                mesh.Positions.push_back(0.5f * (normal + tangent * corner.x + bitangent * corner.y));
+                mesh.Normals.push_back(normal);
+            }
+
+            for (const U32 index : { 0u, 1u, 2u, 2u, 3u, 0u })
+            {
+                mesh.Indices.push_back(firstVertex + index);
+            }
+        }
+    }
+
+    return mesh;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MeshData MeshGenerator::CreateSphere(U32 segments, U32 rings)
+{
+    segments = std::max(segments, 3u);
+    rings = std::max(rings, 2u);
+
+    // The seam and the poles repeat their vertex per segment, so every ring is a plain row of the grid
+    MeshData mesh;
+    mesh.Positions.reserve(static_cast<U64>(rings + 1) * (segments + 1));
+    mesh.Normals.reserve(static_cast<U64>(rings + 1) * (segments + 1));
+    mesh.Indices.reserve(static_cast<U64>(segments) * (rings - 1) * 6);
+
+    for (U32 ring = 0; ring <= rings; ring++)
+    {
+        const F32 theta = glm::pi<F32>() * static_cast<F32>(ring) / static_cast<F32>(rings);
+        for (U32 segment = 0; segment <= segments; segment++)
+        {
+            const F32 phi = glm::two_pi<F32>() * static_cast<F32>(segment) / static_cast<F32>(segments);
+            const glm::vec3 normal = { std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi),
+                                       std::cos(theta) };
+            mesh.Positions.push_back(normal * 0.5f);
+            mesh.Normals.push_back(normal);
+        }
+    }
+
+    for (U32 ring = 0; ring < rings; ring++)
+    {
+        for (U32 segment = 0; segment < segments; segment++)
+        {
+            const U32 a = ring * (segments + 1) + segment;
+            const U32 b = a + 1;
+            const U32 c = a + segments + 1;
+            const U32 d = c + 1;
+
+            // Counter clockwise seen from outside, the triangle touching a pole would be degenerate
+            if (ring != rings - 1)
+            {
+                mesh.Indices.insert(mesh.Indices.end(), { a, c, d });
+            }
+            if (ring != 0)
+            {
+                mesh.Indices.insert(mesh.Indices.end(), { a, d, b });
+            }
+        }
+    }
+
+    return mesh;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MeshData MeshGenerator::Transform(const MeshData& mesh, const glm::mat4& transform)
+{
+    const glm::mat3 normalTransform = glm::transpose(glm::inverse(glm::mat3(transform)));
+
+    MeshData transformed;
+    transformed.Indices = mesh.Indices;
+
+    transformed.Positions.reserve(mesh.Positions.size());
+    for (const glm::vec3& position : mesh.Positions)
+    {
+        transformed.Positions.push_back(glm::vec3(transform * glm::vec4(position, 1.0f)));
+    }
+
+    transformed.Normals.reserve(mesh.Normals.size());
+    for (const glm::vec3& normal : mesh.Normals)
+    {
+        transformed.Normals.push_back(glm::normalize(normalTransform * normal));
+    }
+
+    return transformed;
+}
+} // namespace FFV
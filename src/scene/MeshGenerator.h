@@ -0,0 +1,38 @@
+#pragma once
+
+#include "import/MeshData.h"
+#include "util/Types.h"
+
+#include <glm/glm.hpp>
+
+namespace FFV
+{
+/*
+ * Procedural meshes for testing without model files.
+ */
+class MeshGenerator
+{
+public:
+    /*
+     * Unit quad in the xy plane facing +z.
+     */
+    static MeshData CreateQuad();
+
+    /*
+     * Unit cube centered at the origin with flat normals.
+     */
+    static MeshData CreateCube();
+
+    /*
+     * Unit diameter UV sphere centered at the origin with smooth normals and the poles on the z axis.
+     * @param segments: around the z axis, at least 3
+     * @param rings: from pole to pole, at least 2, the sphere has 2 * segments * (rings - 1) triangles
+     */
+    static MeshData CreateSphere(U32 segments, U32 rings);
+
+    /*
+     * Bakes the transform into the positions and normals.
+     */
+    static MeshData Transform(const MeshData& mesh, const glm::mat4& transform);
+};
+} // namespace FFV
@@ -0,0 +1,457 @@
+#include "FastFileViewerPCH.h"
+
+#include "PathTracer.h"
+
+#include "util/JobSystem.h"
+#include "util/Log.h"
+#include "util/Profiler.h"
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/constants.hpp>
+#include <xmmintrin.h>
+
+namespace FFV
+{
+// Square tiles keep the rays of a job coherent, so they mostly traverse the same nodes
+static constexpr U32 s_TileSize = 16;
+static constexpr U32 s_MaxBounces = 4;
+// Paths are only terminated randomly after the first bounces, they carry most of the light
+static constexpr U32 s_RussianRouletteBounce = 2;
+// Relative to the largest coordinate of the scene
+static constexpr F32 s_RayOffsetScale = 1e-4f;
+// Triangles per job while copying them into leaf order
+static constexpr U32 s_ChunkSize = 16 * 1024;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * PCG hash, good enough to seed and advance the per pixel random numbers.
+ */
+static U32 Hash(U32 value)
+{
+    const U32 state = value * 747796405u + 2891336453u;
+    const U32 word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * @return: uniform in [0, 1)
+ */
+static F32 RandomFloat(U32& state)
+{
+    state = Hash(state);
+    return static_cast<F32>(state >> 8) * (1.0f / 16777216.0f);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * The probability is proportional to the cosine, which cancels against the cosine of the diffuse BRDF.
+ */
+static glm::vec3 SampleCosineHemisphere(const glm::vec3& normal, U32& randomState)
+{
+    // Orthonormal basis without branches, Duff et al. 2017
+    const F32 sign = std::copysign(1.0f, normal.z);
+    const F32 a = -1.0f / (sign + normal.z);
+    const F32 b = normal.x * normal.y * a;
+    const glm::vec3 tangent = { 1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x };
+    const glm::vec3 bitangent = { b, sign + normal.y * normal.y * a, -normal.y };
+
+    const F32 u = RandomFloat(randomState);
+    const F32 radius = std::sqrt(u);
+    const F32 angle = glm::two_pi<F32>() * RandomFloat(randomState);
+    return tangent * (radius * std::cos(angle)) + bitangent * (radius * std::sin(angle)) +
+           normal * std::sqrt(std::max(1.0f - u, 0.0f));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Bright horizon, blue zenith and a darker ground, so surfaces facing up and down can be told apart. z is up.
+ */
+static glm::vec3 GetSkyRadiance(const glm::vec3& direction)
+{
+    if (direction.z < 0.0f)
+    {
+        return glm::vec3(0.25f, 0.23f, 0.2f);
+    }
+
+    return glm::mix(glm::vec3(1.0f, 0.97f, 0.92f), glm::vec3(0.35f, 0.55f, 0.95f), direction.z);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static U8 EncodeSrgb(F32 linear)
+{
+    linear = std::clamp(linear, 0.0f, 1.0f);
+    const F32 encoded = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+    return static_cast<U8>(encoded * 255.0f + 0.5f);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PathTracer::SetScene(const std::vector<MeshData>& meshes, const Scene& scene, const std::vector<glm::vec3>& albedos)
+{
+    FFV_PROFILE_FUNCTION();
+
+    Clear();
+
+    const std::vector<glm::mat4>& transforms = scene.GetTransforms();
+    const std::vector<U32>& meshIndices = scene.GetMeshIndices();
+    const std::vector<U32>& materialIndices = scene.GetMaterialIndices();
+    const U32 objectCount = scene.GetObjectCount();
+
+    // Every object gets its own range, so they can be flattened in parallel
+    std::vector<U64> firstVertices(objectCount + 1, 0);
+    std::vector<U64> firstTriangles(objectCount + 1, 0);
+    for (U32 object = 0; object < objectCount; object++)
+    {
+        const MeshData& mesh = meshes[meshIndices[object]];
+        firstVertices[object + 1] = firstVertices[object] + mesh.Positions.size();
+        firstTriangles[object + 1] = firstTriangles[object] + mesh.Indices.size() / 3;
+    }
+
+    if (firstTriangles.back() == 0)
+    {
+        return;
+    }
+
+    std::vector<glm::vec3> positions(firstVertices.back());
+    std::vector<U32> indices(firstTriangles.back() * 3);
+    std::vector<U32> triangleMaterials(firstTriangles.back());
+    JobSystem::ParallelFor(objectCount,
+                           [&](U32 object, U32)
+                           {
+                               const MeshData& mesh = meshes[meshIndices[object]];
+                               const glm::mat4& transform = transforms[object];
+                               const U64 firstVertex = firstVertices[object];
+                               const U64 firstTriangle = firstTriangles[object];
+
+                               for (U64 i = 0; i < mesh.Positions.size(); i++)
+                               {
+                                   positions[firstVertex + i] = glm::vec3(transform * glm::vec4(mesh.Positions[i], 1.0f));
+                               }
+                               for (U64 i = 0; i < (firstTriangles[object + 1] - firstTriangle) * 3; i++)
+                               {
+                                   indices[firstTriangle * 3 + i] = static_cast<U32>(firstVertex) + mesh.Indices[i];
+                               }
+                               std::fill(triangleMaterials.begin() + firstTriangle,
+                                         triangleMaterials.begin() + firstTriangles[object + 1],
+                                         materialIndices[object]);
+                           });
+
+    m_Bvh = Bvh(positions, indices);
+    const Bvh::Stats& bvhStats = m_Bvh.GetStats();
+    FFV_LOG("Built the path tracer BVH over {0} triangles in {1:.2f} ms, {2:.1f} MB", bvhStats.TriangleCount,
+            bvhStats.BuildMs, m_Bvh.GetSizeInBytes() / (1024.0 * 1024.0));
+
+    // Leaves address consecutive triangles, so the traversal never has to go through the index list
+    const std::vector<U32>& leafOrder = m_Bvh.GetTriangleIndices();
+    m_Triangles.resize(leafOrder.size());
+    const U32 chunkCount = static_cast<U32>((leafOrder.size() + s_ChunkSize - 1) / s_ChunkSize);
+    JobSystem::ParallelFor(chunkCount,
+                           [&](U32 chunk, U32)
+                           {
+                               const U64 end = std::min<U64>((chunk + 1) * static_cast<U64>(s_ChunkSize),
+                                                             leafOrder.size());
+                               for (U64 i = chunk * static_cast<U64>(s_ChunkSize); i < end; i++)
+                               {
+                                   const U32 triangle = leafOrder[i];
+                                   const glm::vec3& vertex0 = positions[indices[triangle * 3]];
+                                   m_Triangles[i] = { .Vertex0 = vertex0,
+                                                      .Edge1 = positions[indices[triangle * 3 + 1]] - vertex0,
+                                                      .Edge2 = positions[indices[triangle * 3 + 2]] - vertex0,
+                                                      .MaterialIndex = triangleMaterials[triangle] };
+                               }
+                           });
+
+    m_Albedos = albedos.empty() ? std::vector<glm::vec3>{ glm::vec3(0.8f) } : albedos;
+
+    const Bvh::Bounds& bounds = m_Bvh.GetBounds();
+    const glm::vec3 largest = glm::max(glm::abs(bounds.Min), glm::abs(bounds.Max));
+    m_RayOffset = s_RayOffsetScale * std::max({ largest.x, largest.y, largest.z, 1e-3f });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PathTracer::Clear()
+{
+    m_Bvh = Bvh();
+    m_Triangles = {};
+    m_Albedos.clear();
+    m_Stacks.clear();
+
+    // Forces the accumulation to restart with the next frame
+    m_AccumulatedWidth = 0;
+    m_AccumulatedHeight = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PathTracer::Render(const glm::mat4& view, const glm::mat4& projection, U32 width, U32 height, U8* pixels)
+{
+    FFV_PROFILE_FUNCTION();
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    const glm::mat4 viewProjection = projection * view;
+    if (width != m_AccumulatedWidth || height != m_AccumulatedHeight || viewProjection != m_AccumulatedViewProjection)
+    {
+        m_Accumulation.assign(static_cast<U64>(width) * height, glm::vec3(0.0f));
+        m_AccumulatedViewProjection = viewProjection;
+        m_AccumulatedWidth = width;
+        m_AccumulatedHeight = height;
+        m_Stats.SampleCount = 0;
+    }
+    m_Stats.SampleCount++;
+
+    // Every push replaces the popped entry and adds at most Width - 1 more, once per level
+    const U32 stackSize = (Bvh::Width - 1) * m_Bvh.GetStats().MaxDepth + 1;
+    m_Stacks.resize(JobSystem::GetNumThreads());
+    for (std::vector<StackEntry>& stack : m_Stacks)
+    {
+        stack.resize(stackSize);
+    }
+
+    const glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+    const U32 sampleSeed = Hash(m_Stats.SampleCount);
+    const F32 inverseSampleCount = 1.0f / static_cast<F32>(m_Stats.SampleCount);
+    const glm::vec2 inverseExtent = 1.0f / glm::vec2(width, height);
+
+    const U32 tilesX = (width + s_TileSize - 1) / s_TileSize;
+    const U32 tilesY = (height + s_TileSize - 1) / s_TileSize;
+    std::atomic<U64> rayCount = 0;
+    JobSystem::ParallelFor(
+        tilesX * tilesY,
+        [&](U32 tile, U32 threadIndex)
+        {
+            std::vector<StackEntry>& stack = m_Stacks[threadIndex];
+            const U32 beginX = tile % tilesX * s_TileSize;
+            const U32 beginY = tile / tilesX * s_TileSize;
+            const U32 endX = std::min(beginX + s_TileSize, width);
+            const U32 endY = std::min(beginY + s_TileSize, height);
+
+            U64 tileRayCount = 0;
+            for (U32 y = beginY; y < endY; y++)
+            {
+                for (U32 x = beginX; x < endX; x++)
+                {
+                    const U64 pixelIndex = static_cast<U64>(y) * width + x;
+                    U32 randomState = Hash(static_cast<U32>(pixelIndex) ^ sampleSeed);
+
+                    // Jittered inside the pixel, so the accumulated samples also antialias the edges
+                    const glm::vec2 pixel = { static_cast<F32>(x) + RandomFloat(randomState),
+                                              static_cast<F32>(y) + RandomFloat(randomState) };
+                    const glm::vec2 ndc = pixel * inverseExtent * 2.0f - 1.0f;
+                    const glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, 0.0f, 1.0f);
+                    const glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+                    const glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+                    const glm::vec3 direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+
+                    glm::vec3& sum = m_Accumulation[pixelIndex];
+                    sum += TracePath(origin, direction, randomState, stack, tileRayCount);
+
+                    const glm::vec3 color = sum * inverseSampleCount;
+                    const std::array<U8, 4> rgba = { EncodeSrgb(color.r), EncodeSrgb(color.g), EncodeSrgb(color.b),
+                                                     255 };
+                    std::memcpy(pixels + pixelIndex * 4, rgba.data(), rgba.size());
+                }
+            }
+
+            rayCount.fetch_add(tileRayCount, std::memory_order_relaxed);
+        });
+
+    m_Stats.RayCount = rayCount.load();
+    m_Stats.RenderMs = std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    m_Stats.MraysPerSecond =
+        m_Stats.RenderMs > 0.0 ? static_cast<F64>(m_Stats.RayCount) / (m_Stats.RenderMs * 1000.0) : 0.0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U64 PathTracer::GetMemoryUsage() const
+{
+    U64 bytes = m_Bvh.GetSizeInBytes() + m_Triangles.capacity() * sizeof(Triangle) +
+                m_Accumulation.capacity() * sizeof(glm::vec3);
+    for (const std::vector<StackEntry>& stack : m_Stacks)
+    {
+        bytes += stack.capacity() * sizeof(StackEntry);
+    }
+
+    return bytes;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PathTracer::Intersect(const glm::vec3& origin, const glm::vec3& direction, std::vector<StackEntry>& stack,
+                           Hit& hit) const
+{
+    const std::vector<Bvh::Node>& nodes = m_Bvh.GetNodes();
+    if (nodes.empty())
+    {
+        return false;
+    }
+
+    // Picking the near and far planes by the direction makes the inverted bounds of unused slots miss every ray, and
+    // saves the min and max of the usual slab test
+    const glm::vec3 inverseDirection = 1.0f / direction;
+    const bool negativeX = inverseDirection.x < 0.0f;
+    const bool negativeY = inverseDirection.y < 0.0f;
+    const bool negativeZ = inverseDirection.z < 0.0f;
+    const __m128 originX = _mm_set1_ps(origin.x);
+    const __m128 originY = _mm_set1_ps(origin.y);
+    const __m128 originZ = _mm_set1_ps(origin.z);
+    const __m128 inverseX = _mm_set1_ps(inverseDirection.x);
+    const __m128 inverseY = _mm_set1_ps(inverseDirection.y);
+    const __m128 inverseZ = _mm_set1_ps(inverseDirection.z);
+    const __m128 zero = _mm_setzero_ps();
+
+    hit = { .Distance = std::numeric_limits<F32>::max(), .TriangleIndex = Bvh::InvalidIndex };
+    U32 stackSize = 0;
+    stack[stackSize++] = { .NodeIndex = 0, .Distance = 0.0f };
+
+    while (stackSize > 0)
+    {
+        const StackEntry entry = stack[--stackSize];
+        if (entry.Distance >= hit.Distance)
+        {
+            continue;
+        }
+
+        // All four children at once. Rays in the plane of a box produce NaNs. _mm_min_ps and _mm_max_ps return their
+        // second operand if either one is NaN, so every NaN is the first operand of a min or max whose second operand
+        // can't be NaN. That way it drops out without taking a valid distance with it.
+        const Bvh::Node& node = nodes[entry.NodeIndex];
+        const __m128 nearX = _mm_mul_ps(_mm_sub_ps(_mm_load_ps((negativeX ? node.MaxX : node.MinX).data()), originX),
+                                        inverseX);
+        const __m128 nearY = _mm_mul_ps(_mm_sub_ps(_mm_load_ps((negativeY ? node.MaxY : node.MinY).data()), originY),
+                                        inverseY);
+        const __m128 nearZ = _mm_mul_ps(_mm_sub_ps(_mm_load_ps((negativeZ ? node.MaxZ : node.MinZ).data()), originZ),
+                                        inverseZ);
+        const __m128 farX = _mm_mul_ps(_mm_sub_ps(_mm_load_ps((negativeX ? node.MinX : node.MaxX).data()), originX),
+                                       inverseX);
+        const __m128 farY = _mm_mul_ps(_mm_sub_ps(_mm_load_ps((negativeY ? node.MinY : node.MaxY).data()), originY),
+                                       inverseY);
+        const __m128 farZ = _mm_mul_ps(_mm_sub_ps(_mm_load_ps((negativeZ ? node.MinZ : node.MaxZ).data()), originZ),
+                                       inverseZ);
+        const __m128 entryDistances = _mm_max_ps(nearX, _mm_max_ps(nearY, _mm_max_ps(nearZ, zero)));
+        const __m128 exitDistances = _mm_min_ps(farX, _mm_min_ps(farY, _mm_min_ps(farZ, _mm_set1_ps(hit.Distance))));
+
+        U32 mask = static_cast<U32>(_mm_movemask_ps(_mm_cmple_ps(entryDistances, exitDistances)));
+        if (mask == 0)
+        {
+            continue;
+        }
+
+        alignas(16) std::array<F32, Bvh::Width> distances;
+        _mm_store_ps(distances.data(), entryDistances);
+
+        std::array<StackEntry, Bvh::Width> children;
+        U32 childCount = 0;
+        for (; mask != 0; mask &= mask - 1)
+        {
+            const U32 slot = static_cast<U32>(std::countr_zero(mask));
+            if (!node.IsLeaf(slot))
+            {
+                children[childCount++] = { .NodeIndex = node.Children[slot], .Distance = distances[slot] };
+                continue;
+            }
+
+            // Möller-Trumbore with the edges precomputed, both sides count as hits like in Bvh::Intersect
+            const U32 end = node.Children[slot] + node.TriangleCounts[slot];
+            for (U32 i = node.Children[slot]; i < end; i++)
+            {
+                const Triangle& triangle = m_Triangles[i];
+                const glm::vec3 p = glm::cross(direction, triangle.Edge2);
+                const F32 determinant = glm::dot(triangle.Edge1, p);
+                if (determinant == 0.0f)
+                {
+                    continue;
+                }
+
+                const F32 inverseDeterminant = 1.0f / determinant;
+                const glm::vec3 s = origin - triangle.Vertex0;
+                const F32 u = glm::dot(s, p) * inverseDeterminant;
+                if (u < 0.0f || u > 1.0f)
+                {
+                    continue;
+                }
+
+                const glm::vec3 q = glm::cross(s, triangle.Edge1);
+                const F32 v = glm::dot(direction, q) * inverseDeterminant;
+                if (v < 0.0f || u + v > 1.0f)
+                {
+                    continue;
+                }
+
+                const F32 distance = glm::dot(triangle.Edge2, q) * inverseDeterminant;
+                if (distance >= 0.0f && distance < hit.Distance)
+                {
+                    hit = { .Distance = distance, .TriangleIndex = i };
+                }
+            }
+        }
+
+        // Pushed far to near, so the nearest child is popped first and tightens the hit distance for the others
+        std::sort(children.begin(), children.begin() + childCount,
+                  [](const StackEntry& a, const StackEntry& b) { return a.Distance > b.Distance; });
+        for (U32 i = 0; i < childCount; i++)
+        {
+            stack[stackSize++] = children[i];
+        }
+    }
+
+    return hit.TriangleIndex != Bvh::InvalidIndex;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec3 PathTracer::TracePath(glm::vec3 origin, glm::vec3 direction, U32& randomState,
+                                std::vector<StackEntry>& stack, U64& rayCount) const
+{
+    glm::vec3 throughput(1.0f);
+    for (U32 bounce = 0;; bounce++)
+    {
+        rayCount++;
+
+        Hit hit;
+        if (!Intersect(origin, direction, stack, hit))
+        {
+            return throughput * GetSkyRadiance(direction);
+        }
+
+        // Paths that never reach the sky carry no light
+        if (bounce == s_MaxBounces)
+        {
+            return glm::vec3(0.0f);
+        }
+
+        const Triangle& triangle = m_Triangles[hit.TriangleIndex];
+        glm::vec3 normal = glm::normalize(glm::cross(triangle.Edge1, triangle.Edge2));
+        if (glm::dot(normal, direction) > 0.0f)
+        {
+            normal = -normal;
+        }
+
+        throughput *= m_Albedos[std::min<U64>(triangle.MaterialIndex, m_Albedos.size() - 1)];
+        if (bounce >= s_RussianRouletteBounce)
+        {
+            const F32 survival = std::min(std::max({ throughput.r, throughput.g, throughput.b }), 0.95f);
+            if (RandomFloat(randomState) >= survival)
+            {
+                return glm::vec3(0.0f);
+            }
+            throughput /= survival;
+        }
+
+        origin += direction * hit.Distance + normal * m_RayOffset;
+        direction = SampleCosineHemisphere(normal, randomState);
+    }
+}
+} // namespace FFV
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "import/MeshData.h"
+#include "scene/Bvh.h"
+#include "scene/Scene.h"
+#include "util/Types.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace FFV
+{
+/*
+ * Path tracer that runs entirely on the CPU, for machines without ray tracing hardware. The screen is split into tiles
+ * that are traced in parallel on the job system, every call adds one sample per pixel to the accumulated image until
+ * the camera or the size changes. Materials are diffuse and the only light is the sky.
+ * The scene is flattened into world space triangles stored in the leaf order of a Bvh, so a leaf reads consecutive
+ * memory. Its 4-wide nodes are traversed with SSE, one instruction tests a ray against all children of a node.
+ */
+class PathTracer
+{
+public:
+    struct Stats
+    {
+        U64 RayCount = 0; // Camera rays and bounces of the last frame
+        F64 RenderMs = 0.0;
+        F64 MraysPerSecond = 0.0;
+        U32 SampleCount = 0; // Accumulated samples per pixel
+    };
+
+public:
+    PathTracer() = default;
+
+    /*
+     * Flattens the objects of the scene into world space and builds the hierarchy, runs on the job system.
+     * @param meshes: positions and indices of the meshes the scene references
+     * @param albedos: linear diffuse color per material index
+     */
+    void SetScene(const std::vector<MeshData>& meshes, const Scene& scene, const std::vector<glm::vec3>& albedos);
+    void Clear();
+    /*
+     * Adds one sample per pixel and writes the average so far.
+     * @param projection: with the y axis flipped like for rendering, so the first row is the top of the image
+     * @param pixels: width * height tightly packed RGBA rows, sRGB encoded
+     */
+    void Render(const glm::mat4& view, const glm::mat4& projection, U32 width, U32 height, U8* pixels);
+
+    bool IsEmpty() const { return m_Triangles.empty(); }
+    const Stats& GetStats() const { return m_Stats; }
+    U64 GetMemoryUsage() const;
+
+private:
+    // Precomputed for Möller-Trumbore, 48 bytes
+    struct Triangle
+    {
+        glm::vec3 Vertex0;
+        F32 Padding0;
+        glm::vec3 Edge1;
+        F32 Padding1;
+        glm::vec3 Edge2;
+        U32 MaterialIndex;
+    };
+
+    struct StackEntry
+    {
+        U32 NodeIndex;
+        F32 Distance; // Where the ray enters the node, entries behind the closest hit are skipped
+    };
+
+    struct Hit
+    {
+        F32 Distance;
+        U32 TriangleIndex; // Into m_Triangles
+    };
+
+private:
+    /*
+     * Closest hit with the SSE traversal.
+     * @return false if the ray leaves the scene
+     */
+    bool Intersect(const glm::vec3& origin, const glm::vec3& direction, std::vector<StackEntry>& stack,
+                   Hit& hit) const;
+    /*
+     * Follows one path from the camera until it reaches the sky or gets terminated.
+     * @param rayCount: incremented for every traced ray
+     */
+    glm::vec3 TracePath(glm::vec3 origin, glm::vec3 direction, U32& randomState, std::vector<StackEntry>& stack,
+                        U64& rayCount) const;
+
+private:
+    Bvh m_Bvh;
+    std::vector<Triangle> m_Triangles;
+    std::vector<glm::vec3> m_Albedos;
+    F32 m_RayOffset = 0.0f; // Keeps bounces from hitting the surface they start on, relative to the scene size
+    // One traversal stack per job system thread, sized for the depth of the hierarchy
+    std::vector<std::vector<StackEntry>> m_Stacks;
+
+    std::vector<glm::vec3> m_Accumulation; // Sum of all samples per pixel, linear
+    glm::mat4 m_AccumulatedViewProjection = glm::mat4(0.0f);
+    U32 m_AccumulatedWidth = 0;
+    U32 m_AccumulatedHeight = 0;
+    Stats m_Stats;
+};
+} // namespace FFV
@@ -0,0 +1,134 @@
+#include "FastFileViewerPCH.h"
+
+#include "Scene.h"
+
+namespace FFV
+{
+U32 Scene::AddMesh(const Mesh& mesh)
+{
+    m_Meshes.push_back(mesh);
+    return static_cast<U32>(m_Meshes.size() - 1);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U32 Scene::AddObject(U32 meshIndex, const glm::mat4& transform, U32 materialIndex)
+{
+    FFV_ASSERT(meshIndex < m_Meshes.size(), std::format("Mesh index {} is out of bounds!", meshIndex), return ~0u);
+
+    m_Transforms.push_back(transform);
+    m_Bounds.push_back(TransformBoundingSphere(m_Meshes[meshIndex].BoundingSphere, transform));
+    m_MeshIndices.push_back(meshIndex);
+    m_MaterialIndices.push_back(materialIndex);
+
+    return GetObjectCount() - 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene::SetTransform(U32 objectIndex, const glm::mat4& transform)
+{
+    m_Transforms[objectIndex] = transform;
+    m_Bounds[objectIndex] = TransformBoundingSphere(m_Meshes[m_MeshIndices[objectIndex]].BoundingSphere, transform);
+    m_TransformVersion++;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene::Reserve(U32 objectCount)
+{
+    m_Transforms.reserve(objectCount);
+    m_Bounds.reserve(objectCount);
+    m_MeshIndices.reserve(objectCount);
+    m_MaterialIndices.reserve(objectCount);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene::Clear()
+{
+    m_Meshes.clear();
+    m_Transforms.clear();
+    m_Bounds.clear();
+    m_MeshIndices.clear();
+    m_MaterialIndices.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U64 Scene::GetMemoryUsage() const
+{
+    return m_Meshes.capacity() * sizeof(Mesh) + m_Transforms.capacity() * sizeof(glm::mat4) +
+           m_Bounds.capacity() * sizeof(glm::vec4) + m_MeshIndices.capacity() * sizeof(U32) +
+           m_MaterialIndices.capacity() * sizeof(U32);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene::BuildBatches(std::vector<Batch>& batches, std::vector<U32>& instances) const
+{
+    // Counting sort by mesh index
+    std::vector<U32> meshOffsets(m_Meshes.size() + 1, 0);
+    for (const U32 meshIndex : m_MeshIndices)
+    {
+        meshOffsets[meshIndex + 1]++;
+    }
+
+    batches.clear();
+    for (U32 meshIndex = 0; meshIndex < m_Meshes.size(); meshIndex++)
+    {
+        const U32 instanceCount = meshOffsets[meshIndex + 1];
+        meshOffsets[meshIndex + 1] += meshOffsets[meshIndex];
+
+        if (instanceCount > 0)
+        {
+            batches.push_back(
+                { .MeshIndex = meshIndex, .FirstInstance = meshOffsets[meshIndex], .InstanceCount = instanceCount });
+        }
+    }
+
+    instances.resize(m_MeshIndices.size());
+    for (U32 objectIndex = 0; objectIndex < m_MeshIndices.size(); objectIndex++)
+    {
+        instances[meshOffsets[m_MeshIndices[objectIndex]]++] = objectIndex;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec4 Scene::ComputeBoundingSphere(const std::vector<glm::vec3>& points)
+{
+    if (points.empty())
+    {
+        return glm::vec4(0.0f);
+    }
+
+    glm::vec3 center(0.0f);
+    for (const glm::vec3& point : points)
+    {
+        center += point;
+    }
+    center /= static_cast<float>(points.size());
+
+    float radiusSquared = 0.0f;
+    for (const glm::vec3& point : points)
+    {
+        const glm::vec3 offset = point - center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+
+    return glm::vec4(center, std::sqrt(radiusSquared));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec4 Scene::TransformBoundingSphere(const glm::vec4& sphere, const glm::mat4& transform)
+{
+    const glm::vec3 center = glm::vec3(transform * glm::vec4(glm::vec3(sphere), 1.0f));
+    const float scale = std::sqrt(std::max({ glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+                                             glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])),
+                                             glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2])) }));
+
+    return glm::vec4(center, sphere.w * scale);
+}
+} // namespace FFV
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "util/Types.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace FFV
+{
+/*
+ * CPU side scene description. Objects are stored as structure of arrays, so passes that only need one attribute (e.g.
+ * culling only reads the bounds) touch as little memory as possible.
+ */
+class Scene
+{
+public:
+    /*
+     * Index range inside the geometry buffers.
+     */
+    struct Mesh
+    {
+        U32 IndexCount = 0;
+        U32 FirstIndex = 0;
+        I32 VertexOffset = 0;
+        glm::vec4 BoundingSphere = glm::vec4(0.0f); // Object space center and radius
+    };
+
+    /*
+     * All objects using one mesh, drawn with a single instanced draw.
+     * Owns the instances [FirstInstance, FirstInstance + InstanceCount) of the list built by BuildBatches.
+     */
+    struct Batch
+    {
+        U32 MeshIndex = 0;
+        U32 FirstInstance = 0;
+        U32 InstanceCount = 0;
+    };
+
+public:
+    U32 AddMesh(const Mesh& mesh);
+    U32 AddObject(U32 meshIndex, const glm::mat4& transform, U32 materialIndex = 0);
+    void SetTransform(U32 objectIndex, const glm::mat4& transform);
+
+    void Reserve(U32 objectCount);
+    void Clear();
+
+    /*
+     * Groups the objects by mesh, meshes without objects don't get a batch.
+     * @param instances: receives the object indices ordered by batch
+     */
+    void BuildBatches(std::vector<Batch>& batches, std::vector<U32>& instances) const;
+
+    U32 GetObjectCount() const { return static_cast<U32>(m_Transforms.size()); }
+    /*
+     * Changes whenever an object moves, never goes back to a previous value, not even after Clear.
+     */
+    U64 GetTransformVersion() const { return m_TransformVersion; }
+    /*
+     * Bytes reserved by the containers, Clear keeps them.
+     */
+    U64 GetMemoryUsage() const;
+
+    const std::vector<Mesh>& GetMeshes() const { return m_Meshes; }
+    const std::vector<glm::mat4>& GetTransforms() const { return m_Transforms; }
+    const std::vector<glm::vec4>& GetBounds() const { return m_Bounds; }
+    const std::vector<U32>& GetMeshIndices() const { return m_MeshIndices; }
+    const std::vector<U32>& GetMaterialIndices() const { return m_MaterialIndices; }
+
+    /*
+     * Bounding sphere around the centroid of the points, not minimal but cheap and good enough for culling.
+     */
+    static glm::vec4 ComputeBoundingSphere(const std::vector<glm::vec3>& points);
+
+private:
+    static glm::vec4 TransformBoundingSphere(const glm::vec4& sphere, const glm::mat4& transform);
+
+private:
+    std::vector<Mesh> m_Meshes;
+
+    // Indexed by object
+    std::vector<glm::mat4> m_Transforms;
+    std::vector<glm::vec4> m_Bounds; // World space bounding spheres
+    std::vector<U32> m_MeshIndices;
+    std::vector<U32> m_MaterialIndices;
+    U64 m_TransformVersion = 0;
+};
+} // namespace FFV
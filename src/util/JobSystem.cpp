@@ -0,0 +1,190 @@
+#include "FastFileViewerPCH.h"
+
+#include "util/JobSystem.h"
+
+#include "util/Profiler.h"
+
+namespace FFV
+{
+std::vector<std::thread> JobSystem::s_Workers;
+std::deque<std::function<void()>> JobSystem::s_Jobs;
+std::mutex JobSystem::s_Mutex;
+std::condition_variable JobSystem::s_Condition;
+bool JobSystem::s_Running = false;
+
+static thread_local U32 s_ThreadIndex = 0;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Counter::Wait()
+{
+    while (!IsDone())
+    {
+        if (!TryRunJob())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Init(U32 numWorkers)
+{
+    FFV_ASSERT(!s_Running, "Job system is already running!", return);
+
+    if (numWorkers == 0)
+    {
+        numWorkers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    s_Running = true;
+    s_Workers.reserve(numWorkers);
+    for (U32 i = 0; i < numWorkers; i++)
+    {
+        s_Workers.emplace_back(&JobSystem::WorkerLoop, i + 1);
+    }
+
+    FFV_TRACE("Started job system with {0} workers!", numWorkers);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Shutdown()
+{
+    {
+        std::lock_guard lock(s_Mutex);
+        s_Running = false;
+    }
+    s_Condition.notify_all();
+
+    for (std::thread& worker : s_Workers)
+    {
+        worker.join();
+    }
+
+    s_Workers.clear();
+    s_Jobs.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Execute(std::function<void()> job, Counter* counter)
+{
+    if (counter)
+    {
+        counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+        job = [job = std::move(job), counter]()
+        {
+            job();
+            counter->m_Pending.fetch_sub(1, std::memory_order_release);
+        };
+    }
+
+    {
+        std::lock_guard lock(s_Mutex);
+        s_Jobs.push_back(std::move(job));
+    }
+    s_Condition.notify_one();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::ParallelFor(U32 count, const std::function<void(U32 index, U32 threadIndex)>& job, U32 maxThreads)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Helpers can still be queued when the loop is already done, so they must not reference the caller's stack
+    struct LoopState
+    {
+        std::function<void(U32, U32)> Job;
+        std::atomic<U32> NextIndex = 0;
+        std::atomic<U32> Finished = 0;
+        U32 Count = 0;
+    };
+
+    SharedPtr<LoopState> state = MakeShared<LoopState>();
+    state->Job = job;
+    state->Count = count;
+
+    const auto work = [](LoopState& loop)
+    {
+        const U32 threadIndex = GetThreadIndex();
+        for (U32 index = loop.NextIndex.fetch_add(1); index < loop.Count; index = loop.NextIndex.fetch_add(1))
+        {
+            loop.Job(index, threadIndex);
+            loop.Finished.fetch_add(1, std::memory_order_release);
+        }
+    };
+
+    const U32 numHelpers = std::min({ GetNumThreads(), maxThreads, count }) - 1;
+    for (U32 i = 0; i < numHelpers; i++)
+    {
+        Execute([state, work]() { work(*state); });
+    }
+
+    work(*state);
+
+    while (state->Finished.load(std::memory_order_acquire) < count)
+    {
+        if (!TryRunJob())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U32 JobSystem::GetThreadIndex() { return s_ThreadIndex; }
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::WorkerLoop(U32 threadIndex)
+{
+    s_ThreadIndex = threadIndex;
+    FFV_PROFILE_THREAD("Worker");
+
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(s_Mutex);
+            s_Condition.wait(lock, []() { return !s_Jobs.empty() || !s_Running; });
+
+            if (s_Jobs.empty())
+            {
+                return;
+            }
+
+            job = std::move(s_Jobs.front());
+            s_Jobs.pop_front();
+        }
+
+        job();
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool JobSystem::TryRunJob()
+{
+    std::function<void()> job;
+    {
+        std::lock_guard lock(s_Mutex);
+        if (s_Jobs.empty())
+        {
+            return false;
+        }
+
+        job = std::move(s_Jobs.front());
+        s_Jobs.pop_front();
+    }
+
+    job();
+    return true;
+}
+} // namespace FFV
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "util/Types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FFV
+{
+class JobSystem
+{
+public:
+    /*
+     * Counts outstanding jobs started with Execute, Wait() helps running queued jobs until all of them are done.
+     */
+    class Counter
+    {
+    public:
+        void Wait();
+        bool IsDone() const { return m_Pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class JobSystem;
+        std::atomic<U32> m_Pending = 0;
+    };
+
+public:
+    /*
+     * Starts the worker threads.
+     * Must be called before any other function of the job system is used.
+     * @param numWorkers: 0 uses one worker per hardware thread except the calling one
+     */
+    static void Init(U32 numWorkers = 0);
+    static void Shutdown();
+
+    /*
+     * Queues a job on the workers.
+     * @param counter: optional, gets incremented now and decremented when the job finished
+     */
+    static void Execute(std::function<void()> job, Counter* counter = nullptr);
+
+    /*
+     * Calls job(index, threadIndex) for every index in [0, count) and returns once all of them are done.
+     * The calling thread takes part in the work, so this can be nested inside other jobs.
+     * @param maxThreads: upper limit of threads working on the loop, including the calling one
+     */
+    static void ParallelFor(U32 count, const std::function<void(U32 index, U32 threadIndex)>& job,
+                            U32 maxThreads = ~0u);
+
+    /*
+     * Number of threads that can run jobs, the workers plus the thread that called Init.
+     */
+    static U32 GetNumThreads() { return static_cast<U32>(s_Workers.size()) + 1; }
+
+    /*
+     * 0 for the thread that called Init (and every other non worker thread), 1..GetNumThreads()-1 for the workers.
+     */
+    static U32 GetThreadIndex();
+
+private:
+    static void WorkerLoop(U32 threadIndex);
+    static bool TryRunJob();
+
+private:
+    static std::vector<std::thread> s_Workers;
+    static std::deque<std::function<void()>> s_Jobs;
+    static std::mutex s_Mutex;
+    static std::condition_variable s_Condition;
+    static bool s_Running;
+};
+} // namespace FFV
@@ -0,0 +1,252 @@
+#include "FastFileViewerPCH.h"
+
+#include "util/MemoryTracker.h"
+
+#include "util/Log.h"
+
+#if defined(FFV_LINUX)
+    #include <fstream>
+    #include <unistd.h>
+#elif defined(FFV_WINDOWS)
+    #include <psapi.h>
+#endif
+
+namespace FFV
+{
+VkPhysicalDevice MemoryTracker::s_PhysicalDevice = VK_NULL_HANDLE;
+VkPhysicalDeviceMemoryProperties MemoryTracker::s_MemoryProperties = {};
+bool MemoryTracker::s_BudgetSupported = false;
+
+std::mutex MemoryTracker::s_Mutex;
+std::unordered_map<VkDeviceMemory, MemoryTracker::Allocation> MemoryTracker::s_Allocations;
+std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> MemoryTracker::s_HeapBytes = {};
+std::array<VkDeviceSize, static_cast<U32>(MemoryCategory::Count)> MemoryTracker::s_CategoryBytes = {};
+std::array<std::atomic<I64>, static_cast<U32>(CpuMemoryCategory::Count)> MemoryTracker::s_CpuCategoryBytes = {};
+
+static F64 ToMiB(U64 bytes) { return static_cast<F64>(bytes) / (1024.0 * 1024.0); }
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void MemoryTracker::Init(VkPhysicalDevice physicalDevice, bool budgetSupported)
+{
+    s_PhysicalDevice = physicalDevice;
+    s_BudgetSupported = budgetSupported;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &s_MemoryProperties);
+
+    if (!budgetSupported)
+    {
+        FFV_WARN("The selected device doesn't support VK_EXT_memory_budget, the memory budget is estimated!");
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void MemoryTracker::OnAllocate(VkDeviceMemory memory, VkDeviceSize size, U32 memoryTypeIndex, MemoryCategory category)
+{
+    const U32 heapIndex = s_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+
+    std::lock_guard lock(s_Mutex);
+    s_Allocations[memory] = { .Size = size, .HeapIndex = heapIndex, .Category = category };
+    s_HeapBytes[heapIndex] += size;
+    s_CategoryBytes[static_cast<U32>(category)] += size;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void MemoryTracker::OnFree(VkDeviceMemory memory)
+{
+    std::lock_guard lock(s_Mutex);
+    const auto it = s_Allocations.find(memory);
+    if (it == s_Allocations.end())
+    {
+        return;
+    }
+
+    s_HeapBytes[it->second.HeapIndex] -= it->second.Size;
+    s_CategoryBytes[static_cast<U32>(it->second.Category)] -= it->second.Size;
+    s_Allocations.erase(it);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void MemoryTracker::AddCpuBytes(CpuMemoryCategory category, I64 deltaBytes)
+{
+    s_CpuCategoryBytes[static_cast<U32>(category)].fetch_add(deltaBytes, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void MemoryTracker::SetCpuBytes(CpuMemoryCategory category, U64 bytes)
+{
+    s_CpuCategoryBytes[static_cast<U32>(category)].store(static_cast<I64>(bytes), std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MemoryTracker::Report MemoryTracker::GetReport()
+{
+    Report report;
+    report.BudgetSupported = s_BudgetSupported;
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT
+    };
+    if (s_BudgetSupported)
+    {
+        // The budget changes with what other processes allocate, so it's queried every time
+        VkPhysicalDeviceMemoryProperties2 memoryProperties = { .sType =
+                                                                   VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+                                                               .pNext = &budgetProperties };
+        vkGetPhysicalDeviceMemoryProperties2(s_PhysicalDevice, &memoryProperties);
+    }
+
+    {
+        std::lock_guard lock(s_Mutex);
+        for (U32 heapIndex = 0; heapIndex < s_MemoryProperties.memoryHeapCount; heapIndex++)
+        {
+            const VkMemoryHeap& heap = s_MemoryProperties.memoryHeaps[heapIndex];
+
+            HeapStats& stats = report.Heaps.emplace_back();
+            stats.Size = heap.size;
+            stats.EngineUsage = s_HeapBytes[heapIndex];
+            stats.DeviceLocal = heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+
+            if (s_BudgetSupported)
+            {
+                stats.Budget = budgetProperties.heapBudget[heapIndex];
+                // The driver may report with a delay, allocations made since then are already in the engine counters
+                stats.Usage = std::max(budgetProperties.heapUsage[heapIndex], stats.EngineUsage);
+            }
+            else
+            {
+                stats.Budget = static_cast<VkDeviceSize>(static_cast<F64>(heap.size) * s_FallbackBudgetFraction);
+                stats.Usage = stats.EngineUsage;
+            }
+        }
+
+        report.CategoryBytes = s_CategoryBytes;
+    }
+
+    for (U32 category = 0; category < report.CpuCategoryBytes.size(); category++)
+    {
+        report.CpuCategoryBytes[category] =
+            static_cast<U64>(std::max<I64>(s_CpuCategoryBytes[category].load(std::memory_order_relaxed), 0));
+    }
+    report.ProcessResidentBytes = QueryProcessResidentBytes();
+
+    return report;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+VkDeviceSize MemoryTracker::GetAvailableBytes(VkMemoryPropertyFlags propertyFlags)
+{
+    const Report report = GetReport();
+    for (U32 typeIndex = 0; typeIndex < s_MemoryProperties.memoryTypeCount; typeIndex++)
+    {
+        const VkMemoryType& type = s_MemoryProperties.memoryTypes[typeIndex];
+        if ((type.propertyFlags & propertyFlags) == propertyFlags)
+        {
+            const HeapStats& heap = report.Heaps[type.heapIndex];
+            return heap.Budget > heap.Usage ? heap.Budget - heap.Usage : 0;
+        }
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string MemoryTracker::FormatSummary()
+{
+    const Report report = GetReport();
+
+    VkDeviceSize usage = 0;
+    VkDeviceSize budget = 0;
+    for (const HeapStats& heap : report.Heaps)
+    {
+        if (heap.DeviceLocal)
+        {
+            usage += heap.Usage;
+            budget += heap.Budget;
+        }
+    }
+
+    return std::format("VRAM: {0:.0f} / {1:.0f} MB", ToMiB(usage), ToMiB(budget));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string MemoryTracker::FormatReport()
+{
+    const Report report = GetReport();
+
+    std::string text = std::format("Memory ({0}):", report.BudgetSupported ? "VK_EXT_memory_budget" : "estimated budget");
+    for (U32 heapIndex = 0; heapIndex < report.Heaps.size(); heapIndex++)
+    {
+        const HeapStats& heap = report.Heaps[heapIndex];
+        text += std::format("\n    Heap {0} {1:<13} {2:8.1f} / {3:8.1f} MB used of {4:8.1f} MB, engine {5:8.1f} MB",
+                            heapIndex, heap.DeviceLocal ? "(device)" : "(host)", ToMiB(heap.Usage), ToMiB(heap.Budget),
+                            ToMiB(heap.Size), ToMiB(heap.EngineUsage));
+    }
+
+    for (U32 category = 0; category < report.CategoryBytes.size(); category++)
+    {
+        text += std::format("\n    GPU {0:<13} {1:8.1f} MB", GetCategoryName(static_cast<MemoryCategory>(category)),
+                            ToMiB(report.CategoryBytes[category]));
+    }
+
+    for (U32 category = 0; category < report.CpuCategoryBytes.size(); category++)
+    {
+        text += std::format("\n    CPU {0:<13} {1:8.1f} MB", GetCpuCategoryName(static_cast<CpuMemoryCategory>(category)),
+                            ToMiB(report.CpuCategoryBytes[category]));
+    }
+    text += std::format("\n    CPU {0:<13} {1:8.1f} MB", "Resident", ToMiB(report.ProcessResidentBytes));
+
+    return text;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* MemoryTracker::GetCategoryName(MemoryCategory category)
+{
+    static constexpr std::array<const char*, static_cast<U32>(MemoryCategory::Count)> names = {
+        "Vertex", "Index", "Uniform", "Storage", "Staging", "Readback", "RenderTarget", "RayTracing"
+    };
+    return names[static_cast<U32>(category)];
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* MemoryTracker::GetCpuCategoryName(CpuMemoryCategory category)
+{
+    static constexpr std::array<const char*, static_cast<U32>(CpuMemoryCategory::Count)> names = {
+        "Scene", "Capture", "Profiler", "PathTracer"
+    };
+    return names[static_cast<U32>(category)];
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U64 MemoryTracker::QueryProcessResidentBytes()
+{
+#if defined(FFV_LINUX)
+    // Total program size followed by the resident set size, both in pages
+    std::ifstream statm("/proc/self/statm");
+    U64 totalPages = 0;
+    U64 residentPages = 0;
+    if (!(statm >> totalPages >> residentPages))
+    {
+        return 0;
+    }
+
+    return residentPages * static_cast<U64>(sysconf(_SC_PAGESIZE));
+#elif defined(FFV_WINDOWS)
+    PROCESS_MEMORY_COUNTERS counters = {};
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.WorkingSetSize;
+#else
+    return 0;
+#endif
+}
+} // namespace FFV
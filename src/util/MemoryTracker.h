@@ -0,0 +1,133 @@
+#pragma once
+
+#include "util/Types.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace FFV
+{
+/*
+ * What a device memory allocation is used for.
+ */
+enum class MemoryCategory : U8
+{
+    Vertex,
+    Index,
+    Uniform,
+    Storage,      // Scene attributes, materials and indirect draw commands
+    Staging,      // Host visible upload buffers, most only alive during a copy
+    Readback,     // Host visible copies of rendered frames
+    RenderTarget, // Offscreen color and depth images
+    RayTracing,   // Acceleration structures, their scratch and instance buffers and the shader binding table
+    Count
+};
+
+/*
+ * CPU side memory the subsystems report themselves, only the large containers are counted.
+ */
+enum class CpuMemoryCategory : U8
+{
+    Scene,      // Object attributes, batches and the positions and indices of the meshes
+    Capture,    // Pixel buffers of pending PNG encodes
+    Profiler,
+    PathTracer, // Flattened triangles, hierarchy and accumulated image of the CPU path tracer
+    Count
+};
+
+/*
+ * Combines the heap budgets of VK_EXT_memory_budget with the engine's own counters per category. Every device memory
+ * allocation goes through Util::CreateBuffer/CreateImage and Util::FreeMemory, which keep the counters up to date.
+ * Without the extension the budget is estimated as a fraction of the heap size and the usage only contains what the
+ * engine allocated itself.
+ */
+class MemoryTracker
+{
+public:
+    struct HeapStats
+    {
+        VkDeviceSize Size = 0;
+        VkDeviceSize Budget = 0;      // What the process can allocate before the driver starts evicting or failing
+        VkDeviceSize Usage = 0;       // Everything the process allocated, including the swapchain and driver internals
+        VkDeviceSize EngineUsage = 0; // Allocations made through the tracker
+        bool DeviceLocal = false;
+    };
+
+    struct Report
+    {
+        std::vector<HeapStats> Heaps;
+        std::array<VkDeviceSize, static_cast<U32>(MemoryCategory::Count)> CategoryBytes = {};
+        std::array<U64, static_cast<U32>(CpuMemoryCategory::Count)> CpuCategoryBytes = {};
+        U64 ProcessResidentBytes = 0; // 0 if it can't be queried
+        bool BudgetSupported = false;
+    };
+
+public:
+    /*
+     * Has to be called before the first allocation.
+     * @param budgetSupported: VK_EXT_memory_budget is enabled on the device
+     */
+    static void Init(VkPhysicalDevice physicalDevice, bool budgetSupported);
+
+    static void OnAllocate(VkDeviceMemory memory, VkDeviceSize size, U32 memoryTypeIndex, MemoryCategory category);
+    static void OnFree(VkDeviceMemory memory);
+
+    /*
+     * @param deltaBytes: negative when memory is released
+     */
+    static void AddCpuBytes(CpuMemoryCategory category, I64 deltaBytes);
+    /*
+     * For categories with a single owner that knows its total.
+     */
+    static void SetCpuBytes(CpuMemoryCategory category, U64 bytes);
+
+    static Report GetReport();
+    /*
+     * Bytes that can still be allocated from the heap of the first memory type with the properties.
+     */
+    static VkDeviceSize GetAvailableBytes(VkMemoryPropertyFlags propertyFlags);
+    static bool Fits(VkDeviceSize size, VkMemoryPropertyFlags propertyFlags)
+    {
+        return size <= GetAvailableBytes(propertyFlags);
+    }
+
+    /*
+     * One line with the device local usage and budget, for the window title.
+     */
+    static std::string FormatSummary();
+    static std::string FormatReport();
+
+    static const char* GetCategoryName(MemoryCategory category);
+    static const char* GetCpuCategoryName(CpuMemoryCategory category);
+
+private:
+    struct Allocation
+    {
+        VkDeviceSize Size = 0;
+        U32 HeapIndex = 0;
+        MemoryCategory Category = MemoryCategory::Storage;
+    };
+
+    // Without VK_EXT_memory_budget, leaves room for other processes and the driver like most allocators do
+    static constexpr F64 s_FallbackBudgetFraction = 0.8;
+
+private:
+    static U64 QueryProcessResidentBytes();
+
+private:
+    static VkPhysicalDevice s_PhysicalDevice;
+    static VkPhysicalDeviceMemoryProperties s_MemoryProperties;
+    static bool s_BudgetSupported;
+
+    static std::mutex s_Mutex;
+    static std::unordered_map<VkDeviceMemory, Allocation> s_Allocations;
+    static std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> s_HeapBytes;
+    static std::array<VkDeviceSize, static_cast<U32>(MemoryCategory::Count)> s_CategoryBytes;
+    static std::array<std::atomic<I64>, static_cast<U32>(CpuMemoryCategory::Count)> s_CpuCategoryBytes;
+};
+} // namespace FFV
@@ -0,0 +1,128 @@
+#include "FastFileViewerPCH.h"
+
+#include "util/Profiler.h"
+
+#include "util/Log.h"
+#include "util/MemoryTracker.h"
+
+#include <chrono>
+#include <fstream>
+
+namespace FFV
+{
+std::mutex Profiler::s_ThreadBuffersMutex;
+std::vector<UniquePtr<Profiler::ThreadBuffer>> Profiler::s_ThreadBuffers;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Profiler::Record(const char* name, U64 beginNs, U64 endNs)
+{
+    ThreadBuffer& buffer = GetThreadBuffer();
+
+    // The owner is the only writer, the release store publishes the event to an export
+    const U64 index = buffer.NumWritten.load(std::memory_order_relaxed);
+    buffer.Events[index % EventsPerThread] = { .Name = name, .BeginNs = beginNs, .EndNs = endNs };
+    buffer.NumWritten.store(index + 1, std::memory_order_release);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Profiler::SetThreadName(const char* name)
+{
+    GetThreadBuffer().ThreadName.store(name, std::memory_order_release);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Profiler::WriteChromeTrace(const std::filesystem::path& path)
+{
+    if (!IsEnabled())
+    {
+        FFV_WARN("Profiling is compiled out, build with FFV_ENABLE_PROFILING to record a trace!");
+        return false;
+    }
+
+    std::ofstream file(path);
+    if (!file)
+    {
+        FFV_WARN("Couldn't open {0} for writing!", path.string());
+        return false;
+    }
+
+    std::vector<Event> events;
+    std::string json = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+
+    std::lock_guard lock(s_ThreadBuffersMutex);
+    for (const UniquePtr<ThreadBuffer>& buffer : s_ThreadBuffers)
+    {
+        // The owner keeps recording during the copy, so it may overwrite the oldest slots. Reading the count again
+        // afterwards tells how far it got, one more slot is dropped for the event it may be writing right now.
+        const U64 numWritten = buffer->NumWritten.load(std::memory_order_acquire);
+        const U64 firstIndex = numWritten > EventsPerThread ? numWritten - EventsPerThread : 0;
+
+        events.clear();
+        for (U64 i = firstIndex; i < numWritten; i++)
+        {
+            events.push_back(buffer->Events[i % EventsPerThread]);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const U64 numWrittenAfterCopy = buffer->NumWritten.load(std::memory_order_relaxed);
+        const U64 firstIntactIndex =
+            numWrittenAfterCopy + 1 > EventsPerThread ? numWrittenAfterCopy + 1 - EventsPerThread : 0;
+        const U64 numOverwritten = std::min<U64>(firstIntactIndex > firstIndex ? firstIntactIndex - firstIndex : 0,
+                                                 events.size());
+        events.erase(events.begin(), events.begin() + static_cast<std::ptrdiff_t>(numOverwritten));
+        const char* threadName = buffer->ThreadName.load(std::memory_order_acquire);
+
+        if (threadName)
+        {
+            json += std::format("{0}\n{{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": {1}, "
+                                "\"args\": {{\"name\": \"{2}\"}}}}",
+                                first ? "" : ",", buffer->ThreadId, threadName);
+            first = false;
+        }
+
+        for (const Event& event : events)
+        {
+            json += std::format("{0}\n{{\"ph\": \"X\", \"name\": \"{1}\", \"pid\": 1, \"tid\": {2}, \"ts\": {3:.3f}, "
+                                "\"dur\": {4:.3f}}}",
+                                first ? "" : ",", event.Name, buffer->ThreadId, event.BeginNs * 1e-3,
+                                (event.EndNs - event.BeginNs) * 1e-3);
+            first = false;
+        }
+    }
+    json += "\n]}\n";
+
+    file << json;
+    FFV_LOG("Wrote the CPU trace to {0}", path.string());
+    return static_cast<bool>(file);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+U64 Profiler::GetTimeNs()
+{
+    static const auto startTime = std::chrono::steady_clock::now();
+    return static_cast<U64>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer()
+{
+    // Buffers stay alive until exit, so traces still contain threads that already finished
+    static thread_local ThreadBuffer* s_ThreadBuffer = nullptr;
+    if (!s_ThreadBuffer)
+    {
+        std::lock_guard lock(s_ThreadBuffersMutex);
+        s_ThreadBuffer = s_ThreadBuffers.emplace_back(MakeUnique<ThreadBuffer>()).get();
+        s_ThreadBuffer->ThreadId = static_cast<U32>(s_ThreadBuffers.size());
+        MemoryTracker::AddCpuBytes(CpuMemoryCategory::Profiler, static_cast<I64>(sizeof(Event) * EventsPerThread));
+    }
+
+    return *s_ThreadBuffer;
+}
+} // namespace FFV
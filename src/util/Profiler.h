@@ -0,0 +1,103 @@
+#pragma once
+
+#include "util/Types.h"
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+#if defined(FFV_ENABLE_PROFILING)
+    #define FFV_PROFILE_CONCAT_INNER(a, b) a##b
+    #define FFV_PROFILE_CONCAT(a, b) FFV_PROFILE_CONCAT_INNER(a, b)
+    /*
+     * Records the time until the end of the enclosing block.
+     * @param name: has to outlive the profiler, string literals are expected
+     */
+    #define FFV_PROFILE_SCOPE(name) ::FFV::Profiler::Scope FFV_PROFILE_CONCAT(_profileScope, __LINE__)(name)
+    #define FFV_PROFILE_FUNCTION() FFV_PROFILE_SCOPE(__FUNCTION__)
+    /*
+     * Names the calling thread in exported traces.
+     */
+    #define FFV_PROFILE_THREAD(name) ::FFV::Profiler::SetThreadName(name)
+#else
+    #define FFV_PROFILE_SCOPE(name)
+    #define FFV_PROFILE_FUNCTION()
+    #define FFV_PROFILE_THREAD(name)
+#endif
+
+namespace FFV
+{
+/*
+ * CPU instrumentation for the FFV_PROFILE_* macros, which only exist in builds with FFV_ENABLE_PROFILING.
+ * Every thread writes its events into its own ring buffer, so the newest events of every thread are kept and can be
+ * exported at any time. Recording takes no lock, an event is published by a release store of the buffer's count.
+ */
+class Profiler
+{
+public:
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name) : m_Name(name), m_BeginNs(GetTimeNs()) {}
+        ~Scope() { Record(m_Name, m_BeginNs, GetTimeNs()); }
+
+        Scope(Scope&&) = delete;
+        Scope(const Scope&) = delete;
+
+    private:
+        const char* m_Name;
+        U64 m_BeginNs;
+    };
+
+public:
+    static constexpr U32 EventsPerThread = 1 << 16;
+
+public:
+    static constexpr bool IsEnabled()
+    {
+#if defined(FFV_ENABLE_PROFILING)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static void Record(const char* name, U64 beginNs, U64 endNs);
+    static void SetThreadName(const char* name);
+
+    /*
+     * Writes the recorded events as Chrome trace JSON, which chrome://tracing and ui.perfetto.dev both open. Safe to
+     * call while other threads record, events that may have been overwritten during the copy are left out.
+     */
+    static bool WriteChromeTrace(const std::filesystem::path& path);
+
+    /*
+     * Nanoseconds since the first call.
+     */
+    static U64 GetTimeNs();
+
+private:
+    struct Event
+    {
+        const char* Name = nullptr;
+        U64 BeginNs = 0;
+        U64 EndNs = 0;
+    };
+
+    struct ThreadBuffer
+    {
+        std::vector<Event> Events = std::vector<Event>(EventsPerThread);
+        std::atomic<U64> NumWritten = 0; // Only written by the owning thread
+        std::atomic<const char*> ThreadName = nullptr;
+        U32 ThreadId = 0;
+    };
+
+private:
+    static ThreadBuffer& GetThreadBuffer();
+
+private:
+    static std::mutex s_ThreadBuffersMutex;
+    static std::vector<UniquePtr<ThreadBuffer>> s_ThreadBuffers;
+};
+} // namespace FFV
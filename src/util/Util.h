@@ -2,6 +2,7 @@
 
 #include "renderer/PhysicalDevice.h"
 #include "util/Assert.h"
+#include "util/MemoryTracker.h"
 #include "util/Types.h"
 
 #include <fstream>
@@ -51,6 +52,67 @@ public:
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+    /*
+     * FNV-1a hash, stable between runs so it can be used for keys that get written to disk.
+     * @param seed: result of a previous hash to chain multiple values
+     */
+    static U64 HashBytes(const void* data, U64 size, U64 seed = 14695981039346656037ull)
+    {
+        const U8* bytes = static_cast<const U8*>(data);
+        for (U64 i = 0; i < size; i++)
+        {
+            seed ^= bytes[i];
+            seed *= 1099511628211ull;
+        }
+
+        return seed;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*
+     * Only use this for types without padding, otherwise the padding bytes end up in the hash.
+     */
+    template<typename T>
+    static void HashCombine(U64& seed, const T& value)
+    {
+        seed = HashBytes(&value, sizeof(T), seed);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*
+     * Hashes the description of a descriptor set layout, pipeline layouts hash every set layout they're created from.
+     * Only VkDescriptorSetLayoutBindingFlagsCreateInfo is followed in the pNext chain, immutable samplers aren't used.
+     */
+    static U64 HashDescriptorSetLayout(const VkDescriptorSetLayoutCreateInfo& createInfo)
+    {
+        U64 hash = HashBytes(&createInfo.flags, sizeof(createInfo.flags));
+        for (U32 i = 0; i < createInfo.bindingCount; i++)
+        {
+            const VkDescriptorSetLayoutBinding& binding = createInfo.pBindings[i];
+            HashCombine(hash, binding.binding);
+            HashCombine(hash, binding.descriptorType);
+            HashCombine(hash, binding.descriptorCount);
+            HashCombine(hash, binding.stageFlags);
+        }
+
+        for (const VkBaseInStructure* next = static_cast<const VkBaseInStructure*>(createInfo.pNext); next;
+             next = next->pNext)
+        {
+            if (next->sType == VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO)
+            {
+                const auto* bindingFlags = reinterpret_cast<const VkDescriptorSetLayoutBindingFlagsCreateInfo*>(next);
+                hash = HashBytes(bindingFlags->pBindingFlags, sizeof(VkDescriptorBindingFlags) * bindingFlags->bindingCount,
+                                 hash);
+            }
+        }
+
+        return hash;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
     static U32 FindMemoryType(SharedPtr<PhysicalDevices> physicalDevice, U32 typeFilter, VkMemoryPropertyFlags properties)
     {
         VkPhysicalDeviceMemoryProperties memoryProperties;
@@ -71,7 +133,7 @@ public:
 
     static void CreateBuffer(VkDevice device, SharedPtr<PhysicalDevices> physicalDevice, VkDeviceSize size,
                              VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags propertyFlags, VkBuffer& buffer,
-                             VkDeviceMemory& bufferMemory)
+                             VkDeviceMemory& bufferMemory, MemoryCategory category)
     {
         const VkBufferCreateInfo bufferCreateInfo = { .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
                                                       .size = size,
@@ -82,20 +144,105 @@ public:
 
         VkMemoryRequirements memoryRequirements;
         vkGetBufferMemoryRequirements(device, buffer, &memoryRequirements);
+
+        // Buffers whose address is queried need memory that was allocated for it
+        const VkMemoryAllocateFlagsInfo allocateFlagsInfo = { .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+                                                              .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT };
         const VkMemoryAllocateInfo memoryAllocateInfo = {
             .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .pNext = (usageFlags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) ? &allocateFlagsInfo : nullptr,
             .allocationSize = memoryRequirements.size,
             .memoryTypeIndex = FindMemoryType(physicalDevice, memoryRequirements.memoryTypeBits, propertyFlags)
         };
 
         FFV_CHECK_VK_RESULT(vkAllocateMemory(device, &memoryAllocateInfo, VK_NULL_HANDLE, &bufferMemory));
+        MemoryTracker::OnAllocate(bufferMemory, memoryAllocateInfo.allocationSize, memoryAllocateInfo.memoryTypeIndex,
+                                  category);
         FFV_CHECK_VK_RESULT(vkBindBufferMemory(device, buffer, bufferMemory, 0));
     }
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+    /*
+     * The buffer has to be created with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT.
+     */
+    static VkDeviceAddress GetBufferAddress(VkDevice device, VkBuffer buffer)
+    {
+        const VkBufferDeviceAddressInfo addressInfo = { .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+                                                        .buffer = buffer };
+        return vkGetBufferDeviceAddress(device, &addressInfo);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    static void CreateImage(VkDevice device, SharedPtr<PhysicalDevices> physicalDevice, VkExtent2D extent, VkFormat format,
+                            VkImageUsageFlags usageFlags, VkMemoryPropertyFlags propertyFlags, VkImage& image,
+                            VkDeviceMemory& imageMemory, MemoryCategory category)
+    {
+        const VkImageCreateInfo imageCreateInfo = { .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                                                    .imageType = VK_IMAGE_TYPE_2D,
+                                                    .format = format,
+                                                    .extent = { extent.width, extent.height, 1 },
+                                                    .mipLevels = 1,
+                                                    .arrayLayers = 1,
+                                                    .samples = VK_SAMPLE_COUNT_1_BIT,
+                                                    .tiling = VK_IMAGE_TILING_OPTIMAL,
+                                                    .usage = usageFlags,
+                                                    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                                                    .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED };
+
+        FFV_CHECK_VK_RESULT(vkCreateImage(device, &imageCreateInfo, VK_NULL_HANDLE, &image));
+
+        VkMemoryRequirements memoryRequirements;
+        vkGetImageMemoryRequirements(device, image, &memoryRequirements);
+        const VkMemoryAllocateInfo memoryAllocateInfo = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = memoryRequirements.size,
+            .memoryTypeIndex = FindMemoryType(physicalDevice, memoryRequirements.memoryTypeBits, propertyFlags)
+        };
+
+        FFV_CHECK_VK_RESULT(vkAllocateMemory(device, &memoryAllocateInfo, VK_NULL_HANDLE, &imageMemory));
+        MemoryTracker::OnAllocate(imageMemory, memoryAllocateInfo.allocationSize, memoryAllocateInfo.memoryTypeIndex,
+                                  category);
+        FFV_CHECK_VK_RESULT(vkBindImageMemory(device, image, imageMemory, 0));
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*
+     * Counterpart of CreateBuffer/CreateImage, keeps the MemoryTracker counters in sync.
+     */
+    static void FreeMemory(VkDevice device, VkDeviceMemory memory)
+    {
+        MemoryTracker::OnFree(memory);
+        vkFreeMemory(device, memory, VK_NULL_HANDLE);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    static VkImageView CreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
+    {
+        const VkImageViewCreateInfo imageViewCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = format,
+            .subresourceRange = { .aspectMask = aspectFlags, .levelCount = 1, .layerCount = 1 }
+        };
+
+        VkImageView imageView = VK_NULL_HANDLE;
+        FFV_CHECK_VK_RESULT(vkCreateImageView(device, &imageViewCreateInfo, VK_NULL_HANDLE, &imageView));
+
+        return imageView;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*
+     * @param dstOffset: byte offset into dstBuffer
+     */
     static void CopyBuffer(VkDevice device, VkQueue queue, VkCommandPool commandBufferPool, VkBuffer& srcBuffer,
-                           VkBuffer& dstBuffer, VkDeviceSize size)
+                           VkBuffer& dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0)
     {
         const VkCommandBufferAllocateInfo commandBufferAllocateInfo = { .sType =
                                                                             VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
@@ -109,7 +256,7 @@ public:
                                                      .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT };
 
         FFV_CHECK_VK_RESULT(vkBeginCommandBuffer(commandCopyBuffer, &beginInfo));
-        const VkBufferCopy copyRegion = { .srcOffset = 0, .dstOffset = 0, .size = size };
+        const VkBufferCopy copyRegion = { .srcOffset = 0, .dstOffset = dstOffset, .size = size };
         vkCmdCopyBuffer(commandCopyBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
         FFV_CHECK_VK_RESULT(vkEndCommandBuffer(commandCopyBuffer));
 
@@ -119,6 +266,9 @@ public:
 
         FFV_CHECK_VK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
         FFV_CHECK_VK_RESULT(vkQueueWaitIdle(queue));
+
+        // The copy is done after the wait, otherwise every upload would leave a command buffer behind in the pool
+        vkFreeCommandBuffers(device, commandBufferPool, 1, &commandCopyBuffer);
     }
 };
 } // namespace FFV